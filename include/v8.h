@@ -116,6 +116,7 @@ namespace internal {
 
 class Arguments;
 class Object;
+class GCTracer;
 class Heap;
 class HeapObject;
 class Isolate;
@@ -2624,11 +2625,41 @@ class V8EXPORT ResourceConstraints {
   uint32_t* stack_limit() const { return stack_limit_; }
   // Sets an address beyond which the VM's stack may not grow.
   void set_stack_limit(uint32_t* value) { stack_limit_ = value; }
+  // The young space grows beyond what scavenge survivors require when
+  // fewer than this percentage of its objects survive scavenges and it
+  // fills up in less than the target scavenge interval.  It shrinks again
+  // in idle notifications.  Zero keeps the defaults, which can also be
+  // changed after initialization.
+  int young_space_growth_survival_rate() const {
+    return young_space_growth_survival_rate_;
+  }
+  void set_young_space_growth_survival_rate(int percent) {
+    young_space_growth_survival_rate_ = percent;
+  }
+  int target_scavenge_interval_ms() const {
+    return target_scavenge_interval_ms_;
+  }
+  void set_target_scavenge_interval_ms(int value) {
+    target_scavenge_interval_ms_ = value;
+  }
+  // The old generation may grow between full collections until they are
+  // expected to take this percentage of wall time, given the measured
+  // collection speed and allocation rate.  The growth stays bounded by
+  // max_old_space_size.  Zero keeps the default of 5 percent.
+  int target_gc_overhead_percent() const {
+    return target_gc_overhead_percent_;
+  }
+  void set_target_gc_overhead_percent(int percent) {
+    target_gc_overhead_percent_ = percent;
+  }
  private:
   int max_young_space_size_;
   int max_old_space_size_;
   int max_executable_size_;
   uint32_t* stack_limit_;
+  int young_space_growth_survival_rate_;
+  int target_scavenge_interval_ms_;
+  int target_gc_overhead_percent_;
 };
 
 
@@ -2743,6 +2774,72 @@ typedef void (*GCEpilogueCallback)(GCType type, GCCallbackFlags flags);
 typedef void (*GCCallback)();
 
 
+/**
+ * Timing and size information about one garbage collection, passed to the
+ * callbacks registered with V8::AddGCTimingCallback.  Sizes are in bytes,
+ * times in milliseconds.
+ */
+class V8EXPORT GCTimingRecord {
+ public:
+  enum Phase {
+    kExternal,  // Embedder callbacks and weak handle processing.
+    kMark,
+    kSweep,
+    kSweepNewSpace,
+    kEvacuate,
+    kUpdatePointers,
+    kNumberOfPhases
+  };
+
+  GCTimingRecord();
+  GCType type() const { return type_; }
+  // The reason given for the collection and the reason for the choice of
+  // collector.  Either may be NULL.
+  const char* reason() const { return reason_; }
+  const char* collector_reason() const { return collector_reason_; }
+  // Duration of the whole pause.
+  double pause_in_ms() const { return pause_in_ms_; }
+  // Duration of one phase of the pause.  Scavenges only report kExternal.
+  double phase_time_in_ms(Phase phase) const { return phase_times_[phase]; }
+  size_t size_before() const { return size_before_; }
+  size_t size_after() const { return size_after_; }
+  size_t freed_bytes() const { return freed_bytes_; }
+  size_t promoted_bytes() const { return promoted_bytes_; }
+  // Size of the duplicate strings that a mark-compact with
+  // --string-deduplication freed.
+  size_t deduplicated_bytes() const { return deduplicated_bytes_; }
+  // Size of the large strings that a mark-compact freed because they were
+  // only reachable through small slices, which got copies of their own.
+  size_t rescued_bytes() const { return rescued_bytes_; }
+  // Percentage of the collected objects that survived: new space objects
+  // for a scavenge, all objects for a mark-compact.
+  double survival_rate() const { return survival_rate_; }
+
+ private:
+  GCType type_;
+  const char* reason_;
+  const char* collector_reason_;
+  double pause_in_ms_;
+  double phase_times_[kNumberOfPhases];
+  size_t size_before_;
+  size_t size_after_;
+  size_t freed_bytes_;
+  size_t promoted_bytes_;
+  size_t deduplicated_bytes_;
+  size_t rescued_bytes_;
+  double survival_rate_;
+
+  friend class internal::GCTracer;
+};
+
+typedef void (*GCTimingCallback)(const GCTimingRecord* record);
+
+enum MemoryPressureLevel {
+  kMemoryPressureModerate,
+  kMemoryPressureCritical
+};
+
+
 /**
  * Collection of V8 heap information.
  *
@@ -2756,6 +2853,10 @@ class V8EXPORT HeapStatistics {
   size_t total_heap_size_executable() { return total_heap_size_executable_; }
   size_t used_heap_size() { return used_heap_size_; }
   size_t heap_size_limit() { return heap_size_limit_; }
+  // Memory of freed heap pages that is kept for reuse instead of being
+  // returned to the OS, and the number of such pages.
+  size_t pooled_heap_size() { return pooled_heap_size_; }
+  size_t pooled_heap_pages() { return pooled_heap_pages_; }
 
  private:
   void set_total_heap_size(size_t size) { total_heap_size_ = size; }
@@ -2764,11 +2865,52 @@ class V8EXPORT HeapStatistics {
   }
   void set_used_heap_size(size_t size) { used_heap_size_ = size; }
   void set_heap_size_limit(size_t size) { heap_size_limit_ = size; }
+  void set_pooled_heap_size(size_t size) { pooled_heap_size_ = size; }
+  void set_pooled_heap_pages(size_t pages) { pooled_heap_pages_ = pages; }
 
   size_t total_heap_size_;
   size_t total_heap_size_executable_;
   size_t used_heap_size_;
   size_t heap_size_limit_;
+  size_t pooled_heap_size_;
+  size_t pooled_heap_pages_;
+
+  friend class V8;
+};
+
+
+/**
+ * Describes the work done by V8::IdleNotificationDeadline.
+ */
+class V8EXPORT IdleTaskReport {
+ public:
+  enum Work {
+    kNoWork = 0,
+    kSweeping = 1 << 0,
+    kIncrementalMarkingStep = 1 << 1,
+    kFinalizeIncrementalMarking = 1 << 2,
+    kScavenge = 1 << 3,
+    kFullGarbageCollection = 1 << 4,
+    kShrinkNewSpace = 1 << 5
+  };
+
+  IdleTaskReport();
+  // A combination of the Work flags.
+  int work_done() { return work_done_; }
+  // Milliseconds spent in the notification.
+  double time_used_in_ms() { return time_used_in_ms_; }
+  // Predicted milliseconds of idle time needed for the most urgent work
+  // that did not fit into the deadline, or 0 if all pending work fit.
+  double time_needed_in_ms() { return time_needed_in_ms_; }
+
+ private:
+  void set_work_done(int work) { work_done_ = work; }
+  void set_time_used_in_ms(double time) { time_used_in_ms_ = time; }
+  void set_time_needed_in_ms(double time) { time_needed_in_ms_ = time; }
+
+  int work_done_;
+  double time_used_in_ms_;
+  double time_needed_in_ms_;
 
   friend class V8;
 };
@@ -3126,6 +3268,19 @@ class V8EXPORT V8 {
    */
   static void RemoveGCEpilogueCallback(GCEpilogueCallback callback);
 
+  /**
+   * Enables the host application to receive timing and size information
+   * after each garbage collection.  The same restrictions as for
+   * epilogue callbacks apply.
+   */
+  static void AddGCTimingCallback(GCTimingCallback callback);
+
+  /**
+   * This function removes callback which was installed by
+   * AddGCTimingCallback function.
+   */
+  static void RemoveGCTimingCallback(GCTimingCallback callback);
+
   /**
    * The function is deprecated. Please use AddGCEpilogueCallback instead.
    * Enables the host application to receive a notification after a
@@ -3355,12 +3510,34 @@ class V8EXPORT V8 {
    */
   static bool IdleNotification(int hint = 1000);
 
+  /**
+   * Optional notification that the embedder is idle for the given number
+   * of milliseconds.  V8 predicts the duration of pending garbage
+   * collection work from the speed of earlier collections and only starts
+   * the work that fits into the idle time.  What was done is described in
+   * the optional report.  Returns true if the embedder should stop calling
+   * IdleNotificationDeadline until real work has been done.
+   */
+  static bool IdleNotificationDeadline(int idle_time_in_ms,
+                                       IdleTaskReport* report = NULL);
+
   /**
    * Optional notification that the system is running low on memory.
    * V8 uses these notifications to attempt to free memory.
    */
   static void LowMemoryNotification();
 
+  /**
+   * Optional notification that the system is under memory pressure.  At
+   * the moderate level V8 does a full garbage collection that reduces the
+   * memory footprint.  At the critical level it additionally clears its
+   * caches, flushes the code of all functions and regular expressions
+   * that are not running and compacts all fragmented pages.  At both
+   * levels new space is shrunk and unused pages are returned to the OS.
+   * Returns the number of bytes of memory that were released.
+   */
+  static size_t MemoryPressureNotification(MemoryPressureLevel level);
+
   /**
    * Optional notification that a context has been disposed. V8 uses
    * these notifications to guide the GC heuristic. Returns the number
@@ -193,6 +193,8 @@ void i::V8::FatalProcessOutOfMemory(const char* location, bool take_snapshot) {
   heap_stats.memory_allocator_size = &memory_allocator_size;
   intptr_t memory_allocator_capacity;
   heap_stats.memory_allocator_capacity = &memory_allocator_capacity;
+  intptr_t memory_allocator_pooled_size;
+  heap_stats.memory_allocator_pooled_size = &memory_allocator_pooled_size;
   int objects_per_type[LAST_TYPE + 1] = {0};
   heap_stats.objects_per_type = objects_per_type;
   int size_per_type[LAST_TYPE + 1] = {0};
@@ -588,7 +590,10 @@ ResourceConstraints::ResourceConstraints()
   : max_young_space_size_(0),
     max_old_space_size_(0),
     max_executable_size_(0),
-    stack_limit_(NULL) { }
+    stack_limit_(NULL),
+    young_space_growth_survival_rate_(0),
+    target_scavenge_interval_ms_(0),
+    target_gc_overhead_percent_(0) { }
 
 
 bool SetResourceConstraints(ResourceConstraints* constraints) {
@@ -609,6 +614,11 @@ bool SetResourceConstraints(ResourceConstraints* constraints) {
     uintptr_t limit = reinterpret_cast<uintptr_t>(constraints->stack_limit());
     isolate->stack_guard()->SetStackLimit(limit);
   }
+  isolate->heap()->ConfigureNewSpaceSizing(
+      constraints->young_space_growth_survival_rate(),
+      constraints->target_scavenge_interval_ms());
+  isolate->heap()->ConfigureOldGenerationGrowing(
+      constraints->target_gc_overhead_percent());
   return true;
 }
 
@@ -4253,7 +4263,29 @@ bool v8::V8::Dispose() {
 HeapStatistics::HeapStatistics(): total_heap_size_(0),
                                   total_heap_size_executable_(0),
                                   used_heap_size_(0),
-                                  heap_size_limit_(0) { }
+                                  heap_size_limit_(0),
+                                  pooled_heap_size_(0),
+                                  pooled_heap_pages_(0) { }
+
+
+GCTimingRecord::GCTimingRecord(): type_(kGCTypeScavenge),
+                                  reason_(NULL),
+                                  collector_reason_(NULL),
+                                  pause_in_ms_(0),
+                                  size_before_(0),
+                                  size_after_(0),
+                                  freed_bytes_(0),
+                                  promoted_bytes_(0),
+                                  deduplicated_bytes_(0),
+                                  rescued_bytes_(0),
+                                  survival_rate_(0) {
+  for (int i = 0; i < kNumberOfPhases; i++) phase_times_[i] = 0;
+}
+
+
+IdleTaskReport::IdleTaskReport(): work_done_(kNoWork),
+                                  time_used_in_ms_(0),
+                                  time_needed_in_ms_(0) { }
 
 
 void v8::V8::GetHeapStatistics(HeapStatistics* heap_statistics) {
@@ -4263,6 +4295,8 @@ void v8::V8::GetHeapStatistics(HeapStatistics* heap_statistics) {
     heap_statistics->set_total_heap_size_executable(0);
     heap_statistics->set_used_heap_size(0);
     heap_statistics->set_heap_size_limit(0);
+    heap_statistics->set_pooled_heap_size(0);
+    heap_statistics->set_pooled_heap_pages(0);
     return;
   }
 
@@ -4272,6 +4306,10 @@ void v8::V8::GetHeapStatistics(HeapStatistics* heap_statistics) {
       heap->CommittedMemoryExecutable());
   heap_statistics->set_used_heap_size(heap->SizeOfObjects());
   heap_statistics->set_heap_size_limit(heap->MaxReserved());
+  i::MemoryAllocator* memory_allocator =
+      i::Isolate::Current()->memory_allocator();
+  heap_statistics->set_pooled_heap_size(memory_allocator->PooledSize());
+  heap_statistics->set_pooled_heap_pages(memory_allocator->PooledChunks());
 }
 
 
@@ -4291,6 +4329,25 @@ bool v8::V8::IdleNotification(int hint) {
 }
 
 
+bool v8::V8::IdleNotificationDeadline(int idle_time_in_ms,
+                                      IdleTaskReport* report) {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (isolate == NULL || !isolate->IsInitialized()) return true;
+  double start = i::OS::TimeCurrentMillis();
+  int work_done = IdleTaskReport::kNoWork;
+  double time_needed_in_ms = 0;
+  bool result = i::V8::IdleNotificationDeadline(idle_time_in_ms,
+                                                &work_done,
+                                                &time_needed_in_ms);
+  if (report != NULL) {
+    report->set_work_done(work_done);
+    report->set_time_used_in_ms(i::OS::TimeCurrentMillis() - start);
+    report->set_time_needed_in_ms(time_needed_in_ms);
+  }
+  return result;
+}
+
+
 void v8::V8::LowMemoryNotification() {
   i::Isolate* isolate = i::Isolate::Current();
   if (isolate == NULL || !isolate->IsInitialized()) return;
@@ -4298,6 +4355,14 @@ void v8::V8::LowMemoryNotification() {
 }
 
 
+size_t v8::V8::MemoryPressureNotification(MemoryPressureLevel level) {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (isolate == NULL || !isolate->IsInitialized()) return 0;
+  return static_cast<size_t>(
+      isolate->heap()->MemoryPressureNotification(level));
+}
+
+
 int v8::V8::ContextDisposedNotification() {
   i::Isolate* isolate = i::Isolate::Current();
   if (!isolate->IsInitialized()) return 0;
@@ -5301,6 +5366,20 @@ void V8::RemoveGCEpilogueCallback(GCEpilogueCallback callback) {
 }
 
 
+void V8::AddGCTimingCallback(GCTimingCallback callback) {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (IsDeadCheck(isolate, "v8::V8::AddGCTimingCallback()")) return;
+  isolate->heap()->AddGCTimingCallback(callback);
+}
+
+
+void V8::RemoveGCTimingCallback(GCTimingCallback callback) {
+  i::Isolate* isolate = i::Isolate::Current();
+  if (IsDeadCheck(isolate, "v8::V8::RemoveGCTimingCallback()")) return;
+  isolate->heap()->RemoveGCTimingCallback(callback);
+}
+
+
 void V8::AddMemoryAllocationCallback(MemoryAllocationCallback callback,
                                      ObjectSpace space,
                                      AllocationAction action) {
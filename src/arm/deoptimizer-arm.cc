@@ -578,6 +578,9 @@ void Deoptimizer::DoComputeConstructStubFrame(TranslationIterator* iterator,
   output_offset -= kPointerSize;
   value = output_frame->GetFrameSlot(output_frame_size - kPointerSize);
   output_frame->SetFrameSlot(output_offset, value);
+  CopyObjectSlot(
+      reinterpret_cast<Address>(top_address) + output_frame_size - kPointerSize,
+      reinterpret_cast<Address>(top_address) + output_offset);
   if (FLAG_trace_deopt) {
     PrintF("    0x%08x: [top + %d] <- 0x%08x ; allocated receiver\n",
            top_address + output_offset, output_offset, value);
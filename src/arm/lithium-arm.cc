@@ -797,6 +797,8 @@ void LChunkBuilder::DoBasicBlock(HBasicBlock* block, HBasicBlock* next_block) {
     HEnvironment* last_environment = pred->last_environment();
     for (int i = 0; i < block->phis()->length(); ++i) {
       HPhi* phi = block->phis()->at(i);
+      // The field phis of captured objects are not environment values.
+      if (!phi->HasMergedIndex()) continue;
       last_environment->SetValueAt(phi->merged_index(), phi);
     }
     for (int i = 0; i < block->deleted_phis()->length(); ++i) {
@@ -864,7 +866,7 @@ LEnvironment* LChunkBuilder::CreateEnvironment(
       ast_id,
       hydrogen_env->parameter_count(),
       argument_count_,
-      value_count,
+      value_count + hydrogen_env->CapturedFieldCount(),
       outer,
       zone());
   int argument_index = *argument_index_accumulator;
@@ -875,6 +877,12 @@ LEnvironment* LChunkBuilder::CreateEnvironment(
     LOperand* op = NULL;
     if (value->IsArgumentsObject()) {
       op = NULL;
+    } else if (value->IsCapturedObject()) {
+      HCapturedObject* object = HCapturedObject::cast(value);
+      result->AddCapturedObject(object->capture_id(),
+                                object->map(),
+                                object->OperandCount());
+      continue;
     } else if (value->IsPushArgument()) {
       op = new(zone()) LArgument(argument_index++);
     } else {
@@ -883,6 +891,20 @@ LEnvironment* LChunkBuilder::CreateEnvironment(
     result->AddValue(op, value->representation());
   }
 
+  // The fields of captured objects follow the values of the frame.
+  for (int i = 0; i < value_count; ++i) {
+    if (hydrogen_env->is_special_index(i)) continue;
+
+    HValue* value = hydrogen_env->values()->at(i);
+    if (!value->IsCapturedObject()) continue;
+    HCapturedObject* object = HCapturedObject::cast(value);
+    if (!result->BeginCapturedObjectFields(object->capture_id())) continue;
+    for (int j = 0; j < object->OperandCount(); ++j) {
+      HValue* field = object->OperandAt(j);
+      result->AddCapturedField(UseAny(field), field->representation());
+    }
+  }
+
   if (hydrogen_env->frame_type() == JS_FUNCTION) {
     *argument_index_accumulator = argument_index;
   }
@@ -2202,6 +2224,12 @@ LInstruction* LChunkBuilder::DoSimulate(HSimulate* instr) {
 }
 
 
+LInstruction* LChunkBuilder::DoCapturedObject(HCapturedObject* instr) {
+  instr->ReplayEnvironment(current_block_->last_environment());
+  return NULL;
+}
+
+
 LInstruction* LChunkBuilder::DoStackCheck(HStackCheck* instr) {
   if (instr->is_function_entry()) {
     return MarkAsCall(new(zone()) LStackCheck, instr);
@@ -944,6 +944,14 @@ ExternalReference ExternalReference::store_buffer_top(Isolate* isolate) {
 }
 
 
+ExternalReference ExternalReference::concurrent_marking_active(
+    Isolate* isolate) {
+  return ExternalReference(
+      isolate->heap()->incremental_marking()->concurrent_marker()->
+          active_address());
+}
+
+
 ExternalReference ExternalReference::new_space_mask(Isolate* isolate) {
   return ExternalReference(reinterpret_cast<Address>(
       isolate->heap()->NewSpaceMask()));
@@ -363,6 +363,11 @@ static FixedArray* LeftTrimFixedArray(Heap* heap,
   STATIC_ASSERT(FixedArray::kLengthOffset == kPointerSize);
   STATIC_ASSERT(FixedArray::kHeaderSize == 2 * kPointerSize);
 
+  // Moving the start of the array changes its mark bits and may push it on
+  // the marking deque.
+  ConcurrentMarkingScope concurrent_marking_scope(
+      heap->incremental_marking()->concurrent_marker(), elms);
+
   Object** former_start = HeapObject::RawField(elms, 0);
 
   const int len = elms->length();
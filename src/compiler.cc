@@ -818,18 +818,12 @@ bool Compiler::CompileLazy(CompilationInfo* info) {
 }
 
 
-void Compiler::RecompileParallel(Handle<JSFunction> closure) {
-  ASSERT(closure->IsMarkedForParallelRecompilation());
-  if (closure->IsInRecompileQueue()) return;
-
+// Builds the graph of the closure on the execution thread and queues it for
+// the compiler threads.  Returns whether the closure was queued.
+static bool QueueParallelRecompilation(Handle<JSFunction> closure,
+                                       int osr_ast_id,
+                                       int priority) {
   Isolate* isolate = closure->GetIsolate();
-  if (!isolate->optimizing_compiler_thread()->IsQueueAvailable()) {
-    if (FLAG_trace_parallel_recompilation) {
-      PrintF("  ** Compilation queue, will retry opting on next run.\n");
-    }
-    return;
-  }
-
   SmartPointer<CompilationInfo> info(new CompilationInfoWithZone(closure));
   VMState state(isolate, PARALLEL_COMPILER_PROLOGUE);
   PostponeInterruptsScope postpone(isolate);
@@ -837,12 +831,17 @@ void Compiler::RecompileParallel(Handle<JSFunction> closure) {
   Handle<SharedFunctionInfo> shared = info->shared_info();
   int compiled_size = shared->end_position() - shared->start_position();
   isolate->counters()->total_compile_size()->Increment(compiled_size);
-  info->SetOptimizing(AstNode::kNoNumber);
+  info->SetOptimizing(osr_ast_id);
+  bool queued = false;
 
   {
     CompilationHandleScope handle_scope(*info);
 
-    if (InstallCodeFromOptimizedCodeMap(*info)) return;
+    // Cached optimized code has no on-stack replacement entry.
+    if (osr_ast_id == AstNode::kNoNumber &&
+        InstallCodeFromOptimizedCodeMap(*info)) {
+      return false;
+    }
 
     if (ParserApi::Parse(*info, kNoParsingFlags)) {
       LanguageMode language_mode = info->function()->language_mode();
@@ -855,11 +854,17 @@ void Compiler::RecompileParallel(Handle<JSFunction> closure) {
             new(info->zone()) OptimizingCompiler(*info);
         OptimizingCompiler::Status status = compiler->CreateGraph();
         if (status == OptimizingCompiler::SUCCEEDED) {
-          isolate->optimizing_compiler_thread()->QueueForOptimization(compiler);
+          isolate->optimizing_compiler_thread()->QueueForOptimization(
+              compiler, priority);
           shared->code()->set_profiler_ticks(0);
-          closure->ReplaceCode(isolate->builtins()->builtin(
-              Builtins::kInRecompileQueue));
+          // A function waiting for on-stack replacement keeps running its
+          // unoptimized code.
+          if (osr_ast_id == AstNode::kNoNumber) {
+            closure->ReplaceCode(isolate->builtins()->builtin(
+                Builtins::kInRecompileQueue));
+          }
           info.Detach();
+          queued = true;
         } else if (status == OptimizingCompiler::BAILED_OUT) {
           isolate->clear_pending_exception();
           InstallFullCode(*info);
@@ -871,6 +876,43 @@ void Compiler::RecompileParallel(Handle<JSFunction> closure) {
   if (isolate->has_pending_exception()) {
     isolate->clear_pending_exception();
   }
+  return queued;
+}
+
+
+void Compiler::RecompileParallel(Handle<JSFunction> closure) {
+  ASSERT(closure->IsMarkedForParallelRecompilation());
+  if (closure->IsInRecompileQueue()) return;
+
+  Isolate* isolate = closure->GetIsolate();
+  // The optimized code of a pending on-stack replacement is installed for
+  // the function as well.
+  if (isolate->optimizing_compiler_thread()->IsQueuedForOSR(*closure)) return;
+
+  // Hotter functions are compiled first.
+  int priority = closure->shared()->code()->profiler_ticks();
+  if (!isolate->optimizing_compiler_thread()->IsQueueAvailable(priority)) {
+    if (FLAG_trace_parallel_recompilation) {
+      PrintF("  ** Compilation queue, will retry opting on next run.\n");
+    }
+    return;
+  }
+
+  QueueParallelRecompilation(closure, AstNode::kNoNumber, priority);
+}
+
+
+bool Compiler::RecompileParallelForOSR(Handle<JSFunction> closure,
+                                       int osr_ast_id) {
+  ASSERT(osr_ast_id != AstNode::kNoNumber);
+  ASSERT(!closure->IsOptimized());
+  // The loop is running right now, so its compilation goes first.
+  const int priority = kMaxInt;
+  Isolate* isolate = closure->GetIsolate();
+  if (!isolate->optimizing_compiler_thread()->IsQueueAvailable(priority)) {
+    return false;
+  }
+  return QueueParallelRecompilation(closure, osr_ast_id, priority);
 }
 
 
@@ -903,6 +945,17 @@ void Compiler::InstallOptimizedCode(OptimizingCompiler* optimizing_compiler) {
 }
 
 
+void Compiler::DiscardOptimizedCode(OptimizingCompiler* optimizing_compiler) {
+  SmartPointer<CompilationInfo> info(optimizing_compiler->info());
+  // Unlike a failed optimization this does not disable optimization of the
+  // function: it is queued again when the runtime profiler finds it hot.
+  JSFunction* closure = *info->closure();
+  if (closure->IsInRecompileQueue()) {
+    closure->ReplaceCode(info->shared_info()->code());
+  }
+}
+
+
 Handle<SharedFunctionInfo> Compiler::BuildFunctionInfo(FunctionLiteral* literal,
                                                        Handle<Script> script) {
   // Precondition: code has been parsed and scopes have been analyzed.
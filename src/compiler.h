@@ -450,6 +450,11 @@ class Compiler : public AllStatic {
 
   static void RecompileParallel(Handle<JSFunction> function);
 
+  // Queues the function for on-stack replacement at the given loop on the
+  // parallel recompilation threads.  Returns whether it was queued.
+  static bool RecompileParallelForOSR(Handle<JSFunction> function,
+                                      int osr_ast_id);
+
   // Compile a shared function info object (the function is possibly lazily
   // compiled).
   static Handle<SharedFunctionInfo> BuildFunctionInfo(FunctionLiteral* node,
@@ -463,6 +468,10 @@ class Compiler : public AllStatic {
 
   static void InstallOptimizedCode(OptimizingCompiler* info);
 
+  // Drops the result of a cancelled parallel recompilation and restores the
+  // unoptimized code of the function.
+  static void DiscardOptimizedCode(OptimizingCompiler* info);
+
 #ifdef ENABLE_DEBUGGER_SUPPORT
   static bool MakeCodeForLiveEdit(CompilationInfo* info);
 #endif
@@ -0,0 +1,374 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "v8.h"
+
+#include "concurrent-marker.h"
+#include "incremental-marking-inl.h"
+#include "mark-compact-inl.h"
+#include "objects-visiting.h"
+
+namespace v8 {
+namespace internal {
+
+
+// Holds the lock of a chunk on the helper thread.
+class ChunkLockScope {
+ public:
+  explicit ChunkLockScope(MemoryChunk* chunk) : chunk_(chunk) {
+    chunk_->LockForConcurrentMarking();
+  }
+
+  ~ChunkLockScope() {
+    chunk_->UnlockForConcurrentMarking();
+  }
+
+ private:
+  MemoryChunk* chunk_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChunkLockScope);
+};
+
+
+ConcurrentMarker::ConcurrentMarker(Heap* heap, IncrementalMarking* marking)
+    : heap_(heap),
+      marking_(marking),
+      thread_(NULL),
+      mutex_(OS::CreateMutex()),
+      shared_work_(0),
+      shared_deferred_objects_(0),
+      shared_recorded_slots_(0),
+      idle_(true),
+      work_(0),
+      local_deferred_objects_(0),
+      local_recorded_slots_(0),
+      deferred_objects_(0),
+      slots_to_record_(0) {
+  NoBarrier_Store(&active_, static_cast<AtomicWord>(false));
+  NoBarrier_Store(&pause_requested_, static_cast<AtomicWord>(false));
+}
+
+
+ConcurrentMarker::~ConcurrentMarker() {
+  ASSERT(thread_ == NULL);
+  delete mutex_;
+}
+
+
+bool ConcurrentMarker::CanMarkConcurrently() {
+#ifdef V8_TARGET_ARCH_X64
+  // Only the x64 record write stub knows about the insertion barrier that
+  // is needed while the helper thread is running.
+  return FLAG_concurrent_marking;
+#else
+  return false;
+#endif
+}
+
+
+void ConcurrentMarker::Start() {
+  ASSERT(!IsRunning());
+  ASSERT(idle_ && work_.is_empty() && shared_work_.is_empty());
+  if (thread_ == NULL) {
+    thread_ = new GCHelperThread(heap_->isolate(), "ConcurrentMarkerThread",
+                                 this, 0);
+    thread_->Start();
+  }
+  NoBarrier_Store(&pause_requested_, static_cast<AtomicWord>(false));
+  Release_Store(&active_, static_cast<AtomicWord>(true));
+  thread_->StartTask();
+}
+
+
+void ConcurrentMarker::Pause() {
+  if (!IsRunning()) return;
+  Release_Store(&pause_requested_, static_cast<AtomicWord>(true));
+  thread_->WaitForTask();
+  NoBarrier_Store(&active_, static_cast<AtomicWord>(false));
+
+  // The helper thread has published its deferred work before returning.
+  ASSERT(local_deferred_objects_.is_empty());
+  ASSERT(local_recorded_slots_.is_empty());
+  TakeDeferredObjects();
+  ReturnToMarkingDeque(&deferred_objects_);
+  ReturnToMarkingDeque(&shared_work_);
+  ReturnToMarkingDeque(&work_);
+  idle_ = true;
+}
+
+
+void ConcurrentMarker::TearDown() {
+  Pause();
+  if (thread_ != NULL) {
+    thread_->Stop();
+    delete thread_;
+    thread_ = NULL;
+  }
+  shared_work_.Free();
+  shared_deferred_objects_.Free();
+  shared_recorded_slots_.Free();
+  work_.Free();
+  local_deferred_objects_.Free();
+  local_recorded_slots_.Free();
+  deferred_objects_.Free();
+  slots_to_record_.Free();
+}
+
+
+void ConcurrentMarker::ReturnToMarkingDeque(List<HeapObject*>* objects) {
+  // If the objects do not fit on the marking deque they are rediscovered
+  // after the deque overflowed, because they are grey.
+  MarkingDeque* marking_deque = marking_->marking_deque();
+  while (!objects->is_empty()) {
+    marking_deque->PushGrey(objects->RemoveLast());
+  }
+}
+
+
+void ConcurrentMarker::HandOffWork(MarkingDeque* marking_deque) {
+  ASSERT(IsRunning());
+  ScopedLock lock(mutex_);
+  if (!shared_work_.is_empty()) return;
+  for (int i = 0; i < kHandOffSize && !marking_deque->IsEmpty(); i++) {
+    shared_work_.Add(marking_deque->Pop());
+  }
+}
+
+
+List<HeapObject*>* ConcurrentMarker::TakeDeferredObjects() {
+  { ScopedLock lock(mutex_);
+    deferred_objects_.AddAll(shared_deferred_objects_);
+    shared_deferred_objects_.Rewind(0);
+    slots_to_record_.AddAll(shared_recorded_slots_);
+    shared_recorded_slots_.Rewind(0);
+  }
+  RecordSlots(&slots_to_record_);
+  return &deferred_objects_;
+}
+
+
+bool ConcurrentMarker::IsIdle() {
+  ScopedLock lock(mutex_);
+  return idle_ &&
+      shared_work_.is_empty() &&
+      shared_deferred_objects_.is_empty() &&
+      shared_recorded_slots_.is_empty();
+}
+
+
+void ConcurrentMarker::RecordSlots(List<Object**>* slots) {
+  // The slots may have been overwritten since the helper thread saw them.
+  // Stores of pointers to evacuation candidates into black objects have
+  // been recorded by the write barrier.
+  MarkCompactCollector* collector = heap_->mark_compact_collector();
+  for (int i = 0; i < slots->length(); i++) {
+    Object** slot = slots->at(i);
+    Object* value = *slot;
+    if (value->NonFailureIsHeapObject()) {
+      collector->RecordSlot(slot, slot, value);
+    }
+  }
+  slots->Rewind(0);
+}
+
+
+void ConcurrentMarker::RunTask(int task_id) {
+  ASSERT(task_id == 0);
+  while (!Acquire_Load(&pause_requested_)) {
+    if (!MarkBatch()) OS::Sleep(1);
+  }
+}
+
+
+bool ConcurrentMarker::MarkBatch() {
+  if (work_.is_empty()) {
+    ScopedLock lock(mutex_);
+    if (shared_work_.is_empty()) {
+      idle_ = true;
+      return false;
+    }
+    idle_ = false;
+    work_.AddAll(shared_work_);
+    shared_work_.Rewind(0);
+  }
+  for (int i = 0; i < kBatchSize && !work_.is_empty(); i++) {
+    if (Acquire_Load(&pause_requested_)) break;
+    VisitObject(work_.RemoveLast());
+  }
+  PublishDeferredWork();
+  return true;
+}
+
+
+void ConcurrentMarker::PublishDeferredWork() {
+  if (local_deferred_objects_.is_empty() && local_recorded_slots_.is_empty()) {
+    return;
+  }
+  ScopedLock lock(mutex_);
+  shared_deferred_objects_.AddAll(local_deferred_objects_);
+  local_deferred_objects_.Rewind(0);
+  shared_recorded_slots_.AddAll(local_recorded_slots_);
+  local_recorded_slots_.Rewind(0);
+}
+
+
+void ConcurrentMarker::VisitObject(HeapObject* object) {
+  MemoryChunk* chunk = MemoryChunk::FromAddress(object->address());
+  ChunkLockScope lock(chunk);
+
+  // Skip fillers.  They are left behind when an object on a work list is
+  // trimmed in place.
+  Map* map = object->map();
+  if (map == heap_->one_pointer_filler_map() ||
+      map == heap_->two_pointer_filler_map() ||
+      map == heap_->free_space_map()) {
+    return;
+  }
+
+  int start_offset;
+  int end_offset;
+  int size = object->SizeFromMap(map);
+  int id = map->visitor_id();
+  switch (id) {
+    case StaticVisitorBase::kVisitShortcutCandidate:
+    case StaticVisitorBase::kVisitConsString:
+      start_offset = ConsString::BodyDescriptor::kStartOffset;
+      end_offset = ConsString::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitSlicedString:
+      if (FLAG_rescue_string_slices) {
+        // The main thread records slices whose parents may be freed, see
+        // MarkCompactCollector::RecordSliceCandidate.
+        local_deferred_objects_.Add(object);
+        return;
+      }
+      start_offset = SlicedString::BodyDescriptor::kStartOffset;
+      end_offset = SlicedString::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitOddball:
+      start_offset = Oddball::BodyDescriptor::kStartOffset;
+      end_offset = Oddball::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitPropertyCell:
+      start_offset = JSGlobalPropertyCell::BodyDescriptor::kStartOffset;
+      end_offset = JSGlobalPropertyCell::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitFixedArray:
+      start_offset = FixedArray::BodyDescriptor::kStartOffset;
+      end_offset = size;
+      break;
+    case StaticVisitorBase::kVisitFixedDoubleArray:
+    case StaticVisitorBase::kVisitByteArray:
+    case StaticVisitorBase::kVisitSeqAsciiString:
+    case StaticVisitorBase::kVisitSeqTwoByteString:
+      start_offset = end_offset = 0;
+      break;
+    default:
+      if (id >= StaticVisitorBase::kVisitDataObject &&
+          id <= StaticVisitorBase::kVisitDataObjectGeneric) {
+        start_offset = end_offset = 0;
+      } else if (id >= StaticVisitorBase::kVisitJSObject &&
+                 id <= StaticVisitorBase::kVisitJSObjectGeneric) {
+        start_offset = JSObject::BodyDescriptor::kStartOffset;
+        end_offset = size;
+      } else if (id >= StaticVisitorBase::kVisitStruct &&
+                 id <= StaticVisitorBase::kVisitStructGeneric) {
+        start_offset = StructBodyDescriptor::kStartOffset;
+        end_offset = size;
+      } else {
+        // The object needs the incremental marking visitor, which may clear
+        // caches and inline caches or treat some of its fields as weak.  It
+        // stays grey until the main thread visits it.
+        local_deferred_objects_.Add(object);
+        return;
+      }
+      break;
+  }
+
+  MarkObject(map, chunk);
+
+  if (start_offset < end_offset) {
+    VisitPointers(object, chunk, start_offset, end_offset);
+  }
+
+  MarkBit mark_bit = Marking::MarkBitFrom(object);
+  SLOW_ASSERT(Marking::IsGrey(mark_bit));
+  Marking::GreyToBlackAtomically(mark_bit);
+  MemoryChunk::IncrementLiveBytesFromGCAtomically(object->address(), size);
+}
+
+
+void ConcurrentMarker::VisitPointers(HeapObject* object,
+                                     MemoryChunk* chunk,
+                                     int start_offset,
+                                     int end_offset) {
+  bool record_slots = marking_->IsCompacting();
+  Object** start = HeapObject::RawField(object, start_offset);
+  Object** end = HeapObject::RawField(object, end_offset);
+  for (Object** slot = start; slot < end; slot++) {
+    Object* value = *slot;
+    if (!value->NonFailureIsHeapObject()) continue;
+    HeapObject* heap_object = HeapObject::cast(value);
+    if (record_slots &&
+        Page::FromAddress(heap_object->address())->IsEvacuationCandidate()) {
+      local_recorded_slots_.Add(slot);
+    }
+    MarkObject(heap_object, chunk);
+  }
+}
+
+
+void ConcurrentMarker::MarkObject(HeapObject* object,
+                                  MemoryChunk* locked_chunk) {
+  MarkBit mark_bit = Marking::MarkBitFrom(object);
+  if (!Marking::IsWhite(mark_bit)) return;
+
+  // The object is claimed under the lock of its chunk, so that the main
+  // thread never sees it half grey while it holds the lock.
+  MemoryChunk* chunk = MemoryChunk::FromAddress(object->address());
+  bool claimed;
+  if (chunk == locked_chunk) {
+    claimed = Marking::WhiteToGreyAtomically(mark_bit);
+  } else {
+    ChunkLockScope lock(chunk);
+    claimed = Marking::WhiteToGreyAtomically(mark_bit);
+  }
+  if (claimed) work_.Add(object);
+}
+
+
+void ConcurrentMarkingScope::Lock(HeapObject* object) {
+  chunk_ = MemoryChunk::FromAddress(object->address());
+  chunk_->LockForConcurrentMarking();
+}
+
+
+void ConcurrentMarkingScope::Unlock() {
+  chunk_->UnlockForConcurrentMarking();
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,205 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_CONCURRENT_MARKER_H_
+#define V8_CONCURRENT_MARKER_H_
+
+#include "atomicops.h"
+#include "gc-helper-thread.h"
+#include "list.h"
+#include "platform.h"
+
+namespace v8 {
+namespace internal {
+
+class Heap;
+class HeapObject;
+class IncrementalMarking;
+class MarkingDeque;
+class MemoryChunk;
+class Object;
+
+// The concurrent marker does part of the transitive marking of the
+// incremental marker on a helper thread while JavaScript runs, so that the
+// mutator does not have to do all of it in its allocation steps.
+//
+// The marking steps of the main thread hand grey objects from the marking
+// deque to the helper thread.  The helper thread keeps the objects it
+// discovers on a work list of its own, so the marking deque stays private
+// to the main thread.  The two threads share only a few short lists for
+// handing work back and forth, which are protected by a mutex that is never
+// held while visiting objects.
+//
+// Objects are synchronized per chunk instead.  The helper thread holds the
+// lock of the chunk of an object while it visits the object, and while it
+// makes a white object on the chunk grey.  The main thread holds the lock of
+// the chunk of an object while it changes the layout of the object in place
+// (see ConcurrentMarkingScope).  Mark bits of different objects can share a
+// cell of the marking bitmap, so both threads change mark bits and live
+// bytes with atomic operations while the helper thread is running.
+//
+// The incremental write barrier marks the stored value in addition to
+// rescanning black hosts, because the helper thread may be visiting the
+// host concurrently.  The record write stubs check the word at
+// active_address() to do the same.
+//
+// Only objects whose bodies are plain ranges of tagged fields are visited
+// on the helper thread.  Maps, code, functions, shared function infos,
+// global contexts, sliced strings and the like stay grey and are left to
+// the main thread, which visits them in its marking steps.  The helper thread does not
+// record slots for compaction either; it leaves them to the main thread.
+//
+// The marker is paused for every garbage collection and restarted by the
+// next marking step.  When it is paused, the objects it has not visited yet
+// are returned to the marking deque.
+class ConcurrentMarker : public GCHelperThread::Task {
+ public:
+  // Number of objects visited by the helper thread between two hand-offs
+  // of deferred work to the main thread.
+  static const int kBatchSize = 64;
+
+  // Maximal number of objects handed to the helper thread by a marking step.
+  static const int kHandOffSize = 256;
+
+  ConcurrentMarker(Heap* heap, IncrementalMarking* marking);
+  ~ConcurrentMarker();
+
+  // Returns whether incremental marking should use the concurrent marker.
+  static bool CanMarkConcurrently();
+
+  bool IsRunning() { return NoBarrier_Load(&active_) != 0; }
+
+  // Address of a word that is non-zero while the helper thread is marking.
+  // Read by the record write stubs.
+  Address active_address() {
+    return reinterpret_cast<Address>(const_cast<AtomicWord*>(&active_));
+  }
+
+  // Starts the helper thread.  It marks the objects handed to it by
+  // HandOffWork().
+  void Start();
+
+  // Stops the helper thread and moves the objects it has not visited back
+  // to the marking deque.
+  void Pause();
+
+  // Pauses marking and shuts down the helper thread.
+  void TearDown();
+
+  // Entry point of the helper thread.  Marks until the marker is paused.
+  virtual void RunTask(int task_id);
+
+  // Called by the main thread.  Moves grey objects from the marking deque
+  // to the helper thread if the helper thread is running out of work.
+  void HandOffWork(MarkingDeque* marking_deque);
+
+  // Called by the main thread.  Records the slots the helper thread left to
+  // the main thread and returns the grey objects that have to be visited by
+  // the main thread.
+  List<HeapObject*>* TakeDeferredObjects();
+
+  // Returns whether the helper thread has run out of work and has nothing
+  // left for the main thread.
+  bool IsIdle();
+
+ private:
+  // Visits a batch of objects from the work list of the helper thread.
+  // Returns false if there was nothing to do.
+  bool MarkBatch();
+
+  // Makes the objects and slots left to the main thread available to it.
+  void PublishDeferredWork();
+
+  // Moves grey objects to the marking deque.
+  void ReturnToMarkingDeque(List<HeapObject*>* objects);
+
+  void RecordSlots(List<Object**>* slots);
+
+  void VisitObject(HeapObject* object);
+  void VisitPointers(HeapObject* object,
+                     MemoryChunk* chunk,
+                     int start_offset,
+                     int end_offset);
+  void MarkObject(HeapObject* object, MemoryChunk* locked_chunk);
+
+  Heap* heap_;
+  IncrementalMarking* marking_;
+  GCHelperThread* thread_;
+
+  // Protects the lists shared between the threads and idle_.
+  Mutex* mutex_;
+  List<HeapObject*> shared_work_;
+  List<HeapObject*> shared_deferred_objects_;
+  List<Object**> shared_recorded_slots_;
+  bool idle_;
+
+  // Owned by the helper thread while it is running.
+  List<HeapObject*> work_;
+  List<HeapObject*> local_deferred_objects_;
+  List<Object**> local_recorded_slots_;
+
+  // Owned by the main thread.
+  List<HeapObject*> deferred_objects_;
+  List<Object**> slots_to_record_;
+
+  // Non-zero while the helper thread is marking, see active_address().
+  volatile AtomicWord active_;
+
+  // Set by the main thread to make the helper thread return from RunTask().
+  volatile AtomicWord pause_requested_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentMarker);
+};
+
+
+// Holds the lock of the chunk of an object while the concurrent marker is
+// running.  The main thread uses it around in-place changes of the layout
+// of the object, and where it has to see a colour of the object that the
+// helper thread does not change concurrently.  Scopes must not be nested.
+class ConcurrentMarkingScope {
+ public:
+  ConcurrentMarkingScope(ConcurrentMarker* marker, HeapObject* object)
+      : chunk_(NULL) {
+    if (marker->IsRunning()) Lock(object);
+  }
+
+  ~ConcurrentMarkingScope() {
+    if (chunk_ != NULL) Unlock();
+  }
+
+ private:
+  void Lock(HeapObject* object);
+  void Unlock();
+
+  MemoryChunk* chunk_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentMarkingScope);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_CONCURRENT_MARKER_H_
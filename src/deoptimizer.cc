@@ -199,8 +199,8 @@ DeoptimizedFrameInfo* Deoptimizer::DebuggerInspectableFrame(
   // Done with the GC-unsafe frame descriptions. This re-enables allocation.
   deoptimizer->DeleteFrameDescriptions();
 
-  // Allocate a heap number for the doubles belonging to this frame.
-  deoptimizer->MaterializeHeapNumbersForDebuggerInspectableFrame(
+  // Allocate the heap numbers and objects belonging to this frame.
+  deoptimizer->MaterializeHeapObjectsForDebuggerInspectableFrame(
       parameters_top, parameters_size, expressions_top, expressions_size, info);
 
   // Finished using the deoptimizer instance.
@@ -234,6 +234,11 @@ class DeoptimizingVisitor : public OptimizedFunctionVisitor {
       PrintF("[deoptimize context: %" V8PRIxPTR "]\n",
              reinterpret_cast<intptr_t>(context));
     }
+    // Code still being optimized for the context would be stale as well.
+    if (FLAG_parallel_recompilation) {
+      context->GetIsolate()->optimizing_compiler_thread()->CancelContext(
+          context);
+    }
   }
 
   virtual void VisitFunction(JSFunction* function) {
@@ -368,7 +373,11 @@ Deoptimizer::Deoptimizer(Isolate* isolate,
       output_count_(0),
       jsframe_count_(0),
       output_(NULL),
-      deferred_heap_numbers_(0) {
+      deferred_heap_numbers_(0),
+      deferred_objects_(0),
+      deferred_object_values_(0),
+      deferred_object_doubles_(0),
+      deferred_object_slots_(0) {
   if (FLAG_trace_deopt && type != OSR) {
     if (type == DEBUGGER) {
       PrintF("**** DEOPT FOR DEBUGGER: ");
@@ -617,25 +626,63 @@ void Deoptimizer::DoComputeOutputFrames() {
 }
 
 
-void Deoptimizer::MaterializeHeapNumbers() {
+void Deoptimizer::MaterializeCapturedObjects(List<Handle<Object> >* objects) {
+  // The field values may be raw pointers into the heap, so they are all put
+  // into handles before anything is allocated.
+  List<Handle<Object> > values(deferred_object_values_.length());
+  for (int i = 0; i < deferred_object_values_.length(); i++) {
+    values.Add(Handle<Object>(deferred_object_values_[i], isolate_));
+  }
+  for (int i = 0; i < deferred_object_doubles_.length(); i++) {
+    HeapNumberMaterializationDescriptor<int> d = deferred_object_doubles_[i];
+    values[d.destination()] = isolate_->factory()->NewNumber(d.value());
+  }
+
+  for (int i = 0; i < deferred_objects_.length(); i++) {
+    CapturedObjectDescriptor d = deferred_objects_[i];
+    Handle<Map> map = Handle<Map>::cast(values[d.first_value()]);
+    Handle<JSObject> object = isolate_->factory()->NewJSObjectFromMap(map);
+    for (int j = 0; j < d.field_count(); j++) {
+      object->InObjectPropertyAtPut(j, *values[d.first_value() + 1 + j]);
+    }
+    if (FLAG_trace_deopt) {
+      PrintF("Materializing captured object #%d %p with %d fields\n",
+             i,
+             reinterpret_cast<void*>(*object),
+             d.field_count());
+    }
+    objects->Add(object);
+  }
+}
+
+
+void Deoptimizer::MaterializeHeapObjects() {
   ASSERT_NE(DEBUGGER, bailout_type_);
+  List<Handle<Object> > objects(deferred_objects_.length());
+  MaterializeCapturedObjects(&objects);
+
   for (int i = 0; i < deferred_heap_numbers_.length(); i++) {
-    HeapNumberMaterializationDescriptor d = deferred_heap_numbers_[i];
+    HeapNumberMaterializationDescriptor<Address> d = deferred_heap_numbers_[i];
     Handle<Object> num = isolate_->factory()->NewNumber(d.value());
     if (FLAG_trace_deopt) {
       PrintF("Materializing a new heap number %p [%e] in slot %p\n",
              reinterpret_cast<void*>(*num),
              d.value(),
-             d.slot_address());
+             d.destination());
     }
 
-    Memory::Object_at(d.slot_address()) = *num;
+    Memory::Object_at(d.destination()) = *num;
+  }
+
+  for (int i = 0; i < deferred_object_slots_.length(); i++) {
+    ObjectMaterializationDescriptor d = deferred_object_slots_[i];
+    Memory::Object_at(d.slot_address()) = *objects[d.object_index()];
   }
 }
 
 
 #ifdef ENABLE_DEBUGGER_SUPPORT
-void Deoptimizer::MaterializeHeapNumbersForDebuggerInspectableFrame(
+void Deoptimizer::MaterializeHeapObjectsForDebuggerInspectableFrame(
     Address parameters_top,
     uint32_t parameters_size,
     Address expressions_top,
@@ -644,12 +691,15 @@ void Deoptimizer::MaterializeHeapNumbersForDebuggerInspectableFrame(
   ASSERT_EQ(DEBUGGER, bailout_type_);
   Address parameters_bottom = parameters_top + parameters_size;
   Address expressions_bottom = expressions_top + expressions_size;
+  List<Handle<Object> > objects(deferred_objects_.length());
+  MaterializeCapturedObjects(&objects);
+
   for (int i = 0; i < deferred_heap_numbers_.length(); i++) {
-    HeapNumberMaterializationDescriptor d = deferred_heap_numbers_[i];
+    HeapNumberMaterializationDescriptor<Address> d = deferred_heap_numbers_[i];
 
     // Check of the heap number to materialize actually belong to the frame
     // being extracted.
-    Address slot = d.slot_address();
+    Address slot = d.destination();
     if (parameters_top <= slot && slot < parameters_bottom) {
       Handle<Object> num = isolate_->factory()->NewNumber(d.value());
 
@@ -661,7 +711,7 @@ void Deoptimizer::MaterializeHeapNumbersForDebuggerInspectableFrame(
                "for parameter slot #%d\n",
                reinterpret_cast<void*>(*num),
                d.value(),
-               d.slot_address(),
+               d.destination(),
                index);
       }
 
@@ -677,13 +727,28 @@ void Deoptimizer::MaterializeHeapNumbersForDebuggerInspectableFrame(
                "for expression slot #%d\n",
                reinterpret_cast<void*>(*num),
                d.value(),
-               d.slot_address(),
+               d.destination(),
                index);
       }
 
       info->SetExpression(index, *num);
     }
   }
+
+  for (int i = 0; i < deferred_object_slots_.length(); i++) {
+    ObjectMaterializationDescriptor d = deferred_object_slots_[i];
+    Address slot = d.slot_address();
+    Object* object = *objects[d.object_index()];
+    if (parameters_top <= slot && slot < parameters_bottom) {
+      int index = (info->parameters_count() - 1) -
+          static_cast<int>(slot - parameters_top) / kPointerSize;
+      info->SetParameter(index, object);
+    } else if (expressions_top <= slot && slot < expressions_bottom) {
+      int index = info->expression_count() - 1 -
+          static_cast<int>(slot - expressions_top) / kPointerSize;
+      info->SetExpression(index, object);
+    }
+  }
 }
 #endif
 
@@ -870,6 +935,140 @@ void Deoptimizer::DoTranslateCommand(TranslationIterator* iterator,
       output_[frame_index]->SetFrameSlot(output_offset, value);
       return;
     }
+
+    case Translation::CAPTURED_OBJECT: {
+      int map_index = iterator->Next();
+      int field_count = iterator->Next();
+      int object_index = deferred_objects_.length();
+      if (FLAG_trace_deopt) {
+        PrintF("    0x%08" V8PRIxPTR ": [top + %d] <- captured object #%d"
+               " with %d fields\n",
+               output_[frame_index]->GetTop() + output_offset,
+               output_offset,
+               object_index,
+               field_count);
+      }
+      deferred_objects_.Add(
+          CapturedObjectDescriptor(deferred_object_values_.length(),
+                                   field_count));
+      deferred_object_values_.Add(ComputeLiteral(map_index));
+      for (int i = 0; i < field_count; i++) {
+        DoTranslateObjectField(iterator);
+      }
+      // The object is allocated after the frames have been built.
+      deferred_object_slots_.Add(ObjectMaterializationDescriptor(
+          reinterpret_cast<Address>(output_[frame_index]->GetTop()) +
+              output_offset,
+          object_index));
+      output_[frame_index]->SetFrameSlot(output_offset, kPlaceholder);
+      return;
+    }
+
+    case Translation::DUPLICATED_OBJECT: {
+      int object_index = iterator->Next();
+      if (FLAG_trace_deopt) {
+        PrintF("    0x%08" V8PRIxPTR ": [top + %d] <- captured object #%d\n",
+               output_[frame_index]->GetTop() + output_offset,
+               output_offset,
+               object_index);
+      }
+      deferred_object_slots_.Add(ObjectMaterializationDescriptor(
+          reinterpret_cast<Address>(output_[frame_index]->GetTop()) +
+              output_offset,
+          object_index));
+      output_[frame_index]->SetFrameSlot(output_offset, kPlaceholder);
+      return;
+    }
+  }
+}
+
+
+void Deoptimizer::DoTranslateObjectField(TranslationIterator* iterator) {
+  int value_index = deferred_object_values_.length();
+  // Numbers that do not fit a smi are allocated later.
+  bool is_heap_number = false;
+  double number = 0;
+  Object* value = NULL;
+
+  Translation::Opcode opcode =
+      static_cast<Translation::Opcode>(iterator->Next());
+  switch (opcode) {
+    case Translation::REGISTER:
+      value = reinterpret_cast<Object*>(
+          input_->GetRegister(iterator->Next()));
+      break;
+
+    case Translation::INT32_REGISTER: {
+      int32_t int32_value =
+          static_cast<int32_t>(input_->GetRegister(iterator->Next()));
+      if (Smi::IsValid(int32_value)) {
+        value = Smi::FromInt(int32_value);
+      } else {
+        is_heap_number = true;
+        number = int32_value;
+      }
+      break;
+    }
+
+    case Translation::DOUBLE_REGISTER:
+      is_heap_number = true;
+      number = input_->GetDoubleRegister(iterator->Next());
+      break;
+
+    case Translation::STACK_SLOT: {
+      unsigned input_offset = input_->GetOffsetFromSlotIndex(iterator->Next());
+      value = reinterpret_cast<Object*>(input_->GetFrameSlot(input_offset));
+      break;
+    }
+
+    case Translation::INT32_STACK_SLOT: {
+      unsigned input_offset = input_->GetOffsetFromSlotIndex(iterator->Next());
+      int32_t int32_value =
+          static_cast<int32_t>(input_->GetFrameSlot(input_offset));
+      if (Smi::IsValid(int32_value)) {
+        value = Smi::FromInt(int32_value);
+      } else {
+        is_heap_number = true;
+        number = int32_value;
+      }
+      break;
+    }
+
+    case Translation::DOUBLE_STACK_SLOT: {
+      unsigned input_offset = input_->GetOffsetFromSlotIndex(iterator->Next());
+      is_heap_number = true;
+      number = input_->GetDoubleFrameSlot(input_offset);
+      break;
+    }
+
+    case Translation::LITERAL:
+      value = ComputeLiteral(iterator->Next());
+      break;
+
+    default:
+      // Fields are never captured objects or the arguments object.
+      UNREACHABLE();
+      return;
+  }
+
+  if (is_heap_number) {
+    // Store a GC-safe placeholder until the heap number is allocated.
+    deferred_object_doubles_.Add(
+        HeapNumberMaterializationDescriptor<int>(value_index, number));
+    value = Smi::FromInt(0);
+  }
+  deferred_object_values_.Add(value);
+}
+
+
+void Deoptimizer::CopyObjectSlot(Address from, Address to) {
+  for (int i = 0; i < deferred_object_slots_.length(); i++) {
+    ObjectMaterializationDescriptor d = deferred_object_slots_[i];
+    if (d.slot_address() == from) {
+      deferred_object_slots_.Add(
+          ObjectMaterializationDescriptor(to, d.object_index()));
+      return;
+    }
   }
 }
 
@@ -1045,6 +1244,12 @@ bool Deoptimizer::DoOsrTranslateCommand(TranslationIterator* iterator,
       UNREACHABLE();
       return false;
     }
+
+    case Translation::CAPTURED_OBJECT:
+    case Translation::DUPLICATED_OBJECT:
+      // Escape analysis is disabled for code with an OSR entry.
+      UNREACHABLE();
+      return false;
   }
 
   if (!duplicate) *input_offset -= kPointerSize;
@@ -1151,7 +1356,7 @@ Object* Deoptimizer::ComputeLiteral(int index) const {
 
 void Deoptimizer::AddDoubleValue(intptr_t slot_address,
                                  double value) {
-  HeapNumberMaterializationDescriptor value_desc(
+  HeapNumberMaterializationDescriptor<Address> value_desc(
       reinterpret_cast<Address>(slot_address), value);
   deferred_heap_numbers_.Add(value_desc);
 }
@@ -1318,6 +1523,22 @@ void TranslationBuffer::Add(int32_t value, Zone* zone) {
 }
 
 
+void TranslationIterator::SkipCommand() {
+  Translation::Opcode opcode = static_cast<Translation::Opcode>(Next());
+  if (opcode == Translation::DUPLICATE) {
+    SkipCommand();
+    opcode = static_cast<Translation::Opcode>(Next());
+  }
+  if (opcode == Translation::CAPTURED_OBJECT) {
+    Next();  // Drop map literal id.
+    int field_count = Next();
+    for (int i = 0; i < field_count; i++) SkipCommand();
+  } else {
+    Skip(Translation::NumberOfOperandsFor(opcode));
+  }
+}
+
+
 int32_t TranslationIterator::Next() {
   // Run through the bytes until we reach one with a least significant
   // bit of zero (marks the end).
@@ -1413,6 +1634,24 @@ void Translation::StoreArgumentsObject() {
 }
 
 
+void Translation::BeginCapturedObject(int capture_id,
+                                      int map_literal_id,
+                                      int length) {
+  object_ids_.Add(capture_id, zone());
+  buffer_->Add(CAPTURED_OBJECT, zone());
+  buffer_->Add(map_literal_id, zone());
+  buffer_->Add(length, zone());
+}
+
+
+void Translation::DuplicateObject(int capture_id) {
+  int object_index = 0;
+  while (object_ids_[object_index] != capture_id) object_index++;
+  buffer_->Add(DUPLICATED_OBJECT, zone());
+  buffer_->Add(object_index, zone());
+}
+
+
 void Translation::MarkDuplicate() {
   buffer_->Add(DUPLICATE, zone());
 }
@@ -1430,10 +1669,12 @@ int Translation::NumberOfOperandsFor(Opcode opcode) {
     case INT32_STACK_SLOT:
     case DOUBLE_STACK_SLOT:
     case LITERAL:
+    case DUPLICATED_OBJECT:
       return 1;
     case BEGIN:
     case ARGUMENTS_ADAPTOR_FRAME:
     case CONSTRUCT_STUB_FRAME:
+    case CAPTURED_OBJECT:
       return 2;
     case JS_FRAME:
       return 3;
@@ -1471,6 +1712,10 @@ const char* Translation::StringFor(Opcode opcode) {
       return "LITERAL";
     case ARGUMENTS_OBJECT:
       return "ARGUMENTS_OBJECT";
+    case CAPTURED_OBJECT:
+      return "CAPTURED_OBJECT";
+    case DUPLICATED_OBJECT:
+      return "DUPLICATED_OBJECT";
     case DUPLICATE:
       return "DUPLICATE";
   }
@@ -1502,7 +1747,8 @@ DeoptimizingCodeListNode::~DeoptimizingCodeListNode() {
 // Thus we build a temporary structure in malloced space.
 SlotRef SlotRef::ComputeSlotForNextArgument(TranslationIterator* iterator,
                                             DeoptimizationInputData* data,
-                                            JavaScriptFrame* frame) {
+                                            int translation_index,
+                                            Address fp) {
   Translation::Opcode opcode =
       static_cast<Translation::Opcode>(iterator->Next());
 
@@ -1529,19 +1775,19 @@ SlotRef SlotRef::ComputeSlotForNextArgument(TranslationIterator* iterator,
 
     case Translation::STACK_SLOT: {
       int slot_index = iterator->Next();
-      Address slot_addr = SlotAddress(frame, slot_index);
+      Address slot_addr = SlotAddress(fp, slot_index);
       return SlotRef(slot_addr, SlotRef::TAGGED);
     }
 
     case Translation::INT32_STACK_SLOT: {
       int slot_index = iterator->Next();
-      Address slot_addr = SlotAddress(frame, slot_index);
+      Address slot_addr = SlotAddress(fp, slot_index);
       return SlotRef(slot_addr, SlotRef::INT32);
     }
 
     case Translation::DOUBLE_STACK_SLOT: {
       int slot_index = iterator->Next();
-      Address slot_addr = SlotAddress(frame, slot_index);
+      Address slot_addr = SlotAddress(fp, slot_index);
       return SlotRef(slot_addr, SlotRef::DOUBLE);
     }
 
@@ -1549,6 +1795,28 @@ SlotRef SlotRef::ComputeSlotForNextArgument(TranslationIterator* iterator,
       int literal_index = iterator->Next();
       return SlotRef(data->LiteralArray()->get(literal_index));
     }
+
+    case Translation::CAPTURED_OBJECT: {
+      SlotRef result(data, fp, iterator->index());
+      iterator->Next();  // Drop map literal id.
+      int field_count = iterator->Next();
+      for (int i = 0; i < field_count; i++) iterator->SkipCommand();
+      return result;
+    }
+
+    case Translation::DUPLICATED_OBJECT: {
+      // Find the command describing the object.
+      int object_index = iterator->Next();
+      TranslationIterator it(data->TranslationByteArray(), translation_index);
+      while (true) {
+        Translation::Opcode opcode =
+            static_cast<Translation::Opcode>(it.Next());
+        if (opcode == Translation::CAPTURED_OBJECT) {
+          if (object_index-- == 0) return SlotRef(data, fp, it.index());
+        }
+        it.Skip(Translation::NumberOfOperandsFor(opcode));
+      }
+    }
   }
 
   UNREACHABLE();
@@ -1559,17 +1827,46 @@ SlotRef SlotRef::ComputeSlotForNextArgument(TranslationIterator* iterator,
 void SlotRef::ComputeSlotsForArguments(Vector<SlotRef>* args_slots,
                                        TranslationIterator* it,
                                        DeoptimizationInputData* data,
-                                       JavaScriptFrame* frame) {
+                                       int translation_index,
+                                       Address fp) {
   // Process the translation commands for the arguments.
 
   // Skip the translation command for the receiver.
-  it->Skip(Translation::NumberOfOperandsFor(
-      static_cast<Translation::Opcode>(it->Next())));
+  it->SkipCommand();
 
   // Compute slots for arguments.
   for (int i = 0; i < args_slots->length(); ++i) {
-    (*args_slots)[i] = ComputeSlotForNextArgument(it, data, frame);
+    (*args_slots)[i] =
+        ComputeSlotForNextArgument(it, data, translation_index, fp);
+  }
+}
+
+
+Handle<Object> SlotRef::GetCapturedObject() {
+  Isolate* isolate = Isolate::Current();
+  Handle<DeoptimizationInputData> data =
+      Handle<DeoptimizationInputData>::cast(literal_);
+  Handle<Map> map;
+  Vector<SlotRef> fields;
+  {
+    AssertNoAllocation no_gc;
+    TranslationIterator it(data->TranslationByteArray(), translation_index_);
+    map = Handle<Map>(Map::cast(data->LiteralArray()->get(it.Next())));
+    fields = Vector<SlotRef>::New(it.Next());
+    for (int i = 0; i < fields.length(); ++i) {
+      // Fields never refer to other captured objects.
+      fields[i] = ComputeSlotForNextArgument(&it, *data, -1, addr_);
+    }
+  }
+
+  // Each access creates a new copy of the object.
+  Handle<JSObject> object = isolate->factory()->NewJSObjectFromMap(map);
+  for (int i = 0; i < fields.length(); ++i) {
+    Handle<Object> value = fields[i].GetValue();
+    object->InObjectPropertyAtPut(i, *value);
   }
+  fields.Dispose();
+  return object;
 }
 
 
@@ -1581,8 +1878,8 @@ Vector<SlotRef> SlotRef::ComputeSlotMappingForArguments(
   int deopt_index = AstNode::kNoNumber;
   DeoptimizationInputData* data =
       static_cast<OptimizedFrame*>(frame)->GetDeoptimizationData(&deopt_index);
-  TranslationIterator it(data->TranslationByteArray(),
-                         data->TranslationIndex(deopt_index)->value());
+  int translation_index = data->TranslationIndex(deopt_index)->value();
+  TranslationIterator it(data->TranslationByteArray(), translation_index);
   Translation::Opcode opcode = static_cast<Translation::Opcode>(it.Next());
   ASSERT(opcode == Translation::BEGIN);
   it.Next();  // Drop frame count.
@@ -1603,7 +1900,8 @@ Vector<SlotRef> SlotRef::ComputeSlotMappingForArguments(
         // inlined function in question.  Number of arguments is height - 1.
         Vector<SlotRef> args_slots =
             Vector<SlotRef>::New(height - 1);  // Minus receiver.
-        ComputeSlotsForArguments(&args_slots, &it, data, frame);
+        ComputeSlotsForArguments(
+            &args_slots, &it, data, translation_index, frame->fp());
         return args_slots;
       }
     } else if (opcode == Translation::JS_FRAME) {
@@ -1617,7 +1915,8 @@ Vector<SlotRef> SlotRef::ComputeSlotMappingForArguments(
         // format parameter count.
         Vector<SlotRef> args_slots =
             Vector<SlotRef>::New(formal_parameter_count);
-        ComputeSlotsForArguments(&args_slots, &it, data, frame);
+        ComputeSlotsForArguments(
+            &args_slots, &it, data, translation_index, frame->fp());
         return args_slots;
       }
       jsframes_to_skip--;
@@ -43,20 +43,54 @@ class TranslationIterator;
 class DeoptimizingCodeListNode;
 class DeoptimizedFrameInfo;
 
+// A heap number to be allocated for a frame slot (an Address) or for a
+// field of a captured object (the index of the field value).
+template<typename T>
 class HeapNumberMaterializationDescriptor BASE_EMBEDDED {
  public:
-  HeapNumberMaterializationDescriptor(Address slot_address, double val)
-      : slot_address_(slot_address), val_(val) { }
+  HeapNumberMaterializationDescriptor(T destination, double val)
+      : destination_(destination), val_(val) { }
 
-  Address slot_address() const { return slot_address_; }
+  T destination() const { return destination_; }
   double value() const { return val_; }
 
  private:
-  Address slot_address_;
+  T destination_;
   double val_;
 };
 
 
+// An object removed by escape analysis.  Its map and the values of its
+// fields are stored consecutively, starting at the first value.
+class CapturedObjectDescriptor BASE_EMBEDDED {
+ public:
+  CapturedObjectDescriptor(int first_value, int field_count)
+      : first_value_(first_value), field_count_(field_count) { }
+
+  int first_value() const { return first_value_; }
+  int field_count() const { return field_count_; }
+
+ private:
+  int first_value_;
+  int field_count_;
+};
+
+
+// A frame slot holding a captured object.
+class ObjectMaterializationDescriptor BASE_EMBEDDED {
+ public:
+  ObjectMaterializationDescriptor(Address slot_address, int object_index)
+      : slot_address_(slot_address), object_index_(object_index) { }
+
+  Address slot_address() const { return slot_address_; }
+  int object_index() const { return object_index_; }
+
+ private:
+  Address slot_address_;
+  int object_index_;
+};
+
+
 class OptimizedFunctionVisitor BASE_EMBEDDED {
  public:
   virtual ~OptimizedFunctionVisitor() {}
@@ -196,9 +230,11 @@ class Deoptimizer : public Malloced {
 
   ~Deoptimizer();
 
-  void MaterializeHeapNumbers();
+  // Allocates the heap numbers and the captured objects that were deferred
+  // while the output frames were computed.
+  void MaterializeHeapObjects();
 #ifdef ENABLE_DEBUGGER_SUPPORT
-  void MaterializeHeapNumbersForDebuggerInspectableFrame(
+  void MaterializeHeapObjectsForDebuggerInspectableFrame(
       Address parameters_top,
       uint32_t parameters_size,
       Address expressions_top,
@@ -287,6 +323,11 @@ class Deoptimizer : public Malloced {
   void DoTranslateCommand(TranslationIterator* iterator,
                           int frame_index,
                           unsigned output_offset);
+  // Translate the command for a field of a captured object.
+  void DoTranslateObjectField(TranslationIterator* iterator);
+  // Makes a frame slot refer to the captured object of another slot, if
+  // that one holds one.
+  void CopyObjectSlot(Address from, Address to);
   // Translate a command for OSR.  Updates the input offset to be used for
   // the next command.  Returns false if translation of the command failed
   // (e.g., a number conversion failed) and may or may not have updated the
@@ -303,6 +344,7 @@ class Deoptimizer : public Malloced {
   Object* ComputeLiteral(int index) const;
 
   void AddDoubleValue(intptr_t slot_address, double value);
+  void MaterializeCapturedObjects(List<Handle<Object> >* objects);
 
   static MemoryChunk* CreateCode(BailoutType type);
   static void GenerateDeoptimizationEntries(
@@ -337,7 +379,14 @@ class Deoptimizer : public Malloced {
   // Array of output frame descriptions.
   FrameDescription** output_;
 
-  List<HeapNumberMaterializationDescriptor> deferred_heap_numbers_;
+  List<HeapNumberMaterializationDescriptor<Address> > deferred_heap_numbers_;
+
+  // Captured objects, the values of their maps and fields, the field values
+  // that are heap numbers, and the frame slots holding the objects.
+  List<CapturedObjectDescriptor> deferred_objects_;
+  List<Object*> deferred_object_values_;
+  List<HeapNumberMaterializationDescriptor<int> > deferred_object_doubles_;
+  List<ObjectMaterializationDescriptor> deferred_object_slots_;
 
   static const int table_entry_size_;
 
@@ -547,6 +596,11 @@ class TranslationIterator BASE_EMBEDDED {
     for (int i = 0; i < n; i++) Next();
   }
 
+  // Skips the next command, including the fields of a captured object.
+  void SkipCommand();
+
+  int index() const { return index_; }
+
  private:
   ByteArray* buffer_;
   int index_;
@@ -568,6 +622,12 @@ class Translation BASE_EMBEDDED {
     DOUBLE_STACK_SLOT,
     LITERAL,
     ARGUMENTS_OBJECT,
+    // An object removed by escape analysis.  The commands for the values of
+    // its in-object fields follow.
+    CAPTURED_OBJECT,
+    // An object that an earlier CAPTURED_OBJECT command of the translation
+    // describes, given by its position among those commands.
+    DUPLICATED_OBJECT,
 
     // A prefix indicating that the next command is a duplicate of the one
     // that follows it.
@@ -578,6 +638,7 @@ class Translation BASE_EMBEDDED {
               Zone* zone)
       : buffer_(buffer),
         index_(buffer->CurrentIndex()),
+        object_ids_(0, zone),
         zone_(zone) {
     buffer_->Add(BEGIN, zone);
     buffer_->Add(frame_count, zone);
@@ -598,8 +659,14 @@ class Translation BASE_EMBEDDED {
   void StoreDoubleStackSlot(int index);
   void StoreLiteral(int literal_id);
   void StoreArgumentsObject();
+  void BeginCapturedObject(int capture_id, int map_literal_id, int length);
+  void DuplicateObject(int capture_id);
   void MarkDuplicate();
 
+  bool HasCapturedObject(int capture_id) const {
+    return object_ids_.Contains(capture_id);
+  }
+
   Zone* zone() const { return zone_; }
 
   static int NumberOfOperandsFor(Opcode opcode);
@@ -614,6 +681,8 @@ class Translation BASE_EMBEDDED {
  private:
   TranslationBuffer* buffer_;
   int index_;
+  // The capture ids of the objects described so far, in order.
+  ZoneList<int> object_ids_;
   Zone* zone_;
 };
 
@@ -645,7 +714,8 @@ class SlotRef BASE_EMBEDDED {
     TAGGED,
     INT32,
     DOUBLE,
-    LITERAL
+    LITERAL,
+    CAPTURED_OBJECT
   };
 
   SlotRef()
@@ -657,6 +727,14 @@ class SlotRef BASE_EMBEDDED {
   explicit SlotRef(Object* literal)
       : literal_(literal), representation_(LITERAL) { }
 
+  // A captured object whose fields are described by the translation
+  // commands at the given index.
+  SlotRef(DeoptimizationInputData* data, Address fp, int translation_index)
+      : addr_(fp),
+        literal_(data),
+        representation_(CAPTURED_OBJECT),
+        translation_index_(translation_index) { }
+
   Handle<Object> GetValue() {
     switch (representation_) {
       case TAGGED:
@@ -679,6 +757,9 @@ class SlotRef BASE_EMBEDDED {
       case LITERAL:
         return literal_;
 
+      case CAPTURED_OBJECT:
+        return GetCapturedObject();
+
       default:
         UNREACHABLE();
         return Handle<Object>::null();
@@ -694,26 +775,32 @@ class SlotRef BASE_EMBEDDED {
   Address addr_;
   Handle<Object> literal_;
   SlotRepresentation representation_;
+  int translation_index_;
+
+  // Allocates a copy of a captured object.
+  Handle<Object> GetCapturedObject();
 
-  static Address SlotAddress(JavaScriptFrame* frame, int slot_index) {
+  static Address SlotAddress(Address fp, int slot_index) {
     if (slot_index >= 0) {
       const int offset = JavaScriptFrameConstants::kLocal0Offset;
-      return frame->fp() + offset - (slot_index * kPointerSize);
+      return fp + offset - (slot_index * kPointerSize);
     } else {
       const int offset = JavaScriptFrameConstants::kLastParameterOffset;
-      return frame->fp() + offset - ((slot_index + 1) * kPointerSize);
+      return fp + offset - ((slot_index + 1) * kPointerSize);
     }
   }
 
   static SlotRef ComputeSlotForNextArgument(TranslationIterator* iterator,
                                             DeoptimizationInputData* data,
-                                            JavaScriptFrame* frame);
+                                            int translation_index,
+                                            Address fp);
 
   static void ComputeSlotsForArguments(
       Vector<SlotRef>* args_slots,
       TranslationIterator* iterator,
       DeoptimizationInputData* data,
-      JavaScriptFrame* frame);
+      int translation_index,
+      Address fp);
 };
 
 
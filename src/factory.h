@@ -78,6 +78,9 @@ class Factory {
 
   Handle<TypeFeedbackInfo> NewTypeFeedbackInfo();
 
+  // Allocates a pre-tenured AllocationSite without feedback.
+  Handle<AllocationSite> NewAllocationSite();
+
   Handle<String> LookupSymbol(Vector<const char> str);
   Handle<String> LookupSymbol(Handle<String> str);
   Handle<String> LookupAsciiSymbol(Vector<const char> str);
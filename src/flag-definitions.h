@@ -160,6 +160,10 @@ DEFINE_bool(clever_optimizations,
 
 // Flags for data representation optimizations
 DEFINE_bool(unbox_double_arrays, true, "automatically unbox arrays of doubles")
+DEFINE_bool(unbox_double_fields, false,
+            "update doubles stored in in-object fields in place instead of "
+            "allocating a new heap number for every store until the field "
+            "is loaded (x64 only)")
 DEFINE_bool(string_slices, true, "use string slices")
 
 // Flags for Crankshaft.
@@ -169,6 +173,10 @@ DEFINE_bool(use_range, true, "use hydrogen range analysis")
 DEFINE_bool(eliminate_dead_phis, true, "eliminate dead phis")
 DEFINE_bool(use_gvn, true, "use hydrogen global value numbering")
 DEFINE_bool(use_canonicalizing, true, "use hydrogen instruction canonicalizing")
+DEFINE_bool(use_escape_analysis, true,
+            "replace non-escaping allocations by their fields")
+DEFINE_bool(use_load_elimination, true,
+            "use hydrogen load elimination and store-to-load forwarding")
 DEFINE_bool(use_inlining, true, "use function inlining")
 DEFINE_int(max_inlined_source_size, 600,
            "maximum source size in bytes considered for a single inlining")
@@ -188,6 +196,10 @@ DEFINE_bool(trace_alloc, false, "trace register allocator")
 DEFINE_bool(trace_all_uses, false, "trace all use positions")
 DEFINE_bool(trace_range, false, "trace range analysis")
 DEFINE_bool(trace_gvn, false, "trace global value numbering")
+DEFINE_bool(trace_escape_analysis, false, "trace escape analysis")
+DEFINE_bool(trace_load_elimination, false, "trace load elimination")
+DEFINE_bool(trace_bounds_checks_hoisting, false,
+            "trace removing and hoisting bounds checks out of loops")
 DEFINE_bool(trace_representation, false, "trace representation types")
 DEFINE_bool(stress_pointer_maps, false, "pointer map for every instruction")
 DEFINE_bool(stress_environments, false, "environment for every instruction")
@@ -200,6 +212,8 @@ DEFINE_bool(polymorphic_inlining, true, "polymorphic inlining")
 DEFINE_bool(use_osr, true, "use on-stack replacement")
 DEFINE_bool(array_bounds_checks_elimination, true,
             "perform array bounds checks elimination")
+DEFINE_bool(array_bounds_checks_hoisting, true,
+            "remove or hoist bounds checks of loop induction variables")
 DEFINE_bool(array_index_dehoisting, false,
             "perform array index dehoisting")
 
@@ -221,8 +235,13 @@ DEFINE_bool(optimize_for_in, true,
 DEFINE_bool(parallel_recompilation, false,
             "optimizing hot functions asynchronously on a separate thread")
 DEFINE_bool(trace_parallel_recompilation, false, "track parallel recompilation")
-DEFINE_int(parallel_recompilation_queue_length, 2,
+DEFINE_int(parallel_recompilation_queue_length, 8,
            "the length of the parallel compilation queue")
+DEFINE_int(parallel_recompilation_threads, 2,
+           "number of threads compiling hot functions in parallel")
+DEFINE_bool(concurrent_osr, true,
+            "compile on-stack replacement code on the parallel "
+            "recompilation threads")
 
 // Experimental profiler changes.
 DEFINE_bool(experimental_profiler, true, "enable all profiler experiments")
@@ -352,6 +371,11 @@ DEFINE_bool(always_inline_smi_code, false,
 DEFINE_int(max_new_space_size, 0, "max size of the new generation (in kBytes)")
 DEFINE_int(max_old_space_size, 0, "max size of the old generation (in Mbytes)")
 DEFINE_int(max_executable_size, 0, "max size of executable memory (in Mbytes)")
+DEFINE_int(max_pooled_memory_size, 8,
+           "max size of freed heap memory kept for reuse (in Mbytes)")
+DEFINE_bool(transparent_huge_pages, false,
+            "back old space pages and large code chunks with transparent "
+            "huge pages where the OS supports them")
 DEFINE_bool(gc_global, false, "always perform global GCs")
 DEFINE_int(gc_interval, -1, "garbage collect after <n> allocations")
 DEFINE_bool(trace_gc, false,
@@ -373,8 +397,26 @@ DEFINE_bool(incremental_marking, true, "use incremental marking")
 DEFINE_bool(incremental_marking_steps, true, "do incremental marking steps")
 DEFINE_bool(trace_incremental_marking, false,
             "trace progress of the incremental marking")
+DEFINE_bool(concurrent_marking, false,
+            "use a helper thread to do incremental marking concurrently "
+            "with the mutator (x64 only)")
 DEFINE_bool(track_gc_object_stats, false,
             "track object counts and memory usage")
+DEFINE_bool(remembered_set_bitmaps, true,
+            "record the slots of pages that overflow the store buffer in "
+            "per-page bitmaps instead of rescanning the whole pages")
+DEFINE_bool(parallel_scavenge, false,
+            "use helper threads to evacuate new space during scavenges")
+DEFINE_int(scavenger_threads, 1,
+           "number of helper threads used by the parallel scavenger")
+DEFINE_bool(trace_parallel_scavenge, false,
+            "trace the work done by each parallel scavenger task")
+DEFINE_bool(allocation_site_pretenuring, false,
+            "allocate objects from literal and constructor sites whose "
+            "objects mostly survive scavenges directly in old space "
+            "(x64 only)")
+DEFINE_bool(trace_pretenuring, false,
+            "trace allocation sites that switch to old space allocation")
 
 // v8.cc
 DEFINE_bool(use_idle_notification, true,
@@ -399,10 +441,34 @@ DEFINE_bool(native_code_counters, false,
 DEFINE_bool(always_compact, false, "Perform compaction on every full GC")
 DEFINE_bool(lazy_sweeping, true,
             "Use lazy sweeping for old pointer and data spaces")
+DEFINE_bool(concurrent_sweeping, false,
+            "use sweeper threads to sweep old pointer and data spaces "
+            "concurrently with the mutator")
+DEFINE_int(sweeper_threads, 1,
+           "number of sweeper threads used by concurrent sweeping")
+DEFINE_bool(parallel_marking, false,
+            "use helper threads to mark live objects during full GCs")
+DEFINE_int(marker_threads, 1,
+           "number of helper threads used by parallel marking")
+DEFINE_bool(parallel_evacuation, false,
+            "use helper threads to evacuate pages and update pointers "
+            "during compacting GCs")
+DEFINE_int(evacuator_threads, 1,
+           "number of helper threads used by parallel evacuation")
+DEFINE_bool(string_deduplication, false,
+            "make pointers to old space strings with equal contents share "
+            "one copy during full GCs")
+DEFINE_int(string_deduplication_min_length, 16,
+           "minimum length of strings merged by string deduplication")
+DEFINE_bool(rescue_string_slices, true,
+            "copy small slices out of large strings that are only reachable "
+            "through those slices during full GCs")
 DEFINE_bool(never_compact, false,
             "Never perform compaction on full GC - testing only")
 DEFINE_bool(compact_code_space, true,
             "Compact code space on full non-incremental collections")
+DEFINE_bool(compact_map_space, false,
+            "Compact map space on full non-incremental collections")
 DEFINE_bool(cleanup_code_caches_at_gc, true,
             "Flush inline caches prior to mark compact collection and "
             "flush code caches in maps during mark compact cycle.")
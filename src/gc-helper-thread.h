@@ -0,0 +1,78 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_GC_HELPER_THREAD_H_
+#define V8_GC_HELPER_THREAD_H_
+
+#include "atomicops.h"
+#include "flags.h"
+#include "platform.h"
+
+namespace v8 {
+namespace internal {
+
+// A helper thread of the garbage collector.  It sleeps until the main
+// thread starts it, runs its task once and signals the main thread when
+// the task returns.  The parallel and concurrent phases of the collector
+// run their work on the helper threads by implementing a Task.
+class GCHelperThread : public Thread {
+ public:
+  // The work run by a helper thread each time it is started.
+  class Task {
+   public:
+    virtual ~Task() { }
+
+    // Called on the helper thread with the task id the thread was created
+    // with.
+    virtual void RunTask(int task_id) = 0;
+  };
+
+  GCHelperThread(Isolate* isolate, const char* name, Task* task, int task_id);
+  ~GCHelperThread();
+
+  void Run();
+  void Stop();
+
+  // Called by the main thread to start the task and to wait for it to
+  // return.  Every call to StartTask() has to be matched by a call to
+  // WaitForTask().
+  void StartTask();
+  void WaitForTask();
+
+ private:
+  Isolate* isolate_;
+  Task* task_;
+  int task_id_;
+  Semaphore* start_semaphore_;
+  Semaphore* end_semaphore_;
+  Semaphore* stop_semaphore_;
+  volatile AtomicWord stop_thread_;
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_GC_HELPER_THREAD_H_
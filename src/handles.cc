@@ -734,7 +734,9 @@ Handle<FixedArray> GetEnumPropertyKeys(Handle<JSObject> object,
         PropertyDetails details = descs->GetDetails(i);
         sort_array->set(index, Smi::FromInt(details.index()));
         if (!indices.is_null()) {
-          if (details.type() != FIELD) {
+          // Optimized for-in loads fields by index and would hand out the
+          // box of a double field with its mutable map.
+          if (details.type() != FIELD || details.IsDoubleField()) {
             indices = Handle<FixedArray>();
             sort_array2 = Handle<FixedArray>();
           } else {
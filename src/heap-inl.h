@@ -332,6 +332,25 @@ bool Heap::ShouldBePromoted(Address old_address, int object_size) {
 }
 
 
+void Heap::UpdateAllocationSiteFeedback(HeapObject* object, int object_size) {
+  if (!FLAG_allocation_site_pretenuring) return;
+  // A memento, if any, directly follows the object.  Objects ending at the
+  // allocation top or at the end of a page cannot be followed by one, and
+  // the memory behind them must not be inspected.
+  Address end = object->address() + object_size;
+  if (end == new_space_top_at_scavenge_start_) return;
+  if (NewSpacePage::IsAtEnd(end)) return;
+  HeapObject* candidate = HeapObject::FromAddress(end);
+  if (candidate->map_word().ToRawValue() !=
+      reinterpret_cast<uintptr_t>(allocation_memento_map())) {
+    return;
+  }
+  Object* site = AllocationMemento::cast(candidate)->allocation_site();
+  if (!site->IsAllocationSite()) return;
+  AllocationSite::cast(site)->IncrementMementoFoundCount();
+}
+
+
 void Heap::RecordWrite(Address address, int offset) {
   if (!InNewSpace(address)) store_buffer_.Mark(address + offset);
 }
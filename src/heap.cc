@@ -43,6 +43,7 @@
 #include "objects-visiting.h"
 #include "objects-visiting-inl.h"
 #include "once.h"
+#include "parallel-scavenger.h"
 #include "runtime-profiler.h"
 #include "scopeinfo.h"
 #include "snapshot.h"
@@ -92,6 +93,9 @@ Heap::Heap()
 // Will be 4 * reserved_semispace_size_ to ensure that young
 // generation can be aligned to its size.
       survived_since_last_expansion_(0),
+      new_space_growth_survival_rate_(kDefaultNewSpaceGrowthSurvivalRate),
+      target_scavenge_interval_ms_(kDefaultTargetScavengeIntervalMs),
+      new_space_size_at_last_gc_(0),
       sweep_generation_(0),
       always_allocate_scope_depth_(0),
       linear_allocation_scope_depth_(0),
@@ -118,10 +122,13 @@ Heap::Heap()
       debug_utils_(NULL),
 #endif  // DEBUG
       new_space_high_promotion_mode_active_(false),
+      new_space_top_at_scavenge_start_(NULL),
       old_gen_promotion_limit_(kMinimumPromotionLimit),
       old_gen_allocation_limit_(kMinimumAllocationLimit),
       old_gen_limit_factor_(1),
       size_of_old_gen_at_last_old_space_gc_(0),
+      target_gc_overhead_(kDefaultTargetGCOverhead),
+      last_mark_compact_end_time_(0),
       external_allocation_limit_(0),
       amount_of_external_allocated_memory_(0),
       amount_of_external_allocated_memory_at_last_global_gc_(0),
@@ -156,7 +163,11 @@ Heap::Heap()
       promotion_queue_(this),
       configured_(false),
       chunks_queued_for_free_(NULL),
-      relocation_mutex_(NULL) {
+      relocation_mutex_(NULL),
+      relocation_readers_mutex_(NULL),
+      relocation_room_(NULL),
+      relocation_readers_(0),
+      parallel_scavenger_(NULL) {
   // Allow build-time customization of the max semispace size. Building
   // V8 with snapshots and a non-default max semispace size is much
   // easier if you can define it as part of the build environment.
@@ -327,6 +338,11 @@ void Heap::PrintShortHeapStatistics() {
                ", available: %6" V8_PTR_PREFIX "d KB\n",
            isolate_->memory_allocator()->Size() / KB,
            isolate_->memory_allocator()->Available() / KB);
+  PrintPID("Page pool,        pooled: %6" V8_PTR_PREFIX "d KB"
+               ", pages: %d, reused: %d\n",
+           isolate_->memory_allocator()->PooledSize() / KB,
+           isolate_->memory_allocator()->PooledChunks(),
+           isolate_->memory_allocator()->PoolHits());
   PrintPID("New space,          used: %6" V8_PTR_PREFIX "d KB"
                ", available: %6" V8_PTR_PREFIX "d KB"
                ", committed: %6" V8_PTR_PREFIX "d KB\n",
@@ -529,6 +545,34 @@ void Heap::CollectAllAvailableGarbage(const char* gc_reason) {
 }
 
 
+intptr_t Heap::MemoryPressureNotification(v8::MemoryPressureLevel level) {
+  MemoryAllocator* allocator = isolate_->memory_allocator();
+  intptr_t committed_before = CommittedMemory() + allocator->PooledSize();
+  if (level == v8::kMemoryPressureCritical) {
+    // Drop everything that can be recreated on demand.  The mark-compact
+    // prologue clears the number string and string split caches.
+    isolate_->compilation_cache()->Clear();
+    polymorphic_code_cache()->set_cache(undefined_value());
+    // Code flushing needs a non-incremental mark-compact.
+    CollectAllGarbage(kReduceMemoryFootprintMask |
+                      kAbortIncrementalMarkingMask |
+                      kForceCompactionMask |
+                      kFlushAllCodeMask,
+                      "memory pressure: critical");
+    incremental_marking()->UncommitMarkingDeque();
+  } else {
+    CollectAllGarbage(kReduceMemoryFootprintMask,
+                      "memory pressure: moderate");
+  }
+  new_space_.Shrink();
+  UncommitFromSpace();
+  Shrink();
+  allocator->ReleasePooledChunks();
+  intptr_t committed_after = CommittedMemory() + allocator->PooledSize();
+  return Max(committed_before - committed_after, static_cast<intptr_t>(0));
+}
+
+
 bool Heap::CollectGarbage(AllocationSpace space,
                           GarbageCollector collector,
                           const char* gc_reason,
@@ -569,6 +613,10 @@ bool Heap::CollectGarbage(AllocationSpace space,
     }
   }
 
+  // The concurrent marker must not run during garbage collections.  It is
+  // restarted by the next incremental marking step.
+  incremental_marking()->concurrent_marker()->Pause();
+
   bool next_gc_likely_to_collect_more = false;
 
   { GCTracer tracer(this, gc_reason, collector_reason);
@@ -603,10 +651,13 @@ bool Heap::CollectGarbage(AllocationSpace space,
 
 
 void Heap::PerformScavenge() {
+  incremental_marking()->concurrent_marker()->Pause();
   GCTracer tracer(this, NULL, NULL);
   if (incremental_marking()->IsStopped()) {
+    tracer.set_collector(SCAVENGER);
     PerformGarbageCollection(SCAVENGER, &tracer);
   } else {
+    tracer.set_collector(MARK_COMPACTOR);
     PerformGarbageCollection(MARK_COMPACTOR, &tracer);
   }
 }
@@ -846,6 +897,8 @@ bool Heap::PerformGarbageCollection(GarbageCollector collector,
   }
 
   if (collector == MARK_COMPACTOR) {
+    RecordOldGenerationAllocationSpeed();
+
     // Perform mark-sweep with optional compaction.
     MarkCompact(tracer);
     sweep_generation_++;
@@ -875,6 +928,7 @@ bool Heap::PerformGarbageCollection(GarbageCollector collector,
         OldGenAllocationLimit(size_of_old_gen_at_last_old_space_gc_);
 
     old_gen_exhausted_ = false;
+    last_mark_compact_end_time_ = OS::TimeCurrentMillis();
   } else {
     tracer_ = tracer;
     Scavenge();
@@ -1065,13 +1119,35 @@ static void VerifyNonPointerSpacePointers() {
 #endif
 
 
+void Heap::RecordOldGenerationAllocationSpeed() {
+  if (last_mark_compact_end_time_ == 0) return;
+  double elapsed = OS::TimeCurrentMillis() - last_mark_compact_end_time_;
+  intptr_t allocated =
+      PromotedSpaceSizeOfObjects() - size_of_old_gen_at_last_old_space_gc_;
+  if (elapsed > 0 && allocated > 0) {
+    old_generation_allocation_speeds_.Add(allocated / elapsed);
+  }
+}
+
+
 void Heap::CheckNewSpaceExpansionCriteria() {
-  if (new_space_.Capacity() < new_space_.MaximumCapacity() &&
-      survived_since_last_expansion_ > new_space_.Capacity() &&
-      !new_space_high_promotion_mode_active_) {
-    // Grow the size of new space if there is room to grow, enough data
-    // has survived scavenge since the last expansion and we are not in
-    // high promotion mode.
+  if (new_space_.Capacity() >= new_space_.MaximumCapacity() ||
+      new_space_high_promotion_mode_active_) {
+    return;
+  }
+  // Grow the size of new space if enough data has survived scavenge since
+  // the last expansion.
+  bool grow = survived_since_last_expansion_ > new_space_.Capacity();
+  // Also grow if scavenges are cheap because few objects survive, but
+  // frequent because the mutator fills new space faster than the target
+  // interval.  A larger new space then means fewer scavenges for the same
+  // work per scavenge.
+  if (!grow && survival_rate_ < new_space_growth_survival_rate_) {
+    double allocation_speed = new_space_allocation_speeds_.Average(0);
+    grow = allocation_speed > 0 &&
+        new_space_.Capacity() / allocation_speed < target_scavenge_interval_ms_;
+  }
+  if (grow) {
     new_space_.Grow();
     survived_since_last_expansion_ = 0;
   }
@@ -1107,8 +1183,13 @@ void StoreBufferRebuilder::Callback(MemoryChunk* page, StoreBufferEvent event) {
         // Did we find too many pointers in the previous page?  The heuristic is
         // that no page can take more then 1/5 the remaining slots in the store
         // buffer.
-        current_page_->set_scan_on_scavenge(true);
-        store_buffer_->SetTop(start_of_current_page_);
+        if (FLAG_remembered_set_bitmaps) {
+          store_buffer_->MoveEntriesToSlotSet(current_page_,
+                                              start_of_current_page_);
+        } else {
+          current_page_->set_scan_on_scavenge(true);
+          store_buffer_->SetTop(start_of_current_page_);
+        }
       } else {
         // In this case the page we scanned took a reasonable number of slots in
         // the store buffer.  It has now been rehabilitated and is no longer
@@ -1132,9 +1213,15 @@ void StoreBufferRebuilder::Callback(MemoryChunk* page, StoreBufferEvent event) {
       // pointers to new space.
       ASSERT(current_page_ == page);
       ASSERT(page != NULL);
-      current_page_->set_scan_on_scavenge(true);
       ASSERT(start_of_current_page_ != store_buffer_->Top());
-      store_buffer_->SetTop(start_of_current_page_);
+      if (FLAG_remembered_set_bitmaps) {
+        // Keep the slots found so far in the slot set of the page.
+        store_buffer_->MoveEntriesToSlotSet(current_page_,
+                                            start_of_current_page_);
+      } else {
+        current_page_->set_scan_on_scavenge(true);
+        store_buffer_->SetTop(start_of_current_page_);
+      }
     }
   } else {
     UNREACHABLE();
@@ -1226,83 +1313,89 @@ void Heap::Scavenge() {
 
   // Flip the semispaces.  After flipping, to space is empty, from space has
   // live objects.
+  new_space_top_at_scavenge_start_ = new_space_.top();
   new_space_.Flip();
   new_space_.ResetAllocationInfo();
 
-  // We need to sweep newly copied objects which can be either in the
-  // to space or promoted to the old generation.  For to-space
-  // objects, we treat the bottom of the to space as a queue.  Newly
-  // copied and unswept objects lie between a 'front' mark and the
-  // allocation pointer.
-  //
-  // Promoted objects can go into various old-generation spaces, and
-  // can be allocated internally in the spaces (from the free list).
-  // We treat the top of the to space as a queue of addresses of
-  // promoted objects.  The addresses of newly promoted and unswept
-  // objects lie between a 'front' mark and a 'rear' mark that is
-  // updated as a side effect of promoting an object.
-  //
-  // There is guaranteed to be enough room at the top of the to space
-  // for the addresses of promoted objects: every object promoted
-  // frees up its size in bytes from the top of the new space, and
-  // objects are at least one pointer in size.
-  Address new_space_front = new_space_.ToSpaceStart();
-  promotion_queue_.Initialize();
+  if (parallel_scavenger_->CanScavengeInParallel()) {
+    ScavengeInParallel();
+  } else {
+    // We need to sweep newly copied objects which can be either in the
+    // to space or promoted to the old generation.  For to-space
+    // objects, we treat the bottom of the to space as a queue.  Newly
+    // copied and unswept objects lie between a 'front' mark and the
+    // allocation pointer.
+    //
+    // Promoted objects can go into various old-generation spaces, and
+    // can be allocated internally in the spaces (from the free list).
+    // We treat the top of the to space as a queue of addresses of
+    // promoted objects.  The addresses of newly promoted and unswept
+    // objects lie between a 'front' mark and a 'rear' mark that is
+    // updated as a side effect of promoting an object.
+    //
+    // There is guaranteed to be enough room at the top of the to space
+    // for the addresses of promoted objects: every object promoted
+    // frees up its size in bytes from the top of the new space, and
+    // objects are at least one pointer in size.
+    Address new_space_front = new_space_.ToSpaceStart();
+    promotion_queue_.Initialize();
 
 #ifdef DEBUG
-  store_buffer()->Clean();
+    store_buffer()->Clean();
 #endif
 
-  ScavengeVisitor scavenge_visitor(this);
-  // Copy roots.
-  IterateRoots(&scavenge_visitor, VISIT_ALL_IN_SCAVENGE);
-
-  // Copy objects reachable from the old generation.
-  {
-    StoreBufferRebuildScope scope(this,
-                                  store_buffer(),
-                                  &ScavengeStoreBufferCallback);
-    store_buffer()->IteratePointersToNewSpace(&ScavengeObject);
-  }
+    ScavengeVisitor scavenge_visitor(this);
+    // Copy roots.
+    IterateRoots(&scavenge_visitor, VISIT_ALL_IN_SCAVENGE);
 
-  // Copy objects reachable from cells by scavenging cell values directly.
-  HeapObjectIterator cell_iterator(cell_space_);
-  for (HeapObject* cell = cell_iterator.Next();
-       cell != NULL; cell = cell_iterator.Next()) {
-    if (cell->IsJSGlobalPropertyCell()) {
-      Address value_address =
-          reinterpret_cast<Address>(cell) +
-          (JSGlobalPropertyCell::kValueOffset - kHeapObjectTag);
-      scavenge_visitor.VisitPointer(reinterpret_cast<Object**>(value_address));
+    // Copy objects reachable from the old generation.
+    {
+      StoreBufferRebuildScope scope(this,
+                                    store_buffer(),
+                                    &ScavengeStoreBufferCallback);
+      store_buffer()->IteratePointersToNewSpace(&ScavengeObject);
+    }
+
+    // Copy objects reachable from cells by scavenging cell values directly.
+    HeapObjectIterator cell_iterator(cell_space_);
+    for (HeapObject* cell = cell_iterator.Next();
+         cell != NULL; cell = cell_iterator.Next()) {
+      if (cell->IsJSGlobalPropertyCell()) {
+        Address value_address =
+            reinterpret_cast<Address>(cell) +
+            (JSGlobalPropertyCell::kValueOffset - kHeapObjectTag);
+        scavenge_visitor.VisitPointer(
+            reinterpret_cast<Object**>(value_address));
+      }
     }
-  }
 
-  // Scavenge object reachable from the global contexts list directly.
-  scavenge_visitor.VisitPointer(BitCast<Object**>(&global_contexts_list_));
+    // Scavenge object reachable from the global contexts list directly.
+    scavenge_visitor.VisitPointer(BitCast<Object**>(&global_contexts_list_));
 
-  new_space_front = DoScavenge(&scavenge_visitor, new_space_front);
-  isolate_->global_handles()->IdentifyNewSpaceWeakIndependentHandles(
-      &IsUnscavengedHeapObject);
-  isolate_->global_handles()->IterateNewSpaceWeakIndependentRoots(
-      &scavenge_visitor);
-  new_space_front = DoScavenge(&scavenge_visitor, new_space_front);
+    new_space_front = DoScavenge(&scavenge_visitor, new_space_front);
+    isolate_->global_handles()->IdentifyNewSpaceWeakIndependentHandles(
+        &IsUnscavengedHeapObject);
+    isolate_->global_handles()->IterateNewSpaceWeakIndependentRoots(
+        &scavenge_visitor);
+    new_space_front = DoScavenge(&scavenge_visitor, new_space_front);
+    ASSERT(new_space_front == new_space_.top());
 
-  UpdateNewSpaceReferencesInExternalStringTable(
-      &UpdateNewSpaceReferenceInExternalStringTableEntry);
+    UpdateNewSpaceReferencesInExternalStringTable(
+        &UpdateNewSpaceReferenceInExternalStringTableEntry);
 
-  promotion_queue_.Destroy();
+    promotion_queue_.Destroy();
+  }
 
   LiveObjectList::UpdateReferencesForScavengeGC();
   if (!FLAG_watch_ic_patching) {
     isolate()->runtime_profiler()->UpdateSamplesAfterScavenge();
   }
   incremental_marking()->UpdateMarkingDequeAfterScavenge();
+  mark_compact_collector()->UpdateSliceCandidatesAfterScavenge();
 
   ScavengeWeakObjectRetainer weak_object_retainer(this);
   ProcessWeakReferences(&weak_object_retainer);
 
-  ASSERT(new_space_front == new_space_.top());
-
   // Set age mark.
   new_space_.set_age_mark(new_space_.top());
 
@@ -1321,6 +1414,62 @@ void Heap::Scavenge() {
 }
 
 
+void Heap::ScavengeInParallel() {
+  ParallelScavenger* scavenger = parallel_scavenger_;
+  scavenger->Prepare();
+
+#ifdef DEBUG
+  store_buffer()->Clean();
+#endif
+
+  // Root slots can be temporaries of the code visiting them, so the objects
+  // they reference are copied before the scavenging tasks are started.
+  ParallelScavengeVisitor scavenge_visitor(scavenger);
+  IterateRoots(&scavenge_visitor, VISIT_ALL_IN_SCAVENGE);
+
+  // Record the slots of the old generation that point into from-space.  They
+  // still point into from-space after the callback, so the store buffer
+  // keeps them; entries that end up pointing to old space are harmless.
+  {
+    StoreBufferRebuildScope scope(this,
+                                  store_buffer(),
+                                  &ScavengeStoreBufferCallback);
+    store_buffer()->IteratePointersToNewSpace(
+        &ParallelScavenger::RecordStoreBufferSlot);
+  }
+
+  HeapObjectIterator cell_iterator(cell_space_);
+  for (HeapObject* cell = cell_iterator.Next();
+       cell != NULL; cell = cell_iterator.Next()) {
+    if (cell->IsJSGlobalPropertyCell()) {
+      Address value_address =
+          reinterpret_cast<Address>(cell) +
+          (JSGlobalPropertyCell::kValueOffset - kHeapObjectTag);
+      scavenger->RecordSlot(reinterpret_cast<Object**>(value_address));
+    }
+  }
+
+  scavenge_visitor.VisitPointer(BitCast<Object**>(&global_contexts_list_));
+
+  scavenger->ScavengeInParallel();
+  isolate_->global_handles()->IdentifyNewSpaceWeakIndependentHandles(
+      &IsUnscavengedHeapObject);
+  isolate_->global_handles()->IterateNewSpaceWeakIndependentRoots(
+      &scavenge_visitor);
+  scavenger->ScavengeInParallel();
+
+  {
+    StoreBufferRebuildScope scope(this,
+                                  store_buffer(),
+                                  &ScavengeStoreBufferCallback);
+    scavenger->Finish();
+  }
+
+  UpdateNewSpaceReferencesInExternalStringTable(
+      &UpdateNewSpaceReferenceInExternalStringTableEntry);
+}
+
+
 String* Heap::UpdateNewSpaceReferenceInExternalStringTableEntry(Heap* heap,
                                                                 Object** p) {
   MapWord first_word = HeapObject::cast(*p)->map_word();
@@ -1598,19 +1747,13 @@ Address Heap::DoScavenge(ObjectVisitor* scavenge_visitor,
 STATIC_ASSERT((FixedDoubleArray::kHeaderSize & kDoubleAlignmentMask) == 0);
 
 
-INLINE(static HeapObject* EnsureDoubleAligned(Heap* heap,
-                                              HeapObject* object,
-                                              int size));
-
-static HeapObject* EnsureDoubleAligned(Heap* heap,
-                                       HeapObject* object,
-                                       int size) {
+HeapObject* Heap::EnsureDoubleAligned(HeapObject* object, int size) {
   if ((OffsetFrom(object->address()) & kDoubleAlignmentMask) != 0) {
-    heap->CreateFillerObjectAt(object->address(), kPointerSize);
+    CreateFillerObjectAt(object->address(), kPointerSize);
     return HeapObject::FromAddress(object->address() + kPointerSize);
   } else {
-    heap->CreateFillerObjectAt(object->address() + size - kPointerSize,
-                               kPointerSize);
+    CreateFillerObjectAt(object->address() + size - kPointerSize,
+                         kPointerSize);
     return object;
   }
 }
@@ -1758,6 +1901,9 @@ class ScavengingVisitor : public StaticVisitorBase {
     }
 
     Heap* heap = map->GetHeap();
+    if (object_contents == POINTER_OBJECT) {
+      heap->UpdateAllocationSiteFeedback(object, object_size);
+    }
     if (heap->ShouldBePromoted(object->address(), object_size)) {
       MaybeObject* maybe_result;
 
@@ -1779,7 +1925,7 @@ class ScavengingVisitor : public StaticVisitorBase {
         HeapObject* target = HeapObject::cast(result);
 
         if (alignment != kObjectAlignment) {
-          target = EnsureDoubleAligned(heap, target, allocation_size);
+          target = heap->EnsureDoubleAligned(target, allocation_size);
         }
 
         // Order is important: slot might be inside of the target if target
@@ -1807,7 +1953,7 @@ class ScavengingVisitor : public StaticVisitorBase {
     HeapObject* target = HeapObject::cast(result);
 
     if (alignment != kObjectAlignment) {
-      target = EnsureDoubleAligned(heap, target, allocation_size);
+      target = heap->EnsureDoubleAligned(target, allocation_size);
     }
 
     // Order is important: slot might be inside of the target if target
@@ -2137,6 +2283,18 @@ MaybeObject* Heap::AllocateAliasedArgumentsEntry(int aliased_context_slot) {
 }
 
 
+MaybeObject* Heap::AllocateAllocationSite() {
+  AllocationSite* site;
+  { MaybeObject* maybe_site = AllocateStruct(ALLOCATION_SITE_TYPE);
+    if (!maybe_site->To(&site)) return maybe_site;
+  }
+  site->set_memento_create_count(0);
+  site->set_memento_found_count(0);
+  site->set_pretenure_decision(AllocationSite::kUndecided);
+  return site;
+}
+
+
 const Heap::StringTypeTable Heap::string_type_table[] = {
 #define STRING_TYPE_ELEMENT(type, size, name, camel_name)                      \
   {type, size, k##camel_name##MapRootIndex},
@@ -2245,6 +2403,11 @@ bool Heap::CreateInitialMaps() {
   }
   set_heap_number_map(Map::cast(obj));
 
+  { MaybeObject* maybe_obj = AllocateMap(HEAP_NUMBER_TYPE, HeapNumber::kSize);
+    if (!maybe_obj->ToObject(&obj)) return false;
+  }
+  set_mutable_heap_number_map(Map::cast(obj));
+
   { MaybeObject* maybe_obj = AllocateMap(FOREIGN_TYPE, Foreign::kSize);
     if (!maybe_obj->ToObject(&obj)) return false;
   }
@@ -2480,6 +2643,18 @@ MaybeObject* Heap::AllocateHeapNumber(double value) {
 }
 
 
+MaybeObject* Heap::AllocateMutableHeapNumber(double value,
+                                             PretenureFlag pretenure) {
+  Object* result;
+  { MaybeObject* maybe_result = AllocateHeapNumber(value, pretenure);
+    if (!maybe_result->ToObject(&result)) return maybe_result;
+  }
+  HeapObject::cast(result)->set_map_no_write_barrier(
+      mutable_heap_number_map());
+  return result;
+}
+
+
 MaybeObject* Heap::AllocateJSGlobalPropertyCell(Object* value) {
   Object* result;
   { MaybeObject* maybe_result = AllocateRawCell();
@@ -3499,6 +3674,40 @@ void Heap::CreateFillerObjectAt(Address addr, int size) {
 }
 
 
+void Heap::RightTrimObject(HeapObject* object, int new_length) {
+  ASSERT(object->IsFixedArrayBase() || object->IsSeqString());
+  ASSERT(object->map() != fixed_cow_array_map());
+  ConcurrentMarkingScope concurrent_marking_scope(
+      incremental_marking()->concurrent_marker(), object);
+
+  int old_size = object->Size();
+  if (object->IsFixedArrayBase()) {
+    ASSERT(new_length <= FixedArrayBase::cast(object)->length());
+    FixedArrayBase::cast(object)->set_length(new_length);
+  } else {
+    ASSERT(new_length <= String::cast(object)->length());
+    String::cast(object)->set_length(new_length);
+  }
+  int delta = old_size - object->Size();
+  if (delta == 0) return;
+
+  // Technically in new space this write might be omitted (except for
+  // debug mode which iterates through the heap), but to play safer
+  // we still do it.
+  CreateFillerObjectAt(object->address() + old_size - delta, delta);
+
+  // Maintain marking consistency for IncrementalMarking.  Grey objects are
+  // counted with their new size when they are visited.
+  if (Marking::IsBlack(Marking::MarkBitFrom(object))) {
+    if (gc_state() == MARK_COMPACT) {
+      MemoryChunk::IncrementLiveBytesFromGC(object->address(), -delta);
+    } else {
+      MemoryChunk::IncrementLiveBytesFromMutator(object->address(), -delta);
+    }
+  }
+}
+
+
 MaybeObject* Heap::AllocateExternalArray(int length,
                                          ExternalArrayType array_type,
                                          void* external_pointer,
@@ -4177,7 +4386,7 @@ MaybeObject* Heap::AllocateGlobalObject(JSFunction* constructor) {
 }
 
 
-MaybeObject* Heap::CopyJSObject(JSObject* source) {
+MaybeObject* Heap::CopyJSObject(JSObject* source, AllocationSite* site) {
   // Never used to copy functions.  If functions need to be copied we
   // have to be careful to clear the literals array.
   SLOW_ASSERT(!source->IsJSFunction());
@@ -4188,12 +4397,17 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
   Object* clone;
 
   WriteBarrierMode wb_mode = UPDATE_WRITE_BARRIER;
+  PretenureFlag pretenure =
+      site != NULL ? site->GetPretenureMode() : NOT_TENURED;
 
   // If we're forced to always allocate, we use the general allocation
-  // functions which may leave us with an object in old space.
-  if (always_allocate()) {
-    { MaybeObject* maybe_clone =
-          AllocateRaw(object_size, NEW_SPACE, OLD_POINTER_SPACE);
+  // functions which may leave us with an object in old space.  Pretenured
+  // clones are allocated in old space right away.
+  if (always_allocate() || pretenure == TENURED) {
+    { AllocationSpace space =
+          (pretenure == TENURED) ? OLD_POINTER_SPACE : NEW_SPACE;
+      MaybeObject* maybe_clone =
+          AllocateRaw(object_size, space, OLD_POINTER_SPACE);
       if (!maybe_clone->ToObject(&clone)) return maybe_clone;
     }
     Address clone_address = HeapObject::cast(clone)->address();
@@ -4206,7 +4420,9 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
                  (object_size - JSObject::kHeaderSize) / kPointerSize);
   } else {
     wb_mode = SKIP_WRITE_BARRIER;
-    { MaybeObject* maybe_clone = new_space_.AllocateRaw(object_size);
+    int memento_size = (site != NULL) ? AllocationMemento::kSize : 0;
+    { MaybeObject* maybe_clone =
+          new_space_.AllocateRaw(object_size + memento_size);
       if (!maybe_clone->ToObject(&clone)) return maybe_clone;
     }
     SLOW_ASSERT(InNewSpace(clone));
@@ -4215,6 +4431,14 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
     CopyBlock(HeapObject::cast(clone)->address(),
               source->address(),
               object_size);
+    if (site != NULL) {
+      AllocationMemento* memento = reinterpret_cast<AllocationMemento*>(
+          HeapObject::FromAddress(
+              HeapObject::cast(clone)->address() + object_size));
+      memento->set_map_no_write_barrier(allocation_memento_map());
+      memento->set_allocation_site(site, SKIP_WRITE_BARRIER);
+      site->IncrementMementoCreateCount();
+    }
   }
 
   SLOW_ASSERT(
@@ -4228,9 +4452,11 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
       if (elements->map() == fixed_cow_array_map()) {
         maybe_elem = FixedArray::cast(elements);
       } else if (source->HasFastDoubleElements()) {
-        maybe_elem = CopyFixedDoubleArray(FixedDoubleArray::cast(elements));
+        maybe_elem = CopyFixedDoubleArrayWithMap(
+            FixedDoubleArray::cast(elements), elements->map(), pretenure);
       } else {
-        maybe_elem = CopyFixedArray(FixedArray::cast(elements));
+        maybe_elem = CopyFixedArrayWithMap(
+            FixedArray::cast(elements), elements->map(), pretenure);
       }
       if (!maybe_elem->ToObject(&elem)) return maybe_elem;
     }
@@ -4239,11 +4465,27 @@ MaybeObject* Heap::CopyJSObject(JSObject* source) {
   // Update properties if necessary.
   if (properties->length() > 0) {
     Object* prop;
-    { MaybeObject* maybe_prop = CopyFixedArray(properties);
+    { MaybeObject* maybe_prop =
+          CopyFixedArrayWithMap(properties, properties->map(), pretenure);
       if (!maybe_prop->ToObject(&prop)) return maybe_prop;
     }
     JSObject::cast(clone)->set_properties(FixedArray::cast(prop), wb_mode);
   }
+  // Give the double fields of the clone boxes of their own.
+  if (map->has_double_fields()) {
+    DescriptorArray* descriptors = map->instance_descriptors();
+    for (int i = 0; i < descriptors->number_of_descriptors(); i++) {
+      if (!descriptors->GetDetails(i).IsDoubleField()) continue;
+      int index = descriptors->GetFieldIndex(i);
+      Object* box;
+      { MaybeObject* maybe_box = AllocateMutableHeapNumber(
+            HeapNumber::cast(source->RawFastPropertyAt(index))->value(),
+            pretenure);
+        if (!maybe_box->ToObject(&box)) return maybe_box;
+      }
+      JSObject::cast(clone)->FastPropertyAtPut(index, box);
+    }
+  }
   // Return the new clone.
   return clone;
 }
@@ -4283,6 +4525,8 @@ MaybeObject* Heap::ReinitializeJSReceiver(
 
   // Because of possible retries of this function after failure,
   // we must NOT fail after this point, where we have changed the type!
+  ConcurrentMarkingScope concurrent_marking_scope(
+      incremental_marking()->concurrent_marker(), object);
 
   // Reset the map for the object.
   object->set_map(map);
@@ -4637,10 +4881,12 @@ MaybeObject* Heap::AllocateRawFixedArray(int length) {
 }
 
 
-MaybeObject* Heap::CopyFixedArrayWithMap(FixedArray* src, Map* map) {
+MaybeObject* Heap::CopyFixedArrayWithMap(FixedArray* src,
+                                         Map* map,
+                                         PretenureFlag pretenure) {
   int len = src->length();
   Object* obj;
-  { MaybeObject* maybe_obj = AllocateRawFixedArray(len);
+  { MaybeObject* maybe_obj = AllocateRawFixedArray(len, pretenure);
     if (!maybe_obj->ToObject(&obj)) return maybe_obj;
   }
   if (InNewSpace(obj)) {
@@ -4664,10 +4910,11 @@ MaybeObject* Heap::CopyFixedArrayWithMap(FixedArray* src, Map* map) {
 
 
 MaybeObject* Heap::CopyFixedDoubleArrayWithMap(FixedDoubleArray* src,
-                                               Map* map) {
+                                               Map* map,
+                                               PretenureFlag pretenure) {
   int len = src->length();
   Object* obj;
-  { MaybeObject* maybe_obj = AllocateRawFixedDoubleArray(len, NOT_TENURED);
+  { MaybeObject* maybe_obj = AllocateRawFixedDoubleArray(len, pretenure);
     if (!maybe_obj->ToObject(&obj)) return maybe_obj;
   }
   HeapObject* dst = HeapObject::cast(obj);
@@ -4861,7 +5108,7 @@ MaybeObject* Heap::AllocateRawFixedDoubleArray(int length,
     if (!maybe_object->To<HeapObject>(&object)) return maybe_object;
   }
 
-  return EnsureDoubleAligned(this, object, size);
+  return EnsureDoubleAligned(object, size);
 }
 
 
@@ -5030,18 +5277,23 @@ void Heap::AdvanceIdleIncrementalMarking(intptr_t step_size) {
                               IncrementalMarking::NO_GC_VIA_STACK_GUARD);
 
   if (incremental_marking()->IsComplete()) {
-    bool uncommit = false;
-    if (gc_count_at_last_idle_gc_ == gc_count_) {
-      // No GC since the last full GC, the mutator is probably not active.
-      isolate_->compilation_cache()->Clear();
-      uncommit = true;
-    }
-    CollectAllGarbage(kNoGCFlags, "idle notification: finalize incremental");
-    gc_count_at_last_idle_gc_ = gc_count_;
-    if (uncommit) {
-      new_space_.Shrink();
-      UncommitFromSpace();
-    }
+    FinalizeIdleIncrementalMarking();
+  }
+}
+
+
+void Heap::FinalizeIdleIncrementalMarking() {
+  bool uncommit = false;
+  if (gc_count_at_last_idle_gc_ == gc_count_) {
+    // No GC since the last full GC, the mutator is probably not active.
+    isolate_->compilation_cache()->Clear();
+    uncommit = true;
+  }
+  CollectAllGarbage(kNoGCFlags, "idle notification: finalize incremental");
+  gc_count_at_last_idle_gc_ = gc_count_;
+  if (uncommit) {
+    new_space_.Shrink();
+    UncommitFromSpace();
   }
 }
 
@@ -5101,6 +5353,11 @@ bool Heap::IdleNotification(int hint) {
 
 
   if (incremental_marking()->IsStopped()) {
+    // Idle time is not mutator time, so use it to help the sweeper threads.
+    if (mark_compact_collector()->IsConcurrentSweepingInProgress() &&
+        !mark_compact_collector()->AdvanceConcurrentSweeping(step_size)) {
+      return false;
+    }
     if (!IsSweepingComplete() &&
         !AdvanceSweepers(static_cast<int>(step_size))) {
       return false;
@@ -5147,6 +5404,174 @@ bool Heap::IdleNotification(int hint) {
 }
 
 
+// Returns true if work predicted to take the given time can be finished
+// before the deadline.  Otherwise remembers the predicted time of the first,
+// i.e. most urgent, work that did not fit.
+static bool FitsBeforeDeadline(double deadline,
+                               double predicted_time_in_ms,
+                               double* time_needed_in_ms) {
+  if (OS::TimeCurrentMillis() + predicted_time_in_ms <= deadline) return true;
+  if (*time_needed_in_ms == 0) *time_needed_in_ms = predicted_time_in_ms;
+  return false;
+}
+
+
+bool Heap::IdleNotificationDeadline(int idle_time_in_ms,
+                                    int* work_done,
+                                    double* time_needed_in_ms) {
+  double deadline = OS::TimeCurrentMillis() + idle_time_in_ms;
+  *work_done = v8::IdleTaskReport::kNoWork;
+  *time_needed_in_ms = 0;
+
+  // Finalizing complete incremental marking comes first, the mutator would
+  // otherwise pay for it with its next allocation.
+  if (incremental_marking()->IsComplete() &&
+      FitsBeforeDeadline(
+          deadline,
+          finalize_marking_speeds_.PredictTime(SizeOfObjects(),
+                                               kInitialFinalizeMarkingSpeed),
+          time_needed_in_ms)) {
+    FinalizeIdleIncrementalMarking();
+    *work_done |= v8::IdleTaskReport::kFinalizeIncrementalMarking;
+  }
+
+  // A scavenge now saves the mutator the pause of a scavenge soon.
+  if (new_space_.Size() >=
+          new_space_.Capacity() / 100 * kIdleScavengeFullnessPercent &&
+      FitsBeforeDeadline(
+          deadline,
+          scavenge_speeds_.PredictTime(new_space_.Size(),
+                                       kInitialScavengeSpeed),
+          time_needed_in_ms)) {
+    CollectGarbage(NEW_SPACE, "idle notification: scavenge");
+    *work_done |= v8::IdleTaskReport::kScavenge;
+  }
+
+  if (contexts_disposed_ > 0 && !FLAG_expose_gc &&
+      incremental_marking()->IsStopped()) {
+    if (FitsBeforeDeadline(
+            deadline,
+            mark_compact_speeds_.PredictTime(SizeOfObjects(),
+                                             kInitialMarkCompactSpeed),
+            time_needed_in_ms)) {
+      HistogramTimerScope scope(isolate_->counters()->gc_context());
+      CollectAllGarbage(kReduceMemoryFootprintMask,
+                        "idle notification: contexts disposed");
+      *work_done |= v8::IdleTaskReport::kFullGarbageCollection;
+    } else if (FLAG_incremental_marking && !Serializer::enabled()) {
+      // Collect the disposed contexts incrementally instead.
+      incremental_marking()->Start();
+      contexts_disposed_ = 0;
+    }
+    // There is likely a lot of garbage left after context disposal.
+    StartIdleRound();
+  }
+
+  // Sweep in small steps for as long as the last step would still fit.
+  double sweeping_step_time = 0;
+  while (mark_compact_collector()->IsConcurrentSweepingInProgress() ||
+         !IsSweepingComplete()) {
+    double start = OS::TimeCurrentMillis();
+    if (start + sweeping_step_time >= deadline) {
+      if (*time_needed_in_ms == 0) *time_needed_in_ms = sweeping_step_time;
+      break;
+    }
+    if (mark_compact_collector()->IsConcurrentSweepingInProgress()) {
+      mark_compact_collector()->AdvanceConcurrentSweeping(
+          kIdleSweepingStepSize);
+    } else {
+      AdvanceSweepers(kIdleSweepingStepSize);
+    }
+    sweeping_step_time = OS::TimeCurrentMillis() - start;
+    *work_done |= v8::IdleTaskReport::kSweeping;
+  }
+
+  // Count mark-sweeps in idle rounds the same way IdleNotification does.
+  bool idle_round_finished = false;
+  if (mark_sweeps_since_idle_round_started_ >= kMaxMarkSweepsInIdleRound &&
+      !EnoughGarbageSinceLastIdleRound()) {
+    idle_round_finished = true;
+  } else {
+    if (mark_sweeps_since_idle_round_started_ >= kMaxMarkSweepsInIdleRound) {
+      StartIdleRound();
+    }
+    mark_sweeps_since_idle_round_started_ +=
+        ms_count_ - ms_count_at_last_idle_notification_;
+    ms_count_at_last_idle_notification_ = ms_count_;
+    if (mark_sweeps_since_idle_round_started_ >= kMaxMarkSweepsInIdleRound) {
+      FinishIdleRound();
+      idle_round_finished = true;
+    }
+  }
+
+  bool incremental = FLAG_incremental_marking && !FLAG_expose_gc &&
+                     !Serializer::enabled();
+  if (!idle_round_finished && incremental_marking()->IsStopped() &&
+      IsSweepingComplete() && OS::TimeCurrentMillis() < deadline) {
+    if (incremental) {
+      incremental_marking()->Start();
+    } else if (FitsBeforeDeadline(
+                   deadline,
+                   mark_compact_speeds_.PredictTime(SizeOfObjects(),
+                                                    kInitialMarkCompactSpeed),
+                   time_needed_in_ms)) {
+      // Without incremental marking one full GC is all an idle round does.
+      CollectAllGarbage(kReduceMemoryFootprintMask,
+                        "idle notification: full GC");
+      *work_done |= v8::IdleTaskReport::kFullGarbageCollection;
+      FinishIdleRound();
+      idle_round_finished = true;
+    }
+  }
+
+  if (!incremental_marking()->IsStopped() &&
+      !incremental_marking()->IsComplete()) {
+    // Size the step to the remaining time.  Step() processes the allocated
+    // bytes times the marking factor.
+    double remaining_time = deadline - OS::TimeCurrentMillis();
+    double marking_speed = marking_speeds_.Average(kInitialMarkingSpeed);
+    intptr_t step_size = static_cast<intptr_t>(
+        remaining_time * marking_speed /
+        incremental_marking()->allocation_marking_factor());
+    if (step_size >= IncrementalMarking::kAllocatedThreshold) {
+      incremental_marking()->Step(step_size,
+                                  IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+      *work_done |= v8::IdleTaskReport::kIncrementalMarkingStep;
+    } else if (*time_needed_in_ms == 0) {
+      *time_needed_in_ms = IncrementalMarking::kAllocatedThreshold *
+          incremental_marking()->allocation_marking_factor() / marking_speed;
+    }
+  }
+
+  if (incremental_marking()->IsComplete() &&
+      FitsBeforeDeadline(
+          deadline,
+          finalize_marking_speeds_.PredictTime(SizeOfObjects(),
+                                               kInitialFinalizeMarkingSpeed),
+          time_needed_in_ms)) {
+    FinalizeIdleIncrementalMarking();
+    *work_done |= v8::IdleTaskReport::kFinalizeIncrementalMarking;
+  }
+
+  // Give back the new space that was grown for the last allocation burst
+  // once the collections are done or a collection has just emptied it.
+  const int kCollections = v8::IdleTaskReport::kScavenge |
+                           v8::IdleTaskReport::kFinalizeIncrementalMarking |
+                           v8::IdleTaskReport::kFullGarbageCollection;
+  if (new_space_.Capacity() > new_space_.InitialCapacity() &&
+      (idle_round_finished || (*work_done & kCollections) != 0)) {
+    new_space_.Shrink();
+    UncommitFromSpace();
+    *work_done |= v8::IdleTaskReport::kShrinkNewSpace;
+  }
+
+  return idle_round_finished &&
+         incremental_marking()->IsStopped() &&
+         !mark_compact_collector()->IsConcurrentSweepingInProgress() &&
+         IsSweepingComplete();
+}
+
+
 bool Heap::IdleGlobalGC() {
   static const int kIdlesBeforeScavenge = 4;
   static const int kIdlesBeforeMarkSweep = 7;
@@ -5320,6 +5745,13 @@ bool Heap::InSpace(Address addr, AllocationSpace space) {
 void Heap::Verify() {
   ASSERT(HasBeenSetUp());
 
+  if (mark_compact_collector()->IsConcurrentSweepingInProgress()) {
+    mark_compact_collector()->WaitUntilSweepingCompleted();
+  }
+
+  // Live bytes are checked against mark bits below.
+  incremental_marking()->concurrent_marker()->Pause();
+
   store_buffer()->Verify();
 
   VerifyPointersVisitor visitor;
@@ -5814,6 +6246,24 @@ bool Heap::ConfigureHeap(int max_semispace_size,
 }
 
 
+void Heap::ConfigureNewSpaceSizing(int growth_survival_rate,
+                                   int target_scavenge_interval_ms) {
+  if (growth_survival_rate > 0) {
+    new_space_growth_survival_rate_ = growth_survival_rate;
+  }
+  if (target_scavenge_interval_ms > 0) {
+    target_scavenge_interval_ms_ = target_scavenge_interval_ms;
+  }
+}
+
+
+void Heap::ConfigureOldGenerationGrowing(int target_gc_overhead) {
+  if (target_gc_overhead > 0) {
+    target_gc_overhead_ = Min(target_gc_overhead, 100);
+  }
+}
+
+
 bool Heap::ConfigureHeapDefault() {
   return ConfigureHeap(static_cast<intptr_t>(FLAG_max_new_space_size / 2) * KB,
                        static_cast<intptr_t>(FLAG_max_old_space_size) * MB,
@@ -5842,6 +6292,8 @@ void Heap::RecordStats(HeapStats* stats, bool take_snapshot) {
   *stats->memory_allocator_capacity =
       isolate()->memory_allocator()->Size() +
       isolate()->memory_allocator()->Available();
+  *stats->memory_allocator_pooled_size =
+      isolate()->memory_allocator()->PooledSize();
   *stats->os_error = OS::GetLastError();
       isolate()->memory_allocator()->Available();
   if (take_snapshot) {
@@ -6158,7 +6610,13 @@ bool Heap::SetUp(bool create_heap_objects) {
 
   store_buffer()->SetUp();
 
-  if (FLAG_parallel_recompilation) relocation_mutex_ = OS::CreateMutex();
+  if (FLAG_parallel_recompilation) {
+    relocation_mutex_ = OS::CreateMutex();
+    relocation_readers_mutex_ = OS::CreateMutex();
+    relocation_room_ = OS::CreateSemaphore(1);
+  }
+
+  parallel_scavenger_ = new ParallelScavenger(this);
 
   return true;
 }
@@ -6182,6 +6640,8 @@ void Heap::SetStackLimits() {
 
 
 void Heap::TearDown() {
+  incremental_marking()->concurrent_marker()->Pause();
+
 #ifdef DEBUG
   if (FLAG_verify_heap) {
     Verify();
@@ -6198,6 +6658,11 @@ void Heap::TearDown() {
     PrintF("\n\n");
   }
 
+  delete parallel_scavenger_;
+  parallel_scavenger_ = NULL;
+
+  mark_compact_collector()->TearDown();
+
   isolate_->global_handles()->TearDown();
 
   external_string_table_.TearDown();
@@ -6246,6 +6711,8 @@ void Heap::TearDown() {
   isolate_->memory_allocator()->TearDown();
 
   delete relocation_mutex_;
+  delete relocation_readers_mutex_;
+  delete relocation_room_;
 
 #ifdef DEBUG
   delete debug_utils_;
@@ -6255,6 +6722,11 @@ void Heap::TearDown() {
 
 
 void Heap::Shrink() {
+  // Unused pages are only known once sweeping is done.
+  if (mark_compact_collector()->IsConcurrentSweepingInProgress()) {
+    mark_compact_collector()->WaitUntilSweepingCompleted();
+  }
+
   // Try to shrink all paged spaces.
   PagedSpaces spaces;
   for (PagedSpace* space = spaces.next();
@@ -6305,6 +6777,21 @@ void Heap::RemoveGCEpilogueCallback(GCEpilogueCallback callback) {
 }
 
 
+void Heap::AddGCTimingCallback(GCTimingCallback callback) {
+  ASSERT(callback != NULL);
+  ASSERT(!gc_timing_callbacks_.Contains(callback));
+  gc_timing_callbacks_.Add(callback);
+}
+
+
+void Heap::RemoveGCTimingCallback(GCTimingCallback callback) {
+  ASSERT(callback != NULL);
+  bool removed = gc_timing_callbacks_.RemoveElement(callback);
+  USE(removed);
+  ASSERT(removed);
+}
+
+
 #ifdef DEBUG
 
 class PrintHandleVisitor: public ObjectVisitor {
@@ -6815,32 +7302,41 @@ GCTracer::GCTracer(Heap* heap,
     : start_time_(0.0),
       start_object_size_(0),
       start_memory_size_(0),
+      start_new_space_size_(0),
+      finishes_incremental_marking_(false),
+      collector_(SCAVENGER),
       gc_count_(0),
       full_gc_count_(0),
       allocated_since_last_gc_(0),
       spent_in_mutator_(0),
       promoted_objects_size_(0),
+      deduplicated_strings_size_(0),
+      rescued_slice_parents_size_(0),
+      scavenge_tasks_(0),
       heap_(heap),
       gc_reason_(gc_reason),
       collector_reason_(collector_reason) {
-  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
+  // The GC speeds used by the idle notification are always recorded.
   start_time_ = OS::TimeCurrentMillis();
   start_object_size_ = heap_->SizeOfObjects();
-  start_memory_size_ = heap_->isolate()->memory_allocator()->Size();
+  start_new_space_size_ = heap_->new_space()->Size();
+  finishes_incremental_marking_ = heap_->incremental_marking()->IsMarking();
+  if (heap_->last_gc_end_timestamp_ > 0) {
+    spent_in_mutator_ = Max(start_time_ - heap_->last_gc_end_timestamp_, 0.0);
+  }
 
   for (int i = 0; i < Scope::kNumberOfScopes; i++) {
     scopes_[i] = 0;
   }
 
+  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
+  start_memory_size_ = heap_->isolate()->memory_allocator()->Size();
+
   in_free_list_or_wasted_before_gc_ = CountTotalHolesSize();
 
   allocated_since_last_gc_ =
       heap_->SizeOfObjects() - heap_->alive_after_last_gc_;
 
-  if (heap_->last_gc_end_timestamp_ > 0) {
-    spent_in_mutator_ = Max(start_time_ - heap_->last_gc_end_timestamp_, 0.0);
-  }
-
   steps_count_ = heap_->incremental_marking()->steps_count();
   steps_took_ = heap_->incremental_marking()->steps_took();
   longest_step_ = heap_->incremental_marking()->longest_step();
@@ -6852,13 +7348,33 @@ GCTracer::GCTracer(Heap* heap,
 
 
 GCTracer::~GCTracer() {
-  // Printf ONE line iff flag is set.
-  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
+  double duration = OS::TimeCurrentMillis() - start_time_;
+  if (duration > 0) {
+    if (collector_ == SCAVENGER) {
+      heap_->scavenge_speeds_.Add(start_new_space_size_ / duration);
+    } else if (finishes_incremental_marking_) {
+      heap_->finalize_marking_speeds_.Add(start_object_size_ / duration);
+    } else {
+      heap_->mark_compact_speeds_.Add(start_object_size_ / duration);
+    }
+  }
+  if (spent_in_mutator_ > 0) {
+    intptr_t allocated =
+        start_new_space_size_ - heap_->new_space_size_at_last_gc_;
+    if (allocated > 0) {
+      heap_->new_space_allocation_speeds_.Add(allocated / spent_in_mutator_);
+    }
+  }
+  ReportTiming(duration);
 
   bool first_gc = (heap_->last_gc_end_timestamp_ == 0);
 
   heap_->alive_after_last_gc_ = heap_->SizeOfObjects();
   heap_->last_gc_end_timestamp_ = OS::TimeCurrentMillis();
+  heap_->new_space_size_at_last_gc_ = heap_->new_space()->Size();
+
+  // Printf ONE line iff flag is set.
+  if (!FLAG_trace_gc && !FLAG_print_cumulative_gc_stat) return;
 
   int time = static_cast<int>(heap_->last_gc_end_timestamp_ - start_time_);
 
@@ -6948,6 +7464,8 @@ GCTracer::~GCTracer() {
         Scope::MC_UPDATE_POINTERS_BETWEEN_EVACUATED]));
     PrintF("misc_compaction=%d ",
            static_cast<int>(scopes_[Scope::MC_UPDATE_MISC_POINTERS]));
+    PrintF("dedup=%d ",
+           static_cast<int>(scopes_[Scope::MC_DEDUPLICATE_STRINGS]));
 
     PrintF("total_size_before=%" V8_PTR_PREFIX "d ", start_object_size_);
     PrintF("total_size_after=%" V8_PTR_PREFIX "d ", heap_->SizeOfObjects());
@@ -6957,6 +7475,15 @@ GCTracer::~GCTracer() {
 
     PrintF("allocated=%" V8_PTR_PREFIX "d ", allocated_since_last_gc_);
     PrintF("promoted=%" V8_PTR_PREFIX "d ", promoted_objects_size_);
+    PrintF("deduplicated=%" V8_PTR_PREFIX "d ", deduplicated_strings_size_);
+    PrintF("rescued_slices=%" V8_PTR_PREFIX "d ", rescued_slice_parents_size_);
+
+    if (scavenge_tasks_ > 0) {
+      PrintF("scavenge_tasks=%d ", scavenge_tasks_);
+      for (int i = 0; i < scavenge_tasks_; i++) {
+        PrintF("scavenge_task%d=%.1f ", i, scavenge_task_times_[i]);
+      }
+    }
 
     if (collector_ == SCAVENGER) {
       PrintF("stepscount=%d ", steps_count_since_last_gc_);
@@ -6984,6 +7511,76 @@ const char* GCTracer::CollectorString() {
 }
 
 
+void GCTracer::ReportTiming(double pause) {
+  double phases[v8::GCTimingRecord::kNumberOfPhases];
+  phases[v8::GCTimingRecord::kExternal] = scopes_[Scope::EXTERNAL];
+  phases[v8::GCTimingRecord::kMark] = scopes_[Scope::MC_MARK];
+  phases[v8::GCTimingRecord::kSweep] = scopes_[Scope::MC_SWEEP];
+  phases[v8::GCTimingRecord::kSweepNewSpace] =
+      scopes_[Scope::MC_SWEEP_NEWSPACE];
+  phases[v8::GCTimingRecord::kEvacuate] = scopes_[Scope::MC_EVACUATE_PAGES];
+  phases[v8::GCTimingRecord::kUpdatePointers] =
+      scopes_[Scope::MC_UPDATE_NEW_TO_NEW_POINTERS] +
+      scopes_[Scope::MC_UPDATE_ROOT_TO_NEW_POINTERS] +
+      scopes_[Scope::MC_UPDATE_OLD_TO_NEW_POINTERS] +
+      scopes_[Scope::MC_UPDATE_POINTERS_TO_EVACUATED] +
+      scopes_[Scope::MC_UPDATE_POINTERS_BETWEEN_EVACUATED] +
+      scopes_[Scope::MC_UPDATE_MISC_POINTERS];
+
+  Counters* counters = heap_->isolate()->counters();
+  counters->gc_phase_external()->AddSample(
+      static_cast<int>(phases[v8::GCTimingRecord::kExternal]));
+  if (collector_ == SCAVENGER) {
+    counters->gc_pause_scavenge()->AddSample(static_cast<int>(pause));
+  } else {
+    counters->gc_pause_mark_compact()->AddSample(static_cast<int>(pause));
+    counters->gc_phase_mark()->AddSample(
+        static_cast<int>(phases[v8::GCTimingRecord::kMark]));
+    counters->gc_phase_sweep()->AddSample(
+        static_cast<int>(phases[v8::GCTimingRecord::kSweep]));
+    counters->gc_phase_sweep_new_space()->AddSample(
+        static_cast<int>(phases[v8::GCTimingRecord::kSweepNewSpace]));
+    counters->gc_phase_evacuate()->AddSample(
+        static_cast<int>(phases[v8::GCTimingRecord::kEvacuate]));
+    counters->gc_phase_update_pointers()->AddSample(
+        static_cast<int>(phases[v8::GCTimingRecord::kUpdatePointers]));
+  }
+
+  List<GCTimingCallback>* callbacks = &heap_->gc_timing_callbacks_;
+  if (callbacks->is_empty()) return;
+
+  v8::GCTimingRecord record;
+  intptr_t end_object_size = heap_->SizeOfObjects();
+  record.type_ = (collector_ == SCAVENGER) ? kGCTypeScavenge
+                                           : kGCTypeMarkSweepCompact;
+  record.reason_ = gc_reason_;
+  record.collector_reason_ = collector_reason_;
+  record.pause_in_ms_ = pause;
+  for (int i = 0; i < v8::GCTimingRecord::kNumberOfPhases; i++) {
+    record.phase_times_[i] = phases[i];
+  }
+  record.size_before_ = start_object_size_;
+  record.size_after_ = end_object_size;
+  record.freed_bytes_ = Max(start_object_size_ - end_object_size,
+                            static_cast<intptr_t>(0));
+  record.promoted_bytes_ = promoted_objects_size_;
+  record.deduplicated_bytes_ = deduplicated_strings_size_;
+  record.rescued_bytes_ = rescued_slice_parents_size_;
+  if (collector_ == SCAVENGER) {
+    intptr_t survived = heap_->new_space()->Size() + promoted_objects_size_;
+    record.survival_rate_ = (start_new_space_size_ > 0)
+        ? 100.0 * survived / start_new_space_size_ : 0;
+  } else {
+    record.survival_rate_ = (start_object_size_ > 0)
+        ? 100.0 * end_object_size / start_object_size_ : 0;
+  }
+
+  for (int i = 0; i < callbacks->length(); i++) {
+    callbacks->at(i)(&record);
+  }
+}
+
+
 int KeyedLookupCache::Hash(Map* map, String* name) {
   // Uses only lower 32 bits if pointers are larger.
   uintptr_t addr_hash =
@@ -70,6 +70,7 @@ namespace internal {
   V(Map, scope_info_map, ScopeInfoMap)                                         \
   V(Map, fixed_cow_array_map, FixedCOWArrayMap)                                \
   V(Map, fixed_double_array_map, FixedDoubleArrayMap)                          \
+  V(Map, mutable_heap_number_map, MutableHeapNumberMap)                        \
   V(Object, no_interceptor_result_sentinel, NoInterceptorResultSentinel)       \
   V(Map, hash_table_map, HashTableMap)                                         \
   V(FixedArray, empty_fixed_array, EmptyFixedArray)                            \
@@ -250,6 +251,7 @@ namespace internal {
 class GCTracer;
 class HeapStats;
 class Isolate;
+class ParallelScavenger;
 class WeakObjectRetainer;
 
 
@@ -278,6 +280,43 @@ class StoreBufferRebuilder {
 
 
 
+// A short history of the throughput of one kind of garbage collection
+// work, in bytes per millisecond.  Used to predict how long the work will
+// take the next time.
+class GCSpeedHistory {
+ public:
+  GCSpeedHistory() : length_(0), next_(0) { }
+
+  void Add(double speed) {
+    speeds_[next_] = speed;
+    next_ = (next_ + 1) % kLength;
+    if (length_ < kLength) length_++;
+  }
+
+  // Returns the average of the recorded speeds, or default_speed if
+  // nothing was recorded yet.
+  double Average(double default_speed) const {
+    if (length_ == 0) return default_speed;
+    double sum = 0;
+    for (int i = 0; i < length_; i++) sum += speeds_[i];
+    return sum / length_;
+  }
+
+  // Returns the predicted time in milliseconds to process the given number
+  // of bytes.
+  double PredictTime(intptr_t bytes, double default_speed) const {
+    return bytes / Average(default_speed);
+  }
+
+  static const int kLength = 8;
+
+ private:
+  double speeds_[kLength];
+  int length_;
+  int next_;
+};
+
+
 // The all static Heap captures the interface to the global object heap.
 // All JavaScript contexts by this process share the same object heap.
 
@@ -441,6 +480,20 @@ class Heap {
                      intptr_t max_executable_size);
   bool ConfigureHeapDefault();
 
+  // Sets the policy that grows new space, see CheckNewSpaceExpansionCriteria.
+  // Zero arguments leave the current setting.
+  void ConfigureNewSpaceSizing(int growth_survival_rate,
+                               int target_scavenge_interval_ms);
+
+  static const int kDefaultNewSpaceGrowthSurvivalRate = 10;
+  static const int kDefaultTargetScavengeIntervalMs = 50;
+
+  // Sets the percentage of wall time that mark-compacts should take, see
+  // OldGenThroughputGrowth.  Zero leaves the current setting.
+  void ConfigureOldGenerationGrowing(int target_gc_overhead);
+
+  static const int kDefaultTargetGCOverhead = 5;
+
   // Initializes the global object heap. If create_heap_objects is true,
   // also creates the basic non-mutable objects.
   // Returns whether it succeeded.
@@ -565,8 +618,11 @@ class Heap {
 
   // Returns a deep copy of the JavaScript object.
   // Properties and elements are copied too.
+  // If an allocation site is given, the copy is either allocated in old
+  // space if the site is pretenured or followed by an allocation memento.
   // Returns failure if allocation failed.
-  MUST_USE_RESULT MaybeObject* CopyJSObject(JSObject* source);
+  MUST_USE_RESULT MaybeObject* CopyJSObject(JSObject* source,
+                                            AllocationSite* site = NULL);
 
   // Allocates the function prototype.
   // Returns Failure::RetryAfterGC(requested_bytes, space) if the allocation
@@ -649,6 +705,9 @@ class Heap {
   // Allocates an AliasedArgumentsEntry.
   MUST_USE_RESULT MaybeObject* AllocateAliasedArgumentsEntry(int slot);
 
+  // Allocates a pre-tenured AllocationSite without feedback.
+  MUST_USE_RESULT MaybeObject* AllocateAllocationSite();
+
   // Clear the Instanceof cache (used when a prototype changes).
   inline void ClearInstanceofCache();
 
@@ -778,7 +837,10 @@ class Heap {
 
   // Make a copy of src, set the map, and return the copy. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
-  MUST_USE_RESULT MaybeObject* CopyFixedArrayWithMap(FixedArray* src, Map* map);
+  MUST_USE_RESULT MaybeObject* CopyFixedArrayWithMap(
+      FixedArray* src,
+      Map* map,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Make a copy of src and return it. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
@@ -788,7 +850,9 @@ class Heap {
   // Make a copy of src, set the map, and return the copy. Returns
   // Failure::RetryAfterGC(requested_bytes, space) if the allocation failed.
   MUST_USE_RESULT MaybeObject* CopyFixedDoubleArrayWithMap(
-      FixedDoubleArray* src, Map* map);
+      FixedDoubleArray* src,
+      Map* map,
+      PretenureFlag pretenure = NOT_TENURED);
 
   // Allocates a fixed array initialized with the hole values.
   // Returns Failure::RetryAfterGC(requested_bytes, space) if the allocation
@@ -889,6 +953,13 @@ class Heap {
   // pretenure = NOT_TENURED
   MUST_USE_RESULT MaybeObject* AllocateHeapNumber(double value);
 
+  // Allocates the box of a double field.  It has the mutable heap number
+  // map as long as no one but the object refers to it, see
+  // JSObject::FastPropertyAt.
+  MUST_USE_RESULT MaybeObject* AllocateMutableHeapNumber(
+      double value,
+      PretenureFlag pretenure = NOT_TENURED);
+
   // Converts an int into either a Smi or a HeapNumber object.
   // Returns Failure::RetryAfterGC(requested_bytes, space) if the allocation
   // failed.
@@ -975,6 +1046,16 @@ class Heap {
   // when shortening objects.
   void CreateFillerObjectAt(Address addr, int size);
 
+  // Shrinks a fixed array, fixed double array or sequential string in place
+  // to new_length elements and turns the freed tail into a filler.  Holds
+  // off the concurrent marker while the length and the filler are written,
+  // and keeps the live bytes of the page right if the object is black.
+  void RightTrimObject(HeapObject* object, int new_length);
+
+  // Aligns an object allocated with one extra word of padding to a double
+  // boundary and turns the unused word into a filler.
+  HeapObject* EnsureDoubleAligned(HeapObject* object, int size);
+
   // Makes a new native code object
   // Returns Failure::RetryAfterGC(requested_bytes, space) if the allocation
   // failed. On success, the pointer to the Code object is stored in the
@@ -1050,6 +1131,8 @@ class Heap {
   static const int kSweepPreciselyMask = 1;
   static const int kReduceMemoryFootprintMask = 2;
   static const int kAbortIncrementalMarkingMask = 4;
+  static const int kForceCompactionMask = 8;
+  static const int kFlushAllCodeMask = 16;
 
   // Making the heap iterable requires us to sweep precisely and abort any
   // incremental marking as well.
@@ -1064,6 +1147,10 @@ class Heap {
   // Last hope GC, should try to squeeze as much as possible.
   void CollectAllAvailableGarbage(const char* gc_reason = NULL);
 
+  // Implements the corresponding V8 API function.  Returns the number of
+  // bytes of committed memory that were released.
+  intptr_t MemoryPressureNotification(v8::MemoryPressureLevel level);
+
   // Check whether the heap is currently iterable.
   bool IsHeapIterable();
 
@@ -1107,6 +1194,9 @@ class Heap {
       GCEpilogueCallback callback, GCType gc_type_filter);
   void RemoveGCEpilogueCallback(GCEpilogueCallback callback);
 
+  void AddGCTimingCallback(GCTimingCallback callback);
+  void RemoveGCTimingCallback(GCTimingCallback callback);
+
   void SetGlobalGCPrologueCallback(GCCallback callback) {
     ASSERT((callback == NULL) ^ (global_gc_prologue_callback_ == NULL));
     global_gc_prologue_callback_ = callback;
@@ -1359,10 +1449,27 @@ class Heap {
   static const intptr_t kMinimumAllocationLimit =
       8 * (Page::kPageSize > MB ? Page::kPageSize : MB);
 
+  // Returns how much the old generation may grow before the next
+  // mark-compact so that mark-compacts take the target share of wall time
+  // at the measured mark-compact speed and old generation allocation rate.
+  // Returns -1 if the allocation rate was not measured yet.
+  intptr_t OldGenThroughputGrowth(intptr_t old_gen_size) {
+    double allocation_speed = old_generation_allocation_speeds_.Average(0);
+    if (allocation_speed <= 0 || FLAG_stress_compaction) return -1;
+    double gc_time = mark_compact_speeds_.PredictTime(old_gen_size,
+                                                      kInitialMarkCompactSpeed);
+    double growth = allocation_speed * gc_time * 100 / target_gc_overhead_;
+    return static_cast<intptr_t>(Min(growth,
+        static_cast<double>(max_old_generation_size_)));
+  }
+
   intptr_t OldGenPromotionLimit(intptr_t old_gen_size) {
     const int divisor = FLAG_stress_compaction ? 10 : 3;
-    intptr_t limit =
-        Max(old_gen_size + old_gen_size / divisor, kMinimumPromotionLimit);
+    intptr_t growth = OldGenThroughputGrowth(old_gen_size);
+    // Keep the promotion limit below the allocation limit in the same ratio
+    // as the fixed growing factors do.
+    growth = growth < 0 ? old_gen_size / divisor : growth * 2 / 3;
+    intptr_t limit = Max(old_gen_size + growth, kMinimumPromotionLimit);
     limit += new_space_.Capacity();
     limit *= old_gen_limit_factor_;
     intptr_t halfway_to_the_max = (old_gen_size + max_old_generation_size_) / 2;
@@ -1371,8 +1478,9 @@ class Heap {
 
   intptr_t OldGenAllocationLimit(intptr_t old_gen_size) {
     const int divisor = FLAG_stress_compaction ? 8 : 2;
-    intptr_t limit =
-        Max(old_gen_size + old_gen_size / divisor, kMinimumAllocationLimit);
+    intptr_t growth = OldGenThroughputGrowth(old_gen_size);
+    if (growth < 0) growth = old_gen_size / divisor;
+    intptr_t limit = Max(old_gen_size + growth, kMinimumAllocationLimit);
     limit += new_space_.Capacity();
     limit *= old_gen_limit_factor_;
     intptr_t halfway_to_the_max = (old_gen_size + max_old_generation_size_) / 2;
@@ -1382,6 +1490,20 @@ class Heap {
   // Implements the corresponding V8 API function.
   bool IdleNotification(int hint);
 
+  // Implements the corresponding V8 API function.  Only starts work that
+  // the recorded GC speeds predict to finish within idle_time_in_ms.  The
+  // work done is returned as a combination of v8::IdleTaskReport::Work
+  // flags; time_needed_in_ms is set to the predicted duration of the most
+  // urgent work that did not fit, or 0.
+  bool IdleNotificationDeadline(int idle_time_in_ms,
+                                int* work_done,
+                                double* time_needed_in_ms);
+
+  // Records the throughput of an incremental marking step.
+  void RecordIncrementalMarkingStep(intptr_t bytes, double time_in_ms) {
+    if (time_in_ms > 0) marking_speeds_.Add(bytes / time_in_ms);
+  }
+
   // Declare all the root indices.
   enum RootListIndex {
 #define ROOT_INDEX_DECLARATION(type, name, camel_name) k##camel_name##RootIndex,
@@ -1430,6 +1552,10 @@ class Heap {
   // Check new space expansion criteria and expand semispaces if it was hit.
   void CheckNewSpaceExpansionCriteria();
 
+  // Measures how fast the old generation grew since the last mark-compact.
+  // Called at the start of a mark-compact.
+  void RecordOldGenerationAllocationSpeed();
+
   inline void IncrementYoungSurvivorsCounter(int survived) {
     ASSERT(survived >= 0);
     young_survivors_after_last_gc_ = survived;
@@ -1473,6 +1599,12 @@ class Heap {
   // we try to promote this object.
   inline bool ShouldBePromoted(Address old_address, int object_size);
 
+  // Called by the scavenger for every object it evacuates from new space.
+  // Records the survival of the object with its allocation site if the
+  // object is followed by an allocation memento.
+  inline void UpdateAllocationSiteFeedback(HeapObject* object,
+                                           int object_size);
+
   int MaxObjectSizeInNewSpace() { return kMaxObjectSizeInNewSpace; }
 
   void ClearJSFunctionResultCaches();
@@ -1517,6 +1649,10 @@ class Heap {
     return &marking_;
   }
 
+  ParallelScavenger* parallel_scavenger() {
+    return parallel_scavenger_;
+  }
+
   IncrementalMarking* incremental_marking() {
     return &incremental_marking_;
   }
@@ -1628,16 +1764,21 @@ class Heap {
   void CheckpointObjectStats();
 
   // We don't use a ScopedLock here since we want to lock the heap
-  // only when FLAG_parallel_recompilation is true.
+  // only when FLAG_parallel_recompilation is true.  The collector takes the
+  // lock exclusively while it moves objects, the compiler threads share it
+  // while they read the heap.  A waiting collection keeps new compiler
+  // threads out so that busy compiler threads cannot starve it.
   class RelocationLock {
    public:
     explicit RelocationLock(Heap* heap) : heap_(heap) {
       if (FLAG_parallel_recompilation) {
         heap_->relocation_mutex_->Lock();
+        heap_->relocation_room_->Wait();
       }
     }
     ~RelocationLock() {
       if (FLAG_parallel_recompilation) {
+        heap_->relocation_room_->Signal();
         heap_->relocation_mutex_->Unlock();
       }
     }
@@ -1646,6 +1787,32 @@ class Heap {
     Heap* heap_;
   };
 
+  class SharedRelocationLock {
+   public:
+    explicit SharedRelocationLock(Heap* heap) : heap_(heap) {
+      if (FLAG_parallel_recompilation) {
+        // Wait for a waiting or running collection to finish.
+        heap_->relocation_mutex_->Lock();
+        heap_->relocation_mutex_->Unlock();
+        ScopedLock lock(heap_->relocation_readers_mutex_);
+        if (heap_->relocation_readers_++ == 0) {
+          heap_->relocation_room_->Wait();
+        }
+      }
+    }
+    ~SharedRelocationLock() {
+      if (FLAG_parallel_recompilation) {
+        ScopedLock lock(heap_->relocation_readers_mutex_);
+        if (--heap_->relocation_readers_ == 0) {
+          heap_->relocation_room_->Signal();
+        }
+      }
+    }
+
+   private:
+    Heap* heap_;
+  };
+
  private:
   Heap();
 
@@ -1666,6 +1833,15 @@ class Heap {
   // scavenge since last new space expansion.
   int survived_since_last_expansion_;
 
+  // New space grows when fewer than this percentage of its objects survive
+  // scavenges and it fills up faster than the target scavenge interval.
+  int new_space_growth_survival_rate_;
+  int target_scavenge_interval_ms_;
+
+  // Size of new space after the last collection, used to compute how much
+  // the mutator allocated in between.
+  intptr_t new_space_size_at_last_gc_;
+
   // For keeping track on when to flush RegExp code.
   int sweep_generation_;
 
@@ -1738,6 +1914,10 @@ class Heap {
   // rates caused by the mutator allocating a lot of long-lived objects.
   bool new_space_high_promotion_mode_active_;
 
+  // The new space allocation top before the semispaces were flipped for the
+  // current scavenge.  No object in from space lies beyond it.
+  Address new_space_top_at_scavenge_start_;
+
   // Limit that triggers a global GC on the next (normally caused) GC.  This
   // is checked when we have already decided to do a GC to help determine
   // which collector to invoke.
@@ -1755,6 +1935,14 @@ class Heap {
   // Used to adjust the limits that control the timing of the next GC.
   intptr_t size_of_old_gen_at_last_old_space_gc_;
 
+  // Percentage of wall time that mark-compacts should take.  The old
+  // generation limits are set to reach it once the allocation rate is known.
+  int target_gc_overhead_;
+
+  // End of the last mark-compact, used to measure the old generation
+  // allocation rate.
+  double last_mark_compact_end_time_;
+
   // Limit on the amount of externally allocated memory allowed
   // between global GCs. If reached a global GC is forced.
   intptr_t external_allocation_limit_;
@@ -1825,6 +2013,8 @@ class Heap {
   };
   List<GCEpilogueCallbackPair> gc_epilogue_callbacks_;
 
+  List<GCTimingCallback> gc_timing_callbacks_;
+
   GCCallback global_gc_prologue_callback_;
   GCCallback global_gc_epilogue_callback_;
 
@@ -1893,6 +2083,9 @@ class Heap {
   // Performs a minor collection in new generation.
   void Scavenge();
 
+  // Evacuates the live objects of new space with the parallel scavenger.
+  void ScavengeInParallel();
+
   static String* UpdateNewSpaceReferenceInExternalStringTableEntry(
       Heap* heap,
       Object** pointer);
@@ -2039,6 +2232,8 @@ class Heap {
 
   void AdvanceIdleIncrementalMarking(intptr_t step_size);
 
+  void FinalizeIdleIncrementalMarking();
+
   void ClearObjectStats(bool clear_last_time_stats = false);
 
   static const int kInitialSymbolTableSize = 2048;
@@ -2085,6 +2280,33 @@ class Heap {
   static const int kMaxMarkSweepsInIdleRound = 7;
   static const int kIdleScavengeThreshold = 5;
 
+  // Throughput of the collectors in bytes per millisecond, recorded by the
+  // GCTracer and by incremental marking steps.  Scavenges are measured
+  // against the size of new space, mark-compacts against the size of all
+  // objects.
+  GCSpeedHistory scavenge_speeds_;
+  GCSpeedHistory marking_speeds_;
+  GCSpeedHistory finalize_marking_speeds_;
+  GCSpeedHistory mark_compact_speeds_;
+
+  // Bytes allocated in new space per millisecond of mutator time.
+  GCSpeedHistory new_space_allocation_speeds_;
+
+  // Bytes allocated in or promoted to the old generation per millisecond of
+  // wall time between mark-compacts.
+  GCSpeedHistory old_generation_allocation_speeds_;
+
+  // Speeds assumed before anything was measured.  They are on the slow side
+  // so that the first idle notifications err towards doing too little.
+  static const int kInitialScavengeSpeed = 512 * KB;
+  static const int kInitialMarkingSpeed = 256 * KB;
+  static const int kInitialFinalizeMarkingSpeed = 1 * MB;
+  static const int kInitialMarkCompactSpeed = 512 * KB;
+
+  // An idle notification scavenges when new space is this full.
+  static const int kIdleScavengeFullnessPercent = 80;
+  static const int kIdleSweepingStepSize = 64 * KB;
+
   // Shared state read by the scavenge collector and set by ScavengeObject.
   PromotionQueue promotion_queue_;
 
@@ -2099,6 +2321,12 @@ class Heap {
   MemoryChunk* chunks_queued_for_free_;
 
   Mutex* relocation_mutex_;
+  Mutex* relocation_readers_mutex_;
+  // Held by the collector or, together, by the compiler threads.
+  Semaphore* relocation_room_;
+  int relocation_readers_;
+
+  ParallelScavenger* parallel_scavenger_;
 
   friend class Factory;
   friend class GCTracer;
@@ -2110,6 +2338,8 @@ class Heap {
   friend class MarkCompactCollector;
   friend class StaticMarkingVisitor;
   friend class MapCompact;
+  friend class ParallelScavenger;
+  friend class ScavengeTask;
 
   DISALLOW_COPY_AND_ASSIGN(Heap);
 };
@@ -2141,10 +2371,11 @@ class HeapStats {
   int* free_global_handle_count;        // 18
   intptr_t* memory_allocator_size;           // 19
   intptr_t* memory_allocator_capacity;       // 20
-  int* objects_per_type;                // 21
-  int* size_per_type;                   // 22
-  int* os_error;                        // 23
-  int* end_marker;                      // 24
+  intptr_t* memory_allocator_pooled_size;    // 21
+  int* objects_per_type;                // 22
+  int* size_per_type;                   // 23
+  int* os_error;                        // 24
+  int* end_marker;                      // 25
 };
 
 
@@ -2460,6 +2691,7 @@ class GCTracer BASE_EMBEDDED {
       MC_UPDATE_POINTERS_BETWEEN_EVACUATED,
       MC_UPDATE_MISC_POINTERS,
       MC_FLUSH_CODE,
+      MC_DEDUPLICATE_STRINGS,
       kNumberOfScopes
     };
 
@@ -2498,6 +2730,23 @@ class GCTracer BASE_EMBEDDED {
     promoted_objects_size_ += object_size;
   }
 
+  void increment_deduplicated_strings_size(int object_size) {
+    deduplicated_strings_size_ += object_size;
+  }
+
+  void increment_rescued_slice_parents_size(int object_size) {
+    rescued_slice_parents_size_ += object_size;
+  }
+
+  // Records the time spent by a task of the parallel scavenger.
+  void set_scavenge_task_time(int task, double time) {
+    ASSERT(task < kMaxScavengeTasks);
+    scavenge_task_times_[task] = time;
+    scavenge_tasks_ = Max(scavenge_tasks_, task + 1);
+  }
+
+  static const int kMaxScavengeTasks = 16;
+
  private:
   // Returns a string matching the collector.
   const char* CollectorString();
@@ -2505,6 +2754,9 @@ class GCTracer BASE_EMBEDDED {
   // Returns size of object in heap (in MB).
   inline double SizeOfHeapObjects();
 
+  // Samples the pause histograms and calls the GC timing callbacks.
+  void ReportTiming(double pause);
+
   // Timestamp set in the constructor.
   double start_time_;
 
@@ -2514,6 +2766,12 @@ class GCTracer BASE_EMBEDDED {
   // Size of memory allocated from OS set in constructor.
   intptr_t start_memory_size_;
 
+  // Size of new space set in constructor.
+  intptr_t start_new_space_size_;
+
+  // Whether a mark-compact finishes incremental marking, set in constructor.
+  bool finishes_incremental_marking_;
+
   // Type of collector.
   GarbageCollector collector_;
 
@@ -2542,6 +2800,16 @@ class GCTracer BASE_EMBEDDED {
   // Size of objects promoted during the current collection.
   intptr_t promoted_objects_size_;
 
+  // Size of the strings freed by string deduplication.
+  intptr_t deduplicated_strings_size_;
+
+  // Size of the strings freed because their slices were copied out.
+  intptr_t rescued_slice_parents_size_;
+
+  // Amounts of time spent by the tasks of the parallel scavenger.
+  int scavenge_tasks_;
+  double scavenge_task_times_[kMaxScavengeTasks];
+
   // Incremental marking steps counters.
   int steps_count_;
   double steps_took_;
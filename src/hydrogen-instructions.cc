@@ -1369,6 +1369,29 @@ void HSimulate::PrintDataTo(StringStream* stream) {
 }
 
 
+void HCapturedObject::PrintDataTo(StringStream* stream) {
+  stream->Add("#%d", capture_id());
+  for (int i = 0; i < values_.length(); ++i) {
+    stream->Add(i == 0 ? " " : ", ");
+    values_[i]->PrintNameTo(stream);
+  }
+}
+
+
+void HCapturedObject::ReplayEnvironment(HEnvironment* env) {
+  while (env != NULL) {
+    for (int i = 0; i < env->length(); ++i) {
+      HValue* value = env->values()->at(i);
+      if (value->IsCapturedObject() &&
+          HCapturedObject::cast(value)->capture_id() == capture_id()) {
+        env->SetValueAt(i, this);
+      }
+    }
+    env = env->outer();
+  }
+}
+
+
 void HDeoptimize::PrintDataTo(StringStream* stream) {
   if (OperandCount() == 0) return;
   OperandAt(0)->PrintNameTo(stream);
@@ -1666,6 +1689,7 @@ void HParameter::PrintDataTo(StringStream* stream) {
 void HLoadNamedField::PrintDataTo(StringStream* stream) {
   object()->PrintNameTo(stream);
   stream->Add(" @%d%s", offset(), is_in_object() ? "[in-object]" : "");
+  if (is_double_field()) stream->Add(" (double)");
 }
 
 
@@ -1720,6 +1744,9 @@ HLoadNamedFieldPolymorphic::HLoadNamedFieldPolymorphic(HValue* context,
     if (lookup.IsFound()) {
       switch (lookup.type()) {
         case FIELD: {
+          // Double fields hand out their box only after changing its map,
+          // so the generic stub handles them.
+          if (lookup.IsDoubleField()) break;
           int index = lookup.GetLocalFieldIndexFromMap(*map);
           if (index < 0) {
             SetGVNFlag(kDependsOnInobjectFields);
@@ -1938,6 +1965,7 @@ void HStoreNamedField::PrintDataTo(StringStream* stream) {
   stream->Add(" = ");
   value()->PrintNameTo(stream);
   stream->Add(" @%d%s", offset(), is_in_object() ? "[in-object]" : "");
+  if (is_double_field()) stream->Add(" (double)");
   if (NeedsWriteBarrier()) {
     stream->Add(" (write-barrier)");
   }
@@ -82,6 +82,7 @@ class LChunkBuilder;
   V(CallNew)                                   \
   V(CallRuntime)                               \
   V(CallStub)                                  \
+  V(CapturedObject)                            \
   V(Change)                                    \
   V(CheckFunction)                             \
   V(CheckInstanceType)                         \
@@ -1364,6 +1365,51 @@ class HSimulate: public HInstruction {
 };
 
 
+// The state of an allocation that escape analysis replaced by its fields.
+// The operands are the values of the object's in-object fields at this point
+// of the program.  Environments refer to the latest state, so the deoptimizer
+// can rematerialize the object.
+class HCapturedObject: public HInstruction {
+ public:
+  HCapturedObject(int capture_id, Handle<Map> map, int length, Zone* zone)
+      : capture_id_(capture_id),
+        map_(map),
+        values_(length, zone) {
+    values_.AddBlock(NULL, length, zone);
+    set_representation(Representation::Tagged());
+  }
+
+  virtual void PrintDataTo(StringStream* stream);
+
+  // The id of the removed allocation, shared by all states of the object.
+  int capture_id() const { return capture_id_; }
+  Handle<Map> map() const { return map_; }
+
+  virtual int OperandCount() { return values_.length(); }
+  virtual HValue* OperandAt(int index) { return values_[index]; }
+
+  virtual Representation RequiredInputRepresentation(int index) {
+    return Representation::None();
+  }
+
+  // Replaces the earlier states of the object in the given environment and
+  // its outer environments by this one.
+  void ReplayEnvironment(HEnvironment* env);
+
+  DECLARE_CONCRETE_INSTRUCTION(CapturedObject)
+
+ protected:
+  virtual void InternalSetOperandAt(int index, HValue* value) {
+    values_[index] = value;
+  }
+
+ private:
+  int capture_id_;
+  Handle<Map> map_;
+  ZoneList<HValue*> values_;
+};
+
+
 class HStackCheck: public HTemplateInstruction<1> {
  public:
   enum Type {
@@ -2354,11 +2400,15 @@ class HPhi: public HValue {
       non_phi_uses_[i] = 0;
       indirect_uses_[i] = 0;
     }
-    ASSERT(merged_index >= 0);
+    ASSERT(merged_index >= 0 || merged_index == kInvalidMergedIndex);
     set_representation(Representation::Tagged());
     SetFlag(kFlexibleRepresentation);
   }
 
+  // Phis that do not merge an environment slot, like the fields of a
+  // captured object, have no merged index.
+  static const int kInvalidMergedIndex = -1;
+
   virtual Representation InferredRepresentation();
 
   virtual Range* InferRange(Zone* zone);
@@ -2375,6 +2425,7 @@ class HPhi: public HValue {
   bool IsReceiver() { return merged_index_ == 0; }
 
   int merged_index() const { return merged_index_; }
+  bool HasMergedIndex() const { return merged_index_ != kInvalidMergedIndex; }
 
   virtual void PrintTo(StringStream* stream);
 
@@ -3730,6 +3781,9 @@ inline bool StoringValueNeedsWriteBarrier(HValue* value) {
 
 inline bool ReceiverObjectNeedsWriteBarrier(HValue* object,
                                             HValue* new_space_dominator) {
+  // The concurrent marker may visit a fresh object as soon as it has been
+  // stored into the heap, so later stores into it need the barrier too.
+  if (FLAG_concurrent_marking) return true;
   return !object->IsAllocateObject() || (object != new_space_dominator);
 }
 
@@ -3925,6 +3979,7 @@ class HLoadNamedField: public HUnaryOperation {
   HLoadNamedField(HValue* object, bool is_in_object, int offset)
       : HUnaryOperation(object),
         is_in_object_(is_in_object),
+        is_double_field_(false),
         offset_(offset) {
     set_representation(Representation::Tagged());
     SetFlag(kUseGVN);
@@ -3940,6 +3995,14 @@ class HLoadNamedField: public HUnaryOperation {
   bool is_in_object() const { return is_in_object_; }
   int offset() const { return offset_; }
 
+  // Loads the untagged value out of the box of a double field.
+  bool is_double_field() const { return is_double_field_; }
+  void set_is_double_field() {
+    ASSERT(is_in_object_);
+    is_double_field_ = true;
+    set_representation(Representation::Double());
+  }
+
   virtual Representation RequiredInputRepresentation(int index) {
     return Representation::Tagged();
   }
@@ -3950,11 +4013,14 @@ class HLoadNamedField: public HUnaryOperation {
  protected:
   virtual bool DataEquals(HValue* other) {
     HLoadNamedField* b = HLoadNamedField::cast(other);
-    return is_in_object_ == b->is_in_object_ && offset_ == b->offset_;
+    return is_in_object_ == b->is_in_object_ &&
+        is_double_field_ == b->is_double_field_ &&
+        offset_ == b->offset_;
   }
 
  private:
   bool is_in_object_;
+  bool is_double_field_;
   int offset_;
 };
 
@@ -4274,6 +4340,7 @@ class HStoreNamedField: public HTemplateInstruction<2> {
                    int offset)
       : name_(name),
         is_in_object_(in_object),
+        is_double_field_(false),
         offset_(offset),
         new_space_dominator_(NULL) {
     SetOperandAt(0, obj);
@@ -4290,6 +4357,7 @@ class HStoreNamedField: public HTemplateInstruction<2> {
   DECLARE_CONCRETE_INSTRUCTION(StoreNamedField)
 
   virtual Representation RequiredInputRepresentation(int index) {
+    if (index == 1 && is_double_field_) return Representation::Double();
     return Representation::Tagged();
   }
   virtual void SetSideEffectDominator(GVNFlag side_effect, HValue* dominator) {
@@ -4308,6 +4376,17 @@ class HStoreNamedField: public HTemplateInstruction<2> {
   void set_transition(Handle<Map> map) { transition_ = map; }
   HValue* new_space_dominator() const { return new_space_dominator_; }
 
+  // Stores an untagged value into the box of a double field.  Only numbers
+  // may be stored, so undefined must deoptimize rather than turn into NaN.
+  // The store allocates a new box if the old one has been handed out.
+  bool is_double_field() const { return is_double_field_; }
+  void set_is_double_field() {
+    ASSERT(is_in_object_ && transition_.is_null());
+    is_double_field_ = true;
+    SetFlag(kDeoptimizeOnUndefined);
+    SetGVNFlag(kChangesNewSpacePromotion);
+  }
+
   bool NeedsWriteBarrier() {
     return StoringValueNeedsWriteBarrier(value()) &&
         ReceiverObjectNeedsWriteBarrier(object(), new_space_dominator());
@@ -4320,6 +4399,7 @@ class HStoreNamedField: public HTemplateInstruction<2> {
  private:
   Handle<String> name_;
   bool is_in_object_;
+  bool is_double_field_;
   int offset_;
   Handle<Map> transition_;
   HValue* new_space_dominator_;
@@ -4710,8 +4790,12 @@ class HStringLength: public HUnaryOperation {
 
 class HAllocateObject: public HTemplateInstruction<1> {
  public:
-  HAllocateObject(HValue* context, Handle<JSFunction> constructor)
-      : constructor_(constructor) {
+  HAllocateObject(HValue* context,
+                  Handle<JSFunction> constructor,
+                  Handle<AllocationSite> allocation_site)
+      : constructor_(constructor),
+        initial_map_(constructor->initial_map()),
+        allocation_site_(allocation_site) {
     SetOperandAt(0, context);
     set_representation(Representation::Tagged());
     SetGVNFlag(kChangesNewSpacePromotion);
@@ -4722,6 +4806,9 @@ class HAllocateObject: public HTemplateInstruction<1> {
 
   HValue* context() { return OperandAt(0); }
   Handle<JSFunction> constructor() { return constructor_; }
+  Handle<Map> initial_map() { return initial_map_; }
+  // The site tracking the allocation, or a null handle if none.
+  Handle<AllocationSite> allocation_site() { return allocation_site_; }
 
   virtual Representation RequiredInputRepresentation(int index) {
     return Representation::Tagged();
@@ -4732,6 +4819,8 @@ class HAllocateObject: public HTemplateInstruction<1> {
 
  private:
   Handle<JSFunction> constructor_;
+  Handle<Map> initial_map_;
+  Handle<AllocationSite> allocation_site_;
 };
 
 
@@ -4756,12 +4845,15 @@ class HFastLiteral: public HMaterializedLiteral<1> {
  public:
   HFastLiteral(HValue* context,
                Handle<JSObject> boilerplate,
+               Handle<AllocationSite> allocation_site,
                int total_size,
                int literal_index,
                int depth)
       : HMaterializedLiteral<1>(literal_index, depth),
         boilerplate_(boilerplate),
-        total_size_(total_size) {
+        allocation_site_(allocation_site),
+        total_size_(total_size),
+        boilerplate_fields_(NULL) {
     SetOperandAt(0, context);
     SetGVNFlag(kChangesNewSpacePromotion);
   }
@@ -4773,8 +4865,21 @@ class HFastLiteral: public HMaterializedLiteral<1> {
 
   HValue* context() { return OperandAt(0); }
   Handle<JSObject> boilerplate() const { return boilerplate_; }
+  // The site tracking the outermost copy, or a null handle if none.  The
+  // total size includes the allocation memento of a tracked copy.
+  Handle<AllocationSite> allocation_site() const { return allocation_site_; }
   int total_size() const { return total_size_; }
 
+  // The map and in-object field values of a boilerplate that is a plain
+  // object without nested literals, so that escape analysis can replace the
+  // copy by its fields.  NULL for all other boilerplates.
+  Handle<Map> boilerplate_map() const { return boilerplate_map_; }
+  ZoneList<HValue*>* boilerplate_fields() const { return boilerplate_fields_; }
+  void set_boilerplate_fields(Handle<Map> map, ZoneList<HValue*>* fields) {
+    boilerplate_map_ = map;
+    boilerplate_fields_ = fields;
+  }
+
   virtual Representation RequiredInputRepresentation(int index) {
     return Representation::Tagged();
   }
@@ -4784,7 +4889,10 @@ class HFastLiteral: public HMaterializedLiteral<1> {
 
  private:
   Handle<JSObject> boilerplate_;
+  Handle<AllocationSite> allocation_site_;
   int total_size_;
+  Handle<Map> boilerplate_map_;
+  ZoneList<HValue*>* boilerplate_fields_;
 };
 
 
@@ -1377,6 +1377,411 @@ void HRangeAnalysis::AddRange(HValue* value, Range* range) {
 }
 
 
+// Replaces allocations that do not escape the optimized function by the
+// values of their in-object fields.  An allocation is captured if it is only
+// used by loads and stores of those fields, by map and smi checks, and by
+// simulates.  Loads are replaced by the last stored values and stores and
+// checks are removed.  Simulates refer to HCapturedObject states instead,
+// from which the deoptimizer rematerializes the object.
+class HEscapeAnalysis BASE_EMBEDDED {
+ public:
+  explicit HEscapeAnalysis(HGraph* graph)
+      : graph_(graph),
+        zone_(graph->zone()),
+        block_maps_(graph->blocks()->length(), zone_),
+        block_states_(graph->blocks()->length(), zone_),
+        store_blocks_(4, zone_),
+        store_fields_(4, zone_),
+        loop_phis_(4, zone_),
+        loop_phi_fields_(4, zone_) { }
+
+  void Analyze();
+
+ private:
+  void TraceEscape(const char* msg, ...);
+  Handle<Map> InitialMap(HInstruction* allocation);
+  bool IsCapturedField(Handle<Map> map,
+                       bool is_in_object,
+                       bool is_double_field,
+                       int offset);
+  bool HasOnlyFieldUses(HInstruction* allocation, Handle<Map> map);
+  bool HasStableMap(HInstruction* allocation, Handle<Map> map);
+  void ReplaceAllocation(HInstruction* allocation, Handle<Map> map);
+  HCapturedObject* NewState(HCapturedObject* state, Handle<Map> map);
+  HCapturedObject* StateAtEntry(HBasicBlock* block);
+  bool IsStoredInLoop(int field, HBasicBlock* loop_header);
+  bool IsDominatedBy(HBasicBlock* block, HBasicBlock* dominator) {
+    return block == dominator || dominator->Dominates(block);
+  }
+  static int FieldIndex(int offset) {
+    return (offset - JSObject::kHeaderSize) / kPointerSize;
+  }
+
+  HGraph* graph_;
+  Zone* zone_;
+  // The map of the object at the end of each block.
+  ZoneList<Handle<Map> > block_maps_;
+  // The state of the object at the end of each block.
+  ZoneList<HCapturedObject*> block_states_;
+  // The blocks and field indices of the stores to the object.
+  ZoneList<HBasicBlock*> store_blocks_;
+  ZoneList<int> store_fields_;
+  // Field phis at loop headers, whose back edge inputs are added after the
+  // loop has been processed.
+  ZoneList<HPhi*> loop_phis_;
+  ZoneList<int> loop_phi_fields_;
+};
+
+
+void HEscapeAnalysis::TraceEscape(const char* msg, ...) {
+  if (FLAG_trace_escape_analysis) {
+    va_list arguments;
+    va_start(arguments, msg);
+    OS::VPrint(msg, arguments);
+    va_end(arguments);
+  }
+}
+
+
+void HEscapeAnalysis::Analyze() {
+  HPhase phase("H_Escape analysis", graph_);
+  const ZoneList<HBasicBlock*>* blocks = graph_->blocks();
+
+  // Collect the candidates first, replacing them changes the graph.  The
+  // arguments of inlined functions using 'arguments' are materialized from
+  // their values, so allocations passed there escape.
+  ZoneList<HInstruction*> allocations(4, zone_);
+  ZoneList<HValue*> materialized_arguments(4, zone_);
+  for (int i = 0; i < blocks->length(); ++i) {
+    for (HInstruction* instr = blocks->at(i)->first();
+         instr != NULL;
+         instr = instr->next()) {
+      if (instr->IsAllocateObject()) {
+        allocations.Add(instr, zone_);
+      } else if (instr->IsFastLiteral() &&
+                 HFastLiteral::cast(instr)->boilerplate_fields() != NULL) {
+        allocations.Add(instr, zone_);
+      } else if (instr->IsEnterInlined()) {
+        ZoneList<HValue*>* arguments =
+            HEnterInlined::cast(instr)->arguments_values();
+        if (arguments != NULL) materialized_arguments.AddAll(*arguments, zone_);
+      }
+    }
+  }
+
+  for (int i = 0; i < allocations.length(); ++i) {
+    HInstruction* allocation = allocations[i];
+    Handle<Map> map = InitialMap(allocation);
+    // Only objects without a backing store can be described by their
+    // in-object fields.
+    if (map->has_double_fields() ||
+        map->instance_size() - map->inobject_properties() * kPointerSize !=
+            JSObject::kHeaderSize) {
+      continue;
+    }
+    if (materialized_arguments.Contains(allocation)) continue;
+    if (!HasOnlyFieldUses(allocation, map)) {
+      TraceEscape("Allocation %d escapes\n", allocation->id());
+      continue;
+    }
+    if (!HasStableMap(allocation, map)) {
+      TraceEscape("Allocation %d changes its map in a loop or merge\n",
+                  allocation->id());
+      continue;
+    }
+    TraceEscape("Replacing allocation %d by its %d fields\n",
+                allocation->id(),
+                map->inobject_properties());
+    ReplaceAllocation(allocation, map);
+  }
+}
+
+
+Handle<Map> HEscapeAnalysis::InitialMap(HInstruction* allocation) {
+  if (allocation->IsAllocateObject()) {
+    return HAllocateObject::cast(allocation)->initial_map();
+  }
+  return HFastLiteral::cast(allocation)->boilerplate_map();
+}
+
+
+bool HEscapeAnalysis::IsCapturedField(Handle<Map> map,
+                                      bool is_in_object,
+                                      bool is_double_field,
+                                      int offset) {
+  return is_in_object &&
+      !is_double_field &&
+      offset >= JSObject::kHeaderSize &&
+      offset < map->instance_size() &&
+      (offset - JSObject::kHeaderSize) % kPointerSize == 0;
+}
+
+
+bool HEscapeAnalysis::HasOnlyFieldUses(HInstruction* allocation,
+                                       Handle<Map> map) {
+  store_blocks_.Rewind(0);
+  store_fields_.Rewind(0);
+  for (HUseIterator it(allocation->uses()); !it.Done(); it.Advance()) {
+    HValue* use = it.value();
+    if (use->IsSimulate()) continue;
+    if (use->IsLoadNamedField()) {
+      HLoadNamedField* load = HLoadNamedField::cast(use);
+      if (!IsCapturedField(map,
+                           load->is_in_object(),
+                           load->is_double_field(),
+                           load->offset())) {
+        return false;
+      }
+    } else if (use->IsStoreNamedField()) {
+      HStoreNamedField* store = HStoreNamedField::cast(use);
+      if (it.index() != 0 || store->value() == allocation) return false;
+      if (!IsCapturedField(map,
+                           store->is_in_object(),
+                           store->is_double_field(),
+                           store->offset())) {
+        return false;
+      }
+      // The object keeps its size, so transitions may only add fields
+      // that are already preallocated in the object.
+      Handle<Map> transition = store->transition();
+      if (!transition.is_null() &&
+          (transition->instance_size() != map->instance_size() ||
+           transition->inobject_properties() != map->inobject_properties() ||
+           transition->has_double_fields())) {
+        return false;
+      }
+      store_blocks_.Add(store->block(), zone_);
+      store_fields_.Add(FieldIndex(store->offset()), zone_);
+    } else if (use->IsCheckMaps()) {
+      if (HCheckMaps::cast(use)->value() != allocation ||
+          !use->HasNoUses()) {
+        return false;
+      }
+    } else if (use->IsCheckNonSmi()) {
+      if (!use->HasNoUses()) return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// Follows the map of the object through the graph.  The states of the
+// object are merged field by field, so the map must agree at merges and be
+// the same around loops.  Map checks of the object must succeed.
+bool HEscapeAnalysis::HasStableMap(HInstruction* allocation,
+                                   Handle<Map> map) {
+  const ZoneList<HBasicBlock*>* blocks = graph_->blocks();
+  HBasicBlock* allocation_block = allocation->block();
+  block_maps_.Rewind(0);
+  block_maps_.AddBlock(Handle<Map>::null(), blocks->length(), zone_);
+  for (int i = allocation_block->block_id(); i < blocks->length(); ++i) {
+    HBasicBlock* block = blocks->at(i);
+    if (!IsDominatedBy(block, allocation_block)) continue;
+    Handle<Map> current;
+    HInstruction* instr;
+    if (block == allocation_block) {
+      current = map;
+      instr = allocation->next();
+    } else {
+      const ZoneList<HBasicBlock*>* predecessors = block->predecessors();
+      current = block_maps_[predecessors->at(0)->block_id()];
+      if (!block->IsLoopHeader()) {
+        for (int j = 1; j < predecessors->length(); ++j) {
+          if (*block_maps_[predecessors->at(j)->block_id()] != *current) {
+            return false;
+          }
+        }
+      }
+      instr = block->first();
+    }
+    for (; instr != NULL; instr = instr->next()) {
+      if (instr->IsStoreNamedField() &&
+          HStoreNamedField::cast(instr)->object() == allocation) {
+        Handle<Map> transition = HStoreNamedField::cast(instr)->transition();
+        if (transition.is_null()) continue;
+        if (transition->GetBackPointer() != *current) return false;
+        current = transition;
+      } else if (instr->IsCheckMaps() &&
+                 HCheckMaps::cast(instr)->value() == allocation) {
+        SmallMapList* maps = HCheckMaps::cast(instr)->map_set();
+        bool found = false;
+        for (int j = 0; j < maps->length(); ++j) {
+          if (*maps->at(j) == *current) found = true;
+        }
+        if (!found) return false;
+      }
+    }
+    block_maps_[i] = current;
+  }
+
+  for (int i = allocation_block->block_id() + 1; i < blocks->length(); ++i) {
+    HBasicBlock* block = blocks->at(i);
+    if (!block->IsLoopHeader() || !IsDominatedBy(block, allocation_block)) {
+      continue;
+    }
+    const ZoneList<HBasicBlock*>* predecessors = block->predecessors();
+    Map* entry_map = *block_maps_[predecessors->at(0)->block_id()];
+    for (int j = 1; j < predecessors->length(); ++j) {
+      if (*block_maps_[predecessors->at(j)->block_id()] != entry_map) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+HCapturedObject* HEscapeAnalysis::NewState(HCapturedObject* state,
+                                           Handle<Map> map) {
+  int length = state->OperandCount();
+  HCapturedObject* result =
+      new(zone_) HCapturedObject(state->capture_id(), map, length, zone_);
+  for (int i = 0; i < length; ++i) {
+    result->SetOperandAt(i, state->OperandAt(i));
+  }
+  return result;
+}
+
+
+bool HEscapeAnalysis::IsStoredInLoop(int field, HBasicBlock* loop_header) {
+  HLoopInformation* loop = loop_header->loop_information();
+  for (int i = 0; i < store_blocks_.length(); ++i) {
+    if (store_fields_[i] == field &&
+        loop->blocks()->Contains(store_blocks_[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// Fields stored inside of a loop or differing between predecessors get a
+// phi.  The state at the block entry is a new HCapturedObject if there is
+// any such phi.
+HCapturedObject* HEscapeAnalysis::StateAtEntry(HBasicBlock* block) {
+  const ZoneList<HBasicBlock*>* predecessors = block->predecessors();
+  HCapturedObject* state = block_states_[predecessors->at(0)->block_id()];
+  if (!block->IsLoopHeader() && predecessors->length() == 1) return state;
+
+  HCapturedObject* result = NULL;
+  for (int i = 0; i < state->OperandCount(); ++i) {
+    HValue* value = state->OperandAt(i);
+    bool needs_phi = false;
+    if (block->IsLoopHeader()) {
+      needs_phi = IsStoredInLoop(i, block);
+    } else {
+      for (int j = 1; j < predecessors->length(); ++j) {
+        HCapturedObject* other = block_states_[predecessors->at(j)->block_id()];
+        if (other->OperandAt(i) != value) needs_phi = true;
+      }
+    }
+    if (!needs_phi) continue;
+
+    if (result == NULL) result = NewState(state, state->map());
+    HPhi* phi = new(zone_) HPhi(HPhi::kInvalidMergedIndex, zone_);
+    phi->set_is_live(true);
+    block->AddPhi(phi);
+    if (block->IsLoopHeader()) {
+      phi->AddInput(value);
+      loop_phis_.Add(phi, zone_);
+      loop_phi_fields_.Add(i, zone_);
+    } else {
+      for (int j = 0; j < predecessors->length(); ++j) {
+        HCapturedObject* other = block_states_[predecessors->at(j)->block_id()];
+        phi->AddInput(other->OperandAt(i));
+      }
+    }
+    result->SetOperandAt(i, phi);
+  }
+  if (result == NULL) return state;
+  result->InsertAfter(block->first());
+  return result;
+}
+
+
+void HEscapeAnalysis::ReplaceAllocation(HInstruction* allocation,
+                                        Handle<Map> map) {
+  const ZoneList<HBasicBlock*>* blocks = graph_->blocks();
+  HBasicBlock* allocation_block = allocation->block();
+  block_states_.Rewind(0);
+  block_states_.AddBlock(NULL, blocks->length(), zone_);
+  loop_phis_.Rewind(0);
+  loop_phi_fields_.Rewind(0);
+
+  int length = map->inobject_properties();
+  HCapturedObject* state =
+      new(zone_) HCapturedObject(allocation->id(), map, length, zone_);
+  if (allocation->IsAllocateObject()) {
+    HValue* undefined = graph_->GetConstantUndefined();
+    for (int i = 0; i < length; ++i) state->SetOperandAt(i, undefined);
+  } else {
+    ZoneList<HValue*>* fields =
+        HFastLiteral::cast(allocation)->boilerplate_fields();
+    for (int i = 0; i < length; ++i) {
+      HConstant* constant = HConstant::cast(fields->at(i));
+      constant->InsertBefore(allocation);
+      state->SetOperandAt(i, constant);
+    }
+  }
+  state->InsertAfter(allocation);
+  HCapturedObject* initial_state = state;
+
+  for (int i = allocation_block->block_id(); i < blocks->length(); ++i) {
+    HBasicBlock* block = blocks->at(i);
+    if (!IsDominatedBy(block, allocation_block)) continue;
+    HInstruction* instr;
+    if (block == allocation_block) {
+      state = initial_state;
+      instr = state->next();
+    } else {
+      state = StateAtEntry(block);
+      instr = block->first();
+    }
+    while (instr != NULL) {
+      HInstruction* next = instr->next();
+      if (instr->IsLoadNamedField() &&
+          HLoadNamedField::cast(instr)->object() == allocation) {
+        HLoadNamedField* load = HLoadNamedField::cast(instr);
+        int field = FieldIndex(load->offset());
+        load->DeleteAndReplaceWith(state->OperandAt(field));
+      } else if (instr->IsStoreNamedField() &&
+                 HStoreNamedField::cast(instr)->object() == allocation) {
+        HStoreNamedField* store = HStoreNamedField::cast(instr);
+        Handle<Map> transition = store->transition();
+        HCapturedObject* new_state =
+            NewState(state, transition.is_null() ? state->map() : transition);
+        new_state->SetOperandAt(FieldIndex(store->offset()), store->value());
+        new_state->InsertBefore(store);
+        store->DeleteAndReplaceWith(NULL);
+        state = new_state;
+      } else if ((instr->IsCheckMaps() || instr->IsCheckNonSmi()) &&
+                 instr->OperandAt(0) == allocation) {
+        instr->DeleteAndReplaceWith(NULL);
+      } else if (instr->IsSimulate()) {
+        for (int j = 0; j < instr->OperandCount(); ++j) {
+          if (instr->OperandAt(j) == allocation) instr->SetOperandAt(j, state);
+        }
+      }
+      instr = next;
+    }
+    block_states_[i] = state;
+  }
+
+  for (int i = 0; i < loop_phis_.length(); ++i) {
+    HPhi* phi = loop_phis_[i];
+    const ZoneList<HBasicBlock*>* predecessors = phi->block()->predecessors();
+    for (int j = 1; j < predecessors->length(); ++j) {
+      HCapturedObject* back_edge_state =
+          block_states_[predecessors->at(j)->block_id()];
+      phi->AddInput(back_edge_state->OperandAt(loop_phi_fields_[i]));
+    }
+  }
+  allocation->DeleteAndReplaceWith(NULL);
+}
+
+
 void TraceGVN(const char* msg, ...) {
   va_list arguments;
   va_start(arguments, msg);
@@ -2277,6 +2682,351 @@ void HGlobalValueNumberer::AnalyzeGraph() {
 }
 
 
+// The fields and elements that may be overwritten by an instruction, a
+// block or a loop.  Fields are tracked by the word index of their offset,
+// all words past the last bit share it.
+class HFieldEffects {
+ public:
+  HFieldEffects()
+      : in_object_words_(0), backing_store_words_(0), elements_(false) { }
+
+  static const int kMaxTrackedWord = 31;
+
+  static uint32_t WordBit(int offset) {
+    int word = offset / kPointerSize;
+    return 1u << (word < kMaxTrackedWord ? word : kMaxTrackedWord);
+  }
+
+  bool KillsField(bool is_in_object, int offset) const {
+    uint32_t words = is_in_object ? in_object_words_ : backing_store_words_;
+    return (words & WordBit(offset)) != 0;
+  }
+  bool KillsElements() const { return elements_; }
+  bool IsEmpty() const {
+    return in_object_words_ == 0 && backing_store_words_ == 0 && !elements_;
+  }
+
+  void Add(HInstruction* instr);
+  void Add(const HFieldEffects& other) {
+    in_object_words_ |= other.in_object_words_;
+    backing_store_words_ |= other.backing_store_words_;
+    elements_ = elements_ || other.elements_;
+  }
+
+ private:
+  uint32_t in_object_words_;
+  uint32_t backing_store_words_;
+  bool elements_;
+};
+
+
+void HFieldEffects::Add(HInstruction* instr) {
+  if (instr->IsStoreNamedField()) {
+    HStoreNamedField* store = HStoreNamedField::cast(instr);
+    if (store->is_in_object()) {
+      in_object_words_ |= WordBit(store->offset());
+    } else {
+      backing_store_words_ |= WordBit(store->offset());
+    }
+    return;
+  }
+  GVNFlagSet flags = instr->ChangesFlags();
+  if (flags.Contains(kChangesOsrEntries)) {
+    // Values flowing in from the unoptimized frame are unknown.
+    in_object_words_ = backing_store_words_ = ~0u;
+    elements_ = true;
+    return;
+  }
+  if (flags.Contains(kChangesInobjectFields)) in_object_words_ = ~0u;
+  if (flags.Contains(kChangesBackingStoreFields)) backing_store_words_ = ~0u;
+  if (flags.Contains(kChangesArrayElements)) elements_ = true;
+}
+
+
+// The known value of a field of an object, or of a fast element of an
+// elements backing store.  The value is either the last value stored to
+// the location or an earlier load of it.
+class HFieldValue {
+ public:
+  enum Kind { IN_OBJECT_FIELD, BACKING_STORE_FIELD, ELEMENT };
+
+  HFieldValue(Kind kind, HValue* object, HValue* key, int offset,
+              HValue* value)
+      : kind_(kind), object_(object), key_(key), offset_(offset),
+        value_(value) { }
+
+  Kind kind() const { return kind_; }
+  HValue* object() const { return object_; }
+  HValue* key() const { return key_; }
+  int offset() const { return offset_; }
+  HValue* value() const { return value_; }
+
+ private:
+  Kind kind_;
+  HValue* object_;
+  HValue* key_;
+  int offset_;
+  HValue* value_;
+};
+
+
+// Eliminates loads of fields and fast elements whose value is already known,
+// because the same location was loaded before or a value was stored to it,
+// and no instruction that may overwrite the location was executed since.
+// Unlike GVN, which only knows that some in-object field changed, the known
+// values are tracked per object and field offset, so stores to other fields
+// do not kill them.  Known values flow down the dominator tree, minus what
+// is overwritten on the paths between a block and the blocks it dominates.
+class HLoadElimination BASE_EMBEDDED {
+ public:
+  explicit HLoadElimination(HGraph* graph)
+      : graph_(graph),
+        zone_(graph->zone()),
+        block_effects_(graph->blocks()->length(), zone_),
+        loop_effects_(graph->blocks()->length(), zone_),
+        visited_on_paths_(zone_, graph->blocks()->length()) {
+    block_effects_.AddBlock(HFieldEffects(), graph->blocks()->length(), zone_);
+    loop_effects_.AddBlock(HFieldEffects(), graph->blocks()->length(), zone_);
+  }
+
+  void Analyze();
+
+ private:
+  typedef ZoneList<HFieldValue> HFieldValueTable;
+
+  // Bounds the number of known values, lookups are linear.
+  static const int kMaxKnownValues = 64;
+
+  void ComputeBlockEffects();
+  HFieldEffects CollectEffectsOnPathsToDominatedBlock(HBasicBlock* dominator,
+                                                      HBasicBlock* dominated);
+  void EliminateLoads(HBasicBlock* block, HFieldValueTable* table);
+  void ProcessStore(HFieldValueTable* table, const HFieldValue& store);
+  void ProcessLoad(HFieldValueTable* table, HInstruction* load,
+                   const HFieldValue& location);
+  void Kill(HFieldValueTable* table, const HFieldEffects& effects);
+  static bool MayAlias(const HFieldValue& a, const HFieldValue& b);
+  static bool IsSameLocation(const HFieldValue& a, const HFieldValue& b);
+  static bool IsAllocation(HValue* value) {
+    return value->IsAllocateObject() || value->IsFastLiteral() ||
+        value->IsObjectLiteral() || value->IsArrayLiteral();
+  }
+  void TraceLoadElimination(const char* msg, ...);
+
+  HGraph* graph_;
+  Zone* zone_;
+  // The fields and elements overwritten by each block.
+  ZoneList<HFieldEffects> block_effects_;
+  // The fields and elements overwritten by each loop, indexed by the block
+  // id of its header.
+  ZoneList<HFieldEffects> loop_effects_;
+  SparseSet visited_on_paths_;
+};
+
+
+void HLoadElimination::TraceLoadElimination(const char* msg, ...) {
+  if (FLAG_trace_load_elimination) {
+    va_list arguments;
+    va_start(arguments, msg);
+    OS::VPrint(msg, arguments);
+    va_end(arguments);
+  }
+}
+
+
+void HLoadElimination::Analyze() {
+  HPhase phase("H_Load elimination", graph_);
+  ComputeBlockEffects();
+  HFieldValueTable table(8, zone_);
+  EliminateLoads(graph_->entry_block(), &table);
+}
+
+
+void HLoadElimination::ComputeBlockEffects() {
+  const ZoneList<HBasicBlock*>* blocks = graph_->blocks();
+  for (int i = blocks->length() - 1; i >= 0; --i) {
+    HBasicBlock* block = blocks->at(i);
+    int id = block->block_id();
+    HFieldEffects effects;
+    for (HInstruction* instr = block->first();
+         instr != NULL;
+         instr = instr->next()) {
+      effects.Add(instr);
+    }
+    block_effects_[id] = effects;
+
+    // Loop headers are part of their loop.
+    if (block->IsLoopHeader()) loop_effects_[id].Add(effects);
+
+    // Propagate loop effects upwards.
+    if (block->HasParentLoopHeader()) {
+      int header_id = block->parent_loop_header()->block_id();
+      loop_effects_[header_id].Add(block->IsLoopHeader()
+                                   ? loop_effects_[id]
+                                   : effects);
+    }
+  }
+}
+
+
+HFieldEffects HLoadElimination::CollectEffectsOnPathsToDominatedBlock(
+    HBasicBlock* dominator, HBasicBlock* dominated) {
+  HFieldEffects effects;
+  for (int i = 0; i < dominated->predecessors()->length(); ++i) {
+    HBasicBlock* block = dominated->predecessors()->at(i);
+    if (dominator->block_id() < block->block_id() &&
+        block->block_id() < dominated->block_id() &&
+        visited_on_paths_.Add(block->block_id())) {
+      effects.Add(block_effects_[block->block_id()]);
+      if (block->IsLoopHeader()) {
+        effects.Add(loop_effects_[block->block_id()]);
+      }
+      effects.Add(CollectEffectsOnPathsToDominatedBlock(dominator, block));
+    }
+  }
+  return effects;
+}
+
+
+bool HLoadElimination::MayAlias(const HFieldValue& a, const HFieldValue& b) {
+  if (a.kind() != b.kind()) return false;
+  if (a.kind() == HFieldValue::ELEMENT) {
+    // Elements at different constant keys never overlap.
+    HValue* a_key = a.key();
+    HValue* b_key = b.key();
+    if (a_key->IsConstant() && b_key->IsConstant() &&
+        HConstant::cast(a_key)->HasInteger32Value() &&
+        HConstant::cast(b_key)->HasInteger32Value() &&
+        HConstant::cast(a_key)->Integer32Value() !=
+            HConstant::cast(b_key)->Integer32Value()) {
+      return false;
+    }
+  } else if (a.offset() != b.offset()) {
+    return false;
+  }
+  // Objects allocated by different instructions are different objects.
+  return a.object() == b.object() ||
+      !IsAllocation(a.object()) || !IsAllocation(b.object());
+}
+
+
+bool HLoadElimination::IsSameLocation(const HFieldValue& a,
+                                      const HFieldValue& b) {
+  if (a.kind() != b.kind() || a.object() != b.object()) return false;
+  if (a.kind() != HFieldValue::ELEMENT) return a.offset() == b.offset();
+  if (a.key() == b.key()) return true;
+  return a.key()->IsConstant() && b.key()->IsConstant() &&
+      HConstant::cast(a.key())->HasInteger32Value() &&
+      HConstant::cast(b.key())->HasInteger32Value() &&
+      HConstant::cast(a.key())->Integer32Value() ==
+          HConstant::cast(b.key())->Integer32Value();
+}
+
+
+void HLoadElimination::Kill(HFieldValueTable* table,
+                            const HFieldEffects& effects) {
+  if (effects.IsEmpty()) return;
+  for (int i = table->length() - 1; i >= 0; --i) {
+    const HFieldValue& known = table->at(i);
+    bool killed = known.kind() == HFieldValue::ELEMENT
+        ? effects.KillsElements()
+        : effects.KillsField(known.kind() == HFieldValue::IN_OBJECT_FIELD,
+                             known.offset());
+    if (killed) table->Remove(i);
+  }
+}
+
+
+void HLoadElimination::ProcessStore(HFieldValueTable* table,
+                                    const HFieldValue& store) {
+  for (int i = table->length() - 1; i >= 0; --i) {
+    if (MayAlias(table->at(i), store)) table->Remove(i);
+  }
+  if (store.value() != NULL && table->length() < kMaxKnownValues) {
+    table->Add(store, zone_);
+  }
+}
+
+
+void HLoadElimination::ProcessLoad(HFieldValueTable* table,
+                                   HInstruction* load,
+                                   const HFieldValue& location) {
+  for (int i = 0; i < table->length(); ++i) {
+    if (IsSameLocation(table->at(i), location)) {
+      HValue* value = table->at(i).value();
+      TraceLoadElimination("Replacing load %d (%s) with value %d (%s)\n",
+                           load->id(), load->Mnemonic(),
+                           value->id(), value->Mnemonic());
+      load->DeleteAndReplaceWith(value);
+      return;
+    }
+  }
+  if (table->length() < kMaxKnownValues) table->Add(location, zone_);
+}
+
+
+void HLoadElimination::EliminateLoads(HBasicBlock* block,
+                                      HFieldValueTable* table) {
+  // If this is a loop header forget everything overwritten by the loop.
+  if (block->IsLoopHeader()) Kill(table, loop_effects_[block->block_id()]);
+
+  HInstruction* instr = block->first();
+  while (instr != NULL) {
+    HInstruction* next = instr->next();
+    if (instr->IsStoreNamedField()) {
+      // Double fields hold a box, the stored value is written into it.
+      HStoreNamedField* store = HStoreNamedField::cast(instr);
+      HFieldValue::Kind kind = store->is_in_object()
+          ? HFieldValue::IN_OBJECT_FIELD
+          : HFieldValue::BACKING_STORE_FIELD;
+      HValue* value = store->is_double_field() ? NULL : store->value();
+      ProcessStore(table, HFieldValue(kind, store->object(), NULL,
+                                      store->offset(), value));
+    } else if (instr->IsLoadNamedField()) {
+      HLoadNamedField* load = HLoadNamedField::cast(instr);
+      if (!load->is_double_field()) {
+        HFieldValue::Kind kind = load->is_in_object()
+            ? HFieldValue::IN_OBJECT_FIELD
+            : HFieldValue::BACKING_STORE_FIELD;
+        ProcessLoad(table, load, HFieldValue(kind, load->object(), NULL,
+                                             load->offset(), load));
+      }
+    } else if (instr->IsStoreKeyedFastElement()) {
+      HStoreKeyedFastElement* store = HStoreKeyedFastElement::cast(instr);
+      ProcessStore(table, HFieldValue(HFieldValue::ELEMENT, store->object(),
+                                      store->key(), 0, store->value()));
+    } else if (instr->IsLoadKeyedFastElement()) {
+      HLoadKeyedFastElement* load = HLoadKeyedFastElement::cast(instr);
+      ProcessLoad(table, load, HFieldValue(HFieldValue::ELEMENT,
+                                           load->object(), load->key(), 0,
+                                           load));
+    } else {
+      HFieldEffects effects;
+      effects.Add(instr);
+      Kill(table, effects);
+    }
+    instr = next;
+  }
+
+  const ZoneList<HBasicBlock*>* dominated_blocks = block->dominated_blocks();
+  for (int i = 0; i < dominated_blocks->length(); ++i) {
+    HBasicBlock* dominated = dominated_blocks->at(i);
+    HFieldValueTable successor_table(table->length(), zone_);
+    successor_table.AddAll(*table, zone_);
+    // Forget everything overwritten on any path between this block and the
+    // dominated block.  If the range of block ids (block_id, dominated_id)
+    // is empty there are no such paths.
+    if (!successor_table.is_empty() &&
+        block->block_id() + 1 < dominated->block_id()) {
+      visited_on_paths_.Clear();
+      Kill(&successor_table,
+           CollectEffectsOnPathsToDominatedBlock(block, dominated));
+    }
+    EliminateLoads(dominated, &successor_table);
+  }
+}
+
+
 class HInferRepresentation BASE_EMBEDDED {
  public:
   explicit HInferRepresentation(HGraph* graph)
@@ -2699,7 +3449,8 @@ void HGraph::MarkDeoptimizeOnUndefined() {
   // Compute DeoptimizeOnUndefined flag for phis.
   // Any phi that can reach a use with DeoptimizeOnUndefined set must
   // have DeoptimizeOnUndefined set.  Currently only HCompareIDAndBranch, with
-  // double input representation, has this flag set.
+  // double input representation, and stores into double fields have this
+  // flag set.
   // The flag is used by HChange tagged->double, which must deoptimize
   // if one of its uses has this flag set.
   for (int i = 0; i < phi_list()->length(); i++) {
@@ -3103,6 +3854,13 @@ bool HGraph::Optimize(SmartArrayPointer<char>* bailout_reason) {
     return false;
   }
   if (FLAG_eliminate_dead_phis) EliminateUnreachablePhis();
+
+  // The deoptimizer cannot rematerialize objects for on-stack replacement.
+  if (FLAG_use_escape_analysis && !has_osr_loop_entry()) {
+    HEscapeAnalysis escape_analysis(this);
+    escape_analysis.Analyze();
+  }
+
   CollectPhis();
 
   if (has_osr_loop_entry()) {
@@ -3136,6 +3894,13 @@ bool HGraph::Optimize(SmartArrayPointer<char>* bailout_reason) {
     }
   }
 
+  // Forward known field and element values to later loads.  This runs after
+  // GVN, which merges the loads of the elements backing stores.
+  if (FLAG_use_load_elimination) {
+    HLoadElimination load_elimination(this);
+    load_elimination.Analyze();
+  }
+
   if (FLAG_use_range) {
     HRangeAnalysis rangeAnalysis(this);
     rangeAnalysis.Analyze();
@@ -3146,6 +3911,7 @@ bool HGraph::Optimize(SmartArrayPointer<char>* bailout_reason) {
   HStackCheckEliminator sce(this);
   sce.Process();
 
+  EliminateLoopBoundsChecks();
   EliminateRedundantBoundsChecks();
   DehoistSimpleArrayIndexComputations();
 
@@ -3483,6 +4249,270 @@ void HGraph::EliminateRedundantBoundsChecks() {
 }
 
 
+// Splits an Integer32 value into base + offset, where the offset is a
+// constant operand of an addition or subtraction.
+static HValue* SplitConstantOffset(HValue* value, int32_t* offset) {
+  *offset = 0;
+  if (!value->representation().IsInteger32()) return value;
+  if (value->IsAdd()) {
+    HAdd* add = HAdd::cast(value);
+    if (add->right()->IsConstant() &&
+        HConstant::cast(add->right())->HasInteger32Value()) {
+      *offset = HConstant::cast(add->right())->Integer32Value();
+      return add->left();
+    }
+    if (add->left()->IsConstant() &&
+        HConstant::cast(add->left())->HasInteger32Value()) {
+      *offset = HConstant::cast(add->left())->Integer32Value();
+      return add->right();
+    }
+  } else if (value->IsSub()) {
+    HSub* sub = HSub::cast(value);
+    if (sub->right()->IsConstant() &&
+        HConstant::cast(sub->right())->HasInteger32Value() &&
+        HConstant::cast(sub->right())->Integer32Value() != kMinInt) {
+      *offset = -HConstant::cast(sub->right())->Integer32Value();
+      return sub->left();
+    }
+  }
+  return value;
+}
+
+
+// Returns 1 if phi is an induction variable that every back edge of its
+// loop increments by a constant, -1 if every back edge decrements it, and
+// 0 otherwise.  Overflowing Integer32 arithmetic deoptimizes, so the value
+// of an induction variable is monotonic.  Sets initial to the value on
+// entry to the loop.
+static int InductionVariableDirection(HPhi* phi, HValue** initial) {
+  HBasicBlock* header = phi->block();
+  const ZoneList<HBasicBlock*>* back_edges =
+      header->loop_information()->back_edges();
+  // The increments of truncating phis do not check for overflow.
+  if (!phi->representation().IsInteger32() ||
+      phi->CheckFlag(HValue::kTruncatingToInt32)) {
+    return 0;
+  }
+  int direction = 0;
+  *initial = NULL;
+  for (int i = 0; i < phi->OperandCount(); ++i) {
+    HValue* operand = phi->OperandAt(i);
+    if (!back_edges->Contains(header->predecessors()->at(i))) {
+      if (*initial != NULL) return 0;
+      *initial = operand;
+      continue;
+    }
+    int32_t step;
+    if (SplitConstantOffset(operand, &step) != phi || step == 0) return 0;
+    int step_direction = step > 0 ? 1 : -1;
+    if (direction != 0 && direction != step_direction) return 0;
+    direction = step_direction;
+  }
+  return *initial != NULL ? direction : 0;
+}
+
+
+// Returns whether value is defined before the loop starting at header.
+static bool IsDefinedBeforeLoop(HValue* value, HBasicBlock* header) {
+  return value->block() != header && value->block()->Dominates(header);
+}
+
+
+// Removes the bounds checks of an induction variable, whose value is
+// between lower + lower_offset and upper + upper_offset in the blocks
+// dominated by body.  A check is redundant if the range of lower and the
+// upper bound being an offset of the checked length prove the index in
+// bounds.  Otherwise, if the length is defined before the loop, a single
+// check of the upper bound is hoisted to the loop preheader.
+void HGraph::EliminateInductionVariableBoundsChecks(HPhi* phi,
+                                                    HBasicBlock* body,
+                                                    HValue* lower,
+                                                    int32_t lower_offset,
+                                                    HValue* upper,
+                                                    int32_t upper_offset,
+                                                    bool allow_hoisting) {
+  HBasicBlock* header = phi->block();
+  HBasicBlock* pre_header = NULL;
+  for (int i = 0; i < header->predecessors()->length(); ++i) {
+    HBasicBlock* predecessor = header->predecessors()->at(i);
+    if (!header->loop_information()->back_edges()->Contains(predecessor)) {
+      pre_header = predecessor;
+    }
+  }
+  ZoneList<HBoundsCheck*> hoisted_checks(2, zone());
+  ZoneList<int32_t> hoisted_offsets(2, zone());
+  ZoneList<HValue*> hoisted_lengths(2, zone());
+
+  const ZoneList<HBasicBlock*>* blocks =
+      header->loop_information()->blocks();
+  for (int i = 0; i < blocks->length(); ++i) {
+    HBasicBlock* block = blocks->at(i);
+    if (block != body && !body->Dominates(block)) continue;
+    HInstruction* instr = block->first();
+    while (instr != NULL) {
+      HInstruction* next = instr->next();
+      if (!instr->IsBoundsCheck()) {
+        instr = next;
+        continue;
+      }
+      HBoundsCheck* check = HBoundsCheck::cast(instr);
+      HValue* length = check->length();
+      int32_t index_offset;
+      if (SplitConstantOffset(check->index(), &index_offset) != phi ||
+          lower->range() == NULL) {
+        instr = next;
+        continue;
+      }
+      int64_t min_index = static_cast<int64_t>(lower->range()->lower()) +
+          lower_offset + index_offset;
+      if (min_index < 0) {
+        instr = next;
+        continue;
+      }
+      int32_t upper_base_offset;
+      HValue* upper_base = SplitConstantOffset(upper, &upper_base_offset);
+      int64_t max_index_offset = static_cast<int64_t>(upper_offset) +
+          index_offset;
+      if (upper_base == length &&
+          upper_base_offset + max_index_offset < 0) {
+        if (FLAG_trace_bounds_checks_hoisting) {
+          PrintF("Removing bounds check %d of induction variable %d\n",
+                 check->id(), phi->id());
+        }
+        check->DeleteAndReplaceWith(check->index());
+      } else if (allow_hoisting &&
+                 !block->IsDeoptimizing() &&
+                 IsDefinedBeforeLoop(length, header) &&
+                 max_index_offset + 1 <= kMaxInt) {
+        // Check 0 <= upper + upper_offset + index_offset + 1 <= length
+        // rather than the maximal index itself, so the check passes for a
+        // loop that is not entered because its upper bound is one below a
+        // non-negative initial value.
+        int32_t offset = static_cast<int32_t>(max_index_offset + 1);
+        HBoundsCheck* hoisted = NULL;
+        for (int j = 0; j < hoisted_checks.length(); ++j) {
+          if (hoisted_offsets[j] == offset && hoisted_lengths[j] == length) {
+            hoisted = hoisted_checks[j];
+          }
+        }
+        if (hoisted == NULL) {
+          hoisted = InsertUpperBoundCheck(pre_header, upper, offset, length);
+          hoisted_checks.Add(hoisted, zone());
+          hoisted_offsets.Add(offset, zone());
+          hoisted_lengths.Add(length, zone());
+        }
+        if (FLAG_trace_bounds_checks_hoisting) {
+          PrintF("Hoisting bounds check %d of induction variable %d to %d\n",
+                 check->id(), phi->id(), hoisted->id());
+        }
+        check->DeleteAndReplaceWith(check->index());
+      }
+      instr = next;
+    }
+  }
+}
+
+
+// Inserts a check of 0 <= upper + offset <= length at the end of block.
+HBoundsCheck* HGraph::InsertUpperBoundCheck(HBasicBlock* block,
+                                            HValue* upper,
+                                            int32_t offset,
+                                            HValue* length) {
+  HInstruction* end = block->end();
+  HValue* index = upper;
+  if (offset != 0) {
+    HConstant* constant =
+        new(zone()) HConstant(offset, Representation::Integer32());
+    constant->InsertBefore(end);
+    constant->ComputeInitialRange(zone());
+    HAdd* add = new(zone()) HAdd(NULL, upper, constant);
+    add->AssumeRepresentation(Representation::Integer32());
+    add->InsertBefore(end);
+    add->ComputeInitialRange(zone());
+    index = add;
+  }
+  // The length of an array is a small positive integer, so the check of
+  // index < length + 1 does not overflow.
+  HConstant* one = new(zone()) HConstant(1, Representation::Integer32());
+  one->InsertBefore(end);
+  one->ComputeInitialRange(zone());
+  HAdd* length_plus_one = new(zone()) HAdd(NULL, length, one);
+  length_plus_one->AssumeRepresentation(Representation::Integer32());
+  length_plus_one->InsertBefore(end);
+  length_plus_one->ComputeInitialRange(zone());
+  HBoundsCheck* check = new(zone()) HBoundsCheck(index, length_plus_one);
+  check->InsertBefore(end);
+  check->ComputeInitialRange(zone());
+  return check;
+}
+
+
+// Finds the induction variables tested by the branch at the end of each loop
+// header.  In the loop body the variable is bounded by the test on one side
+// and by its initial value on the other, which allows removing or hoisting
+// the bounds checks of indices that are offsets of the variable.
+void HGraph::EliminateLoopBoundsChecks() {
+  if (!FLAG_array_bounds_checks_hoisting) return;
+
+  HPhase phase("H_Eliminate loop bounds checks", this);
+  // Hoisted checks fail when an access guarded inside the loop would be out
+  // of bounds, so stop hoisting after repeated deoptimization.
+  bool allow_hoisting =
+      info()->shared_info()->opt_count() + 1 < Compiler::kDefaultMaxOptCount;
+  for (int i = 0; i < blocks()->length(); ++i) {
+    HBasicBlock* header = blocks()->at(i);
+    if (!header->IsLoopHeader() || !header->end()->IsCompareIDAndBranch()) {
+      continue;
+    }
+    HCompareIDAndBranch* test = HCompareIDAndBranch::cast(header->end());
+    if (!test->GetInputRepresentation().IsInteger32()) continue;
+
+    // Find the successor staying in the loop and the comparison that holds
+    // there.
+    const ZoneList<HBasicBlock*>* loop_blocks =
+        header->loop_information()->blocks();
+    HBasicBlock* body;
+    Token::Value op = test->token();
+    if (loop_blocks->Contains(test->FirstSuccessor()) &&
+        !loop_blocks->Contains(test->SecondSuccessor())) {
+      body = test->FirstSuccessor();
+    } else if (loop_blocks->Contains(test->SecondSuccessor()) &&
+               !loop_blocks->Contains(test->FirstSuccessor())) {
+      body = test->SecondSuccessor();
+      op = Token::NegateCompareOp(op);
+    } else {
+      continue;
+    }
+    if (body->predecessors()->length() != 1) continue;
+
+    HValue* phi_value = test->left();
+    HValue* limit = test->right();
+    if (!phi_value->IsPhi() || phi_value->block() != header) {
+      phi_value = test->right();
+      limit = test->left();
+      op = Token::InvertCompareOp(op);
+      if (!phi_value->IsPhi() || phi_value->block() != header) continue;
+    }
+    if (!IsDefinedBeforeLoop(limit, header)) continue;
+
+    HPhi* phi = HPhi::cast(phi_value);
+    HValue* initial;
+    int direction = InductionVariableDirection(phi, &initial);
+    if (direction > 0 && (op == Token::LT || op == Token::LTE)) {
+      EliminateInductionVariableBoundsChecks(phi, body,
+                                             initial, 0,
+                                             limit, op == Token::LT ? -1 : 0,
+                                             allow_hoisting);
+    } else if (direction < 0 && (op == Token::GT || op == Token::GTE)) {
+      EliminateInductionVariableBoundsChecks(phi, body,
+                                             limit, op == Token::GT ? 1 : 0,
+                                             initial, 0,
+                                             allow_hoisting);
+    }
+  }
+}
+
+
 static void DehoistArrayIndex(ArrayInstructionInterface* array_operation) {
   HValue* index = array_operation->GetKey();
 
@@ -4656,6 +5686,9 @@ static bool IsFastLiteral(Handle<JSObject> boilerplate,
   ASSERT(max_depth >= 0 && *max_properties >= 0);
   if (max_depth == 0) return false;
 
+  // Copies of boilerplates with double fields need boxes of their own.
+  if (boilerplate->map()->has_double_fields()) return false;
+
   Handle<FixedArrayBase> elements(boilerplate->elements());
   if (elements->length() > 0 &&
       elements->map() != boilerplate->GetHeap()->fixed_cow_array_map()) {
@@ -4708,6 +5741,25 @@ static bool IsFastLiteral(Handle<JSObject> boilerplate,
 }
 
 
+// Records the in-object field values of a flat boilerplate, so that escape
+// analysis can replace copies that do not escape.  The constants are
+// created here because the analysis may run on a compiler thread.
+static void SetBoilerplateFields(HFastLiteral* literal, Zone* zone) {
+  Handle<JSObject> boilerplate = literal->boilerplate();
+  Handle<Map> map(boilerplate->map());
+  if (map->instance_type() != JS_OBJECT_TYPE) return;
+  if (boilerplate->elements()->length() > 0) return;
+  int nof = map->inobject_properties();
+  ZoneList<HValue*>* fields = new(zone) ZoneList<HValue*>(nof, zone);
+  for (int i = 0; i < nof; i++) {
+    Handle<Object> value(boilerplate->InObjectPropertyAt(i));
+    if (value->IsJSObject()) return;
+    fields->Add(new(zone) HConstant(value, Representation::Tagged()), zone);
+  }
+  literal->set_boilerplate_fields(map, fields);
+}
+
+
 void HGraphBuilder::VisitObjectLiteral(ObjectLiteral* expr) {
   ASSERT(!HasStackOverflow());
   ASSERT(current_block() != NULL);
@@ -4720,17 +5772,30 @@ void HGraphBuilder::VisitObjectLiteral(ObjectLiteral* expr) {
   int total_size = 0;
   int max_properties = HFastLiteral::kMaxLiteralProperties;
   Handle<Object> boilerplate(closure->literals()->get(expr->literal_index()));
+  Handle<AllocationSite> site;
+  if (boilerplate->IsJSObject()) {
+    site = Runtime::GetLiteralAllocationSite(
+        isolate(), Handle<FixedArray>(closure->literals()),
+        expr->literal_index());
+  }
+  // Pretenured literals are allocated by the runtime.
+  bool pretenure = !site.is_null() && site->ShouldPretenure();
   if (boilerplate->IsJSObject() &&
+      !pretenure &&
       IsFastLiteral(Handle<JSObject>::cast(boilerplate),
                     HFastLiteral::kMaxLiteralDepth,
                     &max_properties,
                     &total_size)) {
     Handle<JSObject> boilerplate_object = Handle<JSObject>::cast(boilerplate);
-    literal = new(zone()) HFastLiteral(context,
-                                       boilerplate_object,
-                                       total_size,
-                                       expr->literal_index(),
-                                       expr->depth());
+    if (!site.is_null()) total_size += AllocationMemento::kSize;
+    HFastLiteral* fast_literal = new(zone()) HFastLiteral(context,
+                                                          boilerplate_object,
+                                                          site,
+                                                          total_size,
+                                                          expr->literal_index(),
+                                                          expr->depth());
+    if (FLAG_use_escape_analysis) SetBoilerplateFields(fast_literal, zone());
+    literal = fast_literal;
   } else {
     literal = new(zone()) HObjectLiteral(context,
                                          expr->constant_properties(),
@@ -4827,16 +5892,23 @@ void HGraphBuilder::VisitArrayLiteral(ArrayLiteral* expr) {
   Handle<JSObject> boilerplate = Handle<JSObject>::cast(raw_boilerplate);
   ElementsKind boilerplate_elements_kind =
         Handle<JSObject>::cast(boilerplate)->GetElementsKind();
+  Handle<AllocationSite> site = Runtime::GetLiteralAllocationSite(
+      isolate(), literals, expr->literal_index());
+  // Pretenured literals are allocated by the runtime.
+  bool pretenure = !site.is_null() && site->ShouldPretenure();
 
   // Check whether to use fast or slow deep-copying for boilerplate.
   int total_size = 0;
   int max_properties = HFastLiteral::kMaxLiteralProperties;
-  if (IsFastLiteral(boilerplate,
+  if (!pretenure &&
+      IsFastLiteral(boilerplate,
                     HFastLiteral::kMaxLiteralDepth,
                     &max_properties,
                     &total_size)) {
+    if (!site.is_null()) total_size += AllocationMemento::kSize;
     literal = new(zone()) HFastLiteral(context,
                                        boilerplate,
+                                       site,
                                        total_size,
                                        expr->literal_index(),
                                        expr->depth());
@@ -4915,9 +5987,11 @@ static bool ComputeLoadStoreField(Handle<Map> type,
   if (!is_store) return false;
 
   // 2nd chance: A store into a non-existent field can still be inlined if we
-  // have a matching transition and some room left in the object.
+  // have a matching transition and some room left in the object.  A new
+  // double field needs a box of its own, which only the store IC allocates.
   type->LookupTransition(NULL, *name, lookup);
   return lookup->IsTransitionToField(*type) &&
+      !lookup->GetTransitionDetails(*type).IsDoubleField() &&
       (type->unused_property_fields() > 0);
 }
 
@@ -4992,6 +6066,8 @@ HInstruction* HGraphBuilder::BuildStoreNamedField(HValue* object,
     // TODO(fschneider): Record the new map type of the object in the IR to
     // enable elimination of redundant checks after the transition store.
     instr->SetGVNFlag(kChangesMaps);
+  } else if (lookup->IsDoubleField()) {
+    instr->set_is_double_field();
   }
   return instr;
 }
@@ -5085,6 +6161,7 @@ void HGraphBuilder::HandlePolymorphicLoadNamedField(Property* expr,
   int count = 0;
   int previous_field_offset = 0;
   bool previous_field_is_in_object = false;
+  bool previous_field_is_double = false;
   bool is_monomorphic_field = true;
   Handle<Map> map;
   LookupResult lookup(isolate());
@@ -5104,9 +6181,12 @@ void HGraphBuilder::HandlePolymorphicLoadNamedField(Property* expr,
       if (count == 0) {
         previous_field_offset = offset;
         previous_field_is_in_object = is_in_object;
+        previous_field_is_double = lookup.IsDoubleField();
       } else if (is_monomorphic_field) {
         is_monomorphic_field = (offset == previous_field_offset) &&
-                               (is_in_object == previous_field_is_in_object);
+                               (is_in_object == previous_field_is_in_object) &&
+                               (lookup.IsDoubleField() ==
+                                previous_field_is_double);
       }
       ++count;
     }
@@ -5628,7 +6708,9 @@ HLoadNamedField* HGraphBuilder::BuildLoadNamedField(HValue* object,
     // Negative property indices are in-object properties, indexed
     // from the end of the fixed part of the object.
     int offset = (index * kPointerSize) + type->instance_size();
-    return new(zone()) HLoadNamedField(object, true, offset);
+    HLoadNamedField* instr = new(zone()) HLoadNamedField(object, true, offset);
+    if (lookup->IsDoubleField()) instr->set_is_double_field();
+    return instr;
   } else {
     // Non-negative property indices are in the properties array.
     int offset = (index * kPointerSize) + FixedArray::kHeaderSize;
@@ -7392,7 +8474,24 @@ void HGraphBuilder::VisitCall(Call* expr) {
 
 
 // Checks whether allocation using the given constructor can be inlined.
+// Returns the site tracking the objects constructed by the function, or a
+// null handle if there is none.
+static Handle<AllocationSite> ConstructorAllocationSite(
+    Handle<JSFunction> constructor) {
+  if (!constructor->HasAllocationSiteLiteral()) {
+    return Handle<AllocationSite>::null();
+  }
+  Object* site =
+      constructor->literals()->get(JSFunction::kLiteralAllocationSiteIndex);
+  if (!site->IsAllocationSite()) return Handle<AllocationSite>::null();
+  return Handle<AllocationSite>(AllocationSite::cast(site));
+}
+
+
 static bool IsAllocationInlineable(Handle<JSFunction> constructor) {
+  // Objects of pretenured constructors are allocated by the runtime.
+  Handle<AllocationSite> site = ConstructorAllocationSite(constructor);
+  if (!site.is_null() && site->ShouldPretenure()) return false;
   return constructor->has_initial_map() &&
       constructor->initial_map()->instance_type() == JS_OBJECT_TYPE &&
       constructor->initial_map()->instance_size() < HAllocateObject::kMaxSize;
@@ -7426,7 +8525,8 @@ void HGraphBuilder::VisitCallNew(CallNew* expr) {
     }
 
     // Replace the constructor function with a newly allocated receiver.
-    HInstruction* receiver = new(zone()) HAllocateObject(context, constructor);
+    HInstruction* receiver = new(zone()) HAllocateObject(
+        context, constructor, ConstructorAllocationSite(constructor));
     // Index of the receiver from the top of the expression stack.
     const int receiver_index = argument_count - 1;
     AddInstruction(receiver);
@@ -9118,6 +10218,18 @@ bool HEnvironment::ExpressionStackIsEmpty() const {
 }
 
 
+int HEnvironment::CapturedFieldCount() const {
+  int count = 0;
+  for (int i = 0; i < values_.length(); ++i) {
+    HValue* value = values_[i];
+    if (value != NULL && value->IsCapturedObject()) {
+      count += value->OperandCount();
+    }
+  }
+  return count;
+}
+
+
 void HEnvironment::SetExpressionStackAt(int index_from_top, HValue* value) {
   int count = index_from_top + 1;
   int index = values_.length() - count;
@@ -9513,6 +10625,12 @@ void HStatistics::Print() {
          "Total",
          static_cast<double>(total_) / 1000,
          static_cast<double>(total_) / full_code_gen_);
+  if (osr_count_ > 0) {
+    PrintF("%30s - %7.3f ms (%d on-stack replacements)\n",
+           "OSR wait",
+           static_cast<double>(osr_wait_) / 1000,
+           osr_count_);
+  }
 }
 
 
@@ -268,6 +268,7 @@ class HGraph: public ZoneObject {
   void AssignDominators();
   void ReplaceCheckedValues();
   void EliminateRedundantBoundsChecks();
+  void EliminateLoopBoundsChecks();
   void DehoistSimpleArrayIndexComputations();
   void PropagateDeoptimizingMark();
 
@@ -364,6 +365,17 @@ class HGraph: public ZoneObject {
   void InitializeInferredTypes(int from_inclusive, int to_inclusive);
   void CheckForBackEdge(HBasicBlock* block, HBasicBlock* successor);
   void EliminateRedundantBoundsChecks(HBasicBlock* bb, BoundsCheckTable* table);
+  void EliminateInductionVariableBoundsChecks(HPhi* phi,
+                                              HBasicBlock* body,
+                                              HValue* lower,
+                                              int32_t lower_offset,
+                                              HValue* upper,
+                                              int32_t upper_offset,
+                                              bool allow_hoisting);
+  HBoundsCheck* InsertUpperBoundCheck(HBasicBlock* block,
+                                      HValue* upper,
+                                      int32_t offset,
+                                      HValue* length);
 
   Isolate* isolate_;
   int next_block_id_;
@@ -498,6 +510,10 @@ class HEnvironment: public ZoneObject {
 
   void SetExpressionStackAt(int index_from_top, HValue* value);
 
+  // The number of field values of the captured objects in this environment,
+  // counting objects in several slots once per slot.
+  int CapturedFieldCount() const;
+
   HEnvironment* Copy() const;
   HEnvironment* CopyWithoutHistory() const;
   HEnvironment* CopyAsLoopHeader(HBasicBlock* block) const;
@@ -1310,6 +1326,12 @@ class HStatistics: public Malloced {
   void Initialize(CompilationInfo* info);
   void Print();
   void SaveTiming(const char* name, int64_t ticks, unsigned size);
+  // Time from queueing an on-stack replacement for the parallel
+  // recompilation threads until its code is installed.
+  void IncrementOSRWait(int64_t ticks) {
+    osr_wait_ += ticks;
+    osr_count_++;
+  }
   static HStatistics* Instance() {
     static SetOncePointer<HStatistics> instance;
     if (!instance.is_set()) {
@@ -1326,7 +1348,9 @@ class HStatistics: public Malloced {
         total_(0),
         total_size_(0),
         full_code_gen_(0),
-        source_size_(0) { }
+        source_size_(0),
+        osr_wait_(0),
+        osr_count_(0) { }
 
   List<int64_t> timing_;
   List<const char*> names_;
@@ -1335,6 +1359,8 @@ class HStatistics: public Malloced {
   unsigned total_size_;
   int64_t full_code_gen_;
   double source_size_;
+  int64_t osr_wait_;
+  int osr_count_;
 };
 
 
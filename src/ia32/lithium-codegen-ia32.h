@@ -234,6 +234,9 @@ class LCodeGen BASE_EMBEDDED {
   void AddToTranslation(Translation* translation,
                         LOperand* op,
                         bool is_tagged);
+  void AddCapturedObjectToTranslation(LEnvironment* environment,
+                                      Translation* translation,
+                                      LCapturedObject* object);
   void PopulateDeoptimizationData(Handle<Code> code);
   int DefineDeoptimizationLiteral(Handle<Object> literal);
 
@@ -39,6 +39,13 @@ bool IncrementalMarking::BaseRecordWrite(HeapObject* obj,
                                          Object* value) {
   MarkBit value_bit = Marking::MarkBitFrom(HeapObject::cast(value));
   if (Marking::IsWhite(value_bit)) {
+    if (concurrent_marker_.IsRunning()) {
+      // The concurrent marker may be visiting the object right now and miss
+      // the new value, so we mark the value instead of rescanning the object.
+      WhiteToGreyAndPush(HeapObject::cast(value), value_bit);
+      RestartIfNotMarking();
+      return true;
+    }
     MarkBit obj_bit = Marking::MarkBitFrom(obj);
     if (Marking::IsBlack(obj_bit)) {
       BlackToGreyAndUnshift(obj, obj_bit);
@@ -79,6 +86,9 @@ void IncrementalMarking::RecordWriteIntoCode(HeapObject* obj,
 
 void IncrementalMarking::RecordWrites(HeapObject* obj) {
   if (IsMarking()) {
+    // Wait for the concurrent marker if it is visiting the object.  A grey
+    // object is visited after the writes.
+    ConcurrentMarkingScope scope(&concurrent_marker_, obj);
     MarkBit obj_bit = Marking::MarkBitFrom(obj);
     if (Marking::IsBlack(obj_bit)) {
       BlackToGreyAndUnshift(obj, obj_bit);
@@ -93,9 +103,13 @@ void IncrementalMarking::BlackToGreyAndUnshift(HeapObject* obj,
   ASSERT(Marking::MarkBitFrom(obj) == mark_bit);
   ASSERT(obj->Size() >= 2*kPointerSize);
   ASSERT(IsMarking());
-  Marking::BlackToGrey(mark_bit);
+  if (concurrent_marker_.IsRunning()) {
+    Marking::BlackToGreyAtomically(mark_bit);
+  } else {
+    Marking::BlackToGrey(mark_bit);
+  }
   int obj_size = obj->Size();
-  MemoryChunk::IncrementLiveBytesFromGC(obj->address(), -obj_size);
+  IncrementLiveBytes(obj, -obj_size);
   bytes_scanned_ -= obj_size;
   int64_t old_bytes_rescanned = bytes_rescanned_;
   bytes_rescanned_ = old_bytes_rescanned + obj_size;
@@ -118,7 +132,13 @@ void IncrementalMarking::BlackToGreyAndUnshift(HeapObject* obj,
 
 
 void IncrementalMarking::WhiteToGreyAndPush(HeapObject* obj, MarkBit mark_bit) {
-  Marking::WhiteToGrey(mark_bit);
+  if (concurrent_marker_.IsRunning()) {
+    // The concurrent marker may have claimed the object since the caller
+    // checked its colour.
+    if (!Marking::WhiteToGreyAtomically(mark_bit)) return;
+  } else {
+    Marking::WhiteToGrey(mark_bit);
+  }
   marking_deque_.PushGrey(obj);
 }
 
@@ -136,8 +156,12 @@ bool IncrementalMarking::MarkObjectAndPush(HeapObject* obj) {
 bool IncrementalMarking::MarkObjectWithoutPush(HeapObject* obj) {
   MarkBit mark_bit = Marking::MarkBitFrom(obj);
   if (!mark_bit.Get()) {
-    mark_bit.Set();
-    MemoryChunk::IncrementLiveBytesFromGC(obj->address(), obj->Size());
+    if (concurrent_marker_.IsRunning()) {
+      if (!mark_bit.SetAtomically()) return false;
+    } else {
+      mark_bit.Set();
+    }
+    IncrementLiveBytes(obj, obj->Size());
     return true;
   }
   return false;
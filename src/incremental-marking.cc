@@ -43,6 +43,7 @@ IncrementalMarking::IncrementalMarking(Heap* heap)
       marking_deque_memory_(NULL),
       marking_deque_memory_committed_(false),
       marker_(this, heap->mark_compact_collector()),
+      concurrent_marker_(heap, this),
       steps_count_(0),
       steps_took_(0),
       longest_step_(0.0),
@@ -58,6 +59,7 @@ IncrementalMarking::IncrementalMarking(Heap* heap)
 
 
 void IncrementalMarking::TearDown() {
+  concurrent_marker_.TearDown();
   delete marking_deque_memory_;
 }
 
@@ -67,8 +69,10 @@ void IncrementalMarking::RecordWriteSlow(HeapObject* obj,
                                          Object* value) {
   if (BaseRecordWrite(obj, slot, value) && is_compacting_ && slot != NULL) {
     MarkBit obj_bit = Marking::MarkBitFrom(obj);
-    if (Marking::IsBlack(obj_bit)) {
-      // Object is not going to be rescanned we need to record the slot.
+    // Object is not going to be rescanned we need to record the slot.  The
+    // concurrent marker may be visiting the object and miss the new value,
+    // so we cannot rely on its colour while the marker is running.
+    if (concurrent_marker_.IsRunning() || Marking::IsBlack(obj_bit)) {
       heap_->mark_compact_collector()->RecordSlot(
           HeapObject::RawField(obj, 0), slot, value);
     }
@@ -81,15 +85,19 @@ void IncrementalMarking::RecordWriteFromCode(HeapObject* obj,
                                              Isolate* isolate) {
   ASSERT(obj->IsHeapObject());
 
-  // Fast cases should already be covered by RecordWriteStub.
+  IncrementalMarking* marking = isolate->heap()->incremental_marking();
+
+  // Fast cases should already be covered by RecordWriteStub.  While the
+  // concurrent marker is running the stub leaves all white values to us,
+  // and the marker may have marked the value since the stub checked it.
   ASSERT(value->IsHeapObject());
-  ASSERT(!value->IsHeapNumber());
-  ASSERT(!value->IsString() ||
+  ASSERT(marking->concurrent_marker_.IsRunning() || !value->IsHeapNumber());
+  ASSERT(marking->concurrent_marker_.IsRunning() ||
+         !value->IsString() ||
          value->IsConsString() ||
          value->IsSlicedString());
-  ASSERT(Marking::IsWhite(Marking::MarkBitFrom(HeapObject::cast(value))));
-
-  IncrementalMarking* marking = isolate->heap()->incremental_marking();
+  ASSERT(marking->concurrent_marker_.IsRunning() ||
+         Marking::IsWhite(Marking::MarkBitFrom(HeapObject::cast(value))));
   ASSERT(!marking->is_compacting_);
   marking->RecordWrite(obj, NULL, value);
 }
@@ -140,13 +148,19 @@ void IncrementalMarking::RecordWriteIntoCodeSlow(HeapObject* obj,
                                                  Object* value) {
   MarkBit value_bit = Marking::MarkBitFrom(HeapObject::cast(value));
   if (Marking::IsWhite(value_bit)) {
-    MarkBit obj_bit = Marking::MarkBitFrom(obj);
-    if (Marking::IsBlack(obj_bit)) {
-      BlackToGreyAndUnshift(obj, obj_bit);
+    if (concurrent_marker_.IsRunning()) {
+      // See BaseRecordWrite.
+      WhiteToGreyAndPush(HeapObject::cast(value), value_bit);
       RestartIfNotMarking();
+    } else {
+      MarkBit obj_bit = Marking::MarkBitFrom(obj);
+      if (Marking::IsBlack(obj_bit)) {
+        BlackToGreyAndUnshift(obj, obj_bit);
+        RestartIfNotMarking();
+      }
+      // Object is either grey or white.  It will be scanned if survives.
+      return;
     }
-    // Object is either grey or white.  It will be scanned if survives.
-    return;
   }
 
   if (is_compacting_) {
@@ -237,8 +251,8 @@ class IncrementalMarkingMarkingVisitor : public ObjectVisitor {
     MarkBit mark_bit = Marking::MarkBitFrom(heap_object);
     if (mark_bit.data_only()) {
       if (incremental_marking_->MarkBlackOrKeepGrey(mark_bit)) {
-        MemoryChunk::IncrementLiveBytesFromGC(heap_object->address(),
-                                              heap_object->Size());
+        incremental_marking_->IncrementLiveBytes(heap_object,
+                                                 heap_object->Size());
       }
     } else if (Marking::IsWhite(mark_bit)) {
       incremental_marking_->WhiteToGreyAndPush(heap_object, mark_bit);
@@ -275,8 +289,8 @@ class IncrementalMarkingRootMarkingVisitor : public ObjectVisitor {
     MarkBit mark_bit = Marking::MarkBitFrom(heap_object);
     if (mark_bit.data_only()) {
       if (incremental_marking_->MarkBlackOrKeepGrey(mark_bit)) {
-          MemoryChunk::IncrementLiveBytesFromGC(heap_object->address(),
-                                                heap_object->Size());
+          incremental_marking_->IncrementLiveBytes(heap_object,
+                                                   heap_object->Size());
       }
     } else {
       if (Marking::IsWhite(mark_bit)) {
@@ -501,12 +515,16 @@ void IncrementalMarking::Start() {
 static void MarkObjectGreyDoNotEnqueue(Object* obj) {
   if (obj->IsHeapObject()) {
     HeapObject* heap_obj = HeapObject::cast(obj);
+    IncrementalMarking* marking = heap_obj->GetHeap()->incremental_marking();
     MarkBit mark_bit = Marking::MarkBitFrom(HeapObject::cast(obj));
     if (Marking::IsBlack(mark_bit)) {
-      MemoryChunk::IncrementLiveBytesFromGC(heap_obj->address(),
-                                            -heap_obj->Size());
+      marking->IncrementLiveBytes(heap_obj, -heap_obj->Size());
+    }
+    if (marking->concurrent_marker()->IsRunning()) {
+      Marking::AnyToGreyAtomically(mark_bit);
+    } else {
+      Marking::AnyToGrey(mark_bit);
     }
-    Marking::AnyToGrey(mark_bit);
   }
 }
 
@@ -641,7 +659,97 @@ void IncrementalMarking::VisitGlobalContext(Context* ctx, ObjectVisitor* v) {
 }
 
 
+void IncrementalMarking::ProcessMarkingDeque(intptr_t bytes_to_process) {
+  Map* filler_map = heap_->one_pointer_filler_map();
+  while (!marking_deque_.IsEmpty() && bytes_to_process > 0) {
+    HeapObject* obj = marking_deque_.Pop();
+
+    // Explicitly skip one word fillers. Incremental markbit patterns are
+    // correct only for objects that occupy at least two words.
+    Map* map = obj->map();
+    if (map == filler_map) continue;
+
+    int size = obj->SizeFromMap(map);
+    bytes_to_process -= size;
+    VisitObject(map, obj, size);
+  }
+}
+
+
+bool IncrementalMarking::RecordSliceCandidate(Map* map, HeapObject* obj) {
+  // The parent of a candidate is left to the full collection, which frees
+  // it if nothing else reaches it.
+  return map->visitor_id() == StaticVisitorBase::kVisitSlicedString &&
+      heap_->mark_compact_collector()->RecordSliceCandidate(
+          SlicedString::cast(obj));
+}
+
+
+void IncrementalMarking::VisitObject(Map* map, HeapObject* obj, int size) {
+  MarkBit map_mark_bit = Marking::MarkBitFrom(map);
+  if (Marking::IsWhite(map_mark_bit)) {
+    WhiteToGreyAndPush(map, map_mark_bit);
+  }
+
+  IncrementalMarkingMarkingVisitor marking_visitor(heap_, this);
+
+  // TODO(gc) switch to static visitor instead of normal visitor.
+  if (map == heap_->global_context_map()) {
+    // Global contexts have weak fields.
+    Context* ctx = Context::cast(obj);
+
+    // We will mark cache black with a separate pass
+    // when we finish marking.
+    MarkObjectGreyDoNotEnqueue(ctx->normalized_map_cache());
+
+    VisitGlobalContext(ctx, &marking_visitor);
+  } else if (map->instance_type() == MAP_TYPE) {
+    Map* map = Map::cast(obj);
+    heap_->ClearCacheOnMap(map);
+
+    // When map collection is enabled we have to mark through map's
+    // transitions and back pointers in a special way to make these links
+    // weak.  Only maps for subclasses of JSReceiver can have transitions.
+    STATIC_ASSERT(LAST_TYPE == LAST_JS_RECEIVER_TYPE);
+    if (FLAG_collect_maps &&
+        map->instance_type() >= FIRST_JS_RECEIVER_TYPE) {
+      marker_.MarkMapContents(map);
+    } else {
+      marking_visitor.VisitPointers(
+          HeapObject::RawField(map, Map::kPointerFieldsBeginOffset),
+          HeapObject::RawField(map, Map::kPointerFieldsEndOffset));
+    }
+  } else if (map->instance_type() == JS_FUNCTION_TYPE) {
+    marking_visitor.VisitPointers(
+        HeapObject::RawField(obj, JSFunction::kPropertiesOffset),
+        HeapObject::RawField(obj, JSFunction::kCodeEntryOffset));
+
+    marking_visitor.VisitCodeEntry(
+        obj->address() + JSFunction::kCodeEntryOffset);
+
+    marking_visitor.VisitPointers(
+        HeapObject::RawField(obj,
+                             JSFunction::kCodeEntryOffset + kPointerSize),
+        HeapObject::RawField(obj,
+                             JSFunction::kNonWeakFieldsEndOffset));
+  } else if (!RecordSliceCandidate(map, obj)) {
+    obj->IterateBody(map->instance_type(), size, &marking_visitor);
+  }
+
+  MarkBit obj_mark_bit = Marking::MarkBitFrom(obj);
+  SLOW_ASSERT(Marking::IsGrey(obj_mark_bit) ||
+              (obj->IsFiller() && Marking::IsWhite(obj_mark_bit)));
+  if (concurrent_marker_.IsRunning()) {
+    Marking::MarkBlackAtomically(obj_mark_bit);
+  } else {
+    Marking::MarkBlack(obj_mark_bit);
+  }
+  IncrementLiveBytes(obj, size);
+}
+
+
 void IncrementalMarking::Hurry() {
+  concurrent_marker_.Pause();
   if (state() == MARKING) {
     double start = 0.0;
     if (FLAG_trace_incremental_marking) {
@@ -680,7 +788,7 @@ void IncrementalMarking::Hurry() {
               HeapObject::RawField(map, Map::kPointerFieldsBeginOffset),
               HeapObject::RawField(map, Map::kPointerFieldsEndOffset));
         }
-      } else {
+      } else if (!RecordSliceCandidate(map, obj)) {
         obj->Iterate(&marking_visitor);
       }
 
@@ -724,12 +832,14 @@ void IncrementalMarking::Hurry() {
 
 void IncrementalMarking::Abort() {
   if (IsStopped()) return;
+  concurrent_marker_.Pause();
   if (FLAG_trace_incremental_marking) {
     PrintF("[IncrementalMarking] Aborting.\n");
   }
   heap_->new_space()->LowerInlineAllocationLimit(0);
   IncrementalMarking::set_should_hurry(false);
   ResetStepCounters();
+  heap_->mark_compact_collector()->ClearSliceCandidates();
   if (IsMarking()) {
     PatchIncrementalMarkingRecordWriteStubs(heap_,
                                             RecordWriteStub::STORE_BUFFER_ONLY);
@@ -800,12 +910,9 @@ void IncrementalMarking::Step(intptr_t allocated_bytes,
 
   intptr_t bytes_to_process = allocated_ * allocation_marking_factor_;
   bytes_scanned_ += bytes_to_process;
+  intptr_t bytes_to_mark = (state_ == MARKING) ? bytes_to_process : 0;
 
-  double start = 0;
-
-  if (FLAG_trace_incremental_marking || FLAG_trace_gc) {
-    start = OS::TimeCurrentMillis();
-  }
+  double start = OS::TimeCurrentMillis();
 
   if (state_ == SWEEPING) {
     if (heap_->AdvanceSweepers(static_cast<int>(bytes_to_process))) {
@@ -813,74 +920,32 @@ void IncrementalMarking::Step(intptr_t allocated_bytes,
       StartMarking(PREVENT_COMPACTION);
     }
   } else if (state_ == MARKING) {
-    Map* filler_map = heap_->one_pointer_filler_map();
-    Map* global_context_map = heap_->global_context_map();
-    IncrementalMarkingMarkingVisitor marking_visitor(heap_, this);
-    while (!marking_deque_.IsEmpty() && bytes_to_process > 0) {
-      HeapObject* obj = marking_deque_.Pop();
-
-      // Explicitly skip one word fillers. Incremental markbit patterns are
-      // correct only for objects that occupy at least two words.
-      Map* map = obj->map();
-      if (map == filler_map) continue;
-
-      int size = obj->SizeFromMap(map);
-      bytes_to_process -= size;
-      MarkBit map_mark_bit = Marking::MarkBitFrom(map);
-      if (Marking::IsWhite(map_mark_bit)) {
-        WhiteToGreyAndPush(map, map_mark_bit);
+    if (ConcurrentMarker::CanMarkConcurrently()) {
+      // The concurrent marker visits most of the objects.  We visit the
+      // objects it left to the main thread and hand it more work.
+      if (!concurrent_marker_.IsRunning()) concurrent_marker_.Start();
+      List<HeapObject*>* deferred_objects =
+          concurrent_marker_.TakeDeferredObjects();
+      while (!deferred_objects->is_empty() && bytes_to_process > 0) {
+        HeapObject* obj = deferred_objects->RemoveLast();
+        Map* map = obj->map();
+        int size = obj->SizeFromMap(map);
+        bytes_to_process -= size;
+        VisitObject(map, obj, size);
       }
-
-      // TODO(gc) switch to static visitor instead of normal visitor.
-      if (map == global_context_map) {
-        // Global contexts have weak fields.
-        Context* ctx = Context::cast(obj);
-
-        // We will mark cache black with a separate pass
-        // when we finish marking.
-        MarkObjectGreyDoNotEnqueue(ctx->normalized_map_cache());
-
-        VisitGlobalContext(ctx, &marking_visitor);
-      } else if (map->instance_type() == MAP_TYPE) {
-        Map* map = Map::cast(obj);
-        heap_->ClearCacheOnMap(map);
-
-        // When map collection is enabled we have to mark through map's
-        // transitions and back pointers in a special way to make these links
-        // weak.  Only maps for subclasses of JSReceiver can have transitions.
-        STATIC_ASSERT(LAST_TYPE == LAST_JS_RECEIVER_TYPE);
-        if (FLAG_collect_maps &&
-            map->instance_type() >= FIRST_JS_RECEIVER_TYPE) {
-          marker_.MarkMapContents(map);
-        } else {
-          marking_visitor.VisitPointers(
-              HeapObject::RawField(map, Map::kPointerFieldsBeginOffset),
-              HeapObject::RawField(map, Map::kPointerFieldsEndOffset));
-        }
-      } else if (map->instance_type() == JS_FUNCTION_TYPE) {
-        marking_visitor.VisitPointers(
-            HeapObject::RawField(obj, JSFunction::kPropertiesOffset),
-            HeapObject::RawField(obj, JSFunction::kCodeEntryOffset));
-
-        marking_visitor.VisitCodeEntry(
-            obj->address() + JSFunction::kCodeEntryOffset);
-
-        marking_visitor.VisitPointers(
-            HeapObject::RawField(obj,
-                                 JSFunction::kCodeEntryOffset + kPointerSize),
-            HeapObject::RawField(obj,
-                                 JSFunction::kNonWeakFieldsEndOffset));
-      } else {
-        obj->IterateBody(map->instance_type(), size, &marking_visitor);
+      concurrent_marker_.HandOffWork(&marking_deque_);
+      // Spend the rest of the budget on the deque as well, so that marking
+      // keeps pace even when the helper thread gets little CPU time.
+      ProcessMarkingDeque(bytes_to_process);
+      if (marking_deque_.IsEmpty() &&
+          deferred_objects->is_empty() &&
+          concurrent_marker_.IsIdle()) {
+        MarkingComplete(action);
       }
-
-      MarkBit obj_mark_bit = Marking::MarkBitFrom(obj);
-      SLOW_ASSERT(Marking::IsGrey(obj_mark_bit) ||
-                  (obj->IsFiller() && Marking::IsWhite(obj_mark_bit)));
-      Marking::MarkBlack(obj_mark_bit);
-      MemoryChunk::IncrementLiveBytesFromGC(obj->address(), size);
+    } else {
+      ProcessMarkingDeque(bytes_to_process);
+      if (marking_deque_.IsEmpty()) MarkingComplete(action);
     }
-    if (marking_deque_.IsEmpty()) MarkingComplete(action);
   }
 
   allocated_ = 0;
@@ -951,12 +1016,16 @@ void IncrementalMarking::Step(intptr_t allocated_bytes,
     }
   }
 
-  if (FLAG_trace_incremental_marking || FLAG_trace_gc) {
-    double end = OS::TimeCurrentMillis();
-    double delta = (end - start);
-    longest_step_ = Max(longest_step_, delta);
-    steps_took_ += delta;
-    steps_took_since_last_gc_ += delta;
+  double end = OS::TimeCurrentMillis();
+  double delta = (end - start);
+  longest_step_ = Max(longest_step_, delta);
+  steps_took_ += delta;
+  steps_took_since_last_gc_ += delta;
+
+  // A step that completed marking ran out of work before its budget, so
+  // only the others tell the marking speed.
+  if (bytes_to_mark > 0 && state_ == MARKING) {
+    heap_->RecordIncrementalMarkingStep(bytes_to_mark, delta);
   }
 }
 
@@ -29,6 +29,7 @@
 #define V8_INCREMENTAL_MARKING_H_
 
 
+#include "concurrent-marker.h"
 #include "execution.h"
 #include "mark-compact.h"
 #include "objects.h"
@@ -158,6 +159,7 @@ class IncrementalMarking {
   // white to black.
   inline bool MarkBlackOrKeepGrey(MarkBit mark_bit) {
     ASSERT(!Marking::IsImpossible(mark_bit));
+    if (concurrent_marker_.IsRunning()) return mark_bit.SetAtomically();
     if (mark_bit.Get()) {
       // Grey or black: Keep the color.
       return false;
@@ -167,6 +169,16 @@ class IncrementalMarking {
     return true;
   }
 
+  // Updates the live bytes of the chunk of the object.  The concurrent
+  // marker updates them as well while it is running.
+  inline void IncrementLiveBytes(HeapObject* obj, int by) {
+    if (concurrent_marker_.IsRunning()) {
+      MemoryChunk::IncrementLiveBytesFromGCAtomically(obj->address(), by);
+    } else {
+      MemoryChunk::IncrementLiveBytesFromGC(obj->address(), by);
+    }
+  }
+
   // Marks the object grey and pushes it on the marking stack.
   // Returns true if object needed marking and false otherwise.
   // This is for incremental marking only.
@@ -197,6 +209,10 @@ class IncrementalMarking {
     return steps_took_since_last_gc_;
   }
 
+  inline int allocation_marking_factor() {
+    return allocation_marking_factor_;
+  }
+
   inline void SetOldSpacePageFlags(MemoryChunk* chunk) {
     SetOldSpacePageFlags(chunk, IsMarking(), IsCompacting());
   }
@@ -207,6 +223,8 @@ class IncrementalMarking {
 
   MarkingDeque* marking_deque() { return &marking_deque_; }
 
+  ConcurrentMarker* concurrent_marker() { return &concurrent_marker_; }
+
   bool IsCompacting() { return IsMarking() && is_compacting_; }
 
   void ActivateGeneratedStub(Code* stub);
@@ -261,6 +279,17 @@ class IncrementalMarking {
 
   void VisitGlobalContext(Context* ctx, ObjectVisitor* v);
 
+  // Records a sliced string whose parent the full collection may free
+  // instead of marking the parent.  Returns false for other objects.
+  bool RecordSliceCandidate(Map* map, HeapObject* obj);
+
+  // Visits the body of a grey object and turns it black.
+  void VisitObject(Map* map, HeapObject* obj, int size);
+
+  // Pops and visits objects from the marking deque until it is empty or
+  // roughly bytes_to_process bytes have been visited.
+  void ProcessMarkingDeque(intptr_t bytes_to_process);
+
   Heap* heap_;
 
   State state_;
@@ -270,6 +299,7 @@ class IncrementalMarking {
   bool marking_deque_memory_committed_;
   MarkingDeque marking_deque_;
   Marker<IncrementalMarking> marker_;
+  ConcurrentMarker concurrent_marker_;
 
   int steps_count_;
   double steps_took_;
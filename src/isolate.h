@@ -1291,6 +1291,7 @@ class Isolate {
   OptimizingCompilerThread optimizing_compiler_thread_;
 
   friend class ExecutionAccess;
+  friend class GCHelperThread;
   friend class HandleScopeImplementer;
   friend class IsolateInitializer;
   friend class OptimizingCompilerThread;
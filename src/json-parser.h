@@ -540,12 +540,7 @@ Handle<String> JsonParser<seq_ascii>::SlowScanJsonString(
         template ShrinkStringAtAllocationBoundary<StringType>(
             *seq_str, count);
   } else {
-    int string_size = StringType::SizeFor(count);
-    int allocated_string_size = StringType::SizeFor(length);
-    int delta = allocated_string_size - string_size;
-    Address start_filler_object = seq_str->address() + string_size;
-    seq_str->set_length(count);
-    isolate()->heap()->CreateFillerObjectAt(start_filler_object, delta);
+    isolate()->heap()->RightTrimObject(*seq_str, count);
   }
   ASSERT_EQ('"', c0_);
   // Advance past the last '"'.
@@ -179,7 +179,12 @@ void LEnvironment::PrintTo(StringStream* stream) {
   for (int i = 0; i < values_.length(); ++i) {
     if (i != 0) stream->Add(";");
     if (values_[i] == NULL) {
-      stream->Add("[hole]");
+      LCapturedObject* object = CapturedObjectAt(i);
+      if (object != NULL) {
+        stream->Add("[object #%d]", object->capture_id());
+      } else {
+        stream->Add("[hole]");
+      }
     } else {
       values_[i]->PrintTo(stream);
     }
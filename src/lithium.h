@@ -451,6 +451,34 @@ class LPointerMap: public ZoneObject {
 };
 
 
+// An object that escape analysis removed from the optimized code.  The
+// deoptimizer rematerializes it from its map and the values of its fields,
+// which follow the values of the frame in the environment.
+class LCapturedObject: public ZoneObject {
+ public:
+  LCapturedObject(int slot, int capture_id, Handle<Map> map, int field_count)
+      : slot_(slot),
+        capture_id_(capture_id),
+        map_(map),
+        field_count_(field_count),
+        first_field_(-1) { }
+
+  int slot() const { return slot_; }
+  int capture_id() const { return capture_id_; }
+  Handle<Map> map() const { return map_; }
+  int field_count() const { return field_count_; }
+  int first_field() const { return first_field_; }
+  void set_first_field(int index) { first_field_ = index; }
+
+ private:
+  int slot_;
+  int capture_id_;
+  Handle<Map> map_;
+  int field_count_;
+  int first_field_;
+};
+
+
 class LEnvironment: public ZoneObject {
  public:
   LEnvironment(Handle<JSFunction> closure,
@@ -471,6 +499,8 @@ class LEnvironment: public ZoneObject {
         pc_offset_(-1),
         values_(value_count, zone),
         is_tagged_(value_count, zone),
+        captured_objects_(0, zone),
+        captured_field_count_(0),
         spilled_registers_(NULL),
         spilled_double_registers_(NULL),
         outer_(outer),
@@ -502,6 +532,48 @@ class LEnvironment: public ZoneObject {
     return is_tagged_.Contains(index);
   }
 
+  // The number of values of the frame, the fields of captured objects are
+  // not part of it.
+  int translation_size() const {
+    return values_.length() - captured_field_count_;
+  }
+
+  // Adds a slot holding a captured object.  Several slots may hold the same
+  // object, its fields are added once by AddCapturedField.
+  void AddCapturedObject(int capture_id, Handle<Map> map, int field_count) {
+    LCapturedObject* object = new(zone()) LCapturedObject(
+        values_.length(), capture_id, map, field_count);
+    captured_objects_.Add(object, zone());
+    values_.Add(NULL, zone());
+  }
+
+  // Returns NULL if the slot does not hold a captured object.
+  LCapturedObject* CapturedObjectAt(int slot) const {
+    for (int i = 0; i < captured_objects_.length(); ++i) {
+      if (captured_objects_[i]->slot() == slot) return captured_objects_[i];
+    }
+    return NULL;
+  }
+
+  // Returns false if the fields of the object have already been added.
+  // Otherwise they have to follow.
+  bool BeginCapturedObjectFields(int capture_id) {
+    bool result = false;
+    for (int i = 0; i < captured_objects_.length(); ++i) {
+      LCapturedObject* object = captured_objects_[i];
+      if (object->capture_id() == capture_id && object->first_field() < 0) {
+        object->set_first_field(values_.length());
+        result = true;
+      }
+    }
+    return result;
+  }
+
+  void AddCapturedField(LOperand* operand, Representation representation) {
+    AddValue(operand, representation);
+    captured_field_count_++;
+  }
+
   void Register(int deoptimization_index,
                 int translation_index,
                 int pc_offset) {
@@ -535,6 +607,8 @@ class LEnvironment: public ZoneObject {
   int pc_offset_;
   ZoneList<LOperand*> values_;
   BitVector is_tagged_;
+  ZoneList<LCapturedObject*> captured_objects_;
+  int captured_field_count_;
 
   // Allocation index indexed arrays of spill slot operands for registers
   // that are also in spill slots at an OSR entry.  NULL for environments
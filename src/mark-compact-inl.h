@@ -49,6 +49,8 @@ void MarkCompactCollector::SetFlags(int flags) {
   reduce_memory_footprint_ = ((flags & Heap::kReduceMemoryFootprintMask) != 0);
   abort_incremental_marking_ =
       ((flags & Heap::kAbortIncrementalMarkingMask) != 0);
+  force_compaction_ = ((flags & Heap::kForceCompactionMask) != 0);
+  flush_all_code_ = ((flags & Heap::kFlushAllCodeMask) != 0);
 }
 
 
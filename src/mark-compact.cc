@@ -33,6 +33,7 @@
 #include "execution.h"
 #include "gdb-jit.h"
 #include "global-handles.h"
+#include "hashmap.h"
 #include "heap-profiler.h"
 #include "ic-inl.h"
 #include "incremental-marking.h"
@@ -40,7 +41,10 @@
 #include "mark-compact.h"
 #include "objects-visiting.h"
 #include "objects-visiting-inl.h"
+#include "parallel-evacuator.h"
+#include "parallel-marker.h"
 #include "stub-cache.h"
+#include "sweeper.h"
 
 namespace v8 {
 namespace internal {
@@ -62,15 +66,27 @@ MarkCompactCollector::MarkCompactCollector() :  // NOLINT
       sweep_precisely_(false),
       reduce_memory_footprint_(false),
       abort_incremental_marking_(false),
+      force_compaction_(false),
+      flush_all_code_(false),
       compacting_(false),
       was_marked_incrementally_(false),
       flush_monomorphic_ics_(false),
       tracer_(NULL),
       migration_slots_buffer_(NULL),
+      number_of_sweeper_threads_(0),
+      sweeping_pending_(false),
+      running_sweeper_threads_(0),
+      parallel_marker_(NULL),
+      parallel_evacuator_(NULL),
       heap_(NULL),
       code_flusher_(NULL),
       encountered_weak_maps_(NULL),
-      marker_(this, this) { }
+      marker_(this, this) {
+  for (int i = 0; i < kMaxSweeperThreads; i++) {
+    sweepers_[i] = NULL;
+    sweeper_threads_[i] = NULL;
+  }
+}
 
 
 #ifdef DEBUG
@@ -257,14 +273,22 @@ bool MarkCompactCollector::StartCompaction(CompactionMode mode) {
       TraceFragmentation(heap()->code_space());
     }
 
-    if (FLAG_trace_fragmentation) {
+    // Map space candidates are collected last so that their pages are
+    // evacuated after all objects whose size depends on their maps.
+    if (FLAG_compact_map_space && mode == NON_INCREMENTAL_COMPACTION) {
+      CollectEvacuationCandidates(heap()->map_space());
+    } else if (FLAG_trace_fragmentation) {
       TraceFragmentation(heap()->map_space());
+    }
+
+    if (FLAG_trace_fragmentation) {
       TraceFragmentation(heap()->cell_space());
     }
 
     heap()->old_pointer_space()->EvictEvacuationCandidatesFromFreeLists();
     heap()->old_data_space()->EvictEvacuationCandidatesFromFreeLists();
     heap()->code_space()->EvictEvacuationCandidatesFromFreeLists();
+    heap()->map_space()->EvictEvacuationCandidatesFromFreeLists();
 
     compacting_ = evacuation_candidates_.length() > 0;
   }
@@ -286,12 +310,19 @@ void MarkCompactCollector::CollectGarbage() {
 
   ClearWeakMaps();
 
+  // Large strings that are only reachable through small slices are freed.
+  RescueSlicedStrings();
+
 #ifdef DEBUG
   if (FLAG_verify_heap) {
     VerifyMarking(heap_);
   }
 #endif
 
+  if (FLAG_string_deduplication) DeduplicateStrings();
+
+  if (compacting_) RecordMapSlots();
+
   SweepSpaces();
 
   if (!FLAG_collect_maps) ReattachInitialMaps();
@@ -394,15 +425,31 @@ bool Marking::TransferMark(Address old_start, Address new_start) {
   ObjectColor old_color = Color(old_mark_bit);
 #endif
 
+  // The concurrent marker may change mark bits of neighbouring objects in
+  // the same cells.  The caller holds the lock of the chunk, so it does not
+  // change the colour of this object.
+  bool concurrent =
+      heap_->incremental_marking()->concurrent_marker()->IsRunning();
+
   if (Marking::IsBlack(old_mark_bit)) {
-    old_mark_bit.Clear();
+    if (concurrent) {
+      old_mark_bit.ClearAtomically();
+      Marking::MarkBlackAtomically(new_mark_bit);
+    } else {
+      old_mark_bit.Clear();
+      Marking::MarkBlack(new_mark_bit);
+    }
     ASSERT(IsWhite(old_mark_bit));
-    Marking::MarkBlack(new_mark_bit);
     return true;
   } else if (Marking::IsGrey(old_mark_bit)) {
     ASSERT(heap_->incremental_marking()->IsMarking());
-    old_mark_bit.Clear();
-    old_mark_bit.Next().Clear();
+    if (concurrent) {
+      old_mark_bit.ClearAtomically();
+      old_mark_bit.Next().ClearAtomically();
+    } else {
+      old_mark_bit.Clear();
+      old_mark_bit.Next().Clear();
+    }
     ASSERT(IsWhite(old_mark_bit));
     heap_->incremental_marking()->WhiteToGreyAndPush(
         HeapObject::FromAddress(new_start), new_mark_bit);
@@ -498,7 +545,8 @@ static int FreeListFragmentation(PagedSpace* space, Page* p) {
 void MarkCompactCollector::CollectEvacuationCandidates(PagedSpace* space) {
   ASSERT(space->identity() == OLD_POINTER_SPACE ||
          space->identity() == OLD_DATA_SPACE ||
-         space->identity() == CODE_SPACE);
+         space->identity() == CODE_SPACE ||
+         space->identity() == MAP_SPACE);
 
   static const int kMaxMaxEvacuationCandidates = 1000;
   int number_of_pages = space->CountTotalPages();
@@ -558,6 +606,11 @@ void MarkCompactCollector::CollectEvacuationCandidates(PagedSpace* space) {
     }
   }
 
+  if (force_compaction_) {
+    mode = REDUCE_MEMORY_FOOTPRINT;
+    max_evacuation_candidates = kMaxMaxEvacuationCandidates;
+  }
+
   intptr_t estimated_release = 0;
 
   Candidate candidates[kMaxMaxEvacuationCandidates];
@@ -570,7 +623,9 @@ void MarkCompactCollector::CollectEvacuationCandidates(PagedSpace* space) {
   Candidate* least = NULL;
 
   PageIterator it(space);
-  if (it.has_next()) it.next();  // Never compact the first page.
+  // Never compact the first page.  In map space it holds the meta map and
+  // the other root maps, which must not move.
+  if (it.has_next()) it.next();
 
   while (it.has_next()) {
     Page* p = it.next();
@@ -582,7 +637,8 @@ void MarkCompactCollector::CollectEvacuationCandidates(PagedSpace* space) {
       if ((counter & 1) == (page_number & 1)) fragmentation = 1;
     } else if (mode == REDUCE_MEMORY_FOOTPRINT) {
       // Don't try to release too many pages.
-      if (estimated_release >= ((over_reserved * 3) / 4)) {
+      if (!force_compaction_ &&
+          estimated_release >= ((over_reserved * 3) / 4)) {
         continue;
       }
 
@@ -669,6 +725,11 @@ void MarkCompactCollector::AbortCompaction() {
 void MarkCompactCollector::Prepare(GCTracer* tracer) {
   was_marked_incrementally_ = heap()->incremental_marking()->IsMarking();
 
+  // The sweeper threads still use the mark bits of the pages they sweep.
+  if (IsConcurrentSweepingInProgress()) {
+    WaitUntilSweepingCompleted();
+  }
+
   // Monomorphic ICs are preserved when possible, but need to be flushed
   // when they might be keeping a Context alive, or when the heap is about
   // to be serialized.
@@ -1128,11 +1189,24 @@ class StaticMarkingVisitor : public StaticVisitorBase {
     MarkBit table_mark = Marking::MarkBitFrom(table);
     collector->RecordSlot(table_slot, table_slot, table);
     if (!table_mark.Get()) collector->SetMark(table, table_mark);
-    // Recording the map slot can be skipped, because maps are not compacted.
+    // The map slot is recorded by RecordMapSlots if map space is compacted.
     collector->MarkObject(table->map(), Marking::MarkBitFrom(table->map()));
     ASSERT(MarkCompactCollector::IsMarked(table->map()));
   }
 
+  static void VisitSlicedString(Map* map, HeapObject* object) {
+    MarkCompactCollector* collector = map->GetHeap()->mark_compact_collector();
+    // Candidates do not mark their parents; RescueSlicedStrings decides
+    // whether the parent stays alive once marking is otherwise complete.
+    if (collector->RecordSliceCandidate(
+            reinterpret_cast<SlicedString*>(object))) {
+      return;
+    }
+    FixedBodyVisitor<StaticMarkingVisitor,
+                     SlicedString::BodyDescriptor,
+                     void>::Visit(map, object);
+  }
+
   static void VisitCode(Map* map, HeapObject* object) {
     Heap* heap = map->GetHeap();
     Code* code = reinterpret_cast<Code*>(object);
@@ -1224,8 +1298,9 @@ class StaticMarkingVisitor : public StaticVisitorBase {
       return false;
     }
 
-    // Age this shared function info.
-    if (shared_info->code_age() < kCodeAgeThreshold) {
+    // Age this shared function info, unless all code is to be flushed.
+    if (shared_info->code_age() < kCodeAgeThreshold &&
+        !heap->mark_compact_collector()->flush_all_code()) {
       shared_info->set_code_age(shared_info->code_age() + 1);
       return false;
     }
@@ -1274,6 +1349,16 @@ class StaticMarkingVisitor : public StaticVisitorBase {
 
     Object* code = re->DataAtUnchecked(JSRegExp::code_index(is_ascii));
     if (!code->IsSmi() &&
+        HeapObject::cast(code)->map()->instance_type() == CODE_TYPE &&
+        heap->mark_compact_collector()->flush_all_code()) {
+      // Flush right away instead of saving a copy.
+      re->SetDataAtUnchecked(JSRegExp::code_index(is_ascii),
+                             Smi::FromInt(JSRegExp::kUninitializedValue),
+                             heap);
+      re->SetDataAtUnchecked(JSRegExp::saved_code_index(is_ascii),
+                             Smi::FromInt(JSRegExp::kUninitializedValue),
+                             heap);
+    } else if (!code->IsSmi() &&
         HeapObject::cast(code)->map()->instance_type() == CODE_TYPE) {
       // Save a copy that can be reinstated if we need the code again.
       re->SetDataAtUnchecked(JSRegExp::saved_code_index(is_ascii),
@@ -1302,7 +1387,8 @@ class StaticMarkingVisitor : public StaticVisitorBase {
       }
 
       // Check if we should flush now.
-      if (value == ((heap->sweep_generation() - kRegExpCodeThreshold) & 0xff)) {
+      if (heap->mark_compact_collector()->flush_all_code() ||
+          value == ((heap->sweep_generation() - kRegExpCodeThreshold) & 0xff)) {
         re->SetDataAtUnchecked(JSRegExp::code_index(is_ascii),
                                Smi::FromInt(JSRegExp::kUninitializedValue),
                                heap);
@@ -1646,10 +1732,7 @@ void StaticMarkingVisitor::Initialize() {
                   ConsString::BodyDescriptor,
                   void>::Visit);
 
-  table_.Register(kVisitSlicedString,
-                  &FixedBodyVisitor<StaticMarkingVisitor,
-                  SlicedString::BodyDescriptor,
-                  void>::Visit);
+  table_.Register(kVisitSlicedString, &VisitSlicedString);
 
   table_.Register(kVisitFixedArray,
                   &FlexibleBodyVisitor<StaticMarkingVisitor,
@@ -2326,23 +2409,33 @@ void MarkCompactCollector::MarkImplicitRefGroups() {
 }
 
 
+void MarkCompactCollector::VisitMarkedObject(HeapObject* object) {
+  ASSERT(object->IsHeapObject());
+  ASSERT(heap()->Contains(object));
+  ASSERT(Marking::IsBlack(Marking::MarkBitFrom(object)));
+
+  Map* map = object->map();
+  MarkBit map_mark = Marking::MarkBitFrom(map);
+  MarkObject(map, map_mark);
+
+  StaticMarkingVisitor::IterateBody(map, object);
+}
+
+
 // Mark all objects reachable from the objects on the marking stack.
 // Before: the marking stack contains zero or more heap object pointers.
 // After: the marking stack is empty, and all objects reachable from the
 // marking stack have been marked, or are overflowed in the heap.
 void MarkCompactCollector::EmptyMarkingDeque() {
   while (!marking_deque_.IsEmpty()) {
+    if (ParallelMarker::CanMarkInParallel()) {
+      if (parallel_marker_ == NULL) {
+        parallel_marker_ = new ParallelMarker(this);
+      }
+      parallel_marker_->EmptyMarkingDeque();
+    }
     while (!marking_deque_.IsEmpty()) {
-      HeapObject* object = marking_deque_.Pop();
-      ASSERT(object->IsHeapObject());
-      ASSERT(heap()->Contains(object));
-      ASSERT(Marking::IsBlack(Marking::MarkBitFrom(object)));
-
-      Map* map = object->map();
-      MarkBit map_mark = Marking::MarkBitFrom(map);
-      MarkObject(map, map_mark);
-
-      StaticMarkingVisitor::IterateBody(map, object);
+      VisitMarkedObject(marking_deque_.Pop());
     }
 
     // Process encountered weak maps, mark objects only reachable by those
@@ -2424,6 +2517,138 @@ void MarkCompactCollector::ProcessExternalMarking() {
 }
 
 
+bool MarkCompactCollector::RecordSliceCandidate(SlicedString* slice) {
+  if (!FLAG_rescue_string_slices) return false;
+  String* parent = String::cast(slice->parent());
+  if (!heap()->lo_space()->Contains(parent)) return false;
+  if (Marking::MarkBitFrom(parent).Get()) return false;
+  if (slice->length() > parent->length() / kSliceRescueRatio) return false;
+  slice_candidates_.Add(slice);
+  return true;
+}
+
+
+void MarkCompactCollector::UpdateSliceCandidatesAfterScavenge() {
+  int kept = 0;
+  for (int i = 0; i < slice_candidates_.length(); i++) {
+    SlicedString* slice = slice_candidates_[i];
+    if (heap()->InNewSpace(slice)) {
+      MapWord map_word = slice->map_word();
+      // Slices that were not copied by the scavenge are dead.
+      if (!map_word.IsForwardingAddress()) continue;
+      slice = reinterpret_cast<SlicedString*>(
+          map_word.ToForwardingAddress());
+    }
+    slice_candidates_[kept++] = slice;
+  }
+  slice_candidates_.Rewind(kept);
+}
+
+
+static int CompareSliceCandidates(SlicedString* const* a,
+                                  SlicedString* const* b) {
+  Address parent_a = HeapObject::cast((*a)->parent())->address();
+  Address parent_b = HeapObject::cast((*b)->parent())->address();
+  if (parent_a < parent_b) return -1;
+  if (parent_a > parent_b) return 1;
+  if ((*a)->address() < (*b)->address()) return -1;
+  if ((*a)->address() > (*b)->address()) return 1;
+  return 0;
+}
+
+
+bool MarkCompactCollector::CopySliceOutOfParent(SlicedString* slice) {
+  String* parent = String::cast(slice->parent());
+  int from = slice->offset();
+  int to = from + slice->length();
+  bool is_ascii = slice->IsAsciiRepresentation();
+  int size = is_ascii ? SeqAsciiString::SizeFor(slice->length())
+                      : SeqTwoByteString::SizeFor(slice->length());
+  Object* result;
+  { MaybeObject* maybe_result = heap()->new_space()->AllocateRaw(size);
+    if (!maybe_result->ToObject(&result)) return false;
+  }
+
+  String* copy = reinterpret_cast<String*>(result);
+  if (is_ascii) {
+    copy->set_map_no_write_barrier(heap()->ascii_string_map());
+    copy->set_length(slice->length());
+    copy->set_hash_field(String::kEmptyHashField);
+    String::WriteToFlat(parent, SeqAsciiString::cast(copy)->GetChars(),
+                        from, to);
+  } else {
+    copy->set_map_no_write_barrier(heap()->string_map());
+    copy->set_length(slice->length());
+    copy->set_hash_field(String::kEmptyHashField);
+    String::WriteToFlat(parent, SeqTwoByteString::cast(copy)->GetChars(),
+                        from, to);
+  }
+  // The copy is evacuated with the other marked objects in new space.
+  SetMark(copy, Marking::MarkBitFrom(copy));
+
+  // The slice is already marked, so it is turned into a flat cons string of
+  // the same size in place.  Later collections short-circuit it.
+  STATIC_ASSERT(ConsString::kSize == SlicedString::kSize);
+  slice->set_map_no_write_barrier(is_ascii ? heap()->cons_ascii_string_map()
+                                           : heap()->cons_string_map());
+  ConsString* cons = reinterpret_cast<ConsString*>(slice);
+  cons->set_first(copy);
+  cons->set_second(heap()->empty_string(), SKIP_WRITE_BARRIER);
+  return true;
+}
+
+
+void MarkCompactCollector::RescueSlicedStrings() {
+  // Slices that stopped being sliced strings since they were recorded, for
+  // example by being made external, no longer refer to their parents.
+  int kept = 0;
+  for (int i = 0; i < slice_candidates_.length(); i++) {
+    SlicedString* slice = slice_candidates_[i];
+    if (slice->IsSlicedString()) slice_candidates_[kept++] = slice;
+  }
+  slice_candidates_.Rewind(kept);
+  if (slice_candidates_.is_empty()) return;
+  slice_candidates_.Sort(&CompareSliceCandidates);
+
+  int start = 0;
+  while (start < slice_candidates_.length()) {
+    String* parent = String::cast(slice_candidates_[start]->parent());
+    int end = start;
+    int total_length = 0;
+    while (end < slice_candidates_.length() &&
+           slice_candidates_[end]->parent() == parent) {
+      if (end == start ||
+          slice_candidates_[end] != slice_candidates_[end - 1]) {
+        total_length += slice_candidates_[end]->length();
+      }
+      end++;
+    }
+
+    // Parents that were reached in some other way after their slices were
+    // visited need nothing further; large objects are never moved.
+    MarkBit parent_mark = Marking::MarkBitFrom(parent);
+    if (!parent_mark.Get()) {
+      bool rescued = total_length <= parent->length() / kSliceRescueRatio;
+      for (int i = start; rescued && i < end; i++) {
+        SlicedString* slice = slice_candidates_[i];
+        // A slice recorded twice was handled by its first entry.
+        if (!slice->IsSlicedString()) continue;
+        rescued = CopySliceOutOfParent(slice);
+      }
+      if (rescued) {
+        tracer_->increment_rescued_slice_parents_size(parent->Size());
+      } else {
+        // Slices that were not copied still refer to the parent, which has
+        // no pointers of its own to mark.
+        SetMark(parent, parent_mark);
+      }
+    }
+    start = end;
+  }
+  slice_candidates_.Rewind(0);
+}
+
+
 void MarkCompactCollector::MarkLiveObjects() {
   GCTracer::Scope gc_scope(tracer_, GCTracer::Scope::MC_MARK);
   // The recursive GC marker detects when it is nearing stack overflow,
@@ -2489,6 +2714,10 @@ void MarkCompactCollector::MarkLiveObjects() {
     }
   }
 
+  // Candidates recorded by incremental marking are kept; an aborted
+  // incremental marking has cleared them.
+  ASSERT(was_marked_incrementally_ || slice_candidates_.is_empty());
+
   RootMarkingVisitor root_visitor(heap());
   MarkRoots(&root_visitor);
 
@@ -2651,7 +2880,12 @@ void MarkCompactCollector::ClearNonLiveTransitions() {
       // This map is used for inobject slack tracking and has been detached
       // from SharedFunctionInfo during the mark phase.
       // Since it survived the GC, reattach it now.
-      map->unchecked_constructor()->unchecked_shared()->AttachInitialMap(map);
+      SharedFunctionInfo* shared =
+          map->unchecked_constructor()->unchecked_shared();
+      shared->AttachInitialMap(map);
+      Object** slot =
+          HeapObject::RawField(shared, SharedFunctionInfo::kInitialMapOffset);
+      RecordSlot(slot, slot, map);
     }
 
     ClearNonLivePrototypeTransitions(map);
@@ -2766,6 +3000,308 @@ void MarkCompactCollector::ClearWeakMaps() {
 }
 
 
+// Calls visitor->VisitMarkedObject for every marked object on the page.
+template<class Visitor>
+static void IterateMarkedObjectsOnPage(MemoryChunk* p, Visitor* visitor) {
+  MarkBit::CellType* cells = p->markbits()->cells();
+
+  int last_cell_index =
+      Bitmap::IndexToCell(
+          Bitmap::CellAlignIndex(
+              p->AddressToMarkbitIndex(p->area_end())));
+
+  Address cell_base = p->area_start();
+  int cell_index = Bitmap::IndexToCell(
+          Bitmap::CellAlignIndex(
+              p->AddressToMarkbitIndex(cell_base)));
+
+  int offsets[16];
+
+  for (;
+       cell_index < last_cell_index;
+       cell_index++, cell_base += 32 * kPointerSize) {
+    if (cells[cell_index] == 0) continue;
+
+    int live_objects = MarkWordToObjectStarts(cells[cell_index], offsets);
+    for (int i = 0; i < live_objects; i++) {
+      visitor->VisitMarkedObject(
+          HeapObject::FromAddress(cell_base + offsets[i] * kPointerSize));
+    }
+  }
+}
+
+
+// Collects the sequential strings referenced from strong roots.  Runtime
+// functions write to a sequential string only while they build it, e.g. the
+// JSON parser and regexp replace allocate it for the longest possible
+// result and truncate it when they are done.  Until then the string is only
+// referenced from handles or the stack, so only strings that are not are
+// known to be immutable.
+class PinnedStringCollector: public ObjectVisitor {
+ public:
+  explicit PinnedStringCollector(HashMap* pinned_strings)
+      : pinned_strings_(pinned_strings) { }
+
+  void VisitPointers(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) {
+      Object* object = *p;
+      if (object->IsSeqString() && !object->IsSymbol()) {
+        pinned_strings_->Lookup(object, ComputePointerHash(object), true);
+      }
+    }
+  }
+
+ private:
+  HashMap* pinned_strings_;
+};
+
+
+// Finds marked sequential strings with the same contents as one seen
+// before, forwards them to that canonical copy and unmarks them, so that
+// the sweeper frees them once all pointers to them are updated.
+class StringDeduplicationTable {
+ public:
+  explicit StringDeduplicationTable(GCTracer* tracer)
+      : canonical_strings_(&StringsMatch),
+        pinned_strings_(&PointersMatch),
+        tracer_(tracer) { }
+
+  // Strings that may still be written to; they are neither merged nor used
+  // as the canonical copy of others.
+  HashMap* pinned_strings() { return &pinned_strings_; }
+
+  void VisitMarkedObject(HeapObject* object) {
+    if (!object->IsSeqString() || object->IsSymbol()) return;
+    String* string = String::cast(object);
+    if (string->length() < FLAG_string_deduplication_min_length) return;
+    if (pinned_strings_.Lookup(string, ComputePointerHash(string), false) !=
+        NULL) {
+      return;
+    }
+
+    HashMap::Entry* entry =
+        canonical_strings_.Lookup(string, string->Hash(), true);
+    if (entry->key == string) return;
+
+    int size = string->Size();
+    string->set_map_word(MapWord::FromForwardingAddress(
+        reinterpret_cast<String*>(entry->key)));
+    Marking::MarkBitFrom(string).Clear();
+    MemoryChunk::IncrementLiveBytesFromGC(string->address(), -size);
+    tracer_->increment_deduplicated_strings_size(size);
+    duplicates_.Add(string);
+  }
+
+  bool found_duplicates() { return !duplicates_.is_empty(); }
+
+  // Restores the maps of the duplicates so that they stay iterable until
+  // the sweeper frees them.
+  void UnforwardDuplicates() {
+    for (int i = 0; i < duplicates_.length(); i++) {
+      HeapObject* duplicate = duplicates_[i];
+      HeapObject* canonical = duplicate->map_word().ToForwardingAddress();
+      duplicate->set_map_no_write_barrier(canonical->map());
+    }
+  }
+
+ private:
+  static bool StringsMatch(void* key1, void* key2) {
+    String* string1 = reinterpret_cast<String*>(key1);
+    String* string2 = reinterpret_cast<String*>(key2);
+    // Only strings of the same representation are merged, as a sliced string
+    // needs a parent of its own encoding.
+    return string1->map() == string2->map() && string1->Equals(string2);
+  }
+
+  static bool PointersMatch(void* key1, void* key2) {
+    return key1 == key2;
+  }
+
+  HashMap canonical_strings_;
+  HashMap pinned_strings_;
+  List<HeapObject*> duplicates_;
+  GCTracer* tracer_;
+};
+
+
+// Redirects pointers to duplicate strings to their canonical copies.
+class DeduplicatedStringUpdatingVisitor: public ObjectVisitor {
+ public:
+  void VisitPointer(Object** p) {
+    UpdatePointer(p);
+  }
+
+  void VisitPointers(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) UpdatePointer(p);
+  }
+
+  void VisitMarkedObject(HeapObject* object) {
+    object->Iterate(this);
+  }
+
+ private:
+  inline void UpdatePointer(Object** p) {
+    Object* obj = *p;
+    if (!obj->IsHeapObject()) return;
+    MapWord map_word = HeapObject::cast(obj)->map_word();
+    if (map_word.IsForwardingAddress()) {
+      ASSERT(map_word.ToForwardingAddress()->IsSeqString());
+      *p = map_word.ToForwardingAddress();
+    }
+  }
+};
+
+
+void MarkCompactCollector::DeduplicateStrings() {
+  GCTracer::Scope gc_scope(tracer_, GCTracer::Scope::MC_DEDUPLICATE_STRINGS);
+  StringDeduplicationTable table(tracer_);
+  PinnedStringCollector pinned_string_collector(table.pinned_strings());
+  heap()->IterateStrongRoots(&pinned_string_collector, VISIT_ONLY_STRONG);
+
+  // Strings on evacuation candidates are left alone, as pointers to them
+  // are only updated through the slots recorded during marking.
+  PageIterator it(heap()->old_data_space());
+  while (it.has_next()) {
+    Page* p = it.next();
+    if (!p->IsEvacuationCandidate()) IterateMarkedObjectsOnPage(p, &table);
+  }
+  if (!table.found_duplicates()) return;
+
+  // Pointers to the duplicates are updated before evacuation, so that
+  // evacuated objects are copied with the updated pointers.
+  DeduplicatedStringUpdatingVisitor updating_visitor;
+  heap()->IterateRoots(&updating_visitor, VISIT_ALL_IN_SWEEP_NEWSPACE);
+  LiveObjectList::IterateElements(&updating_visitor);
+
+  SemiSpaceIterator to_it(heap()->new_space()->bottom(),
+                          heap()->new_space()->top());
+  for (HeapObject* object = to_it.Next();
+       object != NULL;
+       object = to_it.Next()) {
+    if (IsMarked(object)) object->Iterate(&updating_visitor);
+  }
+
+  PagedSpaces spaces;
+  for (PagedSpace* space = spaces.next();
+       space != NULL;
+       space = spaces.next()) {
+    if (space == heap()->old_data_space()) continue;
+    PageIterator page_it(space);
+    while (page_it.has_next()) {
+      IterateMarkedObjectsOnPage(page_it.next(), &updating_visitor);
+    }
+  }
+
+  LargeObjectIterator lo_it(heap()->lo_space());
+  for (HeapObject* object = lo_it.Next();
+       object != NULL;
+       object = lo_it.Next()) {
+    if (IsMarked(object)) object->Iterate(&updating_visitor);
+  }
+
+  table.UnforwardDuplicates();
+}
+
+
+// Records the slots of live objects that refer to maps on evacuation
+// candidates but are not recorded during marking.
+class MapSlotRecorder {
+ public:
+  explicit MapSlotRecorder(MarkCompactCollector* collector)
+      : collector_(collector) { }
+
+  void VisitMarkedObject(HeapObject* object) {
+    RecordSlot(HeapObject::RawField(object, HeapObject::kMapOffset));
+    if (object->IsMap()) RecordWeakSlots(Map::cast(object));
+  }
+
+ private:
+  // Only slots of maps on evacuation candidates are recorded.  Almost every
+  // map word points elsewhere and would only fill the slots buffers.
+  void RecordSlot(Object** slot) {
+    Object* target = *slot;
+    if (target->IsHeapObject() &&
+        MarkCompactCollector::IsOnEvacuationCandidate(target)) {
+      collector_->RecordSlot(slot, slot, target);
+    }
+  }
+
+  // Back pointers and transitions are treated weakly during marking and
+  // compacted by ClearNonLiveTransitions, so their slots are recorded now.
+  void RecordWeakSlots(Map* map) {
+    Object* descriptors_or_back_pointer = *HeapObject::RawField(
+        map, Map::kInstanceDescriptorsOrBackPointerOffset);
+    if (!descriptors_or_back_pointer->IsDescriptorArray()) return;
+    DescriptorArray* descriptors =
+        DescriptorArray::cast(descriptors_or_back_pointer);
+    if (descriptors->length() <= DescriptorArray::kBackPointerStorageIndex) {
+      return;
+    }
+    RecordSlot(HeapObject::RawField(
+        descriptors, DescriptorArray::kBackPointerStorageOffset));
+    if (!descriptors->HasTransitionArray()) return;
+
+    TransitionArray* transitions = descriptors->transitions();
+    for (int i = 0; i < transitions->number_of_transitions(); i++) {
+      RecordSlot(transitions->GetTargetSlot(i));
+    }
+    if (transitions->HasElementsTransition()) {
+      RecordSlot(HeapObject::RawField(
+          transitions, TransitionArray::kElementsTransitionOffset));
+    }
+    if (transitions->HasPrototypeTransitions()) {
+      FixedArray* prototype_transitions =
+          transitions->GetPrototypeTransitions();
+      const int map_offset =
+          Map::kProtoTransitionHeaderSize + Map::kProtoTransitionMapOffset;
+      const int step = Map::kProtoTransitionElementsPerEntry;
+      for (int i = 0; i < map->NumberOfProtoTransitions(); i++) {
+        RecordSlot(HeapObject::RawField(
+            prototype_transitions,
+            FixedArray::OffsetOfElementAt(map_offset + i * step)));
+      }
+    }
+  }
+
+  MarkCompactCollector* collector_;
+};
+
+
+void MarkCompactCollector::RecordMapSlots() {
+  bool map_space_compacting = false;
+  for (int i = 0; i < evacuation_candidates_.length(); i++) {
+    Page* p = evacuation_candidates_[i];
+    if (p->owner() == heap()->map_space() && p->IsEvacuationCandidate()) {
+      map_space_compacting = true;
+      break;
+    }
+  }
+  if (!map_space_compacting) return;
+
+  // Objects on evacuation candidates and in new space record their map
+  // slots when they are migrated.  Objects on pages that are rescanned after
+  // evacuation have their map slots updated by the rescan.
+  MapSlotRecorder recorder(this);
+  PagedSpaces spaces;
+  for (PagedSpace* space = spaces.next();
+       space != NULL;
+       space = spaces.next()) {
+    PageIterator it(space);
+    while (it.has_next()) {
+      Page* p = it.next();
+      if (!p->IsEvacuationCandidate()) IterateMarkedObjectsOnPage(p, &recorder);
+    }
+  }
+
+  LargeObjectIterator lo_it(heap()->lo_space());
+  for (HeapObject* object = lo_it.Next();
+       object != NULL;
+       object = lo_it.Next()) {
+    if (IsMarked(object)) recorder.VisitMarkedObject(object);
+  }
+}
+
+
 // We scavange new space simultaneously with sweeping. This is done in two
 // passes.
 //
@@ -2784,6 +3320,16 @@ void MarkCompactCollector::MigrateObject(Address dst,
                                          Address src,
                                          int size,
                                          AllocationSpace dest) {
+  MigrateObject(dst, src, size, dest, &migration_slots_buffer_, NULL);
+}
+
+
+void MarkCompactCollector::MigrateObject(Address dst,
+                                         Address src,
+                                         int size,
+                                         AllocationSpace dest,
+                                         SlotsBuffer** migration_slots_buffer,
+                                         List<Address>* new_space_slots) {
   HEAP_PROFILE(heap(), ObjectMoveEvent(src, dst));
   if (dest == OLD_POINTER_SPACE || dest == LO_SPACE) {
     Address src_slot = src;
@@ -2796,10 +3342,14 @@ void MarkCompactCollector::MigrateObject(Address dst,
       Memory::Object_at(dst_slot) = value;
 
       if (heap_->InNewSpace(value)) {
-        heap_->store_buffer()->Mark(dst_slot);
+        if (new_space_slots == NULL) {
+          heap_->store_buffer()->Mark(dst_slot);
+        } else {
+          new_space_slots->Add(dst_slot);
+        }
       } else if (value->IsHeapObject() && IsOnEvacuationCandidate(value)) {
         SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                           &migration_slots_buffer_,
+                           migration_slots_buffer,
                            reinterpret_cast<Object**>(dst_slot),
                            SlotsBuffer::IGNORE_OVERFLOW);
       }
@@ -2814,35 +3364,79 @@ void MarkCompactCollector::MigrateObject(Address dst,
 
       if (Page::FromAddress(code_entry)->IsEvacuationCandidate()) {
         SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                           &migration_slots_buffer_,
+                           migration_slots_buffer,
                            SlotsBuffer::CODE_ENTRY_SLOT,
                            code_entry_slot,
                            SlotsBuffer::IGNORE_OVERFLOW);
       }
     }
+  } else if (dest == MAP_SPACE) {
+    // Only the pointer fields of a map are scanned, the others hold raw
+    // integers.  The map word of a map is the meta map, which never moves.
+    // Map space is swept after evacuation, so the copy is marked live.
+    heap()->MoveBlock(dst, src, size);
+    Marking::MarkBlack(Marking::MarkBitFrom(HeapObject::FromAddress(dst)));
+    MemoryChunk::IncrementLiveBytesFromGC(dst, size);
+    Address dst_slot = dst + Map::kPointerFieldsBeginOffset;
+    Address end_slot = dst + Map::kPointerFieldsEndOffset;
+    for (; dst_slot < end_slot; dst_slot += kPointerSize) {
+      Object* value = Memory::Object_at(dst_slot);
+      if (heap_->InNewSpace(value)) {
+        if (new_space_slots == NULL) {
+          heap_->store_buffer()->Mark(dst_slot);
+        } else {
+          new_space_slots->Add(dst_slot);
+        }
+      } else if (value->IsHeapObject() && IsOnEvacuationCandidate(value)) {
+        SlotsBuffer::AddTo(&slots_buffer_allocator_,
+                           migration_slots_buffer,
+                           reinterpret_cast<Object**>(dst_slot),
+                           SlotsBuffer::IGNORE_OVERFLOW);
+      }
+    }
   } else if (dest == CODE_SPACE) {
     PROFILE(heap()->isolate(), CodeMoveEvent(src, dst));
     heap()->MoveBlock(dst, src, size);
     SlotsBuffer::AddTo(&slots_buffer_allocator_,
-                       &migration_slots_buffer_,
+                       migration_slots_buffer,
                        SlotsBuffer::RELOCATED_CODE_OBJECT,
                        dst,
                        SlotsBuffer::IGNORE_OVERFLOW);
     Code::cast(HeapObject::FromAddress(dst))->Relocate(dst - src);
+    RecordMigratedMapSlot(dst, migration_slots_buffer);
   } else {
     ASSERT(dest == OLD_DATA_SPACE || dest == NEW_SPACE);
     heap()->MoveBlock(dst, src, size);
+    RecordMigratedMapSlot(dst, migration_slots_buffer);
   }
   Memory::Address_at(src) = dst;
 }
 
 
+void MarkCompactCollector::RecordMigratedMapSlot(
+    Address dst,
+    SlotsBuffer** migration_slots_buffer) {
+  Object* map = Memory::Object_at(dst);
+  if (IsOnEvacuationCandidate(map)) {
+    SlotsBuffer::AddTo(&slots_buffer_allocator_,
+                       migration_slots_buffer,
+                       reinterpret_cast<Object**>(dst),
+                       SlotsBuffer::IGNORE_OVERFLOW);
+  }
+}
+
+
 // Visitor for updating pointers from live objects in old spaces to new space.
 // It does not expect to encounter pointers to dead objects.
 class PointersUpdatingVisitor: public ObjectVisitor {
  public:
   explicit PointersUpdatingVisitor(Heap* heap) : heap_(heap) { }
 
+  // Used to update the live objects on a page that is not swept.
+  void VisitMarkedObject(HeapObject* object) {
+    object->Iterate(this);
+  }
+
   void VisitPointer(Object** p) {
     UpdatePointer(p);
   }
@@ -3049,8 +3643,8 @@ void MarkCompactCollector::EvacuateNewSpace() {
 }
 
 
-void MarkCompactCollector::EvacuateLiveObjectsFromPage(Page* p) {
-  AlwaysAllocateScope always_allocate;
+void MarkCompactCollector::EvacuateLiveObjectsFromPage(Page* p,
+                                                       EvacuationTask* task) {
   PagedSpace* space = static_cast<PagedSpace*>(p->owner());
   ASSERT(p->IsEvacuationCandidate() && !p->WasSwept());
   MarkBit::CellType* cells = p->markbits()->cells();
@@ -3085,19 +3679,33 @@ void MarkCompactCollector::EvacuateLiveObjectsFromPage(Page* p) {
 
       int size = object->Size();
 
-      MaybeObject* target = space->AllocateRaw(size);
-      if (target->IsFailure()) {
-        // OS refused to give us memory.
-        V8::FatalProcessOutOfMemory("Evacuation");
-        return;
-      }
+      if (task != NULL) {
+        HeapObject* target = task->Allocate(space, size);
+        if (target == NULL) {
+          V8::FatalProcessOutOfMemory("Evacuation");
+          return;
+        }
+        MigrateObject(target->address(),
+                      object_addr,
+                      size,
+                      space->identity(),
+                      task->migration_slots_buffer_address(),
+                      task->new_space_slots());
+      } else {
+        MaybeObject* target = space->AllocateRaw(size);
+        if (target->IsFailure()) {
+          // OS refused to give us memory.
+          V8::FatalProcessOutOfMemory("Evacuation");
+          return;
+        }
 
-      Object* target_object = target->ToObjectUnchecked();
+        Object* target_object = target->ToObjectUnchecked();
 
-      MigrateObject(HeapObject::cast(target_object)->address(),
-                    object_addr,
-                    size,
-                    space->identity());
+        MigrateObject(HeapObject::cast(target_object)->address(),
+                      object_addr,
+                      size,
+                      space->identity());
+      }
       ASSERT(object->map_word().IsForwardingAddress());
     }
 
@@ -3108,22 +3716,42 @@ void MarkCompactCollector::EvacuateLiveObjectsFromPage(Page* p) {
 }
 
 
+void MarkCompactCollector::UpdatePointersInToSpace(Address start,
+                                                   Address end) {
+  PointersUpdatingVisitor updating_visitor(heap());
+  Address current = start;
+  while (current < end) {
+    HeapObject* object = HeapObject::FromAddress(current);
+    Map* map = object->map();
+    int size = object->SizeFromMap(map);
+    object->IterateBody(map->instance_type(), size, &updating_visitor);
+    current += size;
+  }
+}
+
+
 void MarkCompactCollector::EvacuatePages() {
+  AlwaysAllocateScope always_allocate;
   int npages = evacuation_candidates_.length();
   for (int i = 0; i < npages; i++) {
     Page* p = evacuation_candidates_[i];
     ASSERT(p->IsEvacuationCandidate() ||
            p->IsFlagSet(Page::RESCAN_ON_EVACUATION));
-    if (p->IsEvacuationCandidate()) {
+    // Pages evacuated by parallel evacuation are already swept.
+    if (p->IsEvacuationCandidate() && !p->WasSwept()) {
       // During compaction we might have to request a new page.
       // Check that space still have room for that.
       if (static_cast<PagedSpace*>(p->owner())->CanExpand()) {
-        EvacuateLiveObjectsFromPage(p);
+        // Pointers to new space are recorded for the copies of the maps.
+        // The store buffer cannot scan a page of evacuated maps.
+        if (p->owner()->identity() == MAP_SPACE) p->set_scan_on_scavenge(false);
+        EvacuateLiveObjectsFromPage(p, NULL);
       } else {
         // Without room for expansion evacuation is not guaranteed to succeed.
         // Pessimistically abandon unevacuated pages.
         for (int j = i; j < npages; j++) {
           Page* page = evacuation_candidates_[j];
+          if (page->IsEvacuationCandidate() && page->WasSwept()) continue;
           slots_buffer_allocator_.DeallocateChain(page->slots_buffer_address());
           page->ClearEvacuationCandidate();
           page->SetFlag(Page::RESCAN_ON_EVACUATION);
@@ -3205,9 +3833,9 @@ enum SkipListRebuildingMode {
 // Sweep a space precisely.  After this has been done the space can
 // be iterated precisely, hitting only the live objects.  Code space
 // is always swept precisely because we want to be able to iterate
-// over it.  Map space is swept precisely, because it is not compacted.
-// Slots in live objects pointing into evacuation candidates are updated
-// if requested.
+// over it.  Map space is swept precisely, because ClearNonLiveTransitions
+// iterates over it.  Slots in live objects, including their map words,
+// pointing into evacuation candidates are updated if requested.
 template<SweepingMode sweeping_mode, SkipListRebuildingMode skip_list_mode>
 static void SweepPrecisely(PagedSpace* space,
                            Page* p,
@@ -3260,6 +3888,8 @@ static void SweepPrecisely(PagedSpace* space,
       Map* map = live_object->map();
       int size = live_object->SizeFromMap(map);
       if (sweeping_mode == SWEEP_AND_VISIT_LIVE_OBJECTS) {
+        v->VisitPointer(
+            HeapObject::RawField(live_object, HeapObject::kMapOffset));
         live_object->IterateBody(map->instance_type(), size, v);
       }
       if ((skip_list_mode == REBUILD_SKIP_LIST) && skip_list != NULL) {
@@ -3404,6 +4034,11 @@ void MarkCompactCollector::ProcessInvalidatedCode(ObjectVisitor* visitor) {
 void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
   Heap::RelocationLock relocation_lock(heap());
 
+  bool evacuate_in_parallel = ParallelEvacuator::CanEvacuateInParallel(heap());
+  if (evacuate_in_parallel && parallel_evacuator_ == NULL) {
+    parallel_evacuator_ = new ParallelEvacuator(this);
+  }
+
   bool code_slots_filtering_required;
   { GCTracer::Scope gc_scope(tracer_, GCTracer::Scope::MC_SWEEP_NEWSPACE);
     code_slots_filtering_required = MarkInvalidatedCode();
@@ -3413,13 +4048,19 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
 
 
   { GCTracer::Scope gc_scope(tracer_, GCTracer::Scope::MC_EVACUATE_PAGES);
+    // Candidates in code and map space are always evacuated by the main
+    // thread, map space last.
+    if (evacuate_in_parallel) parallel_evacuator_->EvacuatePages();
     EvacuatePages();
   }
 
   // Second pass: find pointers to new space and update them.
   PointersUpdatingVisitor updating_visitor(heap());
 
-  { GCTracer::Scope gc_scope(tracer_,
+  // Parallel evacuation updates the pointers in to space together with the
+  // slots recorded on evacuation candidates below.
+  if (!evacuate_in_parallel) {
+    GCTracer::Scope gc_scope(tracer_,
                              GCTracer::Scope::MC_UPDATE_NEW_TO_NEW_POINTERS);
     // Update pointers in to space.
     SemiSpaceIterator to_it(heap()->new_space()->bottom(),
@@ -3479,15 +4120,20 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
   int npages = evacuation_candidates_.length();
   { GCTracer::Scope gc_scope(
       tracer_, GCTracer::Scope::MC_UPDATE_POINTERS_BETWEEN_EVACUATED);
+    if (evacuate_in_parallel) {
+      parallel_evacuator_->UpdatePointers(code_slots_filtering_required);
+    }
     for (int i = 0; i < npages; i++) {
       Page* p = evacuation_candidates_[i];
       ASSERT(p->IsEvacuationCandidate() ||
              p->IsFlagSet(Page::RESCAN_ON_EVACUATION));
 
       if (p->IsEvacuationCandidate()) {
-        SlotsBuffer::UpdateSlotsRecordedIn(heap_,
-                                           p->slots_buffer(),
-                                           code_slots_filtering_required);
+        if (!evacuate_in_parallel) {
+          SlotsBuffer::UpdateSlotsRecordedIn(heap_,
+                                             p->slots_buffer(),
+                                             code_slots_filtering_required);
+        }
         if (FLAG_trace_fragmentation) {
           PrintF("  page %p slots buffer: %d\n",
                  reinterpret_cast<void*>(p),
@@ -3519,6 +4165,11 @@ void MarkCompactCollector::EvacuateNewSpaceAndCandidates() {
             SweepPrecisely<SWEEP_AND_VISIT_LIVE_OBJECTS, REBUILD_SKIP_LIST>(
                 space, p, &updating_visitor);
             break;
+          case MAP_SPACE:
+            // Map space is swept after evacuation, so the page keeps its
+            // mark bits and only the pointers in its live maps are updated.
+            IterateMarkedObjectsOnPage(p, &updating_visitor);
+            break;
           default:
             UNREACHABLE();
             break;
@@ -3865,6 +4516,19 @@ static inline Address StartOfLiveObject(Address block_address, uint32_t cell) {
 }
 
 
+template<MarkCompactCollector::SweepingParallelism mode>
+static intptr_t Free(PagedSpace* space,
+                     FreeList* free_list,
+                     Address start,
+                     int size) {
+  if (mode == MarkCompactCollector::SWEEP_SEQUENTIALLY) {
+    return space->Free(start, size);
+  } else {
+    return size - free_list->Free(start, size);
+  }
+}
+
+
 // Sweeps a space conservatively.  After this has been done the larger free
 // spaces have been put on the free list and the smaller ones have been
 // ignored and left untouched.  A free space is always either ignored or put
@@ -3872,10 +4536,23 @@ static inline Address StartOfLiveObject(Address block_address, uint32_t cell) {
 // because it means that any FreeSpace maps left actually describe a region of
 // memory that can be ignored when scanning.  Dead objects other than free
 // spaces will not contain the free space map.
-intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
-  ASSERT(!p->IsEvacuationCandidate() && !p->WasSwept());
+//
+// When sweeping in parallel the calling thread has claimed the page and the
+// free memory goes to the given free list instead of the space's one.  The
+// page flags and live bytes are left alone in that case and the space's
+// accounting is done by whoever merges the free list into the space.
+template<MarkCompactCollector::SweepingParallelism mode>
+static intptr_t SweepConservatively(PagedSpace* space,
+                                    FreeList* free_list,
+                                    Page* p) {
+  ASSERT(!p->IsEvacuationCandidate());
+  ASSERT(mode == MarkCompactCollector::SWEEP_SEQUENTIALLY ?
+         !p->WasSwept() :
+         p->parallel_sweeping() == MemoryChunk::SWEEPING_IN_PROGRESS);
   MarkBit::CellType* cells = p->markbits()->cells();
-  p->MarkSweptConservatively();
+  if (mode == MarkCompactCollector::SWEEP_SEQUENTIALLY) {
+    p->MarkSweptConservatively();
+  }
 
   int last_cell_index =
       Bitmap::IndexToCell(
@@ -3900,9 +4577,10 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
   }
   size_t size = block_address - p->area_start();
   if (cell_index == last_cell_index) {
-    freed_bytes += static_cast<int>(space->Free(p->area_start(),
-                                                static_cast<int>(size)));
-    ASSERT_EQ(0, p->LiveBytes());
+    freed_bytes += Free<mode>(space, free_list, p->area_start(),
+                              static_cast<int>(size));
+    ASSERT(mode == MarkCompactCollector::SWEEP_IN_PARALLEL ||
+           p->LiveBytes() == 0);
     return freed_bytes;
   }
   // Grow the size of the start-of-page free space a little to get up to the
@@ -3910,8 +4588,8 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
   Address free_end = StartOfLiveObject(block_address, cells[cell_index]);
   // Free the first free space.
   size = free_end - p->area_start();
-  freed_bytes += space->Free(p->area_start(),
-                             static_cast<int>(size));
+  freed_bytes += Free<mode>(space, free_list, p->area_start(),
+                            static_cast<int>(size));
   // The start of the current free area is represented in undigested form by
   // the address of the last 32-word section that contained a live object and
   // the marking bitmap for that cell, which describes where the live object
@@ -3940,8 +4618,8 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
           // so now we need to find the start of the first live object at the
           // end of the free space.
           free_end = StartOfLiveObject(block_address, cell);
-          freed_bytes += space->Free(free_start,
-                                     static_cast<int>(free_end - free_start));
+          freed_bytes += Free<mode>(space, free_list, free_start,
+                                    static_cast<int>(free_end - free_start));
         }
       }
       // Update our undigested record of where the current free area started.
@@ -3955,18 +4633,33 @@ intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
   // Handle the free space at the end of the page.
   if (block_address - free_start > 32 * kPointerSize) {
     free_start = DigestFreeStart(free_start, free_start_cell);
-    freed_bytes += space->Free(free_start,
-                               static_cast<int>(block_address - free_start));
+    freed_bytes += Free<mode>(space, free_list, free_start,
+                              static_cast<int>(block_address - free_start));
   }
 
-  p->ResetLiveBytes();
+  if (mode == MarkCompactCollector::SWEEP_SEQUENTIALLY) {
+    p->ResetLiveBytes();
+  }
   return freed_bytes;
 }
 
 
+intptr_t MarkCompactCollector::SweepConservatively(PagedSpace* space, Page* p) {
+  return v8::internal::SweepConservatively<SWEEP_SEQUENTIALLY>(space, NULL, p);
+}
+
+
+intptr_t MarkCompactCollector::SweepConservativelyInParallel(
+    PagedSpace* space, FreeList* free_list, Page* p) {
+  return v8::internal::SweepConservatively<SWEEP_IN_PARALLEL>(
+      space, free_list, p);
+}
+
+
 void MarkCompactCollector::SweepSpace(PagedSpace* space, SweeperType sweeper) {
   space->set_was_swept_conservatively(sweeper == CONSERVATIVE ||
-                                      sweeper == LAZY_CONSERVATIVE);
+                                      sweeper == LAZY_CONSERVATIVE ||
+                                      sweeper == CONCURRENT_CONSERVATIVE);
 
   space->ClearStats();
 
@@ -4048,6 +4741,20 @@ void MarkCompactCollector::SweepSpace(PagedSpace* space, SweeperType sweeper) {
         }
         break;
       }
+      case CONCURRENT_CONSERVATIVE: {
+        if (FLAG_gc_verbose) {
+          PrintF("Sweeping 0x%" V8PRIxPTR " concurrently.\n",
+                 reinterpret_cast<intptr_t>(p));
+        }
+        // The page flags and live bytes belong to the main thread, so they
+        // are updated before the page is handed over to the sweeper threads.
+        space->IncreaseUnsweptFreeBytes(p);
+        p->MarkSweptConservatively();
+        p->ResetLiveBytes();
+        p->set_parallel_sweeping(MemoryChunk::SWEEPING_PENDING);
+        space->set_concurrent_sweeping(true);
+        break;
+      }
       case PRECISE: {
         if (FLAG_gc_verbose) {
           PrintF("Sweeping 0x%" V8PRIxPTR " precisely.\n",
@@ -4085,6 +4792,7 @@ void MarkCompactCollector::SweepSpaces() {
 #endif
   SweeperType how_to_sweep =
       FLAG_lazy_sweeping ? LAZY_CONSERVATIVE : CONSERVATIVE;
+  if (FLAG_concurrent_sweeping) how_to_sweep = CONCURRENT_CONSERVATIVE;
   if (FLAG_expose_gc) how_to_sweep = CONSERVATIVE;
   if (sweep_precisely_) how_to_sweep = PRECISE;
   // Noncompacting collections simply sweep the spaces to clear the mark
@@ -4104,11 +4812,160 @@ void MarkCompactCollector::SweepSpaces() {
 
   // ClearNonLiveTransitions depends on precise sweeping of map space to
   // detect whether unmarked map became dead in this collection or in one
-  // of the previous ones.
+  // of the previous ones.  Evacuated maps may have been allocated in map
+  // space, so its linear allocation area and free list are dropped again;
+  // the sweep rediscovers the free memory.
+  heap()->map_space()->PrepareForMarkCompact();
   SweepSpace(heap()->map_space(), PRECISE);
 
   // Deallocate unmarked objects and clear marked bits for marked objects.
   heap_->lo_space()->FreeUnmarkedObjects();
+
+  // The sweeper threads are only started once evacuation has updated all
+  // slots, as those may lie in dead objects on the pages being swept.
+  if (heap()->old_pointer_space()->concurrent_sweeping() ||
+      heap()->old_data_space()->concurrent_sweeping()) {
+    StartSweeperThreads();
+  }
+}
+
+
+void MarkCompactCollector::TearDown() {
+  if (IsConcurrentSweepingInProgress()) {
+    WaitUntilSweepingCompleted();
+  }
+  for (int i = 0; i < number_of_sweeper_threads_; i++) {
+    sweeper_threads_[i]->Stop();
+    delete sweeper_threads_[i];
+    sweeper_threads_[i] = NULL;
+    delete sweepers_[i];
+    sweepers_[i] = NULL;
+  }
+  number_of_sweeper_threads_ = 0;
+  delete parallel_marker_;
+  parallel_marker_ = NULL;
+  delete parallel_evacuator_;
+  parallel_evacuator_ = NULL;
+}
+
+
+void MarkCompactCollector::StartSweeperThreads() {
+  ASSERT(!IsConcurrentSweepingInProgress());
+  if (number_of_sweeper_threads_ == 0) {
+    number_of_sweeper_threads_ =
+        Min(Max(FLAG_sweeper_threads, 1), kMaxSweeperThreads);
+    for (int i = 0; i < number_of_sweeper_threads_; i++) {
+      sweepers_[i] = new Sweeper(heap());
+      sweeper_threads_[i] = new GCHelperThread(
+          heap()->isolate(), "SweeperThread", sweepers_[i], i);
+      sweeper_threads_[i]->Start();
+    }
+  }
+  sweeping_pending_ = true;
+  Release_Store(&running_sweeper_threads_, number_of_sweeper_threads_);
+  for (int i = 0; i < number_of_sweeper_threads_; i++) {
+    sweeper_threads_[i]->StartTask();
+  }
+}
+
+
+bool MarkCompactCollector::IsSweepingCompleted() {
+  ASSERT(IsConcurrentSweepingInProgress());
+  return Acquire_Load(&running_sweeper_threads_) == 0;
+}
+
+
+void MarkCompactCollector::WaitUntilSweepingCompleted() {
+  ASSERT(IsConcurrentSweepingInProgress());
+  for (int i = 0; i < number_of_sweeper_threads_; i++) {
+    sweeper_threads_[i]->WaitForTask();
+  }
+  sweeping_pending_ = false;
+  PagedSpace* spaces[] = { heap()->old_pointer_space(),
+                           heap()->old_data_space() };
+  for (size_t i = 0; i < ARRAY_SIZE(spaces); i++) {
+    StealMemoryFromSweeperThreads(spaces[i]);
+    spaces[i]->set_concurrent_sweeping(false);
+    spaces[i]->ResetUnsweptFreeBytes();
+#ifdef DEBUG
+    PageIterator it(spaces[i]);
+    while (it.has_next()) {
+      ASSERT(it.next()->parallel_sweeping() == MemoryChunk::SWEEPING_DONE);
+    }
+#endif
+  }
+}
+
+
+intptr_t MarkCompactCollector::StealMemoryFromSweeperThreads(
+    PagedSpace* space) {
+  intptr_t freed_bytes = 0;
+  for (int i = 0; i < number_of_sweeper_threads_; i++) {
+    freed_bytes += sweepers_[i]->StealMemory(space);
+  }
+  space->RemoveFromAccountingStats(freed_bytes);
+  space->DecrementUnsweptFreeBytes(freed_bytes);
+  return freed_bytes;
+}
+
+
+intptr_t MarkCompactCollector::SweepPendingPage(PagedSpace* space, Page* p) {
+  if (FLAG_gc_verbose) {
+    PrintF("Sweeping 0x%" V8PRIxPTR " on the main thread.\n",
+           reinterpret_cast<intptr_t>(p));
+  }
+  intptr_t freed_bytes =
+      SweepConservativelyInParallel(space, space->free_list(), p);
+  space->RemoveFromAccountingStats(freed_bytes);
+  space->DecrementUnsweptFreeBytes(freed_bytes);
+  p->set_parallel_sweeping(MemoryChunk::SWEEPING_DONE);
+  return freed_bytes;
+}
+
+
+bool MarkCompactCollector::SweepNextPendingPage(PagedSpace* space) {
+  PageIterator it(space);
+  while (it.has_next()) {
+    Page* p = it.next();
+    if (p->TryParallelSweeping()) {
+      SweepPendingPage(space, p);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+bool MarkCompactCollector::AdvanceConcurrentSweeping(intptr_t bytes_to_sweep) {
+  ASSERT(IsConcurrentSweepingInProgress());
+  PagedSpace* spaces[] = { heap()->old_pointer_space(),
+                           heap()->old_data_space() };
+  intptr_t freed_bytes = 0;
+  for (size_t i = 0; i < ARRAY_SIZE(spaces); i++) {
+    PageIterator it(spaces[i]);
+    while (it.has_next()) {
+      Page* p = it.next();
+      if (!p->TryParallelSweeping()) continue;
+      freed_bytes += SweepPendingPage(spaces[i], p);
+      if (freed_bytes >= bytes_to_sweep) return false;
+    }
+  }
+  // The sweeper threads are only finishing the pages they have claimed.
+  WaitUntilSweepingCompleted();
+  return true;
+}
+
+
+void MarkCompactCollector::SweepOrWaitUntilSwept(MemoryChunk* chunk) {
+  if (chunk->parallel_sweeping() == MemoryChunk::SWEEPING_DONE) return;
+  Page* p = static_cast<Page*>(chunk);
+  if (p->TryParallelSweeping()) {
+    SweepPendingPage(static_cast<PagedSpace*>(p->owner()), p);
+    return;
+  }
+  while (p->parallel_sweeping() != MemoryChunk::SWEEPING_DONE) {
+    Thread::YieldCPU();
+  }
 }
 
 
@@ -4264,6 +5121,33 @@ void SlotsBuffer::UpdateSlotsWithFilter(Heap* heap) {
 }
 
 
+void SlotsBuffer::UpdateUntypedSlots(Heap* heap,
+                                     bool code_slots_filtering_required,
+                                     SlotsBufferAllocator* allocator,
+                                     SlotsBuffer** typed_slots_buffer) {
+  for (int slot_idx = 0; slot_idx < idx_; ++slot_idx) {
+    ObjectSlot slot = slots_[slot_idx];
+    if (!IsTypedSlot(slot)) {
+      if (!code_slots_filtering_required ||
+          !IsOnInvalidatedCodeObject(reinterpret_cast<Address>(slot))) {
+        PointersUpdatingVisitor::UpdateSlot(heap, slot);
+      }
+    } else {
+      ++slot_idx;
+      ASSERT(slot_idx < idx_);
+      Address pc = reinterpret_cast<Address>(slots_[slot_idx]);
+      if (!code_slots_filtering_required || !IsOnInvalidatedCodeObject(pc)) {
+        AddTo(allocator,
+              typed_slots_buffer,
+              DecodeSlotType(slot),
+              pc,
+              IGNORE_OVERFLOW);
+      }
+    }
+  }
+}
+
+
 SlotsBuffer* SlotsBufferAllocator::AllocateBuffer(SlotsBuffer* next_buffer) {
   return new SlotsBuffer(next_buffer);
 }
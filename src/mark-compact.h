@@ -41,10 +41,15 @@ typedef bool (*IsAliveFunction)(HeapObject* obj, int* size, int* offset);
 
 // Forward declarations.
 class CodeFlusher;
+class EvacuationTask;
+class GCHelperThread;
 class GCTracer;
 class MarkCompactCollector;
 class MarkingVisitor;
+class ParallelEvacuator;
+class ParallelMarker;
 class RootMarkingVisitor;
+class Sweeper;
 
 
 class Marking {
@@ -105,6 +110,40 @@ class Marking {
     BlackToGrey(MarkBitFrom(obj));
   }
 
+  // Atomic transitions used by parallel marking.  White and black differ
+  // only in the first mark bit, so an object is claimed by setting that bit
+  // with a single compare and swap.
+  static inline bool WhiteToBlackAtomically(MarkBit markbit) {
+    return markbit.SetAtomically();
+  }
+
+  static inline void BlackToGreyAtomically(MarkBit markbit) {
+    markbit.Next().SetAtomically();
+  }
+
+  // Atomic transitions used while the concurrent marker is running.  An
+  // object is claimed by setting its first mark bit, so only one thread
+  // succeeds in making it grey.
+  static inline bool WhiteToGreyAtomically(MarkBit markbit) {
+    if (!markbit.SetAtomically()) return false;
+    markbit.Next().SetAtomically();
+    return true;
+  }
+
+  static inline void GreyToBlackAtomically(MarkBit markbit) {
+    markbit.Next().ClearAtomically();
+  }
+
+  static inline void MarkBlackAtomically(MarkBit markbit) {
+    markbit.SetAtomically();
+    markbit.Next().ClearAtomically();
+  }
+
+  static inline void AnyToGreyAtomically(MarkBit markbit) {
+    markbit.SetAtomically();
+    markbit.Next().SetAtomically();
+  }
+
   static inline void AnyToGrey(MarkBit markbit) {
     markbit.Set();
     markbit.Next().Set();
@@ -308,6 +347,14 @@ class SlotsBuffer {
 
   void UpdateSlotsWithFilter(Heap* heap);
 
+  // Updates the untyped slots and moves the typed slots, which patch code,
+  // to |typed_slots_buffer|.  Used by parallel evacuation, where the typed
+  // slots of a code object may be found in the buffers of several tasks.
+  void UpdateUntypedSlots(Heap* heap,
+                          bool code_slots_filtering_required,
+                          SlotsBufferAllocator* allocator,
+                          SlotsBuffer** typed_slots_buffer);
+
   SlotsBuffer* next() { return next_; }
 
   static int SizeOfChain(SlotsBuffer* buffer) {
@@ -337,6 +384,20 @@ class SlotsBuffer {
     }
   }
 
+  static void UpdateUntypedSlotsRecordedIn(Heap* heap,
+                                           SlotsBuffer* buffer,
+                                           bool code_slots_filtering_required,
+                                           SlotsBufferAllocator* allocator,
+                                           SlotsBuffer** typed_slots_buffer) {
+    while (buffer != NULL) {
+      buffer->UpdateUntypedSlots(heap,
+                                 code_slots_filtering_required,
+                                 allocator,
+                                 typed_slots_buffer);
+      buffer = buffer->next();
+    }
+  }
+
   enum AdditionMode {
     FAIL_ON_OVERFLOW,
     IGNORE_OVERFLOW
@@ -497,14 +558,21 @@ class MarkCompactCollector {
 
   CodeFlusher* code_flusher() { return code_flusher_; }
   inline bool is_code_flushing_enabled() const { return code_flusher_ != NULL; }
+  bool flush_all_code() const { return flush_all_code_; }
   void EnableCodeFlushing(bool enable);
 
   enum SweeperType {
     CONSERVATIVE,
     LAZY_CONSERVATIVE,
+    CONCURRENT_CONSERVATIVE,
     PRECISE
   };
 
+  enum SweepingParallelism {
+    SWEEP_SEQUENTIALLY,
+    SWEEP_IN_PARALLEL
+  };
+
 #ifdef DEBUG
   void VerifyMarkbitsAreClean();
   static void VerifyMarkbitsAreClean(PagedSpace* space);
@@ -515,6 +583,53 @@ class MarkCompactCollector {
   // Return a number of reclaimed bytes.
   static intptr_t SweepConservatively(PagedSpace* space, Page* p);
 
+  // Sweep a single page that was claimed by the calling thread and put the
+  // free memory on the given free list.  Used by the sweeper threads.
+  // Return a number of reclaimed bytes.
+  static intptr_t SweepConservativelyInParallel(PagedSpace* space,
+                                                FreeList* free_list,
+                                                Page* p);
+
+  static const int kMaxSweeperThreads = 16;
+
+  // Stops the sweeper threads.  Called when the heap is torn down.
+  void TearDown();
+
+  // Hands the pages that were left by the last mark-compact collection over
+  // to the sweeper threads.
+  void StartSweeperThreads();
+
+  // True from the end of a mark-compact collection that used concurrent
+  // sweeping until the main thread has picked up the sweeper threads'
+  // results with WaitUntilSweepingCompleted.
+  bool IsConcurrentSweepingInProgress() { return sweeping_pending_; }
+
+  // True if the sweeper threads are done.  Does not block.
+  bool IsSweepingCompleted();
+
+  // Blocks until the sweeper threads are done and merges their free lists
+  // into the spaces.
+  void WaitUntilSweepingCompleted();
+
+  // Merges the memory that the sweeper threads have freed so far in the
+  // given space into the space's free list.  Returns the number of bytes.
+  intptr_t StealMemoryFromSweeperThreads(PagedSpace* space);
+
+  // Claims and sweeps one of the pages in the given space that are left to
+  // the sweeper threads on the calling thread.  Returns false if there is no
+  // such page left.
+  bool SweepNextPendingPage(PagedSpace* space);
+
+  // Sweeps pages that are left to the sweeper threads on the main thread
+  // until about the given number of bytes are freed.  Waits for the sweeper
+  // threads once no page is left.  Returns true if concurrent sweeping has
+  // been completed.
+  bool AdvanceConcurrentSweeping(intptr_t bytes_to_sweep);
+
+  // Makes sure the given chunk is not being swept concurrently, sweeping it
+  // on the calling thread if no sweeper thread has claimed it yet.
+  void SweepOrWaitUntilSwept(MemoryChunk* chunk);
+
   INLINE(static bool ShouldSkipEvacuationSlotRecording(Object** anchor)) {
     return Page::FromAddress(reinterpret_cast<Address>(anchor))->
         ShouldSkipEvacuationSlotRecording();
@@ -561,6 +676,16 @@ class MarkCompactCollector {
                      int size,
                      AllocationSpace to_old_space);
 
+  // Used by parallel evacuation.  Slots of the copy that point to evacuation
+  // candidates are recorded in |migration_slots_buffer|, slots that point to
+  // new space are added to |new_space_slots| instead of the store buffer.
+  void MigrateObject(Address dst,
+                     Address src,
+                     int size,
+                     AllocationSpace to_old_space,
+                     SlotsBuffer** migration_slots_buffer,
+                     List<Address>* new_space_slots);
+
   bool TryPromoteObject(HeapObject* object, int object_size);
 
   inline Object* encountered_weak_maps() { return encountered_weak_maps_; }
@@ -574,6 +699,16 @@ class MarkCompactCollector {
 
   bool is_compacting() const { return compacting_; }
 
+  // Called on the main thread by the marking visitors, including the
+  // incremental one, for a sliced string.  Returns true if the slice was
+  // recorded as a rescue candidate, in which case its parent must not be
+  // marked through it.
+  bool RecordSliceCandidate(SlicedString* slice);
+
+  // Candidates recorded by incremental marking survive scavenges.
+  void UpdateSliceCandidatesAfterScavenge();
+  void ClearSliceCandidates() { slice_candidates_.Rewind(0); }
+
  private:
   MarkCompactCollector();
   ~MarkCompactCollector();
@@ -606,6 +741,13 @@ class MarkCompactCollector {
 
   bool abort_incremental_marking_;
 
+  // Evacuate all pages that are at least half free.
+  bool force_compaction_;
+
+  // Flush the code of all functions and regexps that are not running,
+  // however recently they were used.
+  bool flush_all_code_;
+
   // True if we are collecting slots to perform evacuation from evacuation
   // candidates.
   bool compacting_;
@@ -622,6 +764,27 @@ class MarkCompactCollector {
 
   SlotsBuffer* migration_slots_buffer_;
 
+  Sweeper* sweepers_[kMaxSweeperThreads];
+  GCHelperThread* sweeper_threads_[kMaxSweeperThreads];
+  int number_of_sweeper_threads_;
+
+  // See IsConcurrentSweepingInProgress.
+  bool sweeping_pending_;
+
+  // The number of sweeper threads that are still sweeping.
+  volatile AtomicWord running_sweeper_threads_;
+
+  // Sweeps a page claimed by the main thread into the space's free list.
+  // Returns the number of reclaimed bytes.
+  intptr_t SweepPendingPage(PagedSpace* space, Page* p);
+
+  // Created when the marking deque is emptied in parallel for the first
+  // time.
+  ParallelMarker* parallel_marker_;
+
+  // Created by the first collection that evacuates in parallel.
+  ParallelEvacuator* parallel_evacuator_;
+
   // Finishes GC, performs heap verification if enabled.
   void Finish();
 
@@ -706,6 +869,10 @@ class MarkCompactCollector {
   // overflow flag will be set.
   void EmptyMarkingDeque();
 
+  // Marks the map of a black object taken from the marking stack and
+  // visits the object's body.
+  void VisitMarkedObject(HeapObject* object);
+
   // Refill the marking stack with overflowed objects from the heap.  This
   // function either leaves the marking stack full or clears the overflow
   // flag on the marking stack.
@@ -741,6 +908,40 @@ class MarkCompactCollector {
   // The linked list of all encountered weak maps is destroyed.
   void ClearWeakMaps();
 
+  // Makes all pointers to marked sequential strings in old data space
+  // point to one copy per string contents and unmarks the other copies.
+  // Only strings of at least --string-deduplication-min-length characters
+  // that are not symbols are considered.  Strings referenced from strong
+  // roots may still be built by runtime code and are left alone.
+  void DeduplicateStrings();
+
+  // Records the slots referring to maps on evacuation candidates that
+  // marking leaves out: the map words of live objects and the transitions
+  // and back pointers of live maps.  Only needed when map space is
+  // compacted.
+  void RecordMapSlots();
+
+  // Records the map word of an object migrated to |dst| whose other slots
+  // are not scanned by MigrateObject.
+  void RecordMigratedMapSlot(Address dst,
+                             SlotsBuffer** migration_slots_buffer);
+
+  // A sliced string whose parent is a large object at least this many times
+  // longer than the slice does not keep the parent alive by itself.
+  static const int kSliceRescueRatio = 16;
+
+  // Gives the recorded slices whose parents were not marked otherwise flat
+  // copies of their characters so that the parents can be freed.  Parents
+  // that cannot be dropped are marked instead.  Runs once marking is
+  // complete, so no weak handle refers to a parent that is freed.
+  void RescueSlicedStrings();
+
+  // Turns |slice| into a flat cons string whose first part is a marked copy
+  // of its characters in new space.  The sliced string map is gone
+  // afterwards, which marks the slice as handled.  Returns false if
+  // allocation failed.
+  bool CopySliceOutOfParent(SlicedString* slice);
+
   // -----------------------------------------------------------------------
   // Phase 2: Sweeping to clear mark bits and free non-live objects for
   // a non-compacting collection.
@@ -759,7 +960,13 @@ class MarkCompactCollector {
 
   void EvacuateNewSpace();
 
-  void EvacuateLiveObjectsFromPage(Page* p);
+  // Evacuates the live objects of an evacuation candidate.  The objects
+  // are allocated in the linear allocation areas of |task| if it is not
+  // NULL.
+  void EvacuateLiveObjectsFromPage(Page* p, EvacuationTask* task);
+
+  // Updates the pointers in the to-space objects in [start, end).
+  void UpdatePointersInToSpace(Address start, Address end);
 
   void EvacuatePages();
 
@@ -781,10 +988,19 @@ class MarkCompactCollector {
   Object* encountered_weak_maps_;
   Marker<MarkCompactCollector> marker_;
 
+  // Slices recorded by RecordSliceCandidate since marking started.  A slice
+  // that was visited more than once is recorded more than once.
+  List<SlicedString*> slice_candidates_;
+
   List<Page*> evacuation_candidates_;
   List<Code*> invalidated_code_;
 
   friend class Heap;
+  friend class EvacuationTask;
+  friend class MarkingTask;
+  friend class ParallelEvacuator;
+  friend class ParallelMarker;
+  friend class Sweeper;
 };
 
 
@@ -445,7 +445,7 @@ void LCodeGen::WriteTranslation(LEnvironment* environment,
   if (environment == NULL) return;
 
   // The translation includes one command per value in the environment.
-  int translation_size = environment->values()->length();
+  int translation_size = environment->translation_size();
   // The output frame height does not include the parameters.
   int height = translation_size - environment->parameter_count();
 
@@ -489,11 +489,38 @@ void LCodeGen::WriteTranslation(LEnvironment* environment,
       }
     }
 
+    LCapturedObject* object =
+        value == NULL ? environment->CapturedObjectAt(i) : NULL;
+    if (object != NULL) {
+      AddCapturedObjectToTranslation(environment, translation, object);
+      continue;
+    }
+
     AddToTranslation(translation, value, environment->HasTaggedValueAt(i));
   }
 }
 
 
+void LCodeGen::AddCapturedObjectToTranslation(LEnvironment* environment,
+                                              Translation* translation,
+                                              LCapturedObject* object) {
+  // Objects in several slots or frames are described once.
+  if (translation->HasCapturedObject(object->capture_id())) {
+    translation->DuplicateObject(object->capture_id());
+    return;
+  }
+  translation->BeginCapturedObject(object->capture_id(),
+                                   DefineDeoptimizationLiteral(object->map()),
+                                   object->field_count());
+  for (int i = 0; i < object->field_count(); ++i) {
+    int index = object->first_field() + i;
+    AddToTranslation(translation,
+                     environment->values()->at(index),
+                     environment->HasTaggedValueAt(index));
+  }
+}
+
+
 void LCodeGen::AddToTranslation(Translation* translation,
                                 LOperand* op,
                                 bool is_tagged) {
@@ -285,6 +285,14 @@ void JSObject::JSObjectVerify() {
     CHECK_EQ(map()->unused_property_fields(),
              (map()->inobject_properties() + properties()->length() -
               map()->NextFreePropertyIndex()));
+    if (map()->has_double_fields()) {
+      DescriptorArray* descriptors = map()->instance_descriptors();
+      for (int i = 0; i < descriptors->number_of_descriptors(); i++) {
+        if (!descriptors->GetDetails(i).IsDoubleField()) continue;
+        CHECK(RawFastPropertyAt(descriptors->GetFieldIndex(i))->
+              IsHeapNumber());
+      }
+    }
   }
   ASSERT_EQ((map()->has_fast_smi_or_object_elements() ||
              (elements() == GetHeap()->empty_fixed_array())),
@@ -348,6 +356,19 @@ void AliasedArgumentsEntry::AliasedArgumentsEntryVerify() {
 }
 
 
+void AllocationSite::AllocationSiteVerify() {
+  VerifySmiField(kMementoCreateCountOffset);
+  VerifySmiField(kMementoFoundCountOffset);
+  VerifySmiField(kPretenureDecisionOffset);
+}
+
+
+void AllocationMemento::AllocationMementoVerify() {
+  VerifyHeapPointer(allocation_site());
+  CHECK(allocation_site()->IsAllocationSite());
+}
+
+
 void FixedArray::FixedArrayVerify() {
   for (int i = 0; i < length(); i++) {
     Object* e = get(i);
@@ -68,6 +68,12 @@ PropertyDetails PropertyDetails::AsDeleted() {
 }
 
 
+PropertyDetails PropertyDetails::AsDoubleField() {
+  Smi* smi = Smi::FromInt(value_ | DoubleField::encode(1));
+  return PropertyDetails(smi);
+}
+
+
 #define TYPE_CHECKER(type, instancetype)                                \
   bool Object::Is##type() {                                             \
   return Object::IsHeapObject() &&                                      \
@@ -1525,6 +1531,19 @@ void JSObject::SetInternalField(int index, Smi* value) {
 // is needed to correctly distinguish between properties stored in-object and
 // properties stored in the properties array.
 Object* JSObject::FastPropertyAt(int index) {
+  Object* value = RawFastPropertyAt(index);
+  if (map()->has_double_fields() && value->IsHeapObject()) {
+    HeapObject* box = HeapObject::cast(value);
+    Heap* heap = GetHeap();
+    if (box->map() == heap->mutable_heap_number_map()) {
+      box->set_map_no_write_barrier(heap->heap_number_map());
+    }
+  }
+  return value;
+}
+
+
+Object* JSObject::RawFastPropertyAt(int index) {
   // Adjust for the number of properties stored in the object.
   index -= map()->inobject_properties();
   if (index < 0) {
@@ -3012,6 +3031,16 @@ bool Map::is_shared() {
 }
 
 
+void Map::set_has_double_fields(bool value) {
+  set_bit_field3(HasDoubleFields::update(bit_field3(), value));
+}
+
+
+bool Map::has_double_fields() {
+  return HasDoubleFields::decode(bit_field3());
+}
+
+
 JSFunction* Map::unchecked_constructor() {
   return reinterpret_cast<JSFunction*>(READ_FIELD(this, kConstructorOffset));
 }
@@ -4450,6 +4479,13 @@ int JSFunction::NumberOfLiterals() {
 }
 
 
+bool JSFunction::HasAllocationSiteLiteral() {
+  return AllocationSite::CanTrack() &&
+      shared()->is_function() &&
+      !shared()->bound();
+}
+
+
 Object* JSBuiltinsObject::javascript_builtin(Builtins::JavaScript id) {
   ASSERT(id < kJSBuiltinsCount);  // id is unsigned.
   return READ_FIELD(this, OffsetOfFunctionWithId(id));
@@ -5277,6 +5313,29 @@ ACCESSORS(TypeFeedbackInfo, type_feedback_cells, TypeFeedbackCells,
 SMI_ACCESSORS(AliasedArgumentsEntry, aliased_context_slot, kAliasedContextSlot)
 
 
+SMI_ACCESSORS(AllocationSite, memento_create_count, kMementoCreateCountOffset)
+SMI_ACCESSORS(AllocationSite, memento_found_count, kMementoFoundCountOffset)
+SMI_ACCESSORS(AllocationSite, pretenure_decision, kPretenureDecisionOffset)
+
+
+bool AllocationSite::ShouldPretenure() {
+  return pretenure_decision() == kTenure;
+}
+
+
+PretenureFlag AllocationSite::GetPretenureMode() {
+  return ShouldPretenure() ? TENURED : NOT_TENURED;
+}
+
+
+void AllocationSite::IncrementMementoCreateCount() {
+  set_memento_create_count(memento_create_count() + 1);
+}
+
+
+ACCESSORS(AllocationMemento, allocation_site, Object, kAllocationSiteOffset)
+
+
 Relocatable::Relocatable(Isolate* isolate) {
   ASSERT(isolate == Isolate::Current());
   isolate_ = isolate;
@@ -609,6 +609,21 @@ void AliasedArgumentsEntry::AliasedArgumentsEntryPrint(FILE* out) {
 }
 
 
+void AllocationSite::AllocationSitePrint(FILE* out) {
+  HeapObject::PrintHeader(out, "AllocationSite");
+  PrintF(out, "\n - memento_create_count: %d, memento_found_count: %d",
+         memento_create_count(), memento_found_count());
+  PrintF(out, "\n - pretenure_decision: %d", pretenure_decision());
+}
+
+
+void AllocationMemento::AllocationMementoPrint(FILE* out) {
+  HeapObject::PrintHeader(out, "AllocationMemento");
+  PrintF(out, "\n - allocation_site: ");
+  allocation_site()->ShortPrint(out);
+}
+
+
 void FixedArray::FixedArrayPrint(FILE* out) {
   HeapObject::PrintHeader(out, "FixedArray");
   PrintF(out, " - length: %d", length());
@@ -928,6 +928,9 @@ bool String::MakeExternal(v8::String::ExternalStringResource* resource) {
   bool is_ascii = this->IsAsciiRepresentation();
   bool is_symbol = this->IsSymbol();
 
+  ConcurrentMarkingScope concurrent_marking_scope(
+      heap->incremental_marking()->concurrent_marker(), this);
+
   // Morph the object to an external string by adjusting the map and
   // reinitializing the fields.
   if (size >= ExternalString::kSize) {
@@ -979,6 +982,9 @@ bool String::MakeExternal(v8::String::ExternalAsciiStringResource* resource) {
   }
   bool is_symbol = this->IsSymbol();
 
+  ConcurrentMarkingScope concurrent_marking_scope(
+      heap->incremental_marking()->concurrent_marker(), this);
+
   // Morph the object to an external string by adjusting the map and
   // reinitializing the fields.  Use short version if space is limited.
   if (size >= ExternalString::kSize) {
@@ -1485,10 +1491,81 @@ String* JSReceiver::constructor_name() {
 }
 
 
+bool JSObject::CanUseDoubleFields() {
+#ifdef V8_TARGET_ARCH_X64
+  return FLAG_unbox_double_fields;
+#else
+  return false;
+#endif
+}
+
+
+MaybeObject* JSObject::DoubleFieldAtPut(int descriptor, Object* value) {
+  DescriptorArray* descriptors = map()->instance_descriptors();
+  int index = descriptors->GetFieldIndex(descriptor);
+  if (value->IsNumber()) {
+    Heap* heap = GetHeap();
+    HeapNumber* box = HeapNumber::cast(RawFastPropertyAt(index));
+    if (box->map() == heap->mutable_heap_number_map()) {
+      box->set_value(value->Number());
+      return value;
+    }
+    // The box has been handed out as a number, so it must not change.
+    Object* new_box;
+    { MaybeObject* maybe_box = heap->AllocateMutableHeapNumber(value->Number());
+      if (!maybe_box->ToObject(&new_box)) return maybe_box;
+    }
+    FastPropertyAtPut(index, new_box);
+    return value;
+  }
+
+  // Generalize the field on a copy of the map.  The box stays behind as the
+  // ordinary value of the field until it is overwritten below.
+  PropertyDetails details = descriptors->GetDetails(descriptor);
+  FieldDescriptor field(descriptors->GetKey(descriptor),
+                        index,
+                        details.attributes());
+  Map* new_map;
+  MaybeObject* maybe_new_map =
+      map()->CopyReplaceDescriptor(&field, descriptor, OMIT_TRANSITION);
+  if (!maybe_new_map->To(&new_map)) return maybe_new_map;
+
+  set_map(new_map);
+  return FastPropertyAtPut(index, value);
+}
+
+
+// Double fields are only used for plain writable in-object properties that
+// start out holding a heap number.
+static bool ShouldAddDoubleField(Map* map,
+                                 int index,
+                                 Object* value,
+                                 PropertyAttributes attributes) {
+  return JSObject::CanUseDoubleFields() &&
+      value->IsHeapNumber() &&
+      attributes == NONE &&
+      index < map->inobject_properties() &&
+      map->instance_type() == JS_OBJECT_TYPE;
+}
+
+
 MaybeObject* JSObject::AddFastPropertyUsingMap(Map* new_map,
                                                String* name,
                                                Object* value,
                                                int field_index) {
+  PropertyDetails details =
+      new_map->instance_descriptors()->GetDetails(new_map->LastAdded());
+  Object* field_value = value;
+  if (details.IsDoubleField()) {
+    // Objects that do not fit the double field leave the transition tree.
+    if (!value->IsNumber()) {
+      return ConvertDescriptorToField(name, value, details.attributes());
+    }
+    MaybeObject* maybe_box =
+        GetHeap()->AllocateMutableHeapNumber(value->Number());
+    if (!maybe_box->ToObject(&field_value)) return maybe_box;
+  }
+
   if (map()->unused_property_fields() == 0) {
     int new_unused = new_map->unused_property_fields();
     FixedArray* values;
@@ -1499,7 +1576,8 @@ MaybeObject* JSObject::AddFastPropertyUsingMap(Map* new_map,
     set_properties(values);
   }
   set_map(new_map);
-  return FastPropertyAtPut(field_index, value);
+  FastPropertyAtPut(field_index, field_value);
+  return value;
 }
 
 
@@ -1550,6 +1628,16 @@ MaybeObject* JSObject::AddFastProperty(String* name,
   // Allocate new instance descriptors with (name, index) added
   FieldDescriptor new_field(name, index, attributes, 0);
 
+  // A double field owns a box of its own, never the heap number stored.
+  Object* field_value = value;
+  bool is_double_field = ShouldAddDoubleField(map(), index, value, attributes);
+  if (is_double_field) {
+    new_field.MarkAsDoubleField();
+    MaybeObject* maybe_box =
+        GetHeap()->AllocateMutableHeapNumber(value->Number());
+    if (!maybe_box->ToObject(&field_value)) return maybe_box;
+  }
+
   ASSERT(index < map()->inobject_properties() ||
          (index - map()->inobject_properties()) < properties()->length() ||
          map()->unused_property_fields() == 0);
@@ -1579,9 +1667,11 @@ MaybeObject* JSObject::AddFastProperty(String* name,
   } else {
     new_map->set_unused_property_fields(map()->unused_property_fields() - 1);
   }
+  if (is_double_field) new_map->set_has_double_fields(true);
 
   set_map(new_map);
-  return FastPropertyAtPut(index, value);
+  FastPropertyAtPut(index, field_value);
+  return value;
 }
 
 
@@ -2749,6 +2839,9 @@ MaybeObject* JSObject::SetPropertyForResult(LookupResult* result,
     case NORMAL:
       return self->SetNormalizedProperty(result, *value);
     case FIELD:
+      if (result->IsDoubleField()) {
+        return self->DoubleFieldAtPut(result->GetDescriptorIndex(), *value);
+      }
       return self->FastPropertyAtPut(result->GetFieldIndex(), *value);
     case CONSTANT_FUNCTION:
       // Only replace the function if necessary.
@@ -2879,6 +2972,9 @@ MaybeObject* JSObject::SetLocalPropertyIgnoreAttributes(
       return SetNormalizedProperty(name, value, details);
     }
     case FIELD:
+      if (result.IsDoubleField()) {
+        return DoubleFieldAtPut(result.GetDescriptorIndex(), value);
+      }
       return FastPropertyAtPut(result.GetFieldIndex(), value);
     case CONSTANT_FUNCTION:
       // Only replace the function if necessary.
@@ -3228,6 +3324,8 @@ MaybeObject* JSObject::NormalizeProperties(PropertyNormalizationMode mode,
 
   // We have now successfully allocated all the necessary objects.
   // Changes can now be made with the guarantee that all of them take effect.
+  ConcurrentMarkingScope concurrent_marking_scope(
+      current_heap->incremental_marking()->concurrent_marker(), this);
 
   // Resize the object in the heap if necessary.
   int new_instance_size = new_map->instance_size();
@@ -7083,43 +7181,21 @@ void String::PrintOn(FILE* file) {
 }
 
 
-// This function should only be called from within the GC, since it uses
-// IncrementLiveBytesFromGC. If called from anywhere else, this results in an
-// inconsistent live-bytes count.
 static void RightTrimFixedArray(Heap* heap, FixedArray* elms, int to_trim) {
-  ASSERT(elms->map() != HEAP->fixed_cow_array_map());
-  // For now this trick is only applied to fixed arrays in new and paged space.
-  // In large object space the object's start must coincide with chunk
-  // and thus the trick is just not applicable.
-  ASSERT(!HEAP->lo_space()->Contains(elms));
-
   const int len = elms->length();
 
   ASSERT(to_trim < len);
 
-  Address new_end = elms->address() + FixedArray::SizeFor(len - to_trim);
-
 #ifdef DEBUG
   // If we are doing a big trim in old space then we zap the space.
-  Object** zap = reinterpret_cast<Object**>(new_end);
+  Object** zap = reinterpret_cast<Object**>(
+      elms->address() + FixedArray::SizeFor(len - to_trim));
   for (int i = 1; i < to_trim; i++) {
     *zap++ = Smi::FromInt(0);
   }
 #endif
 
-  int size_delta = to_trim * kPointerSize;
-
-  // Technically in new space this write might be omitted (except for
-  // debug mode which iterates through the heap), but to play safer
-  // we still do it.
-  heap->CreateFillerObjectAt(new_end, size_delta);
-
-  elms->set_length(len - to_trim);
-
-  // Maintain marking consistency for IncrementalMarking.
-  if (Marking::IsBlack(Marking::MarkBitFrom(elms))) {
-    MemoryChunk::IncrementLiveBytesFromGC(elms->address(), -size_delta);
-  }
+  heap->RightTrimObject(elms, len - to_trim);
 }
 
 
@@ -7251,9 +7327,8 @@ void JSFunction::MarkForParallelRecompilation() {
 
   // Unlike MarkForLazyRecompilation, after queuing a function for
   // recompilation on the compiler thread, we actually tail-call into
-  // the full code.  We reset the profiler ticks here so that the
-  // function doesn't bother the runtime profiler too much.
-  shared()->code()->set_profiler_ticks(0);
+  // the full code.  The profiler ticks are kept until the function is
+  // queued: they give its priority in the compilation queue.
 }
 
 static bool CompileLazyHelper(CompilationInfo* info,
@@ -7569,6 +7644,10 @@ bool SharedFunctionInfo::CanGenerateInlineConstructor(Object* prototype) {
     return false;
   }
 
+  // The inline constructor stores the arguments into tagged fields that are
+  // preallocated in the initial map, so double fields would never be made.
+  if (JSObject::CanUseDoubleFields()) return false;
+
   Heap* heap = GetHeap();
 
   // Traverse the proposed prototype chain looking for properties of the
@@ -7882,6 +7961,12 @@ void SharedFunctionInfo::CompleteInobjectSlackTracking() {
   Heap* heap = map->GetHeap();
   set_initial_map(heap->undefined_value());
   Builtins* builtins = heap->isolate()->builtins();
+
+  // Traversing the transition tree temporarily overwrites the map words of
+  // the maps, which the concurrent marker must not see.  This is rare, so
+  // we pause the marker instead of locking the chunks of all the maps.  The
+  // next marking step restarts it.
+  heap->incremental_marking()->concurrent_marker()->Pause();
   ASSERT_EQ(builtins->builtin(Builtins::kJSConstructStubCountdown),
             construct_stub());
   set_construct_stub(builtins->builtin(Builtins::kJSConstructStubGeneric));
@@ -8279,6 +8364,19 @@ void DeoptimizationInputData::DeoptimizationInputDataPrint(FILE* out) {
 
         case Translation::ARGUMENTS_OBJECT:
           break;
+
+        case Translation::CAPTURED_OBJECT: {
+          int map_index = iterator.Next();
+          int length = iterator.Next();
+          PrintF(out, "{map=%d, length=%d}", map_index, length);
+          break;
+        }
+
+        case Translation::DUPLICATED_OBJECT: {
+          int object_index = iterator.Next();
+          PrintF(out, "{object_index=%d}", object_index);
+          break;
+        }
       }
       PrintF(out, "\n");
     }
@@ -13047,4 +13145,41 @@ void JSDate::SetLocalFields(int64_t local_time_ms, DateCache* date_cache) {
   set_sec(Smi::FromInt(sec), SKIP_WRITE_BARRIER);
 }
 
+
+bool AllocationSite::CanTrack() {
+#ifdef V8_TARGET_ARCH_X64
+  return FLAG_allocation_site_pretenuring;
+#else
+  return false;
+#endif
+}
+
+
+void AllocationSite::IncrementMementoFoundCount() {
+  // Smis have a zero tag, so adding the raw value of Smi 1 to the field
+  // increments the count it holds.
+  AtomicWord* found_address = reinterpret_cast<AtomicWord*>(
+      address() + kMementoFoundCountOffset);
+  AtomicWord raw_found = NoBarrier_AtomicIncrement(
+      found_address, reinterpret_cast<AtomicWord>(Smi::FromInt(1)));
+  int found = Smi::cast(reinterpret_cast<Object*>(raw_found))->value();
+  int created = memento_create_count();
+  if (created < 0 || created >= kMaximumCount) {
+    // Racing scavenger threads may lose a few increments when the counts
+    // are restarted, which does not matter for a heuristic.
+    set_memento_create_count(0);
+    set_memento_found_count(0);
+    return;
+  }
+  if (ShouldPretenure() || found < kPretenureMinimumFound) return;
+  if (found * 100 >= created * kPretenureRatio) {
+    set_pretenure_decision(kTenure);
+    if (FLAG_trace_pretenuring) {
+      PrintF("[pretenuring: site %p switches to old space, "
+             "%d of %d objects survived]\n",
+             reinterpret_cast<void*>(this), found, created);
+    }
+  }
+}
+
 } }  // namespace v8::internal
@@ -203,7 +203,7 @@ const int kStubMinorKeyBits = kBitsPerInt - kSmiTagSize - kStubMajorKeyBits;
 // HeapObject::Size, HeapObject::IterateBody, the typeof operator, and
 // Object::IsString.
 //
-// NOTE: Everything following JS_VALUE_TYPE is considered a
+// NOTE: Everything following JS_OBJECT_TYPE is considered a
 // JSObject for GC purposes. The first four entries here have typeof
 // 'object', whereas JS_FUNCTION_TYPE has typeof 'function'.
 #define INSTANCE_TYPE_LIST_ALL(V)                                              \
@@ -266,6 +266,8 @@ const int kStubMinorKeyBits = kBitsPerInt - kSmiTagSize - kStubMajorKeyBits;
   V(POLYMORPHIC_CODE_CACHE_TYPE)                                               \
   V(TYPE_FEEDBACK_INFO_TYPE)                                                   \
   V(ALIASED_ARGUMENTS_ENTRY_TYPE)                                              \
+  V(ALLOCATION_SITE_TYPE)                                                      \
+  V(ALLOCATION_MEMENTO_TYPE)                                                   \
                                                                                \
   V(FIXED_ARRAY_TYPE)                                                          \
   V(FIXED_DOUBLE_ARRAY_TYPE)                                                   \
@@ -417,7 +419,9 @@ const int kStubMinorKeyBits = kBitsPerInt - kSmiTagSize - kStubMajorKeyBits;
   V(CODE_CACHE, CodeCache, code_cache)                                         \
   V(POLYMORPHIC_CODE_CACHE, PolymorphicCodeCache, polymorphic_code_cache)      \
   V(TYPE_FEEDBACK_INFO, TypeFeedbackInfo, type_feedback_info)                  \
-  V(ALIASED_ARGUMENTS_ENTRY, AliasedArgumentsEntry, aliased_arguments_entry)
+  V(ALIASED_ARGUMENTS_ENTRY, AliasedArgumentsEntry, aliased_arguments_entry) \
+  V(ALLOCATION_SITE, AllocationSite, allocation_site)                          \
+  V(ALLOCATION_MEMENTO, AllocationMemento, allocation_memento)
 
 #ifdef ENABLE_DEBUGGER_SUPPORT
 #define STRUCT_LIST_DEBUGGER(V)                                                \
@@ -574,6 +578,8 @@ enum InstanceType {
   POLYMORPHIC_CODE_CACHE_TYPE,
   TYPE_FEEDBACK_INFO_TYPE,
   ALIASED_ARGUMENTS_ENTRY_TYPE,
+  ALLOCATION_SITE_TYPE,
+  ALLOCATION_MEMENTO_TYPE,
   // The following two instance types are only used when ENABLE_DEBUGGER_SUPPORT
   // is defined. However as include/v8.h contain some of the instance type
   // constants always having them avoids them getting different numbers
@@ -594,9 +600,10 @@ enum InstanceType {
   JS_FUNCTION_PROXY_TYPE,  // FIRST_JS_RECEIVER_TYPE, FIRST_JS_PROXY_TYPE
   JS_PROXY_TYPE,  // LAST_JS_PROXY_TYPE
 
-  JS_VALUE_TYPE,  // FIRST_JS_OBJECT_TYPE
+  // JS_OBJECT_TYPE is exposed in include/v8.h and keeps its value.
+  JS_OBJECT_TYPE,  // FIRST_JS_OBJECT_TYPE
+  JS_VALUE_TYPE,
   JS_DATE_TYPE,
-  JS_OBJECT_TYPE,
   JS_CONTEXT_EXTENSION_OBJECT_TYPE,
   JS_MODULE_TYPE,
   JS_GLOBAL_OBJECT_TYPE,
@@ -629,7 +636,7 @@ enum InstanceType {
   FIRST_JS_RECEIVER_TYPE = JS_FUNCTION_PROXY_TYPE,
   LAST_JS_RECEIVER_TYPE = LAST_TYPE,
   // Boundaries for testing the types represented as JSObject
-  FIRST_JS_OBJECT_TYPE = JS_VALUE_TYPE,
+  FIRST_JS_OBJECT_TYPE = JS_OBJECT_TYPE,
   LAST_JS_OBJECT_TYPE = LAST_TYPE,
   // Boundaries for testing the types represented as JSProxy
   FIRST_JS_PROXY_TYPE = JS_FUNCTION_PROXY_TYPE,
@@ -2029,10 +2036,31 @@ class JSObject: public JSReceiver {
   MUST_USE_RESULT MaybeObject* TransformToFastProperties(
       int unused_property_fields);
 
-  // Access fast-case object properties at index.
+  // Access fast-case object properties at index.  The box of a double field
+  // is handed out as an ordinary heap number: its map is changed from the
+  // mutable heap number map to the heap number map, so that later stores
+  // give the field a new box instead of changing the number handed out.
   inline Object* FastPropertyAt(int index);
   inline Object* FastPropertyAtPut(int index, Object* value);
 
+  // Reads the property at index without handing out the box of a double
+  // field.  For code that only inspects the value.
+  inline Object* RawFastPropertyAt(int index);
+
+  // Returns true if named stores may create double fields: in-object fields
+  // whose heap number is owned by the object and overwritten in place, so
+  // that storing a double does not allocate.  Only the x64 stubs and
+  // optimized code know how to access them.
+  static bool CanUseDoubleFields();
+
+  // Stores value into the double field described by the given descriptor of
+  // the object's map.  The number is written into the box of the field
+  // unless the box has been handed out, in which case the field gets a new
+  // box.  A value that is not a number turns the field back into a tagged
+  // one on a copy of the map.
+  MUST_USE_RESULT MaybeObject* DoubleFieldAtPut(int descriptor,
+                                               Object* value);
+
   // Access to in object properties.
   inline int GetInObjectPropertyOffset(int index);
   inline Object* InObjectPropertyAt(int index);
@@ -4672,6 +4700,7 @@ class Map: public HeapObject {
   class IsShared:              public BitField<bool, 0, 1> {};
   class FunctionWithPrototype: public BitField<bool, 1, 1> {};
   class LastAddedBits:         public BitField<int, 2, 11> {};
+  class HasDoubleFields:       public BitField<bool, 13, 1> {};
 
   // Tells whether the object in the prototype property will be used
   // for instances created from this function.  If the prototype
@@ -4817,6 +4846,12 @@ class Map: public HeapObject {
   inline void set_is_shared(bool value);
   inline bool is_shared();
 
+  // Tells whether the map or one of its ancestors in the transition tree
+  // described a double field.  Objects with such a map must not be copied
+  // word by word, as the copy would share the boxes of its double fields.
+  inline void set_has_double_fields(bool value);
+  inline bool has_double_fields();
+
   // Tells whether the instance needs security checks when accessing its
   // properties.
   inline void set_is_access_check_needed(bool access_check_needed);
@@ -6116,6 +6151,11 @@ class JSFunction: public JSObject {
   // Returns the number of allocated literals.
   inline int NumberOfLiterals();
 
+  // Returns whether the literals of the function hold the allocation site
+  // of the objects it constructs.  The slot is only reserved while
+  // allocation sites are tracked.
+  inline bool HasAllocationSiteLiteral();
+
   // Retrieve the global context from a function's literal array.
   static Context* GlobalContextFromLiterals(FixedArray* literals);
 
@@ -6135,6 +6175,7 @@ class JSFunction: public JSObject {
   // Layout of the literals array.
   static const int kLiteralsPrefixSize = 1;
   static const int kLiteralGlobalContextIndex = 0;
+  static const int kLiteralAllocationSiteIndex = kLiteralsPrefixSize;
 
   // Layout of the bound-function binding array.
   static const int kBoundFunctionIndex = 0;
@@ -6911,6 +6952,105 @@ class AliasedArgumentsEntry: public Struct {
 };
 
 
+// An allocation site collects survival feedback for the objects created by
+// an object or array literal (stored in the literals array slot following
+// the boilerplate) or by a constructor (stored in the first literals array
+// slot of the function).  The slots are only reserved while sites are
+// tracked.
+// Every tracked object allocated in new space is followed by an
+// AllocationMemento pointing back to the site.  The scavenger counts the
+// mementos it finds behind surviving objects, and sites whose objects mostly
+// survive switch to allocating directly in old space.
+class AllocationSite: public Struct {
+ public:
+  enum PretenureDecision {
+    kUndecided = 0,
+    kTenure = 1
+  };
+
+  // A site is pretenured once at least kPretenureMinimumFound of its objects
+  // survived a scavenge and they make up at least kPretenureRatio percent of
+  // the objects created with a memento.
+  static const int kPretenureMinimumFound = 100;
+  static const int kPretenureRatio = 85;
+
+  // Counts are restarted when they get this large, so that the ratio keeps
+  // reflecting recent behavior and the Smi counters cannot overflow.
+  static const int kMaximumCount = 1 << 24;
+
+  inline int memento_create_count();
+  inline void set_memento_create_count(int count);
+
+  inline int memento_found_count();
+  inline void set_memento_found_count(int count);
+
+  inline int pretenure_decision();
+  inline void set_pretenure_decision(int decision);
+
+  inline bool ShouldPretenure();
+  inline PretenureFlag GetPretenureMode();
+
+  inline void IncrementMementoCreateCount();
+
+  // Called by the scavenger for every memento found behind a surviving
+  // object.  Safe to call from the helper threads of the parallel scavenger.
+  void IncrementMementoFoundCount();
+
+  // Returns true if allocation sites are created and tracked.  Only the x64
+  // stubs and optimized code emit allocation mementos.
+  static bool CanTrack();
+
+  static inline AllocationSite* cast(Object* obj);
+
+#ifdef OBJECT_PRINT
+  inline void AllocationSitePrint() {
+    AllocationSitePrint(stdout);
+  }
+  void AllocationSitePrint(FILE* out);
+#endif
+#ifdef DEBUG
+  void AllocationSiteVerify();
+#endif
+
+  static const int kMementoCreateCountOffset = HeapObject::kHeaderSize;
+  static const int kMementoFoundCountOffset =
+      kMementoCreateCountOffset + kPointerSize;
+  static const int kPretenureDecisionOffset =
+      kMementoFoundCountOffset + kPointerSize;
+  static const int kSize = kPretenureDecisionOffset + kPointerSize;
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(AllocationSite);
+};
+
+
+// An allocation memento directly follows a newly allocated object in new
+// space and links it to its AllocationSite.  Mementos are never referenced,
+// so they die with the first garbage collection after their allocation.
+class AllocationMemento: public Struct {
+ public:
+  DECL_ACCESSORS(allocation_site, Object)
+
+  static inline AllocationMemento* cast(Object* obj);
+
+#ifdef OBJECT_PRINT
+  inline void AllocationMementoPrint() {
+    AllocationMementoPrint(stdout);
+  }
+  void AllocationMementoPrint(FILE* out);
+#endif
+#ifdef DEBUG
+  void AllocationMementoVerify();
+#endif
+
+  static const int kAllocationSiteOffset = HeapObject::kHeaderSize;
+  static const int kSize = kAllocationSiteOffset + kPointerSize;
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(AllocationMemento);
+};
+
+
 enum AllowNullsFlag {ALLOW_NULLS, DISALLOW_NULLS};
 enum RobustnessFlag {ROBUST_STRING_TRAVERSAL, FAST_STRING_TRAVERSAL};
 
@@ -31,15 +31,71 @@
 
 #include "hydrogen.h"
 #include "isolate.h"
+#include "runtime-profiler.h"
 #include "v8threads.h"
 
 namespace v8 {
 namespace internal {
 
 
-void OptimizingCompilerThread::Run() {
+class OptimizingCompilerWorker : public Thread {
+ public:
+  OptimizingCompilerWorker(OptimizingCompilerThread* pool, int index)
+      : Thread("OptimizingCompilerThread"),
+        pool_(pool),
+        index_(index) { }
+
+  void Run() { pool_->Run(index_); }
+
+ private:
+  OptimizingCompilerThread* pool_;
+  int index_;
+};
+
+
+OptimizingCompilerThread::OptimizingCompilerThread(Isolate* isolate)
+    : isolate_(isolate),
+      number_of_threads_(0),
+      stop_semaphore_(OS::CreateSemaphore(0)),
+      input_queue_semaphore_(OS::CreateSemaphore(0)),
+      input_queue_mutex_(OS::CreateMutex()),
+      output_queue_mutex_(OS::CreateMutex()) {
+  NoBarrier_Store(&stop_thread_, static_cast<AtomicWord>(false));
+  NoBarrier_Store(&install_requested_, static_cast<Atomic32>(0));
+  for (int i = 0; i < kMaxThreads; i++) {
+    workers_[i] = NULL;
+    time_spent_compiling_[i] = 0;
+    time_spent_total_[i] = 0;
 #ifdef DEBUG
-  thread_id_ = ThreadId::Current().ToInteger();
+    thread_ids_[i] = ThreadId::Invalid().ToInteger();
+#endif
+  }
+}
+
+
+OptimizingCompilerThread::~OptimizingCompilerThread() {
+  for (int i = 0; i < number_of_threads_; i++) delete workers_[i];
+  delete output_queue_mutex_;
+  delete input_queue_mutex_;
+  delete input_queue_semaphore_;
+  delete stop_semaphore_;
+}
+
+
+void OptimizingCompilerThread::Start() {
+  ASSERT(number_of_threads_ == 0);
+  number_of_threads_ =
+      Min(Max(FLAG_parallel_recompilation_threads, 1), kMaxThreads);
+  for (int i = 0; i < number_of_threads_; i++) {
+    workers_[i] = new OptimizingCompilerWorker(this, i);
+    workers_[i]->Start();
+  }
+}
+
+
+void OptimizingCompilerThread::Run(int index) {
+#ifdef DEBUG
+  thread_ids_[index] = ThreadId::Current().ToInteger();
 #endif
   Isolate::SetIsolateThreadLocals(isolate_, NULL);
 
@@ -51,75 +107,269 @@ void OptimizingCompilerThread::Run() {
     if (Acquire_Load(&stop_thread_)) {
       stop_semaphore_->Signal();
       if (FLAG_trace_parallel_recompilation) {
-        time_spent_total_ = OS::Ticks() - epoch;
+        time_spent_total_[index] = OS::Ticks() - epoch;
       }
       return;
     }
 
+    // Jobs dropped from the input queue leave their signal behind.
+    Job* job = DequeueHottest();
+    if (job == NULL) continue;
+
     int64_t compiling_start = 0;
     if (FLAG_trace_parallel_recompilation) compiling_start = OS::Ticks();
 
-    Heap::RelocationLock relocation_lock(isolate_->heap());
-    OptimizingCompiler* optimizing_compiler = NULL;
-    input_queue_.Dequeue(&optimizing_compiler);
-    Barrier_AtomicIncrement(&queue_length_, static_cast<Atomic32>(-1));
-
-    ASSERT(!optimizing_compiler->info()->closure()->IsOptimized());
+    {
+      Heap::SharedRelocationLock relocation_lock(isolate_->heap());
+      // A function waiting for on-stack replacement may have been
+      // optimized by other means meanwhile.
+      ASSERT(job->compiler->info()->osr_ast_id() != AstNode::kNoNumber ||
+             !job->compiler->info()->closure()->IsOptimized());
 
-    OptimizingCompiler::Status status = optimizing_compiler->OptimizeGraph();
-    ASSERT(status != OptimizingCompiler::FAILED);
-    // Prevent an unused-variable error in release mode.
-    USE(status);
+      OptimizingCompiler::Status status = job->compiler->OptimizeGraph();
+      ASSERT(status != OptimizingCompiler::FAILED);
+      // Prevent an unused-variable error in release mode.
+      USE(status);
+    }
 
-    output_queue_.Enqueue(optimizing_compiler);
-    isolate_->stack_guard()->RequestCodeReadyEvent();
+    {
+      ScopedLock lock(output_queue_mutex_);
+      output_queue_.Enqueue(job);
+    }
+    // Functions finished before the interrupt is handled are installed
+    // together.
+    if (Release_CompareAndSwap(&install_requested_, 0, 1) == 0) {
+      isolate_->stack_guard()->RequestCodeReadyEvent();
+    }
 
     if (FLAG_trace_parallel_recompilation) {
-      time_spent_compiling_ += OS::Ticks() - compiling_start;
+      time_spent_compiling_[index] += OS::Ticks() - compiling_start;
+    }
+  }
+}
+
+
+OptimizingCompilerThread::Job* OptimizingCompilerThread::DequeueHottest() {
+  ScopedLock lock(input_queue_mutex_);
+  if (input_queue_.is_empty()) return NULL;
+  // The queue is short, so a linear scan is cheaper than keeping it sorted.
+  // Among equally hot functions the one queued first wins.
+  int hottest = 0;
+  for (int i = 1; i < input_queue_.length(); i++) {
+    if (input_queue_[i]->priority > input_queue_[hottest]->priority) {
+      hottest = i;
     }
   }
+  return input_queue_.Remove(hottest);
 }
 
 
 void OptimizingCompilerThread::Stop() {
   Release_Store(&stop_thread_, static_cast<AtomicWord>(true));
-  input_queue_semaphore_->Signal();
-  stop_semaphore_->Wait();
+  for (int i = 0; i < number_of_threads_; i++) {
+    input_queue_semaphore_->Signal();
+  }
+  for (int i = 0; i < number_of_threads_; i++) {
+    stop_semaphore_->Wait();
+  }
+  for (int i = 0; i < number_of_threads_; i++) {
+    workers_[i]->Join();
+  }
 
   if (FLAG_trace_parallel_recompilation) {
-    double compile_time = static_cast<double>(time_spent_compiling_);
-    double total_time = static_cast<double>(time_spent_total_);
+    double compile_time = 0;
+    double total_time = 0;
+    for (int i = 0; i < number_of_threads_; i++) {
+      compile_time += static_cast<double>(time_spent_compiling_[i]);
+      total_time += static_cast<double>(time_spent_total_[i]);
+    }
     double percentage = (compile_time * 100) / total_time;
-    PrintF("  ** Compiler thread did %.2f%% useful work\n", percentage);
+    PrintF("  ** %d compiler thread(s) did %.2f%% useful work\n",
+           number_of_threads_, percentage);
+  }
+}
+
+
+// The functions of a detached global context can no longer run, so their
+// optimized code is not worth installing.
+static bool IsContextDetached(JSFunction* function) {
+  Context* global_context = function->context()->global_context();
+  return !global_context->global_proxy()->IsJSGlobalProxy();
+}
+
+
+// The loop that queued an on-stack replacement runs with the original stack
+// checks while it waits.  Patch them again so that its next back edge enters
+// the installed code.
+static void PatchForOnStackReplacement(Isolate* isolate,
+                                       JSFunction* function) {
+  Code* unoptimized = function->shared()->code();
+  if (unoptimized->kind() != Code::FUNCTION) return;
+  if (unoptimized->allow_osr_at_loop_nesting_level() == 0) {
+    isolate->runtime_profiler()->AttemptOnStackReplacement(function);
   }
+  unoptimized->set_allow_osr_at_loop_nesting_level(
+      Code::kMaxLoopNestingMarker);
 }
 
 
 void OptimizingCompilerThread::InstallOptimizedFunctions() {
   HandleScope handle_scope(isolate_);
   int functions_installed = 0;
+  int functions_discarded = 0;
+  // Clear the request before draining the queue: a worker finishing after
+  // this point requests another interrupt.
+  NoBarrier_Store(&install_requested_, static_cast<Atomic32>(0));
+  MemoryBarrier();
   while (!output_queue_.IsEmpty()) {
-    OptimizingCompiler* compiler = NULL;
-    output_queue_.Dequeue(&compiler);
-    Compiler::InstallOptimizedCode(compiler);
-    functions_installed++;
+    Job* job = NULL;
+    output_queue_.Dequeue(&job);
+    if (job->cancelled ||
+        IsContextDetached(*job->compiler->info()->closure())) {
+      DiscardJob(job);
+      functions_discarded++;
+    } else {
+      jobs_.RemoveElement(job);
+      bool is_osr = job->compiler->info()->osr_ast_id() != AstNode::kNoNumber;
+      Handle<JSFunction> closure(*job->compiler->info()->closure());
+      if (FLAG_hydrogen_stats && is_osr) {
+        // The loop ran unoptimized code while waiting for this.
+        HStatistics::Instance()->IncrementOSRWait(
+            OS::Ticks() - job->queued_at);
+      }
+      Compiler::InstallOptimizedCode(job->compiler);
+      if (is_osr && closure->IsOptimized()) {
+        PatchForOnStackReplacement(isolate_, *closure);
+      }
+      delete job;
+      functions_installed++;
+    }
   }
   if (FLAG_trace_parallel_recompilation && functions_installed != 0) {
     PrintF("  ** Installed %d function(s).\n", functions_installed);
   }
+  if (FLAG_trace_parallel_recompilation && functions_discarded != 0) {
+    PrintF("  ** Discarded %d cancelled function(s).\n", functions_discarded);
+  }
 }
 
 
 void OptimizingCompilerThread::QueueForOptimization(
-    OptimizingCompiler* optimizing_compiler) {
-  input_queue_.Enqueue(optimizing_compiler);
+    OptimizingCompiler* optimizing_compiler,
+    int priority) {
+  ASSERT(!IsOptimizerThread());
+  Job* job = new Job(optimizing_compiler, priority);
+  if (FLAG_hydrogen_stats) job->queued_at = OS::Ticks();
+  jobs_.Add(job);
+  {
+    ScopedLock lock(input_queue_mutex_);
+    input_queue_.Add(job);
+  }
   input_queue_semaphore_->Signal();
 }
 
+
+bool OptimizingCompilerThread::IsQueueAvailable(int priority) {
+  // This can be queried only from the execution thread.
+  ASSERT(!IsOptimizerThread());
+  Job* coldest = NULL;
+  {
+    ScopedLock lock(input_queue_mutex_);
+    if (input_queue_.length() < FLAG_parallel_recompilation_queue_length) {
+      return true;
+    }
+    int index = -1;
+    for (int i = 0; i < input_queue_.length(); i++) {
+      if (input_queue_[i]->priority < priority &&
+          (index == -1 ||
+           input_queue_[i]->priority < input_queue_[index]->priority)) {
+        index = i;
+      }
+    }
+    if (index == -1) return false;
+    coldest = input_queue_.Remove(index);
+  }
+  if (FLAG_trace_parallel_recompilation) {
+    PrintF("  ** Dropping colder function from the compilation queue: ");
+    coldest->compiler->info()->closure()->PrintName();
+    PrintF("\n");
+  }
+  // The dropped function is queued again when it gets hot.
+  DiscardJob(coldest);
+  return true;
+}
+
+
+void OptimizingCompilerThread::CancelFunction(JSFunction* function) {
+  Cancel(function, NULL);
+}
+
+
+void OptimizingCompilerThread::CancelContext(Context* global_context) {
+  ASSERT(global_context->IsGlobalContext());
+  Cancel(NULL, global_context);
+}
+
+
+void OptimizingCompilerThread::Cancel(JSFunction* function,
+                                      Context* global_context) {
+  ASSERT(!IsOptimizerThread());
+  int i = 0;
+  while (i < jobs_.length()) {
+    Job* job = jobs_[i];
+    JSFunction* closure = *job->compiler->info()->closure();
+    if (closure != function &&
+        closure->context()->global_context() != global_context) {
+      i++;
+      continue;
+    }
+    bool waiting;
+    {
+      ScopedLock lock(input_queue_mutex_);
+      waiting = input_queue_.RemoveElement(job);
+    }
+    if (waiting) {
+      // DiscardJob removes the job from jobs_.
+      DiscardJob(job);
+    } else {
+      // The job is being compiled or waits to be installed.
+      job->cancelled = true;
+      i++;
+    }
+  }
+}
+
+
+bool OptimizingCompilerThread::IsQueuedForOSR(JSFunction* function) {
+  ASSERT(!IsOptimizerThread());
+  for (int i = 0; i < jobs_.length(); i++) {
+    Job* job = jobs_[i];
+    CompilationInfo* info = job->compiler->info();
+    if (!job->cancelled &&
+        *info->closure() == function &&
+        info->osr_ast_id() != AstNode::kNoNumber) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+void OptimizingCompilerThread::DiscardJob(Job* job) {
+  jobs_.RemoveElement(job);
+  Compiler::DiscardOptimizedCode(job->compiler);
+  delete job;
+}
+
+
 #ifdef DEBUG
 bool OptimizingCompilerThread::IsOptimizerThread() {
   if (!FLAG_parallel_recompilation) return false;
-  return ThreadId::Current().ToInteger() == thread_id_;
+  int current = ThreadId::Current().ToInteger();
+  for (int i = 0; i < number_of_threads_; i++) {
+    if (thread_ids_[i] == current) return true;
+  }
+  return false;
 }
 #endif
 
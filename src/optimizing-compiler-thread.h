@@ -31,68 +31,103 @@
 #include "atomicops.h"
 #include "platform.h"
 #include "flags.h"
+#include "list.h"
 #include "unbound-queue.h"
 
 namespace v8 {
 namespace internal {
 
+class Context;
 class HGraphBuilder;
+class JSFunction;
 class OptimizingCompiler;
+class OptimizingCompilerWorker;
 
-class OptimizingCompilerThread : public Thread {
+// Optimizes the graphs of hot functions on a pool of background threads.
+// The execution thread builds the graph and queues it; the hottest queued
+// function is compiled first.  Finished functions are installed in batches
+// by the execution thread when it handles a stack guard interrupt.
+class OptimizingCompilerThread {
  public:
-  explicit OptimizingCompilerThread(Isolate *isolate) :
-      Thread("OptimizingCompilerThread"),
-      isolate_(isolate),
-      stop_semaphore_(OS::CreateSemaphore(0)),
-      input_queue_semaphore_(OS::CreateSemaphore(0)),
-      time_spent_compiling_(0),
-      time_spent_total_(0) {
-    NoBarrier_Store(&stop_thread_, static_cast<AtomicWord>(false));
-    NoBarrier_Store(&queue_length_, static_cast<AtomicWord>(0));
-  }
-
-  void Run();
+  explicit OptimizingCompilerThread(Isolate *isolate);
+  ~OptimizingCompilerThread();
+
+  void Start();
   void Stop();
-  void QueueForOptimization(OptimizingCompiler* optimizing_compiler);
+
+  // The priority of a function is its hotness as seen by the runtime
+  // profiler.
+  void QueueForOptimization(OptimizingCompiler* optimizing_compiler,
+                            int priority);
   void InstallOptimizedFunctions();
 
-  inline bool IsQueueAvailable() {
-    // We don't need a barrier since we have a data dependency right
-    // after.
-    Atomic32 current_length = NoBarrier_Load(&queue_length_);
+  // Returns whether a function with the given priority can be queued.  When
+  // the queue is full, a colder function that is still waiting is dropped
+  // to make room.
+  bool IsQueueAvailable(int priority);
 
-    // This can be queried only from the execution thread.
-    ASSERT(!IsOptimizerThread());
-    // Since only the execution thread increments queue_length_ and
-    // only one thread can run inside an Isolate at one time, a direct
-    // doesn't introduce a race -- queue_length_ may decreased in
-    // meantime, but not increased.
-    return (current_length < FLAG_parallel_recompilation_queue_length);
-  }
+  // Drops the queued and running compilations of a function, or of all
+  // functions of a global context, when it is deoptimized.  A running
+  // compilation finishes but its code is not installed.
+  void CancelFunction(JSFunction* function);
+  void CancelContext(Context* global_context);
+
+  // Returns whether an on-stack replacement of the function is being
+  // compiled.
+  bool IsQueuedForOSR(JSFunction* function);
 
 #ifdef DEBUG
   bool IsOptimizerThread();
 #endif
 
-  ~OptimizingCompilerThread() {
-    delete input_queue_semaphore_;
-    delete stop_semaphore_;
-  }
+  static const int kMaxThreads = 8;
 
  private:
+  friend class OptimizingCompilerWorker;
+
+  struct Job : public Malloced {
+    Job(OptimizingCompiler* compiler, int priority)
+        : compiler(compiler),
+          priority(priority),
+          queued_at(0),
+          cancelled(false) { }
+
+    OptimizingCompiler* compiler;
+    int priority;
+    // Only recorded for --hydrogen-stats.
+    int64_t queued_at;
+    // Only accessed by the execution thread.
+    bool cancelled;
+  };
+
+  void Run(int index);
+  Job* DequeueHottest();
+  void Cancel(JSFunction* function, Context* global_context);
+  void DiscardJob(Job* job);
+
   Isolate* isolate_;
+  int number_of_threads_;
+  OptimizingCompilerWorker* workers_[kMaxThreads];
   Semaphore* stop_semaphore_;
   Semaphore* input_queue_semaphore_;
-  UnboundQueue<OptimizingCompiler*> input_queue_;
-  UnboundQueue<OptimizingCompiler*> output_queue_;
+  // Guards input_queue_.
+  Mutex* input_queue_mutex_;
+  List<Job*> input_queue_;
+  // Serializes the workers enqueueing to output_queue_.
+  Mutex* output_queue_mutex_;
+  UnboundQueue<Job*> output_queue_;
+  // All jobs that have been queued and not yet installed or discarded.  Only
+  // accessed by the execution thread.
+  List<Job*> jobs_;
   volatile AtomicWord stop_thread_;
-  volatile Atomic32 queue_length_;
-  int64_t time_spent_compiling_;
-  int64_t time_spent_total_;
+  // Set while a code ready interrupt is pending, so that the workers request
+  // one interrupt per batch of finished functions.
+  volatile Atomic32 install_requested_;
+  int64_t time_spent_compiling_[kMaxThreads];
+  int64_t time_spent_total_[kMaxThreads];
 
 #ifdef DEBUG
-  int thread_id_;
+  int thread_ids_[kMaxThreads];
 #endif
 };
 
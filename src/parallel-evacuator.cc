@@ -0,0 +1,320 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "v8.h"
+
+#include "heap-profiler.h"
+#include "mark-compact.h"
+#include "parallel-evacuator.h"
+#include "work-stealing-list-inl.h"
+
+namespace v8 {
+namespace internal {
+
+
+EvacuationTask::EvacuationTask(ParallelEvacuator* evacuator, int id)
+    : evacuator_(evacuator),
+      collector_(evacuator->collector()),
+      heap_(evacuator->heap()),
+      id_(id),
+      migration_slots_buffer_(NULL),
+      typed_slots_buffer_(NULL) {
+  old_pointer_buffer_.top = old_pointer_buffer_.limit = NULL;
+  old_data_buffer_.top = old_data_buffer_.limit = NULL;
+}
+
+
+EvacuationTask::~EvacuationTask() {
+  ASSERT(migration_slots_buffer_ == NULL);
+  ASSERT(typed_slots_buffer_ == NULL);
+}
+
+
+void EvacuationTask::EvacuatePages() {
+  List<Page*>* pages = &evacuator_->pages_;
+  int i;
+  while (evacuator_->NextWorkItem(id_, &i)) {
+    Page* p = pages->at(i);
+    PagedSpace* space = static_cast<PagedSpace*>(p->owner());
+    bool can_expand;
+    { ScopedLock lock(evacuator_->allocation_mutex_);
+      can_expand = space->CanExpand();
+    }
+    if (can_expand) {
+      collector_->EvacuateLiveObjectsFromPage(p, this);
+    } else {
+      // Without room for expansion evacuation is not guaranteed to succeed.
+      // Unlike the sequential evacuation only this page is abandoned, the
+      // other tasks check their pages themselves.
+      collector_->slots_buffer_allocator_.DeallocateChain(
+          p->slots_buffer_address());
+      p->ClearEvacuationCandidate();
+      p->SetFlag(Page::RESCAN_ON_EVACUATION);
+    }
+  }
+}
+
+
+void EvacuationTask::UpdatePointers() {
+  int number_of_tasks = evacuator_->number_of_tasks_;
+  List<Page*>* pages = &evacuator_->pages_;
+  List<Address>* to_space_ranges = &evacuator_->to_space_ranges_;
+  bool filtering = evacuator_->code_slots_filtering_required_;
+  int i;
+  while (evacuator_->NextWorkItem(id_, &i)) {
+    SlotsBuffer* buffer;
+    if (i < number_of_tasks) {
+      buffer = evacuator_->tasks_[i]->migration_slots_buffer_;
+    } else if (i < number_of_tasks + pages->length()) {
+      buffer = pages->at(i - number_of_tasks)->slots_buffer();
+    } else {
+      int range = i - number_of_tasks - pages->length();
+      collector_->UpdatePointersInToSpace(to_space_ranges->at(2 * range),
+                                          to_space_ranges->at(2 * range + 1));
+      continue;
+    }
+    SlotsBuffer::UpdateUntypedSlotsRecordedIn(
+        heap_,
+        buffer,
+        filtering,
+        &collector_->slots_buffer_allocator_,
+        &typed_slots_buffer_);
+  }
+}
+
+
+void EvacuationTask::FinishEvacuation() {
+  CloseBuffer(&old_pointer_buffer_, heap_->old_pointer_space());
+  CloseBuffer(&old_data_buffer_, heap_->old_data_space());
+  StoreBuffer* store_buffer = heap_->store_buffer();
+  for (int i = 0; i < new_space_slots_.length(); i++) {
+    store_buffer->Mark(new_space_slots_[i]);
+  }
+  new_space_slots_.Clear();
+}
+
+
+void EvacuationTask::FinishUpdatingPointers() {
+  // The typed slots were filtered when they were collected.
+  SlotsBuffer::UpdateSlotsRecordedIn(heap_, typed_slots_buffer_, false);
+  SlotsBufferAllocator* allocator = &collector_->slots_buffer_allocator_;
+  allocator->DeallocateChain(&typed_slots_buffer_);
+  allocator->DeallocateChain(&migration_slots_buffer_);
+}
+
+
+HeapObject* EvacuationTask::Allocate(PagedSpace* space, int size) {
+  AllocationInfo* buffer = (space->identity() == OLD_POINTER_SPACE)
+      ? &old_pointer_buffer_
+      : &old_data_buffer_;
+  if (buffer->top + size > buffer->limit) {
+    ScopedLock lock(evacuator_->allocation_mutex_);
+    Object* result;
+    if (size > kBufferSize / 4) {
+      // Large objects are allocated directly in the space.
+      if (!space->AllocateRaw(size)->ToObject(&result)) return NULL;
+      return HeapObject::cast(result);
+    }
+    CloseBuffer(buffer, space);
+    if (!space->AllocateRaw(kBufferSize)->ToObject(&result)) {
+      // The space may still have room for the object itself.
+      if (!space->AllocateRaw(size)->ToObject(&result)) return NULL;
+      return HeapObject::cast(result);
+    }
+    buffer->top = HeapObject::cast(result)->address();
+    buffer->limit = buffer->top + kBufferSize;
+  }
+  HeapObject* object = HeapObject::FromAddress(buffer->top);
+  buffer->top += size;
+  return object;
+}
+
+
+void EvacuationTask::CloseBuffer(AllocationInfo* buffer, PagedSpace* space) {
+  int remaining = static_cast<int>(buffer->limit - buffer->top);
+  if (remaining > 0) space->Free(buffer->top, remaining);
+  buffer->top = buffer->limit = NULL;
+}
+
+
+ParallelEvacuator::ParallelEvacuator(MarkCompactCollector* collector)
+    : collector_(collector),
+      heap_(collector->heap()),
+      number_of_tasks_(0),
+      allocation_mutex_(OS::CreateMutex()),
+      phase_(EVACUATE_PAGES),
+      code_slots_filtering_required_(false) {
+  for (int i = 0; i < kMaxTasks; i++) {
+    tasks_[i] = NULL;
+    threads_[i] = NULL;
+  }
+}
+
+
+ParallelEvacuator::~ParallelEvacuator() {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    if (threads_[i] != NULL) {
+      threads_[i]->Stop();
+      delete threads_[i];
+    }
+    delete tasks_[i];
+  }
+  delete allocation_mutex_;
+}
+
+
+bool ParallelEvacuator::CanEvacuateInParallel(Heap* heap) {
+  if (!FLAG_parallel_evacuation) return false;
+  // Object moves are reported to the loggers and profilers one at a time.
+  Isolate* isolate = heap->isolate();
+  return !isolate->logger()->is_logging() &&
+         !CpuProfiler::is_profiling(isolate) &&
+         (isolate->heap_profiler() == NULL ||
+          !isolate->heap_profiler()->is_profiling());
+}
+
+
+void ParallelEvacuator::SetUp() {
+  if (number_of_tasks_ > 0) return;
+  number_of_tasks_ = 1 + Min(Max(FLAG_evacuator_threads, 0), kMaxTasks - 1);
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i] = new EvacuationTask(this, i);
+    if (i > 0) {
+      threads_[i] = new GCHelperThread(
+          heap_->isolate(), "EvacuatorThread", this, i);
+      threads_[i]->Start();
+    }
+  }
+  work_list_.SetUp(number_of_tasks_);
+}
+
+
+void ParallelEvacuator::EvacuatePages() {
+  SetUp();
+  List<Page*>* candidates = &collector_->evacuation_candidates_;
+  pages_.Clear();
+  for (int i = 0; i < candidates->length(); i++) {
+    Page* p = candidates->at(i);
+    if (p->IsEvacuationCandidate() &&
+        p->owner()->identity() != CODE_SPACE &&
+        p->owner()->identity() != MAP_SPACE) {
+      pages_.Add(p);
+    }
+  }
+  if (pages_.is_empty()) return;
+
+  // The allocation scope is not thread-safe, the main thread holds it for
+  // all tasks.
+  AlwaysAllocateScope always_allocate;
+  RunPhase(EVACUATE_PAGES);
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i]->FinishEvacuation();
+  }
+}
+
+
+void ParallelEvacuator::UpdatePointers(bool code_slots_filtering_required) {
+  SetUp();
+  code_slots_filtering_required_ = code_slots_filtering_required;
+
+  List<Page*>* candidates = &collector_->evacuation_candidates_;
+  pages_.Clear();
+  for (int i = 0; i < candidates->length(); i++) {
+    Page* p = candidates->at(i);
+    if (p->IsEvacuationCandidate()) pages_.Add(p);
+  }
+
+  to_space_ranges_.Clear();
+  Address bottom = heap_->new_space()->bottom();
+  Address top = heap_->new_space()->top();
+  NewSpacePage* first_page = NewSpacePage::FromAddress(bottom);
+  NewSpacePage* last_page = NewSpacePage::FromLimit(top);
+  NewSpacePageIterator it(bottom, top);
+  while (it.has_next()) {
+    NewSpacePage* page = it.next();
+    Address start = (page == first_page) ? bottom : page->area_start();
+    Address end = (page == last_page) ? top : page->area_end();
+    if (start < end) {
+      to_space_ranges_.Add(start);
+      to_space_ranges_.Add(end);
+    }
+  }
+
+  RunPhase(UPDATE_POINTERS);
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i]->FinishUpdatingPointers();
+  }
+}
+
+
+void ParallelEvacuator::RunPhase(Phase phase) {
+  phase_ = phase;
+  int number_of_items = pages_.length();
+  if (phase == UPDATE_POINTERS) {
+    number_of_items += number_of_tasks_ + to_space_ranges_.length() / 2;
+  }
+  for (int i = 0; i < number_of_items; i++) {
+    // The work list is unbounded.
+    bool success = work_list_.Push(i % number_of_tasks_, i);
+    ASSERT(success);
+    USE(success);
+  }
+  work_list_.StartPhase();
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads_[i]->StartTask();
+  }
+  RunTask(0);
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads_[i]->WaitForTask();
+  }
+  ASSERT(work_list_.IsEmpty());
+}
+
+
+bool ParallelEvacuator::NextWorkItem(int task_id, int* item) {
+  while (!work_list_.Pop(task_id, item)) {
+    if (!work_list_.Steal(task_id) && !work_list_.WaitForWork()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+void ParallelEvacuator::RunTask(int task_id) {
+  ASSERT(task_id >= 0 && task_id < number_of_tasks_);
+  switch (phase_) {
+    case EVACUATE_PAGES:
+      tasks_[task_id]->EvacuatePages();
+      break;
+    case UPDATE_POINTERS:
+      tasks_[task_id]->UpdatePointers();
+      break;
+  }
+}
+
+} }  // namespace v8::internal
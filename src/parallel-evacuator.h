@@ -0,0 +1,180 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_PARALLEL_EVACUATOR_H_
+#define V8_PARALLEL_EVACUATOR_H_
+
+#include "atomicops.h"
+#include "gc-helper-thread.h"
+#include "list.h"
+#include "platform.h"
+#include "spaces.h"
+#include "work-stealing-list.h"
+
+namespace v8 {
+namespace internal {
+
+class EvacuationTask;
+class Heap;
+class MarkCompactCollector;
+class SlotsBuffer;
+
+// The parallel evacuator evacuates the evacuation candidates of a
+// compacting collection and updates the pointers to the evacuated objects
+// using the main thread and a number of helper threads.  Both phases are
+// split into independent work items that are dealt out to the tasks before
+// the phase starts: candidate pages while evacuating, and slots buffers and
+// to-space pages while updating pointers.  Tasks that run out of items
+// steal them from the others.
+//
+// The tasks copy objects into linear allocation areas of their own and
+// record the slots of the copies in slots buffers of their own.  Candidates
+// in code space are left to the main thread, which relocates code objects.
+// Typed slots, which patch code, are collected by the tasks and updated by
+// the main thread, since the same code object may be reached through
+// several slots buffers.
+class ParallelEvacuator : public GCHelperThread::Task {
+ public:
+  static const int kMaxTasks = 16;
+
+  explicit ParallelEvacuator(MarkCompactCollector* collector);
+  ~ParallelEvacuator();
+
+  // Returns whether the next compaction can be done in parallel.
+  static bool CanEvacuateInParallel(Heap* heap);
+
+  // Evacuates the candidates of the old pointer and old data spaces.  Like
+  // the sequential evacuation, candidates are abandoned when their space
+  // cannot expand any more.
+  void EvacuatePages();
+
+  // Updates the slots recorded during evacuation and on the candidates, as
+  // well as the pointers in to-space.
+  void UpdatePointers(bool code_slots_filtering_required);
+
+  // Entry point of the tasks run by the helper threads.
+  virtual void RunTask(int task_id);
+
+  MarkCompactCollector* collector() { return collector_; }
+  Heap* heap() { return heap_; }
+  int number_of_tasks() { return number_of_tasks_; }
+
+ private:
+  static const int kSegmentCapacity = 16;
+  typedef WorkStealingList<int, kSegmentCapacity> WorkList;
+
+  enum Phase {
+    EVACUATE_PAGES,
+    UPDATE_POINTERS
+  };
+
+  // Starts the helper threads when they are needed for the first time.
+  void SetUp();
+
+  // Runs the tasks on the work items of |phase| until all are claimed.
+  void RunPhase(Phase phase);
+
+  // Claims the index of a work item for the task.  Returns false once all
+  // work items of the phase have been claimed.
+  bool NextWorkItem(int task_id, int* item);
+
+  MarkCompactCollector* collector_;
+  Heap* heap_;
+  int number_of_tasks_;
+  EvacuationTask* tasks_[kMaxTasks];
+  GCHelperThread* threads_[kMaxTasks];
+
+  // Serializes allocation in the spaces of the heap.
+  Mutex* allocation_mutex_;
+
+  // The work items of the current phase.  While updating pointers the
+  // items are the migration slots buffers of the tasks, followed by the
+  // slots buffers of the candidates and the to-space pages.
+  Phase phase_;
+  bool code_slots_filtering_required_;
+  List<Page*> pages_;
+  List<Address> to_space_ranges_;
+  WorkList work_list_;
+
+  friend class EvacuationTask;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelEvacuator);
+};
+
+
+// The state of one evacuation task.  Task 0 is run by the main thread, the
+// other tasks by the helper threads of the parallel evacuator.
+class EvacuationTask : public Malloced {
+ public:
+  EvacuationTask(ParallelEvacuator* evacuator, int id);
+  ~EvacuationTask();
+
+  void EvacuatePages();
+  void UpdatePointers();
+
+  // Releases the unused parts of the allocation areas and enters the slots
+  // pointing to new space into the store buffer.
+  void FinishEvacuation();
+
+  // Updates the typed slots collected while updating pointers and releases
+  // the slots buffers of the task.
+  void FinishUpdatingPointers();
+
+  // Allocates an object in the old pointer or old data space.  Returns
+  // NULL if the space cannot provide the memory.
+  HeapObject* Allocate(PagedSpace* space, int size);
+
+  SlotsBuffer** migration_slots_buffer_address() {
+    return &migration_slots_buffer_;
+  }
+  List<Address>* new_space_slots() { return &new_space_slots_; }
+
+ private:
+  static const int kBufferSize = 8 * KB;
+
+  void CloseBuffer(AllocationInfo* buffer, PagedSpace* space);
+
+  ParallelEvacuator* evacuator_;
+  MarkCompactCollector* collector_;
+  Heap* heap_;
+  int id_;
+
+  AllocationInfo old_pointer_buffer_;
+  AllocationInfo old_data_buffer_;
+
+  // Slots of the copied objects that point to evacuation candidates or to
+  // new space.
+  SlotsBuffer* migration_slots_buffer_;
+  List<Address> new_space_slots_;
+
+  // Typed slots found while updating pointers.
+  SlotsBuffer* typed_slots_buffer_;
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_PARALLEL_EVACUATOR_H_
@@ -0,0 +1,333 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "v8.h"
+
+#include "mark-compact-inl.h"
+#include "objects-visiting.h"
+#include "parallel-marker.h"
+#include "work-stealing-list-inl.h"
+
+namespace v8 {
+namespace internal {
+
+
+// The state of one marking task.  Task 0 is run by the main thread, the
+// other tasks by the helper threads of the parallel marker.
+class MarkingTask : public Malloced {
+ public:
+  MarkingTask(ParallelMarker* marker, int id);
+
+  void Run();
+
+  // Hands the work deferred to the main thread over to the collector.
+  void ProcessDeferredWork();
+
+ private:
+  void VisitObject(HeapObject* object);
+  void VisitPointers(HeapObject* object, int start_offset, int end_offset);
+  void MarkObject(HeapObject* object);
+
+  void Push(HeapObject* object, MarkBit mark_bit);
+
+  ParallelMarker* marker_;
+  Heap* heap_;
+  int id_;
+
+  // Work that has to be done by the main thread: unmarked maps, objects
+  // that need the sequential marking visitor and pairs of anchor slots and
+  // slots pointing to evacuation candidates.
+  List<HeapObject*> deferred_maps_;
+  List<HeapObject*> deferred_objects_;
+  List<Object**> recorded_slots_;
+};
+
+
+MarkingTask::MarkingTask(ParallelMarker* marker, int id)
+    : marker_(marker),
+      heap_(marker->heap()),
+      id_(id) {
+}
+
+
+void MarkingTask::Run() {
+  ParallelMarker::WorkList* work_list = &marker_->work_list_;
+  HeapObject* object;
+  do {
+    do {
+      while (work_list->Pop(id_, &object)) VisitObject(object);
+    } while (work_list->Steal(id_));
+  } while (work_list->WaitForWork());
+}
+
+
+void MarkingTask::ProcessDeferredWork() {
+  MarkCompactCollector* collector = marker_->collector();
+  for (int i = 0; i < recorded_slots_.length(); i += 2) {
+    Object** anchor_slot = recorded_slots_[i];
+    Object** slot = recorded_slots_[i + 1];
+    collector->RecordSlot(anchor_slot, slot, *slot);
+  }
+  recorded_slots_.Rewind(0);
+
+  for (int i = 0; i < deferred_maps_.length(); i++) {
+    HeapObject* map = deferred_maps_[i];
+    collector->MarkObject(map, Marking::MarkBitFrom(map));
+  }
+  deferred_maps_.Rewind(0);
+
+  for (int i = 0; i < deferred_objects_.length(); i++) {
+    collector->VisitMarkedObject(deferred_objects_[i]);
+  }
+  deferred_objects_.Rewind(0);
+}
+
+
+void MarkingTask::VisitObject(HeapObject* object) {
+  ASSERT(Marking::IsBlack(Marking::MarkBitFrom(object)));
+  Map* map = object->map();
+  int start_offset;
+  int end_offset;
+  int id = map->visitor_id();
+  switch (id) {
+    case StaticVisitorBase::kVisitShortcutCandidate:
+    case StaticVisitorBase::kVisitConsString:
+      // Unlike the sequential marking visitor we do not short-circuit cons
+      // strings, which is only an optimization.
+      start_offset = ConsString::BodyDescriptor::kStartOffset;
+      end_offset = ConsString::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitSlicedString:
+      if (FLAG_rescue_string_slices) {
+        // The sequential marking visitor records slices whose parents may
+        // be freed, see MarkCompactCollector::RecordSliceCandidate.
+        deferred_objects_.Add(object);
+        return;
+      }
+      start_offset = SlicedString::BodyDescriptor::kStartOffset;
+      end_offset = SlicedString::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitOddball:
+      start_offset = Oddball::BodyDescriptor::kStartOffset;
+      end_offset = Oddball::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitPropertyCell:
+      start_offset = JSGlobalPropertyCell::BodyDescriptor::kStartOffset;
+      end_offset = JSGlobalPropertyCell::BodyDescriptor::kEndOffset;
+      break;
+    case StaticVisitorBase::kVisitFixedArray:
+      start_offset = FixedArray::BodyDescriptor::kStartOffset;
+      end_offset = object->SizeFromMap(map);
+      break;
+    case StaticVisitorBase::kVisitFixedDoubleArray:
+    case StaticVisitorBase::kVisitByteArray:
+    case StaticVisitorBase::kVisitFreeSpace:
+    case StaticVisitorBase::kVisitSeqAsciiString:
+    case StaticVisitorBase::kVisitSeqTwoByteString:
+      start_offset = end_offset = 0;
+      break;
+    default:
+      if (id >= StaticVisitorBase::kVisitDataObject &&
+          id <= StaticVisitorBase::kVisitDataObjectGeneric) {
+        start_offset = end_offset = 0;
+      } else if (id >= StaticVisitorBase::kVisitJSObject &&
+                 id <= StaticVisitorBase::kVisitJSObjectGeneric) {
+        start_offset = JSObject::BodyDescriptor::kStartOffset;
+        end_offset = object->SizeFromMap(map);
+      } else if (id >= StaticVisitorBase::kVisitStruct &&
+                 id <= StaticVisitorBase::kVisitStructGeneric) {
+        start_offset = StructBodyDescriptor::kStartOffset;
+        end_offset = object->SizeFromMap(map);
+      } else {
+        // The object needs the sequential marking visitor, which also takes
+        // care of its map.
+        deferred_objects_.Add(object);
+        return;
+      }
+      break;
+  }
+
+  if (!Marking::MarkBitFrom(map).Get()) deferred_maps_.Add(map);
+  if (start_offset < end_offset) {
+    VisitPointers(object, start_offset, end_offset);
+  }
+}
+
+
+void MarkingTask::VisitPointers(HeapObject* object,
+                                int start_offset,
+                                int end_offset) {
+  Object** start = HeapObject::RawField(object, start_offset);
+  Object** end = HeapObject::RawField(object, end_offset);
+  bool record_slots =
+      !MarkCompactCollector::ShouldSkipEvacuationSlotRecording(start);
+  for (Object** slot = start; slot < end; slot++) {
+    Object* value = *slot;
+    if (!value->IsHeapObject()) continue;
+    HeapObject* target = HeapObject::cast(value);
+    if (record_slots &&
+        MarkCompactCollector::IsOnEvacuationCandidate(target)) {
+      recorded_slots_.Add(start);
+      recorded_slots_.Add(slot);
+    }
+    MarkObject(target);
+  }
+}
+
+
+void MarkingTask::MarkObject(HeapObject* object) {
+  MarkBit mark_bit = Marking::MarkBitFrom(object);
+  if (mark_bit.Get()) return;
+  if (object->IsMap()) {
+    // Maps are marked by the main thread, see ProcessNewlyMarkedObject.
+    deferred_maps_.Add(object);
+    return;
+  }
+  if (!Marking::WhiteToBlackAtomically(mark_bit)) return;
+  if (mark_bit.data_only()) {
+    // Objects in the data space have no pointers to visit.
+    MemoryChunk::IncrementLiveBytesFromGCAtomically(object->address(),
+                                                    object->Size());
+    return;
+  }
+  Push(object, mark_bit);
+}
+
+
+void MarkingTask::Push(HeapObject* object, MarkBit mark_bit) {
+  if (!marker_->work_list_.Push(id_, object)) {
+    // Leave a grey object in the heap, the collector rediscovers it when
+    // it refills its marking deque.
+    Marking::BlackToGreyAtomically(mark_bit);
+    Release_Store(&marker_->overflowed_, static_cast<AtomicWord>(true));
+    return;
+  }
+  MemoryChunk::IncrementLiveBytesFromGCAtomically(object->address(),
+                                                  object->Size());
+}
+
+
+ParallelMarker::ParallelMarker(MarkCompactCollector* collector)
+    : collector_(collector),
+      heap_(collector->heap()),
+      number_of_tasks_(0),
+      overflowed_(false) {
+  for (int i = 0; i < kMaxTasks; i++) {
+    tasks_[i] = NULL;
+    threads_[i] = NULL;
+  }
+}
+
+
+ParallelMarker::~ParallelMarker() {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    if (threads_[i] != NULL) {
+      threads_[i]->Stop();
+      delete threads_[i];
+    }
+    delete tasks_[i];
+  }
+}
+
+
+bool ParallelMarker::CanMarkInParallel() {
+  // Object statistics are collected by a different marking visitor table.
+  return FLAG_parallel_marking && !FLAG_track_gc_object_stats;
+}
+
+
+void ParallelMarker::SetUp() {
+  if (number_of_tasks_ > 0) return;
+  number_of_tasks_ = 1 + Min(Max(FLAG_marker_threads, 0), kMaxTasks - 1);
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i] = new MarkingTask(this, i);
+    if (i > 0) {
+      threads_[i] = new GCHelperThread(
+          heap_->isolate(), "MarkerThread", this, i);
+      threads_[i]->Start();
+    }
+  }
+  work_list_.SetUp(number_of_tasks_);
+}
+
+
+void ParallelMarker::EmptyMarkingDeque() {
+  SetUp();
+  MarkingDeque* marking_deque = &collector_->marking_deque_;
+  while (!marking_deque->IsEmpty()) {
+    // The work lists of the tasks together hold about as many objects as
+    // the marking deque.
+    work_list_.set_available_segments(
+        (marking_deque->mask() + 1) / kSegmentCapacity);
+    overflowed_ = false;
+    DistributeMarkingDeque();
+    MarkInParallel();
+    if (overflowed_) marking_deque->SetOverflowed();
+    ProcessDeferredWork();
+  }
+}
+
+
+void ParallelMarker::DistributeMarkingDeque() {
+  MarkingDeque* marking_deque = &collector_->marking_deque_;
+  int task = 0;
+  while (!marking_deque->IsEmpty()) {
+    // The segment budget covers the whole marking deque.
+    bool success = work_list_.Push(task, marking_deque->Pop());
+    ASSERT(success);
+    USE(success);
+    task = (task + 1) % number_of_tasks_;
+  }
+}
+
+
+void ParallelMarker::MarkInParallel() {
+  work_list_.StartPhase();
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads_[i]->StartTask();
+  }
+  tasks_[0]->Run();
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads_[i]->WaitForTask();
+  }
+  ASSERT(work_list_.IsEmpty());
+}
+
+
+void ParallelMarker::ProcessDeferredWork() {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i]->ProcessDeferredWork();
+  }
+}
+
+
+void ParallelMarker::RunTask(int task_id) {
+  ASSERT(task_id > 0 && task_id < number_of_tasks_);
+  tasks_[task_id]->Run();
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,120 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_PARALLEL_MARKER_H_
+#define V8_PARALLEL_MARKER_H_
+
+#include "atomicops.h"
+#include "gc-helper-thread.h"
+#include "platform.h"
+#include "work-stealing-list.h"
+
+namespace v8 {
+namespace internal {
+
+class Heap;
+class HeapObject;
+class MarkCompactCollector;
+class MarkingTask;
+
+// The parallel marker empties the marking deque of the mark-compact
+// collector using the main thread and a number of helper threads.  Objects
+// are claimed by atomically setting their mark bit and pushed onto the
+// work list of the claiming task.  Tasks publish segments of their work
+// lists when other tasks are idle, and idle tasks steal them.
+//
+// The tasks only visit objects whose bodies are plain ranges of tagged
+// fields.  Maps, code, functions, shared function infos, regexps, global
+// contexts, weak maps and sliced strings need the special treatment of the
+// sequential marking visitor; they are deferred to the main thread, which visits them
+// between parallel phases.  Slots pointing to evacuation candidates are
+// collected by the tasks and recorded by the main thread as well, so that
+// slots buffer overflows evict candidates as usual.
+//
+// When the work lists of the tasks run out of space the object is turned
+// grey and the overflow flag of the collector's marking deque is set.  The
+// collector rediscovers grey objects when it refills its marking deque.
+class ParallelMarker : public GCHelperThread::Task {
+ public:
+  static const int kMaxTasks = 16;
+
+  explicit ParallelMarker(MarkCompactCollector* collector);
+  ~ParallelMarker();
+
+  // Returns whether the marking deque of the collector can be emptied in
+  // parallel.
+  static bool CanMarkInParallel();
+
+  // Marks all objects reachable from the objects on the collector's
+  // marking deque.  Afterwards the marking deque is empty, but there may be
+  // overflowed objects left in the heap.
+  void EmptyMarkingDeque();
+
+  // Entry point of the marking tasks run by the helper threads.
+  virtual void RunTask(int task_id);
+
+  MarkCompactCollector* collector() { return collector_; }
+  Heap* heap() { return heap_; }
+  int number_of_tasks() { return number_of_tasks_; }
+
+ private:
+  static const int kSegmentCapacity = 256;
+  typedef WorkStealingList<HeapObject*, kSegmentCapacity> WorkList;
+
+  // Starts the helper threads when they are needed for the first time.
+  void SetUp();
+
+  // Moves the contents of the collector's marking deque to the tasks.
+  void DistributeMarkingDeque();
+
+  void MarkInParallel();
+
+  // Records the collected slots, marks the deferred maps and visits the
+  // deferred objects on the main thread.
+  void ProcessDeferredWork();
+
+  MarkCompactCollector* collector_;
+  Heap* heap_;
+  int number_of_tasks_;
+  MarkingTask* tasks_[kMaxTasks];
+  GCHelperThread* threads_[kMaxTasks];
+
+  // Black objects whose bodies still have to be visited.  The number of
+  // segments is bounded by the capacity of the collector's marking deque.
+  WorkList work_list_;
+
+  // Set by a task that had to leave a grey object in the heap.
+  volatile AtomicWord overflowed_;
+
+  friend class MarkingTask;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMarker);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_PARALLEL_MARKER_H_
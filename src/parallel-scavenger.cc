@@ -0,0 +1,516 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "v8.h"
+
+#include "heap-profiler.h"
+#include "parallel-scavenger.h"
+#include "work-stealing-list-inl.h"
+
+namespace v8 {
+namespace internal {
+
+
+// The state of one scavenging task.  Task 0 is run by the main thread, the
+// other tasks by the helper threads of the parallel scavenger.
+class ScavengeTask : public Malloced {
+ public:
+  ScavengeTask(ParallelScavenger* scavenger, int id);
+
+  void Prepare();
+  void Run();
+  void Finish();
+
+  // Returns the new location of |object|, copying it first if no other task
+  // has claimed it yet.
+  HeapObject* Evacuate(HeapObject* object);
+
+ private:
+  static const int kNewSpaceBufferSize = 4 * KB;
+  static const int kOldSpaceBufferSize = 8 * KB;
+  static const int kSlotsPerChunk = 128;
+
+  // The map word of an object that is being copied by some task.  It has
+  // the tag of a forwarding address but is never a valid one.
+  static const AtomicWord kEvacuationInProgress = 0;
+
+  HeapObject* CopyObject(HeapObject* object, Map* map);
+  HeapObject* AllocateInNewSpace(int size);
+  HeapObject* AllocateInOldSpace(bool is_data, int size);
+  HeapObject* AllocateInOldSpaceOrDie(bool is_data, int size);
+  void CloseBuffer(AllocationInfo* buffer, PagedSpace* space);
+
+  void ScavengeBody(HeapObject* object, int size);
+  void ScavengeSlot(Object** slot);
+  bool ScavengeSlots();
+
+  void Push(HeapObject* object, int size);
+  bool Steal();
+
+  ParallelScavenger* scavenger_;
+  Heap* heap_;
+  int id_;
+
+  AllocationInfo new_space_buffer_;
+  AllocationInfo old_pointer_buffer_;
+  AllocationInfo old_data_buffer_;
+
+  // Slots of promoted objects that point to new space.  They are entered
+  // into the store buffer once all tasks are done.
+  List<Address> promoted_slots_;
+
+  intptr_t copied_bytes_;
+  intptr_t promoted_bytes_;
+  int stolen_segments_;
+  double time_;
+};
+
+
+ScavengeTask::ScavengeTask(ParallelScavenger* scavenger, int id)
+    : scavenger_(scavenger),
+      heap_(scavenger->heap()),
+      id_(id),
+      copied_bytes_(0),
+      promoted_bytes_(0),
+      stolen_segments_(0),
+      time_(0.0) {
+}
+
+
+void ScavengeTask::Prepare() {
+  new_space_buffer_.top = new_space_buffer_.limit = NULL;
+  old_pointer_buffer_.top = old_pointer_buffer_.limit = NULL;
+  old_data_buffer_.top = old_data_buffer_.limit = NULL;
+  promoted_slots_.Rewind(0);
+  copied_bytes_ = 0;
+  promoted_bytes_ = 0;
+  stolen_segments_ = 0;
+  time_ = 0.0;
+}
+
+
+void ScavengeTask::Run() {
+  double start_time = OS::TimeCurrentMillis();
+  ParallelScavenger::WorkList* work_list = &scavenger_->work_list_;
+  ParallelScavenger::WorkEntry entry;
+  do {
+    do {
+      while (work_list->Pop(id_, &entry)) {
+        ScavengeBody(entry.object, entry.size);
+      }
+    } while (ScavengeSlots() || Steal());
+  } while (work_list->WaitForWork());
+  time_ += OS::TimeCurrentMillis() - start_time;
+}
+
+
+void ScavengeTask::Finish() {
+  if (new_space_buffer_.top != new_space_buffer_.limit) {
+    heap_->CreateFillerObjectAt(
+        new_space_buffer_.top,
+        static_cast<int>(new_space_buffer_.limit - new_space_buffer_.top));
+  }
+  CloseBuffer(&old_pointer_buffer_, heap_->old_pointer_space());
+  CloseBuffer(&old_data_buffer_, heap_->old_data_space());
+
+  StoreBuffer* store_buffer = heap_->store_buffer();
+  for (int i = 0; i < promoted_slots_.length(); i++) {
+    Address slot = promoted_slots_[i];
+    // The slot may have been updated by a task that found it in the store
+    // buffer after this task recorded it.
+    if (heap_->InNewSpace(*reinterpret_cast<Object**>(slot))) {
+      store_buffer->EnterDirectlyIntoStoreBuffer(slot);
+    }
+  }
+  promoted_slots_.Rewind(0);
+
+  heap_->tracer()->increment_promoted_objects_size(
+      static_cast<int>(promoted_bytes_));
+  heap_->tracer()->set_scavenge_task_time(id_, time_);
+
+  if (FLAG_trace_parallel_scavenge) {
+    PrintF("Parallel scavenge task %d: %.1f ms, "
+           "copied %" V8_PTR_PREFIX "d bytes, "
+           "promoted %" V8_PTR_PREFIX "d bytes, "
+           "stole %d segments\n",
+           id_, time_, copied_bytes_, promoted_bytes_, stolen_segments_);
+  }
+}
+
+
+HeapObject* ScavengeTask::Evacuate(HeapObject* object) {
+  ASSERT(heap_->InFromSpace(object));
+  volatile AtomicWord* map_slot =
+      reinterpret_cast<volatile AtomicWord*>(object->address());
+  while (true) {
+    AtomicWord value = Acquire_Load(map_slot);
+    MapWord map_word = MapWord::FromRawValue(static_cast<uintptr_t>(value));
+    if (map_word.IsForwardingAddress()) {
+      if (value != kEvacuationInProgress) {
+        return map_word.ToForwardingAddress();
+      }
+      // Another task is copying the object.
+      Thread::YieldCPU();
+    } else if (Acquire_CompareAndSwap(map_slot,
+                                      value,
+                                      kEvacuationInProgress) == value) {
+      HeapObject* target = CopyObject(object, map_word.ToMap());
+      Release_Store(map_slot, static_cast<AtomicWord>(
+          MapWord::FromForwardingAddress(target).ToRawValue()));
+      return target;
+    }
+  }
+}
+
+
+HeapObject* ScavengeTask::CopyObject(HeapObject* object, Map* map) {
+  int object_size = object->SizeFromMap(map);
+  InstanceType type = map->instance_type();
+  bool is_data = heap_->TargetSpaceId(type) == OLD_DATA_SPACE;
+
+  int allocation_size = object_size;
+  bool needs_double_alignment =
+      kDoubleAlignment != kObjectAlignment && type == FIXED_DOUBLE_ARRAY_TYPE;
+  if (needs_double_alignment) allocation_size += kPointerSize;
+
+  if (!is_data) heap_->UpdateAllocationSiteFeedback(object, object_size);
+
+  HeapObject* target = NULL;
+  bool promoted = false;
+  if (heap_->ShouldBePromoted(object->address(), object_size)) {
+    target = AllocateInOldSpace(is_data, allocation_size);
+    promoted = target != NULL;
+  }
+  if (target == NULL) {
+    target = AllocateInNewSpace(allocation_size);
+  }
+  if (target == NULL) {
+    // To-space is exhausted by the fragmentation of the allocation buffers.
+    target = AllocateInOldSpaceOrDie(is_data, allocation_size);
+    promoted = true;
+  }
+
+  if (needs_double_alignment) {
+    target = heap_->EnsureDoubleAligned(target, allocation_size);
+  }
+
+  // Copy everything but the map word, which holds the in-progress marker.
+  heap_->CopyBlock(target->address() + kPointerSize,
+                   object->address() + kPointerSize,
+                   object_size - kPointerSize);
+  target->set_map_no_write_barrier(map);
+
+  if (promoted) {
+    promoted_bytes_ += object_size;
+  } else {
+    copied_bytes_ += object_size;
+  }
+
+  if (!is_data) {
+    if (type == JS_FUNCTION_TYPE) {
+      Push(target, JSFunction::kNonWeakFieldsEndOffset);
+    } else {
+      Push(target, object_size);
+    }
+  }
+  return target;
+}
+
+
+HeapObject* ScavengeTask::AllocateInNewSpace(int size) {
+  AllocationInfo* buffer = &new_space_buffer_;
+  if (buffer->limit - buffer->top < size) {
+    NewSpace* new_space = heap_->new_space();
+    ScopedLock lock(scavenger_->allocation_mutex_);
+    if (size > kNewSpaceBufferSize / 4) {
+      Object* result;
+      if (!new_space->AllocateRaw(size)->ToObject(&result)) return NULL;
+      return HeapObject::cast(result);
+    }
+    if (buffer->top != buffer->limit) {
+      heap_->CreateFillerObjectAt(
+          buffer->top, static_cast<int>(buffer->limit - buffer->top));
+    }
+    buffer->top = buffer->limit = NULL;
+    Object* result;
+    if (!new_space->AllocateRaw(kNewSpaceBufferSize)->ToObject(&result)) {
+      // Fall back to an exact allocation for the rest of to-space.
+      if (!new_space->AllocateRaw(size)->ToObject(&result)) return NULL;
+      return HeapObject::cast(result);
+    }
+    buffer->top = HeapObject::cast(result)->address();
+    buffer->limit = buffer->top + kNewSpaceBufferSize;
+  }
+  Address result = buffer->top;
+  buffer->top += size;
+  return HeapObject::FromAddress(result);
+}
+
+
+HeapObject* ScavengeTask::AllocateInOldSpace(bool is_data, int size) {
+  AllocationInfo* buffer = is_data ? &old_data_buffer_ : &old_pointer_buffer_;
+  if (buffer->limit - buffer->top < size) {
+    ScopedLock lock(scavenger_->allocation_mutex_);
+    Object* result;
+    if (size > Page::kMaxNonCodeHeapObjectSize) {
+      if (!heap_->lo_space()->AllocateRaw(size, NOT_EXECUTABLE)->
+              ToObject(&result)) {
+        return NULL;
+      }
+      return HeapObject::cast(result);
+    }
+    PagedSpace* space = is_data
+        ? static_cast<PagedSpace*>(heap_->old_data_space())
+        : static_cast<PagedSpace*>(heap_->old_pointer_space());
+    if (size > kOldSpaceBufferSize / 4) {
+      if (!space->AllocateRaw(size)->ToObject(&result)) return NULL;
+      return HeapObject::cast(result);
+    }
+    CloseBuffer(buffer, space);
+    if (!space->AllocateRaw(kOldSpaceBufferSize)->ToObject(&result)) {
+      if (!space->AllocateRaw(size)->ToObject(&result)) return NULL;
+      return HeapObject::cast(result);
+    }
+    buffer->top = HeapObject::cast(result)->address();
+    buffer->limit = buffer->top + kOldSpaceBufferSize;
+  }
+  Address result = buffer->top;
+  buffer->top += size;
+  return HeapObject::FromAddress(result);
+}
+
+
+HeapObject* ScavengeTask::AllocateInOldSpaceOrDie(bool is_data, int size) {
+  {
+    ScopedLock lock(scavenger_->allocation_mutex_);
+    heap_->always_allocate_scope_depth_++;
+  }
+  HeapObject* result = AllocateInOldSpace(is_data, size);
+  {
+    ScopedLock lock(scavenger_->allocation_mutex_);
+    heap_->always_allocate_scope_depth_--;
+  }
+  if (result == NULL) {
+    V8::FatalProcessOutOfMemory("ParallelScavenger::AllocateInOldSpace");
+  }
+  return result;
+}
+
+
+void ScavengeTask::CloseBuffer(AllocationInfo* buffer, PagedSpace* space) {
+  if (buffer->top != buffer->limit) {
+    space->Free(buffer->top, static_cast<int>(buffer->limit - buffer->top));
+  }
+  buffer->top = buffer->limit = NULL;
+}
+
+
+void ScavengeTask::ScavengeBody(HeapObject* object, int size) {
+  // Promoted objects can be allocated over dead objects whose fields are
+  // still recorded in the store buffer, so we look for pointers to from-space
+  // instead of pointers to new space.
+  bool record_slots = !heap_->InNewSpace(object);
+  Object** code_entry_slot = NULL;
+  if (object->map()->instance_type() == JS_FUNCTION_TYPE) {
+    code_entry_slot =
+        HeapObject::RawField(object, JSFunction::kCodeEntryOffset);
+  }
+  Object** end = HeapObject::RawField(object, size);
+  for (Object** slot = HeapObject::RawField(object, kPointerSize);
+       slot < end;
+       slot++) {
+    if (slot == code_entry_slot) continue;
+    Object* value = *slot;
+    if (!value->IsHeapObject()) continue;
+    if (heap_->InFromSpace(value)) {
+      value = Evacuate(HeapObject::cast(value));
+      *slot = value;
+    }
+    if (record_slots && heap_->InNewSpace(value)) {
+      promoted_slots_.Add(reinterpret_cast<Address>(slot));
+    }
+  }
+}
+
+
+void ScavengeTask::ScavengeSlot(Object** slot) {
+  Object* value = *slot;
+  if (!value->IsHeapObject() || !heap_->InFromSpace(value)) return;
+  HeapObject* target = Evacuate(HeapObject::cast(value));
+  // Recorded slots can be overwritten by objects promoted into dead memory
+  // while we are copying, so only update the slot if it is unchanged.
+  Release_CompareAndSwap(reinterpret_cast<volatile AtomicWord*>(slot),
+                         reinterpret_cast<AtomicWord>(value),
+                         reinterpret_cast<AtomicWord>(target));
+}
+
+
+bool ScavengeTask::ScavengeSlots() {
+  List<Object**>* slots = &scavenger_->slots_;
+  intptr_t end = Barrier_AtomicIncrement(&scavenger_->next_slot_,
+                                         kSlotsPerChunk);
+  intptr_t start = end - kSlotsPerChunk;
+  if (start >= slots->length()) return false;
+  end = Min(end, static_cast<intptr_t>(slots->length()));
+  for (intptr_t i = start; i < end; i++) {
+    ScavengeSlot(slots->at(static_cast<int>(i)));
+  }
+  return true;
+}
+
+
+void ScavengeTask::Push(HeapObject* object, int size) {
+  ParallelScavenger::WorkEntry entry = { object, size };
+  // The work list of the scavenger is unbounded.
+  bool success = scavenger_->work_list_.Push(id_, entry);
+  ASSERT(success);
+  USE(success);
+}
+
+
+bool ScavengeTask::Steal() {
+  if (!scavenger_->work_list_.Steal(id_)) return false;
+  stolen_segments_++;
+  return true;
+}
+
+
+STATIC_ASSERT(ParallelScavenger::kMaxTasks == GCTracer::kMaxScavengeTasks);
+
+
+ParallelScavenger::ParallelScavenger(Heap* heap)
+    : heap_(heap),
+      number_of_tasks_(0),
+      allocation_mutex_(OS::CreateMutex()),
+      slots_(0),
+      next_slot_(0) {
+  for (int i = 0; i < kMaxTasks; i++) {
+    tasks_[i] = NULL;
+    threads_[i] = NULL;
+  }
+}
+
+
+ParallelScavenger::~ParallelScavenger() {
+  TearDown();
+  delete allocation_mutex_;
+}
+
+
+void ParallelScavenger::TearDown() {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    if (threads_[i] != NULL) {
+      threads_[i]->Stop();
+      delete threads_[i];
+      threads_[i] = NULL;
+    }
+    delete tasks_[i];
+    tasks_[i] = NULL;
+  }
+  work_list_.TearDown();
+  number_of_tasks_ = 0;
+}
+
+
+bool ParallelScavenger::CanScavengeInParallel() {
+  if (!FLAG_parallel_scavenge) return false;
+  if (heap_->incremental_marking()->IsMarking()) return false;
+  bool record_copied_objects = FLAG_log_gc;
+#ifdef DEBUG
+  record_copied_objects = record_copied_objects || FLAG_heap_stats;
+#endif
+  if (record_copied_objects) return false;
+  Isolate* isolate = heap_->isolate();
+  return !isolate->logger()->is_logging() &&
+         !CpuProfiler::is_profiling(isolate) &&
+         (isolate->heap_profiler() == NULL ||
+          !isolate->heap_profiler()->is_profiling());
+}
+
+
+void ParallelScavenger::Prepare() {
+  if (number_of_tasks_ == 0) {
+    number_of_tasks_ = 1 + Min(Max(FLAG_scavenger_threads, 0), kMaxTasks - 1);
+    for (int i = 0; i < number_of_tasks_; i++) {
+      tasks_[i] = new ScavengeTask(this, i);
+      if (i > 0) {
+        threads_[i] = new GCHelperThread(
+            heap_->isolate(), "ScavengerThread", this, i);
+        threads_[i]->Start();
+      }
+    }
+    work_list_.SetUp(number_of_tasks_);
+  }
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i]->Prepare();
+  }
+  slots_.Rewind(0);
+}
+
+
+void ParallelScavenger::ScavengePointer(Object** p) {
+  Object* object = *p;
+  if (!heap_->InFromSpace(object)) return;
+  *p = tasks_[0]->Evacuate(HeapObject::cast(object));
+}
+
+
+void ParallelScavenger::RecordStoreBufferSlot(HeapObject** slot,
+                                              HeapObject* object) {
+  object->GetHeap()->parallel_scavenger()->RecordSlot(
+      reinterpret_cast<Object**>(slot));
+}
+
+
+void ParallelScavenger::ScavengeInParallel() {
+  next_slot_ = 0;
+  work_list_.StartPhase();
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads_[i]->StartTask();
+  }
+  tasks_[0]->Run();
+  for (int i = 1; i < number_of_tasks_; i++) {
+    threads_[i]->WaitForTask();
+  }
+  ASSERT(work_list_.IsEmpty());
+  slots_.Rewind(0);
+}
+
+
+void ParallelScavenger::Finish() {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    tasks_[i]->Finish();
+  }
+}
+
+
+void ParallelScavenger::RunTask(int task_id) {
+  ASSERT(task_id > 0 && task_id < number_of_tasks_);
+  tasks_[task_id]->Run();
+}
+
+} }  // namespace v8::internal
@@ -0,0 +1,149 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_PARALLEL_SCAVENGER_H_
+#define V8_PARALLEL_SCAVENGER_H_
+
+#include "atomicops.h"
+#include "gc-helper-thread.h"
+#include "list.h"
+#include "platform.h"
+#include "work-stealing-list.h"
+
+namespace v8 {
+namespace internal {
+
+class Heap;
+class HeapObject;
+class ScavengeTask;
+
+// The parallel scavenger evacuates the live objects of new space using the
+// main thread and a number of helper threads.  Objects are claimed by
+// atomically replacing their map word, copied into task-local allocation
+// buffers in to-space or the old generation and pushed onto task-local
+// work lists.  Idle tasks steal work published by the other tasks.
+//
+// The parallel scavenger does not support transferring incremental marks,
+// logging or profiling of moved objects; the heap falls back to the
+// sequential scavenger whenever one of them is needed.
+class ParallelScavenger : public GCHelperThread::Task {
+ public:
+  static const int kMaxTasks = 16;
+
+  explicit ParallelScavenger(Heap* heap);
+  ~ParallelScavenger();
+
+  // Stops the helper threads.
+  void TearDown();
+
+  // Returns whether the next scavenge can be done by the parallel scavenger.
+  bool CanScavengeInParallel();
+
+  // Sets up the tasks for a new scavenge.  Starts the helper threads when
+  // they are needed for the first time.
+  void Prepare();
+
+  // Copies the object referenced by a root slot on the main thread and
+  // updates the slot.  Root slots may be temporaries of the code that visits
+  // them, so they cannot be deferred to the scavenging tasks.
+  void ScavengePointer(Object** p);
+
+  // Records a slot of the old generation that points into from-space.  The
+  // slot is updated by one of the scavenging tasks.
+  void RecordSlot(Object** slot) { slots_.Add(slot); }
+
+  // Store buffer callback recording the slot in the parallel scavenger of
+  // the heap owning |object|.
+  static void RecordStoreBufferSlot(HeapObject** slot, HeapObject* object);
+
+  // Runs the scavenging tasks until all objects reachable from the roots
+  // and the recorded slots have been evacuated.
+  void ScavengeInParallel();
+
+  // Releases the unused parts of the allocation buffers and enters the
+  // old-to-new slots found in promoted objects into the store buffer.  Must
+  // be called within a store buffer rebuild scope.
+  void Finish();
+
+  // Entry point of the scavenging tasks run by the helper threads.
+  virtual void RunTask(int task_id);
+
+  Heap* heap() { return heap_; }
+  int number_of_tasks() { return number_of_tasks_; }
+
+ private:
+  // An object that still has to be scanned and the size of its body.
+  struct WorkEntry {
+    HeapObject* object;
+    int size;
+  };
+
+  static const int kSegmentCapacity = 64;
+  typedef WorkStealingList<WorkEntry, kSegmentCapacity> WorkList;
+
+  Heap* heap_;
+  int number_of_tasks_;
+  ScavengeTask* tasks_[kMaxTasks];
+  GCHelperThread* threads_[kMaxTasks];
+
+  // Serializes allocation in the spaces of the heap.
+  Mutex* allocation_mutex_;
+
+  // Slots recorded by the main thread and the index of the next unclaimed
+  // chunk of slots.
+  List<Object**> slots_;
+  volatile AtomicWord next_slot_;
+
+  // Copied objects that still have to be scanned.
+  WorkList work_list_;
+
+  friend class ScavengeTask;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelScavenger);
+};
+
+
+// Visitor copying the objects referenced by root slots with the parallel
+// scavenger.
+class ParallelScavengeVisitor: public ObjectVisitor {
+ public:
+  explicit ParallelScavengeVisitor(ParallelScavenger* scavenger)
+      : scavenger_(scavenger) { }
+
+  void VisitPointer(Object** p) { scavenger_->ScavengePointer(p); }
+
+  void VisitPointers(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) scavenger_->ScavengePointer(p);
+  }
+
+ private:
+  ParallelScavenger* scavenger_;
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_PARALLEL_SCAVENGER_H_
@@ -550,6 +550,7 @@ Parser::Parser(CompilationInfo* info,
       allow_natives_syntax_((parser_flags & kAllowNativesSyntax) != 0),
       allow_lazy_((parser_flags & kAllowLazy) != 0),
       allow_modules_((parser_flags & kAllowModules) != 0),
+      allow_allocation_sites_((parser_flags & kAllowAllocationSites) != 0),
       stack_overflow_(false),
       parenthesized_function_(false),
       zone_(info->zone()),
@@ -3815,8 +3816,12 @@ Expression* Parser::ParseArrayLiteral(bool* ok) {
   }
   Expect(Token::RBRACK, CHECK_OK);
 
-  // Update the scope information before the pre-parsing bailout.
+  // Update the scope information before the pre-parsing bailout.  The slot
+  // after the boilerplate holds the literal's allocation site.
   int literal_index = current_function_state_->NextMaterializedLiteralIndex();
+  if (allow_allocation_sites_) {
+    current_function_state_->NextMaterializedLiteralIndex();
+  }
 
   // Allocate a fixed array to hold all the object literals.
   Handle<FixedArray> object_literals =
@@ -4294,8 +4299,12 @@ Expression* Parser::ParseObjectLiteral(bool* ok) {
   }
   Expect(Token::RBRACE, CHECK_OK);
 
-  // Computation of literal_index must happen before pre parse bailout.
+  // Computation of literal_index must happen before pre parse bailout.  The
+  // slot after the boilerplate holds the literal's allocation site.
   int literal_index = current_function_state_->NextMaterializedLiteralIndex();
+  if (allow_allocation_sites_) {
+    current_function_state_->NextMaterializedLiteralIndex();
+  }
 
   Handle<FixedArray> constant_properties = isolate()->factory()->NewFixedArray(
       number_of_boilerplate_properties * 2, TENURED);
@@ -4491,6 +4500,13 @@ FunctionLiteral* Parser::ParseFunctionLiteral(Handle<String> function_name,
   // Parse function body.
   { FunctionState function_state(this, scope, isolate());
     top_scope_->SetScopeName(function_name);
+    // The allocation site of the objects constructed by the function comes
+    // first.
+    if (allow_allocation_sites_) {
+      int site_index = function_state.NextMaterializedLiteralIndex();
+      ASSERT_EQ(JSFunction::kLiteralAllocationSiteIndex, site_index);
+      USE(site_index);
+    }
 
     //  FormalParameterList ::
     //    '(' (Identifier)*[','] ')'
@@ -4747,7 +4763,8 @@ preparser::PreParser::PreParseResult Parser::LazyParseFunctionLiteral(
                                                    stack_limit,
                                                    do_allow_lazy,
                                                    allow_natives_syntax_,
-                                                   allow_modules_);
+                                                   allow_modules_,
+                                                   allow_allocation_sites_);
   }
   preparser::PreParser::PreParseResult result =
       reusable_preparser_->PreParseLazyFunction(top_scope_->language_mode(),
@@ -6052,6 +6069,11 @@ bool ParserApi::Parse(CompilationInfo* info, int parsing_flags) {
     // We require %identifier(..) syntax.
     parsing_flags |= kAllowNativesSyntax;
   }
+  if (AllocationSite::CanTrack() || info->is_native()) {
+    // Natives always have the slots, so that natives from a snapshot taken
+    // without allocation site tracking can be used with it.
+    parsing_flags |= kAllowAllocationSites;
+  }
   if (info->is_lazy()) {
     ASSERT(!info->is_eval());
     Parser parser(info, parsing_flags, NULL, NULL);
@@ -6062,7 +6084,13 @@ bool ParserApi::Parse(CompilationInfo* info, int parsing_flags) {
     }
   } else {
     ScriptDataImpl* pre_data = info->pre_parse_data();
-    Parser parser(info, parsing_flags, info->extension(), pre_data);
+    // The literal counts of pre-parse data from the API may not include the
+    // allocation site slots, so only its error message is used then.
+    Parser parser(info,
+                  parsing_flags,
+                  info->extension(),
+                  (parsing_flags & kAllowAllocationSites) != 0 ? NULL
+                                                                : pre_data);
     if (pre_data != NULL && pre_data->has_error()) {
       Scanner::Location loc = pre_data->MessageLocation();
       const char* message = pre_data->BuildMessage();
@@ -825,6 +825,10 @@ class Parser {
   bool allow_natives_syntax_;
   bool allow_lazy_;
   bool allow_modules_;
+  // Reserve literal slots for allocation sites: one after the boilerplate
+  // of each object and array literal and one for the objects constructed
+  // by each function.
+  bool allow_allocation_sites_;
   bool stack_overflow_;
   // If true, the next (and immediately following) function literal is
   // preceded by a parenthesis.
@@ -93,6 +93,68 @@ void OS::Guard(void* address, const size_t size) {
 #endif  // __CYGWIN__
 
 
+bool VirtualMemory::DiscardRegion(void* base, size_t size) {
+#ifdef MADV_FREE
+  // Lets the kernel reclaim the pages only when it runs short of memory.
+  int advice = MADV_FREE;
+#else
+  int advice = MADV_DONTNEED;
+#endif
+  return madvise(base, size, advice) == 0;
+}
+
+
+bool VirtualMemory::HasHugePages() {
+#ifdef MADV_HUGEPAGE
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+bool VirtualMemory::AdviseHugePages(void* base, size_t size) {
+#ifdef MADV_HUGEPAGE
+  return madvise(base, size, MADV_HUGEPAGE) == 0;
+#else
+  return false;
+#endif
+}
+
+
+intptr_t VirtualMemory::HugePageBytes(void* base, size_t size) {
+#ifdef MADV_HUGEPAGE
+  // /proc/self/smaps lists each mapping followed by its statistics, one
+  // "Name: value kB" line each.  Mappings that only partly overlap the
+  // region are counted up to the size of the overlap.
+  FILE* fp = fopen("/proc/self/smaps", "r");
+  if (fp == NULL) return -1;
+  uintptr_t region_start = reinterpret_cast<uintptr_t>(base);
+  uintptr_t region_end = region_start + size;
+  uintptr_t overlap = 0;
+  intptr_t result = 0;
+  char line[1024];
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    uintptr_t start, end;
+    intptr_t kilobytes;
+    if (sscanf(line, "%" V8PRIxPTR "-%" V8PRIxPTR, &start, &end) == 2) {
+      start = Max(start, region_start);
+      end = Min(end, region_end);
+      overlap = (start < end) ? end - start : 0;
+    } else if (sscanf(line, "AnonHugePages: %" V8PRIdPTR " kB",
+                      &kilobytes) == 1) {
+      result += static_cast<intptr_t>(
+          Min(static_cast<uintptr_t>(kilobytes) * KB, overlap));
+    }
+  }
+  fclose(fp);
+  return result;
+#else
+  return -1;
+#endif
+}
+
+
 void* OS::GetRandomMmapAddr() {
   Isolate* isolate = Isolate::UncheckedCurrent();
   // Note that the current isolate isn't set up in a call path via
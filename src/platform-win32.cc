@@ -1551,6 +1551,28 @@ bool VirtualMemory::ReleaseRegion(void* base, size_t size) {
 }
 
 
+bool VirtualMemory::HasHugePages() {
+  // Large pages on Windows have to be locked in memory; there are no
+  // transparent huge pages.
+  return false;
+}
+
+
+bool VirtualMemory::AdviseHugePages(void* base, size_t size) {
+  return false;
+}
+
+
+intptr_t VirtualMemory::HugePageBytes(void* base, size_t size) {
+  return -1;
+}
+
+
+bool VirtualMemory::DiscardRegion(void* base, size_t size) {
+  return VirtualAlloc(base, size, MEM_RESET, PAGE_READWRITE) != NULL;
+}
+
+
 // ----------------------------------------------------------------------------
 // Win32 thread support.
 
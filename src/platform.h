@@ -388,6 +388,17 @@ class VirtualMemory {
     ASSERT(result);
   }
 
+  // Moves the part of the reserved region from offset on to a different,
+  // unused VirtualMemory object.  Releasing part of a reservation is not
+  // supported on Windows, so only use this together with huge pages.
+  void Split(size_t offset, VirtualMemory* upper) {
+    ASSERT(IsReserved() && !upper->IsReserved());
+    ASSERT(offset > 0 && offset < size_);
+    upper->address_ = static_cast<char*>(address_) + offset;
+    upper->size_ = size_ - offset;
+    size_ = offset;
+  }
+
   // Assign control of the reserved region to a different VirtualMemory object.
   // The old object is no longer functional (IsReserved() returns false).
   void TakeControl(VirtualMemory* from) {
@@ -403,6 +414,25 @@ class VirtualMemory {
 
   static bool UncommitRegion(void* base, size_t size);
 
+  // Size and alignment of the huge pages that AdviseHugePages asks for.
+  static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+  // Returns whether the OS can back memory with transparent huge pages.
+  static bool HasHugePages();
+
+  // Asks the OS to back committed memory with huge pages where the memory
+  // covers whole, aligned huge pages.
+  static bool AdviseHugePages(void* base, size_t size);
+
+  // Returns how many bytes of the region are currently backed by huge pages,
+  // or -1 if the OS does not tell.
+  static intptr_t HugePageBytes(void* base, size_t size);
+
+  // Tells the OS that the contents of committed memory are no longer needed.
+  // The memory stays committed but the OS may reclaim its physical pages,
+  // after which it reads as zero or as its old contents.
+  static bool DiscardRegion(void* base, size_t size);
+
   // Must be called with a base pointer that has been returned by ReserveRegion
   // and the same size it was reserved with.
   static bool ReleaseRegion(void* base, size_t size);
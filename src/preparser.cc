@@ -59,6 +59,8 @@ PreParser::PreParseResult PreParser::PreParseLazyFunction(
   Scope top_scope(&scope_, kTopLevelScope);
   set_language_mode(mode);
   Scope function_scope(&scope_, kFunctionScope);
+  // Reserve the allocation site slot of the function, like the parser.
+  if (allow_allocation_sites_) function_scope.NextMaterializedLiteralIndex();
   ASSERT_EQ(i::Token::LBRACE, scanner_->current_token());
   bool ok = true;
   int start_position = scanner_->peek_location().beg_pos;
@@ -1200,7 +1202,9 @@ PreParser::Expression PreParser::ParseArrayLiteral(bool* ok) {
   }
   Expect(i::Token::RBRACK, CHECK_OK);
 
+  // Reserve the boilerplate and allocation site slots, like the parser.
   scope_->NextMaterializedLiteralIndex();
+  if (allow_allocation_sites_) scope_->NextMaterializedLiteralIndex();
   return Expression::Default();
 }
 
@@ -1310,7 +1314,9 @@ PreParser::Expression PreParser::ParseObjectLiteral(bool* ok) {
   }
   Expect(i::Token::RBRACE, CHECK_OK);
 
+  // Reserve the boilerplate and allocation site slots, like the parser.
   scope_->NextMaterializedLiteralIndex();
+  if (allow_allocation_sites_) scope_->NextMaterializedLiteralIndex();
   return Expression::Default();
 }
 
@@ -1368,6 +1374,8 @@ PreParser::Expression PreParser::ParseFunctionLiteral(bool* ok) {
   ScopeType outer_scope_type = scope_->type();
   bool inside_with = scope_->IsInsideWith();
   Scope function_scope(&scope_, kFunctionScope);
+  // Reserve the allocation site slot of the function, like the parser.
+  if (allow_allocation_sites_) function_scope.NextMaterializedLiteralIndex();
   //  FormalParameterList ::
   //    '(' (Identifier)*[','] ')'
   Expect(i::Token::LPAREN, CHECK_OK);
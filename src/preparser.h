@@ -117,7 +117,8 @@ class PreParser {
             uintptr_t stack_limit,
             bool allow_lazy,
             bool allow_natives_syntax,
-            bool allow_modules)
+            bool allow_modules,
+            bool allow_allocation_sites)
       : scanner_(scanner),
         log_(log),
         scope_(NULL),
@@ -128,6 +129,7 @@ class PreParser {
         allow_lazy_(allow_lazy),
         allow_modules_(allow_modules),
         allow_natives_syntax_(allow_natives_syntax),
+        allow_allocation_sites_(allow_allocation_sites),
         parenthesized_function_(false),
         harmony_scoping_(scanner->HarmonyScoping()) { }
 
@@ -144,8 +146,10 @@ class PreParser {
     bool allow_lazy = (flags & i::kAllowLazy) != 0;
     bool allow_natives_syntax = (flags & i::kAllowNativesSyntax) != 0;
     bool allow_modules = (flags & i::kAllowModules) != 0;
+    bool allow_allocation_sites = (flags & i::kAllowAllocationSites) != 0;
     return PreParser(scanner, log, stack_limit, allow_lazy,
-                     allow_natives_syntax, allow_modules).PreParse();
+                     allow_natives_syntax, allow_modules,
+                     allow_allocation_sites).PreParse();
   }
 
   // Parses a single function literal, from the opening parentheses before
@@ -664,6 +668,8 @@ class PreParser {
   bool allow_lazy_;
   bool allow_modules_;
   bool allow_natives_syntax_;
+  // Reserve the literal slots of allocation sites, like the parser.
+  bool allow_allocation_sites_;
   bool parenthesized_function_;
   bool harmony_scoping_;
 };
@@ -111,12 +111,18 @@ class PropertyDetails BASE_EMBEDDED {
   bool IsDontEnum() { return (attributes() & DONT_ENUM) != 0; }
   bool IsDeleted() { return DeletedField::decode(value_) != 0;}
 
+  // A double field holds a heap number owned by the object that is updated
+  // in place and never handed out; see JSObject::CanUseDoubleFields.
+  bool IsDoubleField() { return DoubleField::decode(value_) != 0; }
+  inline PropertyDetails AsDoubleField();
+
   // Bit fields in value_ (type, shift, size). Must be public so the
   // constants can be embedded in generated code.
   class TypeField:       public BitField<PropertyType,       0, 3> {};
   class AttributesField: public BitField<PropertyAttributes, 3, 3> {};
   class DeletedField:    public BitField<uint32_t,           6, 1> {};
-  class StorageField:    public BitField<uint32_t,           7, 32-7> {};
+  class DoubleField:     public BitField<uint32_t,           7, 1> {};
+  class StorageField:    public BitField<uint32_t,           8, 32-8> {};
 
   static const int kInitialIndex = 1;
 
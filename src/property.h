@@ -66,7 +66,8 @@ class Descriptor BASE_EMBEDDED {
 
   void SetEnumerationIndex(int index) {
     ASSERT(PropertyDetails::IsValidIndex(index));
-    details_ = PropertyDetails(details_.attributes(), details_.type(), index);
+    PropertyDetails details(details_.attributes(), details_.type(), index);
+    details_ = details_.IsDoubleField() ? details.AsDoubleField() : details;
   }
 
  private:
@@ -88,6 +89,8 @@ class Descriptor BASE_EMBEDDED {
         value_(value),
         details_(details) { }
 
+  void set_details(PropertyDetails details) { details_ = details; }
+
   Descriptor(String* key,
              Object* value,
              PropertyAttributes attributes,
@@ -108,6 +111,8 @@ class FieldDescriptor: public Descriptor {
                   PropertyAttributes attributes,
                   int index = 0)
       : Descriptor(key, Smi::FromInt(field_index), attributes, FIELD, index) {}
+
+  void MarkAsDoubleField() { set_details(GetDetails().AsDoubleField()); }
 };
 
 
@@ -248,6 +253,10 @@ class LookupResult BASE_EMBEDDED {
     return details_.type() == FIELD;
   }
 
+  bool IsDoubleField() {
+    return IsField() && details_.IsDoubleField();
+  }
+
   bool IsNormal() {
     ASSERT(!(details_.type() == NORMAL && !IsFound()));
     return details_.type() == NORMAL;
@@ -161,10 +161,13 @@ void RuntimeProfiler::Optimize(JSFunction* function, const char* reason) {
 
 
 void RuntimeProfiler::AttemptOnStackReplacement(JSFunction* function) {
+  // Also called when the on-stack replacement code of a function has been
+  // compiled in parallel and installed.
+  ASSERT(function->IsMarkedForLazyRecompilation() ||
+         function->IsMarkedForParallelRecompilation() ||
+         function->IsOptimized());
   // See AlwaysFullCompiler (in compiler.cc) comment on why we need
   // Debug::has_break_points().
-  ASSERT(function->IsMarkedForLazyRecompilation() ||
-         function->IsMarkedForParallelRecompilation());
   if (!FLAG_use_osr ||
       isolate_->DebuggerHasBreakPoints() ||
       function->IsBuiltin()) {
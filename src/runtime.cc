@@ -136,17 +136,24 @@ namespace internal {
       static_cast<LanguageMode>(args.smi_at(index));
 
 
-MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
-                                                   JSObject* boilerplate) {
+// Copies the boilerplate and all objects nested in it.  Only the outermost
+// copy is tracked by the allocation site, but the nested copies follow its
+// pretenuring decision.
+MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(
+    Isolate* isolate,
+    JSObject* boilerplate,
+    AllocationSite* site = NULL) {
   StackLimitCheck check(isolate);
   if (check.HasOverflowed()) return isolate->StackOverflow();
 
   Heap* heap = isolate->heap();
   Object* result;
-  { MaybeObject* maybe_result = heap->CopyJSObject(boilerplate);
+  { MaybeObject* maybe_result = heap->CopyJSObject(boilerplate, site);
     if (!maybe_result->ToObject(&result)) return maybe_result;
   }
   JSObject* copy = JSObject::cast(result);
+  AllocationSite* nested_site =
+      (site != NULL && site->ShouldPretenure()) ? site : NULL;
 
   // Deep copy local properties.
   if (copy->HasFastProperties()) {
@@ -155,7 +162,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
       Object* value = properties->get(i);
       if (value->IsJSObject()) {
         JSObject* js_object = JSObject::cast(value);
-        { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate, js_object);
+        { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate, js_object,
+                                                          nested_site);
           if (!maybe_result->ToObject(&result)) return maybe_result;
         }
         properties->set(i, result);
@@ -166,7 +174,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
       Object* value = copy->InObjectPropertyAt(i);
       if (value->IsJSObject()) {
         JSObject* js_object = JSObject::cast(value);
-        { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate, js_object);
+        { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate, js_object,
+                                                          nested_site);
           if (!maybe_result->ToObject(&result)) return maybe_result;
         }
         copy->InObjectPropertyAtPut(i, result);
@@ -192,7 +201,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
           copy->GetProperty(key_string, &attributes)->ToObjectUnchecked();
       if (value->IsJSObject()) {
         JSObject* js_object = JSObject::cast(value);
-        { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate, js_object);
+        { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate, js_object,
+                                                          nested_site);
           if (!maybe_result->ToObject(&result)) return maybe_result;
         }
         { MaybeObject* maybe_result =
@@ -229,7 +239,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
           if (value->IsJSObject()) {
             JSObject* js_object = JSObject::cast(value);
             { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate,
-                                                              js_object);
+                                                              js_object,
+                                                              nested_site);
               if (!maybe_result->ToObject(&result)) return maybe_result;
             }
             elements->set(i, result);
@@ -248,7 +259,8 @@ MUST_USE_RESULT static MaybeObject* DeepCopyBoilerplate(Isolate* isolate,
           if (value->IsJSObject()) {
             JSObject* js_object = JSObject::cast(value);
             { MaybeObject* maybe_result = DeepCopyBoilerplate(isolate,
-                                                              js_object);
+                                                              js_object,
+                                                              nested_site);
               if (!maybe_result->ToObject(&result)) return maybe_result;
             }
             element_dictionary->ValueAtPut(i, result);
@@ -573,6 +585,22 @@ static Handle<Object> CreateLiteralBoilerplate(
 }
 
 
+Handle<AllocationSite> Runtime::GetLiteralAllocationSite(
+    Isolate* isolate,
+    Handle<FixedArray> literals,
+    int literals_index) {
+  if (!AllocationSite::CanTrack()) return Handle<AllocationSite>::null();
+  int site_index = literals_index + 1;
+  Object* site = literals->get(site_index);
+  if (site->IsAllocationSite()) {
+    return Handle<AllocationSite>(AllocationSite::cast(site), isolate);
+  }
+  Handle<AllocationSite> new_site = isolate->factory()->NewAllocationSite();
+  literals->set(site_index, *new_site);
+  return new_site;
+}
+
+
 RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateObjectLiteral) {
   HandleScope scope(isolate);
   ASSERT(args.length() == 4);
@@ -595,7 +623,11 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateObjectLiteral) {
     // Update the functions literal and return the boilerplate.
     literals->set(literals_index, *boilerplate);
   }
-  return DeepCopyBoilerplate(isolate, JSObject::cast(*boilerplate));
+  Handle<AllocationSite> site =
+      Runtime::GetLiteralAllocationSite(isolate, literals, literals_index);
+  return DeepCopyBoilerplate(isolate,
+                             JSObject::cast(*boilerplate),
+                             site.is_null() ? NULL : *site);
 }
 
 
@@ -621,7 +653,10 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateObjectLiteralShallow) {
     // Update the functions literal and return the boilerplate.
     literals->set(literals_index, *boilerplate);
   }
-  return isolate->heap()->CopyJSObject(JSObject::cast(*boilerplate));
+  Handle<AllocationSite> site =
+      Runtime::GetLiteralAllocationSite(isolate, literals, literals_index);
+  return isolate->heap()->CopyJSObject(JSObject::cast(*boilerplate),
+                                       site.is_null() ? NULL : *site);
 }
 
 
@@ -642,7 +677,11 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateArrayLiteral) {
     // Update the functions literal and return the boilerplate.
     literals->set(literals_index, *boilerplate);
   }
-  return DeepCopyBoilerplate(isolate, JSObject::cast(*boilerplate));
+  Handle<AllocationSite> site =
+      Runtime::GetLiteralAllocationSite(isolate, literals, literals_index);
+  return DeepCopyBoilerplate(isolate,
+                             JSObject::cast(*boilerplate),
+                             site.is_null() ? NULL : *site);
 }
 
 
@@ -667,7 +706,10 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CreateArrayLiteralShallow) {
       isolate->heap()->fixed_cow_array_map()) {
     isolate->counters()->cow_arrays_created_runtime()->Increment();
   }
-  return isolate->heap()->CopyJSObject(JSObject::cast(*boilerplate));
+  Handle<AllocationSite> site =
+      Runtime::GetLiteralAllocationSite(isolate, literals, literals_index);
+  return isolate->heap()->CopyJSObject(JSObject::cast(*boilerplate),
+                                       site.is_null() ? NULL : *site);
 }
 
 
@@ -3391,19 +3433,7 @@ MUST_USE_RESULT static MaybeObject* StringReplaceRegExpWithEmptyString(
   }
 
   // Shorten string and fill
-  int string_size = ResultSeqString::SizeFor(position);
-  int allocated_string_size = ResultSeqString::SizeFor(new_length);
-  int delta = allocated_string_size - string_size;
-
-  answer->set_length(position);
-  if (delta == 0) return *answer;
-
-  Address end_of_string = answer->address() + string_size;
-  isolate->heap()->CreateFillerObjectAt(end_of_string, delta);
-  if (Marking::IsBlack(Marking::MarkBitFrom(*answer))) {
-    MemoryChunk::IncrementLiveBytesFromMutator(answer->address(), -delta);
-  }
-
+  isolate->heap()->RightTrimObject(*answer, position);
   return *answer;
 }
 
@@ -4413,7 +4443,9 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_KeyedGetProperty) {
         // appropriate.
         LookupResult result(isolate);
         receiver->LocalLookup(key, &result);
-        if (result.IsField()) {
+        // The generic keyed load stub reads cached fields directly, which
+        // would hand out the box of a double field with its mutable map.
+        if (result.IsField() && !result.IsDoubleField()) {
           int offset = result.GetFieldIndex();
           keyed_lookup_cache->Update(receiver_map, key, offset);
           return receiver->FastPropertyAt(offset);
@@ -8197,8 +8229,22 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_NewObject) {
     shared->CompleteInobjectSlackTracking();
   }
 
+  // Objects constructed by the function are tracked by an allocation site
+  // in its literals, which the construct stubs share.
+  PretenureFlag pretenure = NOT_TENURED;
+  if (function->HasAllocationSiteLiteral()) {
+    Handle<FixedArray> literals(function->literals(), isolate);
+    Object* site = literals->get(JSFunction::kLiteralAllocationSiteIndex);
+    if (!site->IsAllocationSite()) {
+      site = *isolate->factory()->NewAllocationSite();
+      literals->set(JSFunction::kLiteralAllocationSiteIndex, site);
+    }
+    pretenure = AllocationSite::cast(site)->GetPretenureMode();
+  }
+
   bool first_allocation = !shared->live_objects_may_exist();
-  Handle<JSObject> result = isolate->factory()->NewJSObject(function);
+  Handle<JSObject> result = isolate->factory()->NewJSObject(function,
+                                                            pretenure);
   RETURN_IF_EMPTY_HANDLE(isolate, result);
   // Delay setting the stub if inobject slack tracking is in progress.
   if (first_allocation && !shared->IsInobjectSlackTrackingInProgress()) {
@@ -8364,7 +8410,7 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_NotifyDeoptimized) {
   ASSERT(isolate->heap()->IsAllocationAllowed());
   int jsframes = deoptimizer->jsframe_count();
 
-  deoptimizer->MaterializeHeapNumbers();
+  deoptimizer->MaterializeHeapObjects();
   delete deoptimizer;
 
   JavaScriptFrameIterator it(isolate);
@@ -8433,6 +8479,9 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_DeoptimizeFunction) {
   HandleScope scope(isolate);
   ASSERT(args.length() == 1);
   CONVERT_ARG_HANDLE_CHECKED(JSFunction, function, 0);
+  if (FLAG_parallel_recompilation && function->IsInRecompileQueue()) {
+    isolate->optimizing_compiler_thread()->CancelFunction(*function);
+  }
   if (!function->IsOptimized()) return isolate->heap()->undefined_value();
 
   Deoptimizer::DeoptimizeFunction(*function);
@@ -8469,9 +8518,19 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_OptimizeFunctionOnNextCall) {
   CONVERT_ARG_HANDLE_CHECKED(JSFunction, function, 0);
 
   if (!function->IsOptimizable()) return isolate->heap()->undefined_value();
-  function->MarkForLazyRecompilation();
 
   Code* unoptimized = function->shared()->code();
+  if (args.length() == 2 && FLAG_parallel_recompilation) {
+    CONVERT_ARG_HANDLE_CHECKED(String, type, 1);
+    if (type->IsEqualTo(CStrVector("parallel"))) {
+      if (!function->IsInRecompileQueue()) {
+        function->MarkForParallelRecompilation();
+      }
+      return isolate->heap()->undefined_value();
+    }
+  }
+  function->MarkForLazyRecompilation();
+
   if (args.length() == 2 &&
       unoptimized->kind() == Code::FUNCTION) {
     CONVERT_ARG_HANDLE_CHECKED(String, type, 1);
@@ -8578,19 +8637,41 @@ RUNTIME_FUNCTION(MaybeObject*, Runtime_CompileForOnStackReplacement) {
       PrintF("]\n");
     }
 
-    // Try to compile the optimized code.  A true return value from
-    // CompileOptimized means that compilation succeeded, not necessarily
-    // that optimization succeeded.
-    if (JSFunction::CompileOptimized(function, ast_id, CLEAR_EXCEPTION) &&
-        function->IsOptimized()) {
+    bool optimized;
+    if (FLAG_parallel_recompilation && FLAG_concurrent_osr) {
+      // Queue the compilation and keep running the unoptimized code with
+      // the original stack checks, so that interrupts are still handled.
+      // The code ready interrupt installs the code and patches the stack
+      // checks again to enter it here.
+      if (!function->IsOptimized() &&
+          !isolate->optimizing_compiler_thread()->IsQueuedForOSR(*function) &&
+          Compiler::RecompileParallelForOSR(function, ast_id) &&
+          FLAG_trace_osr) {
+        PrintF("[queued on-stack replacement code for ");
+        function->PrintName();
+        PrintF("]\n");
+      }
+      optimized = function->IsOptimized();
+    } else {
+      // Try to compile the optimized code.  A true return value from
+      // CompileOptimized means that compilation succeeded, not necessarily
+      // that optimization succeeded.
+      optimized =
+          JSFunction::CompileOptimized(function, ast_id, CLEAR_EXCEPTION) &&
+          function->IsOptimized();
+    }
+
+    if (optimized) {
       DeoptimizationInputData* data = DeoptimizationInputData::cast(
           function->code()->deoptimization_data());
-      if (data->OsrPcOffset()->value() >= 0) {
+      // Code installed by the compiler threads may have been optimized
+      // without an entry for this loop.
+      if (data->OsrPcOffset()->value() >= 0 &&
+          data->OsrAstId()->value() == ast_id) {
         if (FLAG_trace_osr) {
           PrintF("[on-stack replacement offset %d in optimized code]\n",
                data->OsrPcOffset()->value());
         }
-        ASSERT(data->OsrAstId()->value() == ast_id);
       } else {
         // We may never generate the desired OSR entry if we emit an
         // early deoptimize.
@@ -708,6 +708,14 @@ class Runtime : public AllStatic {
       Isolate* isolate,
       Handle<FixedArray> literals,
       Handle<FixedArray> elements);
+
+  // Returns the allocation site stored in the slot after the boilerplate of
+  // an object or array literal, creating it if necessary.  Returns a null
+  // handle if allocation sites are not tracked.
+  static Handle<AllocationSite> GetLiteralAllocationSite(
+      Isolate* isolate,
+      Handle<FixedArray> literals,
+      int literals_index);
 };
 
 
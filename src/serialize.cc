@@ -511,6 +511,10 @@ void ExternalReferenceTable::PopulateTable(Isolate* isolate) {
       UNCLASSIFIED,
       47,
       "date_cache_stamp");
+  Add(ExternalReference::concurrent_marking_active(isolate).address(),
+      UNCLASSIFIED,
+      48,
+      "concurrent_marking_active");
 }
 
 
@@ -27,6 +27,7 @@
 
 #include "v8.h"
 
+#include "compiler-intrinsics.h"
 #include "liveobjectlist-inl.h"
 #include "macro-assembler.h"
 #include "mark-compact.h"
@@ -119,6 +120,14 @@ bool HeapObjectIterator::AdvanceToNextPage() {
 }
 
 
+// Whether heap memory is backed by transparent huge pages.  Code pages only
+// use them for the part of their body that covers whole huge pages, so that
+// the non-executable header and the guard pages stay in place.
+static bool UseHugePages() {
+  return FLAG_transparent_huge_pages && VirtualMemory::HasHugePages();
+}
+
+
 // -----------------------------------------------------------------------------
 // CodeRange
 
@@ -266,7 +275,9 @@ MemoryAllocator::MemoryAllocator(Isolate* isolate)
       capacity_(0),
       capacity_executable_(0),
       size_(0),
-      size_executable_(0) {
+      size_executable_(0),
+      pooled_size_(0),
+      pool_hits_(0) {
 }
 
 
@@ -283,6 +294,7 @@ bool MemoryAllocator::SetUp(intptr_t capacity, intptr_t capacity_executable) {
 
 
 void MemoryAllocator::TearDown() {
+  ReleasePooledChunks();
   // Check that spaces were torn down before MemoryAllocator.
   ASSERT(size_ == 0);
   // TODO(gc) this will be true again when we fix FreeMemory.
@@ -339,6 +351,108 @@ void MemoryAllocator::FreeMemory(Address base,
 }
 
 
+bool MemoryAllocator::PoolChunk(MemoryChunk* chunk) {
+  if (chunk->executable() == EXECUTABLE) return false;
+  VirtualMemory* reservation = chunk->reserved_memory();
+  size_t reserved = reservation->size();
+  if (pooled_size_ + reserved >
+      static_cast<size_t>(FLAG_max_pooled_memory_size) * MB) {
+    return false;
+  }
+
+  // The reservation lives in the chunk header, so move it out before the
+  // memory is discarded.
+  PooledChunk pooled;
+  pooled.reservation = new VirtualMemory();
+  pooled.reservation->TakeControl(reservation);
+  pooled.base = chunk->address();
+  pooled.size = chunk->size();
+  // Discarding part of a huge page would break it up into small pages.
+  if (!UseHugePages() &&
+      !VirtualMemory::DiscardRegion(pooled.base, pooled.size)) {
+    reservation->TakeControl(pooled.reservation);
+    delete pooled.reservation;
+    return false;
+  }
+
+  ASSERT(size_ >= reserved);
+  size_ -= reserved;
+  isolate_->counters()->memory_allocated()->
+      Decrement(static_cast<int>(reserved));
+  pooled_size_ += reserved;
+  pooled_chunks_.Add(pooled);
+  return true;
+}
+
+
+Address MemoryAllocator::AllocatePooledMemory(size_t size,
+                                              VirtualMemory* controller) {
+  int best = -1;
+  for (int i = 0; i < pooled_chunks_.length(); i++) {
+    size_t pooled = pooled_chunks_[i].size;
+    if (pooled >= size &&
+        pooled - size < static_cast<size_t>(Page::kPageSize) &&
+        (best == -1 || pooled < pooled_chunks_[best].size)) {
+      best = i;
+    }
+  }
+  if (best == -1) return NULL;
+
+  PooledChunk pooled = pooled_chunks_.Remove(best);
+  size_t reserved = pooled.reservation->size();
+  pooled_size_ -= reserved;
+  size_ += reserved;
+  pool_hits_++;
+  controller->TakeControl(pooled.reservation);
+  delete pooled.reservation;
+  return pooled.base;
+}
+
+
+Address MemoryAllocator::AllocateHugePage(VirtualMemory* controller) {
+  static const size_t kPagesPerHugePage =
+      VirtualMemory::kHugePageSize / Page::kPageSize;
+  STATIC_ASSERT(kPagesPerHugePage * Page::kPageSize ==
+                VirtualMemory::kHugePageSize);
+  size_t pooled = (kPagesPerHugePage - 1) * Page::kPageSize;
+  if (pooled_size_ + pooled >
+      static_cast<size_t>(FLAG_max_pooled_memory_size) * MB) {
+    return NULL;
+  }
+
+  VirtualMemory reservation;
+  Address base = AllocateAlignedMemory(VirtualMemory::kHugePageSize,
+                                       VirtualMemory::kHugePageSize,
+                                       NOT_EXECUTABLE,
+                                       &reservation);
+  if (base == NULL) return NULL;
+  ASSERT(base == reservation.address());
+
+  for (size_t i = kPagesPerHugePage - 1; i > 0; i--) {
+    PooledChunk page;
+    page.reservation = new VirtualMemory();
+    reservation.Split(i * Page::kPageSize, page.reservation);
+    page.base = base + i * Page::kPageSize;
+    page.size = Page::kPageSize;
+    pooled_chunks_.Add(page);
+  }
+  size_ -= pooled;
+  pooled_size_ += pooled;
+  controller->TakeControl(&reservation);
+  return base;
+}
+
+
+void MemoryAllocator::ReleasePooledChunks() {
+  while (!pooled_chunks_.is_empty()) {
+    PooledChunk pooled = pooled_chunks_.RemoveLast();
+    pooled.reservation->Release();
+    delete pooled.reservation;
+  }
+  pooled_size_ = 0;
+}
+
+
 Address MemoryAllocator::ReserveAlignedMemory(size_t size,
                                               size_t alignment,
                                               VirtualMemory* controller) {
@@ -368,6 +482,8 @@ Address MemoryAllocator::AllocateAlignedMemory(size_t size,
   } else {
     if (!reservation.Commit(base, size, false)) {
       base = NULL;
+    } else if (UseHugePages()) {
+      VirtualMemory::AdviseHugePages(base, size);
     }
   }
 
@@ -447,6 +563,10 @@ MemoryChunk* MemoryChunk::Initialize(Heap* heap,
   chunk->InitializeReservedMemory();
   chunk->slots_buffer_ = NULL;
   chunk->skip_list_ = NULL;
+  chunk->slot_set_ = NULL;
+  chunk->parallel_sweeping_ = SWEEPING_DONE;
+  chunk->concurrent_marking_lock_ = 0;
+  chunk->ResetFreeListStatistics();
   chunk->ResetLiveBytes();
   Bitmap::Clear(chunk);
   chunk->initialize_scan_on_scavenge(false);
@@ -536,10 +656,18 @@ MemoryChunk* MemoryAllocator::AllocateChunk(intptr_t body_size,
     area_end = area_start + body_size;
   } else {
     chunk_size = MemoryChunk::kObjectStartOffset + body_size;
-    base = AllocateAlignedMemory(chunk_size,
-                                 MemoryChunk::kAlignment,
-                                 executable,
-                                 &reservation);
+    base = AllocatePooledMemory(chunk_size, &reservation);
+    if (base == NULL &&
+        UseHugePages() &&
+        chunk_size == static_cast<size_t>(Page::kPageSize)) {
+      base = AllocateHugePage(&reservation);
+    }
+    if (base == NULL) {
+      base = AllocateAlignedMemory(chunk_size,
+                                   MemoryChunk::kAlignment,
+                                   executable,
+                                   &reservation);
+    }
 
     if (base == NULL) return NULL;
 
@@ -605,10 +733,11 @@ void MemoryAllocator::Free(MemoryChunk* chunk) {
 
   delete chunk->slots_buffer();
   delete chunk->skip_list();
+  delete chunk->slot_set();
 
   VirtualMemory* reservation = chunk->reserved_memory();
   if (reservation->IsReserved()) {
-    FreeMemory(reservation, chunk->executable());
+    if (!PoolChunk(chunk)) FreeMemory(reservation, chunk->executable());
   } else {
     FreeMemory(chunk->address(),
                chunk->size(),
@@ -754,10 +883,31 @@ bool MemoryAllocator::CommitCodePage(VirtualMemory* vm,
     return false;
   }
 
+  if (UseHugePages()) {
+    Address huge_start;
+    Address huge_end;
+    CodePageHugePageArea(start, size, &huge_start, &huge_end);
+    if (huge_start < huge_end) {
+      VirtualMemory::AdviseHugePages(huge_start, huge_end - huge_start);
+    }
+  }
+
   return true;
 }
 
 
+void MemoryAllocator::CodePageHugePageArea(Address start,
+                                           size_t size,
+                                           Address* huge_start,
+                                           Address* huge_end) {
+  Address area_start = start + CodePageAreaStartOffset();
+  Address area_end = start + size - CodePageGuardSize();
+  *huge_start = RoundUp(area_start, VirtualMemory::kHugePageSize);
+  *huge_end = RoundDown(area_end, VirtualMemory::kHugePageSize);
+  if (*huge_end < *huge_start) *huge_end = *huge_start;
+}
+
+
 // -----------------------------------------------------------------------------
 // MemoryChunk implementation
 
@@ -766,7 +916,15 @@ void MemoryChunk::IncrementLiveBytesFromMutator(Address address, int by) {
   if (!chunk->InNewSpace() && !static_cast<Page*>(chunk)->WasSwept()) {
     static_cast<PagedSpace*>(chunk->owner())->IncrementUnsweptFreeBytes(-by);
   }
-  chunk->IncrementLiveBytes(by);
+  IncrementLiveBytesFromGCAtomically(address, by);
+}
+
+
+void MemoryChunk::LockForConcurrentMarkingSlow() {
+  // The lock is only held for the visit of a single object, so spin.
+  do {
+    Thread::YieldCPU();
+  } while (Acquire_CompareAndSwap(&concurrent_marking_lock_, 0, 1) != 0);
 }
 
 // -----------------------------------------------------------------------------
@@ -780,7 +938,8 @@ PagedSpace::PagedSpace(Heap* heap,
       free_list_(this),
       was_swept_conservatively_(false),
       first_unswept_page_(Page::FromAddress(NULL)),
-      unswept_free_bytes_(0) {
+      unswept_free_bytes_(0),
+      concurrent_sweeping_(false) {
   if (id == CODE_SPACE) {
     area_size_ = heap->isolate()->memory_allocator()->
         CodePageAreaSize();
@@ -1895,108 +2054,204 @@ FreeList::FreeList(PagedSpace* owner)
 
 void FreeList::Reset() {
   available_ = 0;
-  small_list_ = NULL;
-  medium_list_ = NULL;
-  large_list_ = NULL;
-  huge_list_ = NULL;
+  for (int i = 0; i < kNumberOfSizeClasses; i++) {
+    heads_[i] = NULL;
+    tails_[i] = NULL;
+  }
+  for (int i = 0; i < kSizeClassCells; i++) {
+    non_empty_size_classes_[i] = 0;
+  }
 }
 
 
-int FreeList::Free(Address start, int size_in_bytes) {
-  if (size_in_bytes == 0) return 0;
-  FreeListNode* node = FreeListNode::FromAddress(start);
-  node->set_size(heap_, size_in_bytes);
+int FreeList::SizeClassFor(int size_in_bytes) {
+  ASSERT(size_in_bytes >= kMinBlockSize);
+  uint32_t words = static_cast<uint32_t>(size_in_bytes) >> kPointerSizeLog2;
+  int log2 = 31 - CompilerIntrinsics::CountLeadingZeros(words);
+  ASSERT(log2 < kMaxBlockSizeInWordsLog2);
+  int sub_class = (words >> (log2 - kSizeClassesPerPowerOfTwoLog2)) &
+      ((1 << kSizeClassesPerPowerOfTwoLog2) - 1);
+  return ((log2 - kMinBlockSizeInWordsLog2) <<
+          kSizeClassesPerPowerOfTwoLog2) + sub_class;
+}
 
-  // Early return to drop too-small blocks on the floor.
-  if (size_in_bytes < kSmallListMin) return size_in_bytes;
-
-  // Insert other blocks at the head of a free list of the appropriate
-  // magnitude.
-  if (size_in_bytes <= kSmallListMax) {
-    node->set_next(small_list_);
-    small_list_ = node;
-  } else if (size_in_bytes <= kMediumListMax) {
-    node->set_next(medium_list_);
-    medium_list_ = node;
-  } else if (size_in_bytes <= kLargeListMax) {
-    node->set_next(large_list_);
-    large_list_ = node;
-  } else {
-    node->set_next(huge_list_);
-    huge_list_ = node;
-  }
-  available_ += size_in_bytes;
-  ASSERT(IsVeryLong() || available_ == SumFreeLists());
-  return 0;
+
+int FreeList::SizeClassMinimum(int size_class) {
+  int log2 = (size_class >> kSizeClassesPerPowerOfTwoLog2) +
+      kMinBlockSizeInWordsLog2;
+  int sub_class = size_class & ((1 << kSizeClassesPerPowerOfTwoLog2) - 1);
+  int words = ((1 << kSizeClassesPerPowerOfTwoLog2) + sub_class) <<
+      (log2 - kSizeClassesPerPowerOfTwoLog2);
+  return words << kPointerSizeLog2;
 }
 
 
-FreeListNode* FreeList::PickNodeFromList(FreeListNode** list, int* node_size) {
-  FreeListNode* node = *list;
+// Returns the first non-empty size class starting at first_size_class, or
+// -1 if there is none.
+int FreeList::FindNonEmptySizeClass(int first_size_class) {
+  int cell_index = first_size_class >> Bitmap::kBitsPerCellLog2;
+  if (cell_index >= kSizeClassCells) return -1;
+  uint32_t cell = non_empty_size_classes_[cell_index] &
+      (~0u << (first_size_class & Bitmap::kBitIndexMask));
+  while (cell == 0) {
+    if (++cell_index == kSizeClassCells) return -1;
+    cell = non_empty_size_classes_[cell_index];
+  }
+  return (cell_index << Bitmap::kBitsPerCellLog2) +
+      CompilerIntrinsics::CountTrailingZeros(cell);
+}
 
-  if (node == NULL) return NULL;
 
-  while (node != NULL &&
-         Page::FromAddress(node->address())->IsEvacuationCandidate()) {
-    available_ -= node->Size();
-    node = node->next();
+intptr_t* FreeList::PageStatisticsFor(Page* page, int size_in_bytes) {
+  int size_class = SizeClassFor(size_in_bytes);
+  if (size_class < kSizeClassesPerCategory) {
+    return &page->available_in_small_free_list_;
+  } else if (size_class < 2 * kSizeClassesPerCategory) {
+    return &page->available_in_medium_free_list_;
+  } else if (size_class < 3 * kSizeClassesPerCategory) {
+    return &page->available_in_large_free_list_;
   }
+  return &page->available_in_huge_free_list_;
+}
+
 
-  if (node != NULL) {
-    *node_size = node->Size();
-    *list = node->next();
+void FreeList::AddToSizeClass(int size_class,
+                              FreeListNode* node,
+                              bool at_tail) {
+  FreeListNode* head = heads_[size_class];
+  if (head == NULL) {
+    node->set_next(NULL);
+    heads_[size_class] = tails_[size_class] = node;
+    non_empty_size_classes_[size_class >> Bitmap::kBitsPerCellLog2] |=
+        1u << (size_class & Bitmap::kBitIndexMask);
+  } else if (at_tail) {
+    node->set_next(NULL);
+    tails_[size_class]->set_next(node);
+    tails_[size_class] = node;
   } else {
-    *list = NULL;
+    node->set_next(head);
+    heads_[size_class] = node;
   }
+}
+
 
+FreeListNode* FreeList::RemoveFromSizeClass(int size_class) {
+  FreeListNode* node = heads_[size_class];
+  ASSERT(node != NULL);
+  FreeListNode* next = node->next();
+  heads_[size_class] = next;
+  if (next == NULL) {
+    tails_[size_class] = NULL;
+    non_empty_size_classes_[size_class >> Bitmap::kBitsPerCellLog2] &=
+        ~(1u << (size_class & Bitmap::kBitIndexMask));
+  }
   return node;
 }
 
 
-FreeListNode* FreeList::FindNodeFor(int size_in_bytes, int* node_size) {
-  FreeListNode* node = NULL;
-
-  if (size_in_bytes <= kSmallAllocationMax) {
-    node = PickNodeFromList(&small_list_, node_size);
-    if (node != NULL) return node;
+intptr_t FreeList::Concatenate(FreeList* other) {
+  intptr_t moved_bytes = other->available_;
+  for (int i = 0; i < kNumberOfSizeClasses; i++) {
+    FreeListNode* other_head = other->heads_[i];
+    if (other_head == NULL) continue;
+    other->tails_[i]->set_next(heads_[i]);
+    if (heads_[i] == NULL) tails_[i] = other->tails_[i];
+    heads_[i] = other_head;
   }
-
-  if (size_in_bytes <= kMediumAllocationMax) {
-    node = PickNodeFromList(&medium_list_, node_size);
-    if (node != NULL) return node;
+  for (int i = 0; i < kSizeClassCells; i++) {
+    non_empty_size_classes_[i] |= other->non_empty_size_classes_[i];
   }
+  available_ += static_cast<int>(moved_bytes);
+  other->Reset();
+  return moved_bytes;
+}
 
-  if (size_in_bytes <= kLargeAllocationMax) {
-    node = PickNodeFromList(&large_list_, node_size);
-    if (node != NULL) return node;
-  }
 
-  for (FreeListNode** cur = &huge_list_;
-       *cur != NULL;
-       cur = (*cur)->next_address()) {
-    FreeListNode* cur_node = *cur;
-    while (cur_node != NULL &&
-           Page::FromAddress(cur_node->address())->IsEvacuationCandidate()) {
-      available_ -= reinterpret_cast<FreeSpace*>(cur_node)->Size();
-      cur_node = cur_node->next();
+int FreeList::Free(Address start, int size_in_bytes) {
+  if (size_in_bytes == 0) return 0;
+  FreeListNode* node = FreeListNode::FromAddress(start);
+  node->set_size(heap_, size_in_bytes);
+
+  // Early return to drop too-small blocks on the floor.
+  if (size_in_bytes < kMinBlockSize) return size_in_bytes;
+
+  Page* page = Page::FromAddress(start);
+  *PageStatisticsFor(page, size_in_bytes) += size_in_bytes;
+  bool mostly_free = page->available_in_free_list() > page->area_size() / 2;
+  AddToSizeClass(SizeClassFor(size_in_bytes), node, mostly_free);
+  available_ += size_in_bytes;
+  ASSERT(IsVeryLong() || available_ == SumFreeLists());
+  return 0;
+}
+
+
+FreeListNode* FreeList::SearchSizeClass(int size_class,
+                                        int size_in_bytes,
+                                        int* node_size) {
+  FreeListNode* previous = NULL;
+  for (FreeListNode* node = heads_[size_class];
+       node != NULL;
+       node = node->next()) {
+    int size = reinterpret_cast<FreeSpace*>(node)->Size();
+    if (size >= size_in_bytes &&
+        !Page::FromAddress(node->address())->IsEvacuationCandidate()) {
+      if (previous == NULL) {
+        RemoveFromSizeClass(size_class);
+      } else {
+        previous->set_next(node->next());
+        if (tails_[size_class] == node) tails_[size_class] = previous;
+      }
+      *node_size = size;
+      return node;
     }
+    previous = node;
+  }
+  return NULL;
+}
 
-    *cur = cur_node;
-    if (cur_node == NULL) break;
 
-    ASSERT((*cur)->map() == HEAP->raw_unchecked_free_space_map());
-    FreeSpace* cur_as_free_space = reinterpret_cast<FreeSpace*>(*cur);
-    int size = cur_as_free_space->Size();
-    if (size >= size_in_bytes) {
-      // Large enough node found.  Unlink it from the list.
-      node = *cur;
+FreeListNode* FreeList::FindNodeFor(int size_in_bytes, int* node_size) {
+  // Every block in the first size class whose minimum is at least the
+  // requested size fits.  The blocks of the class containing the requested
+  // size may be too small, so only the first one of them is tried before
+  // the larger classes.  The rest of them are searched last.
+  int first_size_class = 0;
+  int partial_size_class = -1;
+  if (size_in_bytes > kMinBlockSize) {
+    first_size_class = SizeClassFor(size_in_bytes);
+    if (SizeClassMinimum(first_size_class) < size_in_bytes) {
+      FreeListNode* head = heads_[first_size_class];
+      if (head != NULL &&
+          reinterpret_cast<FreeSpace*>(head)->Size() >= size_in_bytes &&
+          !Page::FromAddress(head->address())->IsEvacuationCandidate()) {
+        RemoveFromSizeClass(first_size_class);
+        *node_size = reinterpret_cast<FreeSpace*>(head)->Size();
+        return head;
+      }
+      partial_size_class = first_size_class;
+      first_size_class++;
+    }
+  }
+
+  for (int size_class = FindNonEmptySizeClass(first_size_class);
+       size_class >= 0;
+       size_class = FindNonEmptySizeClass(size_class)) {
+    FreeListNode* node = RemoveFromSizeClass(size_class);
+    Page* page = Page::FromAddress(node->address());
+    int size = reinterpret_cast<FreeSpace*>(node)->Size();
+    if (!page->IsEvacuationCandidate()) {
       *node_size = size;
-      *cur = node->next();
-      break;
+      return node;
     }
+    // Drop blocks on evacuation candidates, they are about to be released.
+    available_ -= size;
+    *PageStatisticsFor(page, size) -= size;
   }
 
-  return node;
+  if (partial_size_class >= 0 && heads_[partial_size_class] != NULL) {
+    return SearchSizeClass(partial_size_class, size_in_bytes, node_size);
+  }
+  return NULL;
 }
 
 
@@ -2016,6 +2271,8 @@ HeapObject* FreeList::Allocate(int size_in_bytes) {
   if (new_node == NULL) return NULL;
 
   available_ -= new_node_size;
+  *PageStatisticsFor(Page::FromAddress(new_node->address()), new_node_size) -=
+      new_node_size;
   ASSERT(IsVeryLong() || available_ == SumFreeLists());
 
   int bytes_left = new_node_size - size_in_bytes;
@@ -2073,56 +2330,59 @@ HeapObject* FreeList::Allocate(int size_in_bytes) {
 }
 
 
-static intptr_t CountFreeListItemsInList(FreeListNode* n, Page* p) {
-  intptr_t sum = 0;
-  while (n != NULL) {
-    if (Page::FromAddress(n->address()) == p) {
-      FreeSpace* free_space = reinterpret_cast<FreeSpace*>(n);
-      sum += free_space->Size();
-    }
-    n = n->next();
-  }
-  return sum;
-}
-
-
 void FreeList::CountFreeListItems(Page* p, SizeStats* sizes) {
-  sizes->huge_size_ = CountFreeListItemsInList(huge_list_, p);
-  if (sizes->huge_size_ < p->area_size()) {
-    sizes->small_size_ = CountFreeListItemsInList(small_list_, p);
-    sizes->medium_size_ = CountFreeListItemsInList(medium_list_, p);
-    sizes->large_size_ = CountFreeListItemsInList(large_list_, p);
-  } else {
-    sizes->small_size_ = 0;
-    sizes->medium_size_ = 0;
-    sizes->large_size_ = 0;
-  }
+  sizes->small_size_ = p->available_in_small_free_list();
+  sizes->medium_size_ = p->available_in_medium_free_list();
+  sizes->large_size_ = p->available_in_large_free_list();
+  sizes->huge_size_ = p->available_in_huge_free_list();
 }
 
 
-static intptr_t EvictFreeListItemsInList(FreeListNode** n, Page* p) {
+intptr_t FreeList::EvictFreeListItemsInSizeClass(int size_class, Page* p) {
   intptr_t sum = 0;
+  FreeListNode* previous = NULL;
+  FreeListNode** n = &heads_[size_class];
   while (*n != NULL) {
     if (Page::FromAddress((*n)->address()) == p) {
       FreeSpace* free_space = reinterpret_cast<FreeSpace*>(*n);
       sum += free_space->Size();
       *n = (*n)->next();
     } else {
+      previous = *n;
       n = (*n)->next_address();
     }
   }
+  tails_[size_class] = previous;
+  if (previous == NULL) {
+    non_empty_size_classes_[size_class >> Bitmap::kBitsPerCellLog2] &=
+        ~(1u << (size_class & Bitmap::kBitIndexMask));
+  }
   return sum;
 }
 
 
 intptr_t FreeList::EvictFreeListItems(Page* p) {
-  intptr_t sum = EvictFreeListItemsInList(&huge_list_, p);
-
-  if (sum < p->area_size()) {
-    sum += EvictFreeListItemsInList(&small_list_, p) +
-        EvictFreeListItemsInList(&medium_list_, p) +
-        EvictFreeListItemsInList(&large_list_, p);
+  // Only the size classes of the categories the page has blocks in need to
+  // be searched.
+  intptr_t category_sizes[] = {
+    p->available_in_small_free_list(),
+    p->available_in_medium_free_list(),
+    p->available_in_large_free_list(),
+    p->available_in_huge_free_list()
+  };
+  intptr_t sum = 0;
+  for (int category = 0; category < 4; category++) {
+    if (category_sizes[category] == 0) continue;
+    int first = category * kSizeClassesPerCategory;
+    int last = (category == 3) ? kNumberOfSizeClasses
+                               : first + kSizeClassesPerCategory;
+    for (int size_class = first; size_class < last; size_class++) {
+      if (heads_[size_class] != NULL) {
+        sum += EvictFreeListItemsInSizeClass(size_class, p);
+      }
+    }
   }
+  p->ResetFreeListStatistics();
 
   available_ -= static_cast<int>(sum);
 
@@ -2158,10 +2418,11 @@ int FreeList::FreeListLength(FreeListNode* cur) {
 
 
 bool FreeList::IsVeryLong() {
-  if (FreeListLength(small_list_) == kVeryLongFreeList) return  true;
-  if (FreeListLength(medium_list_) == kVeryLongFreeList) return  true;
-  if (FreeListLength(large_list_) == kVeryLongFreeList) return  true;
-  if (FreeListLength(huge_list_) == kVeryLongFreeList) return  true;
+  int length = 0;
+  for (int i = 0; i < kNumberOfSizeClasses; i++) {
+    length += FreeListLength(heads_[i]);
+    if (length >= kVeryLongFreeList) return true;
+  }
   return false;
 }
 
@@ -2170,10 +2431,10 @@ bool FreeList::IsVeryLong() {
 // on the free list, so it should not be called if FreeListLength returns
 // kVeryLongFreeList.
 intptr_t FreeList::SumFreeLists() {
-  intptr_t sum = SumFreeList(small_list_);
-  sum += SumFreeList(medium_list_);
-  sum += SumFreeList(large_list_);
-  sum += SumFreeList(huge_list_);
+  intptr_t sum = 0;
+  for (int i = 0; i < kNumberOfSizeClasses; i++) {
+    sum += SumFreeList(heads_[i]);
+  }
   return sum;
 }
 #endif
@@ -2214,6 +2475,9 @@ void PagedSpace::PrepareForMarkCompact() {
   Free(top(), old_linear_size);
   SetTop(NULL, NULL);
 
+  // Concurrent sweeping must have been finished by the collector.
+  ASSERT(!concurrent_sweeping_);
+
   // Stop lazy sweeping and clear marking bits for unswept pages.
   if (first_unswept_page_ != NULL) {
     Page* p = first_unswept_page_;
@@ -2236,6 +2500,15 @@ void PagedSpace::PrepareForMarkCompact() {
 
   // Clear the free list before a full GC---it will be rebuilt afterward.
   free_list_.Reset();
+  ResetFreeListStatistics();
+}
+
+
+void PagedSpace::ResetFreeListStatistics() {
+  PageIterator page_iterator(this);
+  while (page_iterator.has_next()) {
+    page_iterator.next()->ResetFreeListStatistics();
+  }
 }
 
 
@@ -2274,6 +2547,18 @@ bool LargeObjectSpace::ReserveSpace(int bytes) {
 bool PagedSpace::AdvanceSweeper(intptr_t bytes_to_sweep) {
   if (IsSweepingComplete()) return true;
 
+  // Pages left to the sweeper threads are not swept here.  Their free
+  // memory is merged into the space once the threads are done.
+  if (concurrent_sweeping_) {
+    MarkCompactCollector* collector = heap()->mark_compact_collector();
+    if (!collector->IsConcurrentSweepingInProgress() ||
+        !collector->IsSweepingCompleted()) {
+      return false;
+    }
+    collector->WaitUntilSweepingCompleted();
+    return IsSweepingComplete();
+  }
+
   intptr_t freed_bytes = 0;
   Page* p = first_unswept_page_;
   do {
@@ -2319,6 +2604,21 @@ void PagedSpace::EvictEvacuationCandidatesFromFreeLists() {
 HeapObject* PagedSpace::SlowAllocateRaw(int size_in_bytes) {
   // Allocation in this space has failed.
 
+  // If the sweeper threads are sweeping this space take the memory they have
+  // freed so far.  Only if that is not enough sweep pages that no sweeper
+  // thread has claimed yet, one at a time.
+  MarkCompactCollector* collector = heap()->mark_compact_collector();
+  if (concurrent_sweeping_) {
+    collector->StealMemoryFromSweeperThreads(this);
+    HeapObject* object = free_list_.Allocate(size_in_bytes);
+    if (object != NULL) return object;
+
+    while (collector->SweepNextPendingPage(this)) {
+      object = free_list_.Allocate(size_in_bytes);
+      if (object != NULL) return object;
+    }
+  }
+
   // If there are unswept pages advance lazy sweeper then sweep one page before
   // allocating a new page.
   if (first_unswept_page_->is_valid()) {
@@ -2344,6 +2644,13 @@ HeapObject* PagedSpace::SlowAllocateRaw(int size_in_bytes) {
 
   // Last ditch, sweep all the remaining pages to try to find space.  This may
   // cause a pause.
+  if (collector->IsConcurrentSweepingInProgress()) {
+    collector->WaitUntilSweepingCompleted();
+
+    // Retry the free list allocation.
+    HeapObject* object = free_list_.Allocate(size_in_bytes);
+    if (object != NULL) return object;
+  }
   if (!IsSweepingComplete()) {
     AdvanceSweeper(kMaxInt);
 
@@ -29,6 +29,7 @@
 #define V8_SPACES_H_
 
 #include "allocation.h"
+#include "atomicops.h"
 #include "hashmap.h"
 #include "list.h"
 #include "log.h"
@@ -141,6 +142,33 @@ class MarkBit {
   inline bool Get() { return (*cell_ & mask_) != 0; }
   inline void Clear() { *cell_ &= ~mask_; }
 
+  // Sets the bit with a compare and swap on the cell, so that bits of the
+  // same cell can be set concurrently.  Returns false if the bit was already
+  // set.
+  inline bool SetAtomically() {
+    volatile Atomic32* cell = reinterpret_cast<volatile Atomic32*>(cell_);
+    Atomic32 old_value = NoBarrier_Load(cell);
+    while ((old_value & mask_) == 0) {
+      Atomic32 new_value = static_cast<Atomic32>(old_value | mask_);
+      Atomic32 value = NoBarrier_CompareAndSwap(cell, old_value, new_value);
+      if (value == old_value) return true;
+      old_value = value;
+    }
+    return false;
+  }
+
+  // Clears the bit with a compare and swap on the cell, see SetAtomically().
+  inline void ClearAtomically() {
+    volatile Atomic32* cell = reinterpret_cast<volatile Atomic32*>(cell_);
+    Atomic32 old_value = NoBarrier_Load(cell);
+    while ((old_value & mask_) != 0) {
+      Atomic32 new_value = static_cast<Atomic32>(old_value & ~mask_);
+      Atomic32 value = NoBarrier_CompareAndSwap(cell, old_value, new_value);
+      if (value == old_value) return;
+      old_value = value;
+    }
+  }
+
   inline bool data_only() { return data_only_; }
 
   inline MarkBit Next() {
@@ -292,6 +320,7 @@ class Bitmap {
 
 
 class SkipList;
+class SlotSet;
 class SlotsBuffer;
 
 // MemoryChunk represents a memory region owned by a specific space.
@@ -472,6 +501,16 @@ class MemoryChunk {
     MemoryChunk::FromAddress(address)->IncrementLiveBytes(by);
   }
 
+  // Used by parallel marking, which updates the live bytes of a chunk from
+  // several threads.
+  static void IncrementLiveBytesFromGCAtomically(Address address, int by) {
+    MemoryChunk* chunk = MemoryChunk::FromAddress(address);
+    NoBarrier_AtomicIncrement(
+        reinterpret_cast<volatile Atomic32*>(&chunk->live_byte_count_), by);
+  }
+
+  // The live bytes of a chunk may be updated concurrently by the concurrent
+  // marker, so this uses an atomic increment.
   static void IncrementLiveBytesFromMutator(Address address, int by);
 
   static const intptr_t kAlignment =
@@ -489,7 +528,8 @@ class MemoryChunk {
   static const size_t kSlotsBufferOffset = kLiveBytesOffset + kIntSize;
 
   static const size_t kHeaderSize =
-      kSlotsBufferOffset + kPointerSize + kPointerSize;
+      kSlotsBufferOffset + kPointerSize + kPointerSize + kPointerSize +
+      kPointerSize + 4 * kPointerSize + kPointerSize;
 
   static const int kBodyOffset =
     CODE_POINTER_ALIGN(MAP_POINTER_ALIGN(kHeaderSize + Bitmap::kSize));
@@ -577,6 +617,85 @@ class MemoryChunk {
     skip_list_ = skip_list;
   }
 
+  // The slots of this chunk that the store buffer recorded exactly, or NULL
+  // if all of them are in the store buffer.
+  inline SlotSet* slot_set() {
+    return slot_set_;
+  }
+
+  inline void set_slot_set(SlotSet* slot_set) {
+    slot_set_ = slot_set;
+  }
+
+  // Pages that are left to the sweeper threads move from
+  // SWEEPING_PENDING to SWEEPING_IN_PROGRESS when a thread (the mutator
+  // included) claims them and to SWEEPING_DONE when their free memory is
+  // on a free list.
+  enum ParallelSweepingState {
+    SWEEPING_DONE,
+    SWEEPING_PENDING,
+    SWEEPING_IN_PROGRESS
+  };
+
+  ParallelSweepingState parallel_sweeping() {
+    return static_cast<ParallelSweepingState>(
+        Acquire_Load(&parallel_sweeping_));
+  }
+
+  void set_parallel_sweeping(ParallelSweepingState state) {
+    Release_Store(&parallel_sweeping_, state);
+  }
+
+  // Bytes of this chunk that are on a free list, by the size category of
+  // the free blocks (see FreeList::SizeStats).
+  intptr_t available_in_small_free_list() {
+    return available_in_small_free_list_;
+  }
+  intptr_t available_in_medium_free_list() {
+    return available_in_medium_free_list_;
+  }
+  intptr_t available_in_large_free_list() {
+    return available_in_large_free_list_;
+  }
+  intptr_t available_in_huge_free_list() {
+    return available_in_huge_free_list_;
+  }
+  intptr_t available_in_free_list() {
+    return available_in_small_free_list_ + available_in_medium_free_list_ +
+        available_in_large_free_list_ + available_in_huge_free_list_;
+  }
+
+  void ResetFreeListStatistics() {
+    available_in_small_free_list_ = 0;
+    available_in_medium_free_list_ = 0;
+    available_in_large_free_list_ = 0;
+    available_in_huge_free_list_ = 0;
+  }
+
+  // The concurrent marker holds the lock of a chunk while it visits an
+  // object on the chunk, and the mutator holds it while it changes the
+  // layout of an object on the chunk in place.  Neither thread holds the
+  // locks of two chunks at a time, except for the marker, which takes the
+  // lock of a second chunk only around marking an object grey.
+  void LockForConcurrentMarking() {
+    if (Acquire_CompareAndSwap(&concurrent_marking_lock_, 0, 1) != 0) {
+      LockForConcurrentMarkingSlow();
+    }
+  }
+
+  void UnlockForConcurrentMarking() {
+    ASSERT(NoBarrier_Load(&concurrent_marking_lock_) == 1);
+    Release_Store(&concurrent_marking_lock_, 0);
+  }
+
+  // Claims a pending page for sweeping.  Returns false if the page is not
+  // pending or was claimed by another thread first.
+  bool TryParallelSweeping() {
+    return Acquire_CompareAndSwap(&parallel_sweeping_,
+                                  SWEEPING_PENDING,
+                                  SWEEPING_IN_PROGRESS) == SWEEPING_PENDING;
+  }
+
   inline SlotsBuffer* slots_buffer() {
     return slots_buffer_;
   }
@@ -625,6 +744,16 @@ class MemoryChunk {
   int live_byte_count_;
   SlotsBuffer* slots_buffer_;
   SkipList* skip_list_;
+  SlotSet* slot_set_;
+  // One of the ParallelSweepingState values.
+  volatile AtomicWord parallel_sweeping_;
+  intptr_t available_in_small_free_list_;
+  intptr_t available_in_medium_free_list_;
+  intptr_t available_in_large_free_list_;
+  intptr_t available_in_huge_free_list_;
+  volatile AtomicWord concurrent_marking_lock_;
+
+  void LockForConcurrentMarkingSlow();
 
   static MemoryChunk* Initialize(Heap* heap,
                                  Address base,
@@ -634,6 +763,7 @@ class MemoryChunk {
                                  Executability executable,
                                  Space* owner);
 
+  friend class FreeList;
   friend class MemoryAllocator;
 };
 
@@ -975,6 +1105,18 @@ class MemoryAllocator {
   // Returns allocated executable spaces in bytes.
   intptr_t SizeExecutable() { return size_executable_; }
 
+  // Returns the bytes of freed chunks that are kept for reuse.
+  intptr_t PooledSize() { return pooled_size_; }
+
+  // Returns the number of freed chunks that are kept for reuse.
+  int PooledChunks() { return pooled_chunks_.length(); }
+
+  // Returns the number of chunks that were allocated from the pool.
+  int PoolHits() { return pool_hits_; }
+
+  // Returns the memory of all pooled chunks to the OS.
+  void ReleasePooledChunks();
+
   // Returns maximum available bytes that the old space can have.
   intptr_t MaxAvailable() {
     return (Available() / Page::kPageSize) * Page::kMaxNonCodeHeapObjectSize;
@@ -1046,6 +1188,15 @@ class MemoryAllocator {
                                              Address start,
                                              size_t size);
 
+  // Computes the part of the body of a code chunk that is backed by huge
+  // pages with --transparent-huge-pages: the whole, aligned huge pages
+  // between the guard pages.  The range is empty for chunks of a single
+  // page, which are smaller than a huge page.
+  static void CodePageHugePageArea(Address start,
+                                   size_t size,
+                                   Address* huge_start,
+                                   Address* huge_end);
+
  private:
   Isolate* isolate_;
 
@@ -1074,6 +1225,34 @@ class MemoryAllocator {
   List<MemoryAllocationCallbackRegistration>
       memory_allocation_callbacks_;
 
+  // A freed non-executable chunk.  Its memory is discarded but stays
+  // reserved, and the first size bytes from base stay committed, so that
+  // AllocateChunk can reuse it without going to the OS.
+  struct PooledChunk {
+    VirtualMemory* reservation;
+    Address base;
+    size_t size;
+  };
+
+  // Pooled chunks are not included in size_.
+  List<PooledChunk> pooled_chunks_;
+  size_t pooled_size_;
+  int pool_hits_;
+
+  // Adds a freed chunk to the pool.  Returns false if it does not fit.
+  bool PoolChunk(MemoryChunk* chunk);
+
+  // Maps a region of the size and alignment of a huge page and splits it
+  // into regular pages, so that neighbouring pages share a huge page.
+  // Returns the first page and adds the others to the pool, or returns NULL
+  // if they do not fit into the pool.
+  Address AllocateHugePage(VirtualMemory* controller);
+
+  // Moves the smallest pooled chunk that has at least size committed bytes
+  // and does not waste a page into controller.  Returns the base of the
+  // chunk or NULL if there is none.
+  Address AllocatePooledMemory(size_t size, VirtualMemory* controller);
+
   // Initializes pages in a chunk. Returns the first page address.
   // This function and GetChunkId() are provided for the mark-compact
   // collector to rebuild page headers in the from space, which is
@@ -1325,29 +1504,26 @@ class FreeListNode: public HeapObject {
 };
 
 
-// The free list for the old space.  The free list is organized in such a way
-// as to encourage objects allocated around the same time to be near each
-// other.  The normal way to allocate is intended to be by bumping a 'top'
-// pointer until it hits a 'limit' pointer.  When the limit is hit we need to
-// find a new space to allocate from.  This is done with the free list, which
-// is divided up into rough categories to cut down on waste.  Having finer
-// categories would scatter allocation more.
-
-// The old space free list is organized in categories.
-// 1-31 words:  Such small free areas are discarded for efficiency reasons.
-//     They can be reclaimed by the compactor.  However the distance between top
-//     and limit may be this small.
-// 32-255 words: There is a list of spaces this large.  It is used for top and
-//     limit when the object we need to allocate is 1-31 words in size.  These
-//     spaces are called small.
-// 256-2047 words: There is a list of spaces this large.  It is used for top and
-//     limit when the object we need to allocate is 32-255 words in size.  These
-//     spaces are called medium.
-// 1048-16383 words: There is a list of spaces this large.  It is used for top
-//     and limit when the object we need to allocate is 256-2047 words in size.
-//     These spaces are call large.
-// At least 16384 words.  This list is for objects of 2048 words or larger.
-//     Empty pages are added to this list.  These spaces are called huge.
+// The free list for the old space.  The normal way to allocate is intended to
+// be by bumping a 'top' pointer until it hits a 'limit' pointer.  When the
+// limit is hit we need to find a new space to allocate from.  This is done
+// with the free list.
+//
+// Free blocks smaller than 32 words are discarded for efficiency reasons.
+// They can be reclaimed by the compactor.  However the distance between top
+// and limit may be this small.
+//
+// Larger blocks are kept on segregated lists.  Every power of two of block
+// sizes (in words) is split into four size classes of equal width, and a
+// bitmap records which classes are non-empty.  An allocation takes the first
+// block of the smallest non-empty class whose blocks are all large enough,
+// so it needs neither a search through a list nor a split of a larger block
+// than necessary.
+//
+// Each page counts the bytes it has on the free list.  Blocks on pages that
+// are mostly free are queued behind the blocks of other pages, so that
+// allocation fills the fuller pages first and the emptier ones are left to
+// become evacuation candidates.
 class FreeList BASE_EMBEDDED {
  public:
   explicit FreeList(PagedSpace* owner);
@@ -1366,6 +1542,11 @@ class FreeList BASE_EMBEDDED {
   // aligned, and the size should be a non-zero multiple of the word size.
   int Free(Address start, int size_in_bytes);
 
+  // Moves all nodes of 'other' to this free list, leaving 'other' empty.
+  // Returns the number of bytes moved.  Not thread-safe: the sweeper threads
+  // guard their shared free lists with a lock.
+  intptr_t Concatenate(FreeList* other);
+
   // Allocate a block of size 'size_in_bytes' from the free list.  The block
   // is unitialized.  A failure is returned if no block is available.  The
   // number of bytes lost to fragmentation is returned in the output parameter
@@ -1380,6 +1561,9 @@ class FreeList BASE_EMBEDDED {
   bool IsVeryLong();
 #endif
 
+  // Bytes of a page on the free list, by the size of the free blocks.
+  // Small blocks have 32-255 words, medium blocks 256-2047 words, large
+  // blocks 2048-16383 words and huge blocks at least 16384 words.
   struct SizeStats {
     intptr_t Total() {
       return small_size_ + medium_size_ + large_size_ + huge_size_;
@@ -1397,30 +1581,52 @@ class FreeList BASE_EMBEDDED {
 
  private:
   // The size range of blocks, in bytes.
-  static const int kMinBlockSize = 3 * kPointerSize;
+  static const int kMinBlockSize = 0x20 * kPointerSize;
   static const int kMaxBlockSize = Page::kMaxNonCodeHeapObjectSize;
 
-  FreeListNode* PickNodeFromList(FreeListNode** list, int* node_size);
+  // Size classes.  Class boundaries coincide with the SizeStats categories.
+  static const int kMinBlockSizeInWordsLog2 = 5;
+  static const int kMaxBlockSizeInWordsLog2 = kPageSizeBits - kPointerSizeLog2;
+  static const int kSizeClassesPerPowerOfTwoLog2 = 2;
+  static const int kNumberOfSizeClasses =
+      (kMaxBlockSizeInWordsLog2 - kMinBlockSizeInWordsLog2) <<
+      kSizeClassesPerPowerOfTwoLog2;
+  static const int kSizeClassesPerCategory =
+      3 << kSizeClassesPerPowerOfTwoLog2;
+  static const int kSizeClassCells =
+      (kNumberOfSizeClasses + Bitmap::kBitsPerCell - 1) >>
+      Bitmap::kBitsPerCellLog2;
+
+  static inline int SizeClassFor(int size_in_bytes);
+  static inline int SizeClassMinimum(int size_class);
+  int FindNonEmptySizeClass(int first_size_class);
+
+  // Returns the page counter that accounts for a free block of the given
+  // size.
+  static intptr_t* PageStatisticsFor(Page* page, int size_in_bytes);
+
+  void AddToSizeClass(int size_class, FreeListNode* node, bool at_tail);
+  FreeListNode* RemoveFromSizeClass(int size_class);
+
+  // Returns the first block of a size class that is large enough, or NULL.
+  FreeListNode* SearchSizeClass(int size_class,
+                                int size_in_bytes,
+                                int* node_size);
 
   FreeListNode* FindNodeFor(int size_in_bytes, int* node_size);
 
+  intptr_t EvictFreeListItemsInSizeClass(int size_class, Page* p);
+
   PagedSpace* owner_;
   Heap* heap_;
 
   // Total available bytes in all blocks on this free list.
   int available_;
 
-  static const int kSmallListMin = 0x20 * kPointerSize;
-  static const int kSmallListMax = 0xff * kPointerSize;
-  static const int kMediumListMax = 0x7ff * kPointerSize;
-  static const int kLargeListMax = 0x3fff * kPointerSize;
-  static const int kSmallAllocationMax = kSmallListMin - kPointerSize;
-  static const int kMediumAllocationMax = kSmallListMax;
-  static const int kLargeAllocationMax = kMediumListMax;
-  FreeListNode* small_list_;
-  FreeListNode* medium_list_;
-  FreeListNode* large_list_;
-  FreeListNode* huge_list_;
+  FreeListNode* heads_[kNumberOfSizeClasses];
+  FreeListNode* tails_[kNumberOfSizeClasses];
+  // Bit i is set if size class i is non-empty.
+  uint32_t non_empty_size_classes_[kSizeClassCells];
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(FreeList);
 };
@@ -1524,8 +1730,12 @@ class PagedSpace : public Space {
 
   void ResetFreeList() {
     free_list_.Reset();
+    ResetFreeListStatistics();
   }
 
+  // Clears the free list statistics of all pages.
+  void ResetFreeListStatistics();
+
   // Set space allocation info.
   void SetTop(Address top, Address limit) {
     ASSERT(top == limit ||
@@ -1602,10 +1812,33 @@ class PagedSpace : public Space {
     unswept_free_bytes_ -= (p->area_size() - p->LiveBytes());
   }
 
+  // Pages that are swept concurrently are only accounted for by the bytes
+  // that were actually freed on them.
+  void DecrementUnsweptFreeBytes(intptr_t by) {
+    unswept_free_bytes_ = Max(static_cast<intptr_t>(0),
+                              unswept_free_bytes_ - by);
+  }
+
+  void ResetUnsweptFreeBytes() {
+    unswept_free_bytes_ = 0;
+  }
+
+  // Removes memory that was put on a free list of this space without going
+  // through Free, e.g. by a sweeper thread, from the allocated bytes.
+  void RemoveFromAccountingStats(intptr_t bytes) {
+    accounting_stats_.DeallocateBytes(bytes);
+  }
+
+  FreeList* free_list() { return &free_list_; }
+
   bool AdvanceSweeper(intptr_t bytes_to_sweep);
 
+  // True while some pages of this space are left to the sweeper threads.
+  bool concurrent_sweeping() { return concurrent_sweeping_; }
+  void set_concurrent_sweeping(bool value) { concurrent_sweeping_ = value; }
+
   bool IsSweepingComplete() {
-    return !first_unswept_page_->is_valid();
+    return !first_unswept_page_->is_valid() && !concurrent_sweeping_;
   }
 
   Page* FirstPage() { return anchor_.next_page(); }
@@ -1664,6 +1897,8 @@ class PagedSpace : public Space {
   // done conservatively.
   intptr_t unswept_free_bytes_;
 
+  bool concurrent_sweeping_;
+
   // Expands the space by allocating a fixed number of pages. Returns false if
   // it cannot allocate requested number of pages from OS, or if the hard heap
   // size limit has been hit.
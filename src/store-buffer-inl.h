@@ -74,6 +74,42 @@ void StoreBuffer::EnterDirectlyIntoStoreBuffer(Address addr) {
 }
 
 
+int SlotSet::BitIndex(Address slot) {
+  ASSERT(slot >= base_);
+  int index = static_cast<int>((slot - base_) >> kPointerSizeLog2);
+  ASSERT((index >> kBitsPerCellLog2) < cells_count_);
+  return index;
+}
+
+
+bool SlotSet::Insert(Address slot) {
+  int index = BitIndex(slot);
+  uint32_t mask = 1u << (index & (kBitsPerCell - 1));
+  uint32_t* cell = &cells_[index >> kBitsPerCellLog2];
+  if ((*cell & mask) != 0) return false;
+  *cell |= mask;
+  size_++;
+  return true;
+}
+
+
+void SlotSet::Remove(Address slot) {
+  int index = BitIndex(slot);
+  uint32_t mask = 1u << (index & (kBitsPerCell - 1));
+  uint32_t* cell = &cells_[index >> kBitsPerCellLog2];
+  if ((*cell & mask) == 0) return;
+  *cell &= ~mask;
+  size_--;
+}
+
+
+bool SlotSet::Contains(Address slot) {
+  int index = BitIndex(slot);
+  uint32_t mask = 1u << (index & (kBitsPerCell - 1));
+  return (cells_[index >> kBitsPerCellLog2] & mask) != 0;
+}
+
+
 } }  // namespace v8::internal
 
 #endif  // V8_STORE_BUFFER_INL_H_
@@ -27,6 +27,7 @@
 
 #include "v8.h"
 
+#include "compiler-intrinsics.h"
 #include "store-buffer.h"
 #include "store-buffer-inl.h"
 #include "v8-counters.h"
@@ -34,6 +35,21 @@
 namespace v8 {
 namespace internal {
 
+SlotSet::SlotSet(MemoryChunk* chunk)
+    : base_(chunk->address()),
+      size_(0) {
+  int slots = static_cast<int>(chunk->size() >> kPointerSizeLog2);
+  cells_count_ = (slots + kBitsPerCell - 1) >> kBitsPerCellLog2;
+  cells_ = NewArray<uint32_t>(cells_count_);
+  memset(cells_, 0, cells_count_ * sizeof(*cells_));
+}
+
+
+SlotSet::~SlotSet() {
+  DeleteArray(cells_);
+}
+
+
 StoreBuffer::StoreBuffer(Heap* heap)
     : heap_(heap),
       start_(NULL),
@@ -196,6 +212,8 @@ void StoreBuffer::EnsureSpace(intptr_t space_needed) {
     Filter(MemoryChunk::SCAN_ON_SCAVENGE);
   }
 
+  if (FLAG_remembered_set_bitmaps) MoveEntriesToSlotSets();
+
   // If filtering out the entries from scan_on_scavenge pages got us down to
   // less than half full, then we are satisfied with that.
   if (old_limit_ - old_top_ > old_top_ - old_start_) return;
@@ -232,6 +250,7 @@ void StoreBuffer::ExemptPopularPages(int prime_sample_step, int threshold) {
     chunk->set_store_buffer_counter(0);
   }
   bool created_new_scan_on_scavenge_pages = false;
+  bool created_new_slot_sets = false;
   MemoryChunk* previous_chunk = NULL;
   for (Address* p = old_start_; p < old_top_; p += prime_sample_step) {
     Address addr = *p;
@@ -243,8 +262,16 @@ void StoreBuffer::ExemptPopularPages(int prime_sample_step, int threshold) {
     }
     int old_counter = containing_chunk->store_buffer_counter();
     if (old_counter == threshold) {
-      containing_chunk->set_scan_on_scavenge(true);
-      created_new_scan_on_scavenge_pages = true;
+      if (FLAG_remembered_set_bitmaps) {
+        // Record the slots of the page exactly instead of scanning all of it.
+        if (containing_chunk->slot_set() == NULL) {
+          containing_chunk->set_slot_set(new SlotSet(containing_chunk));
+        }
+        created_new_slot_sets = true;
+      } else {
+        containing_chunk->set_scan_on_scavenge(true);
+        created_new_scan_on_scavenge_pages = true;
+      }
     }
     containing_chunk->set_store_buffer_counter(old_counter + 1);
     previous_chunk = containing_chunk;
@@ -252,10 +279,56 @@ void StoreBuffer::ExemptPopularPages(int prime_sample_step, int threshold) {
   if (created_new_scan_on_scavenge_pages) {
     Filter(MemoryChunk::SCAN_ON_SCAVENGE);
   }
+  if (created_new_slot_sets) {
+    MoveEntriesToSlotSets();
+  }
   old_buffer_is_filtered_ = true;
 }
 
 
+void StoreBuffer::MoveEntriesToSlotSets() {
+  Address* new_top = old_start_;
+  MemoryChunk* previous_chunk = NULL;
+  for (Address* p = old_start_; p < old_top_; p++) {
+    Address addr = *p;
+    MemoryChunk* containing_chunk = NULL;
+    if (previous_chunk != NULL && previous_chunk->Contains(addr)) {
+      containing_chunk = previous_chunk;
+    } else {
+      containing_chunk = MemoryChunk::FromAnyPointerAddress(addr);
+      previous_chunk = containing_chunk;
+    }
+    SlotSet* slot_set = containing_chunk->slot_set();
+    if (slot_set != NULL) {
+      slot_set->Insert(addr);
+    } else {
+      *new_top++ = addr;
+    }
+  }
+  old_top_ = new_top;
+
+  // Filtering hash sets are inconsistent with the store buffer after this
+  // operation.
+  ClearFilteringHashSets();
+}
+
+
+void StoreBuffer::MoveEntriesToSlotSet(MemoryChunk* chunk, Object*** start) {
+  ASSERT(start >= Start() && start <= Top());
+  SlotSet* slot_set = chunk->slot_set();
+  if (slot_set == NULL) {
+    slot_set = new SlotSet(chunk);
+    chunk->set_slot_set(slot_set);
+  }
+  for (Address* p = reinterpret_cast<Address*>(start); p < old_top_; p++) {
+    ASSERT(chunk->Contains(*p));
+    slot_set->Insert(*p);
+  }
+  SetTop(start);
+  ClearFilteringHashSets();
+}
+
+
 void StoreBuffer::Filter(int flag) {
   Address* new_top = old_start_;
   MemoryChunk* previous_chunk = NULL;
@@ -348,7 +421,9 @@ bool StoreBuffer::CellIsInStoreBuffer(Address cell_address) {
       return true;
     }
   }
-  return false;
+  SlotSet* slot_set =
+      MemoryChunk::FromAnyPointerAddress(cell_address)->slot_set();
+  return slot_set != NULL && slot_set->Contains(cell_address);
 }
 #endif
 
@@ -416,6 +491,12 @@ void StoreBuffer::VerifyPointers(LargeObjectSpace* space) {
 
 void StoreBuffer::Verify() {
 #ifdef DEBUG
+  // The pages are walked word by word, which must not race with the sweeper
+  // threads.
+  MarkCompactCollector* collector = heap_->mark_compact_collector();
+  if (collector->IsConcurrentSweepingInProgress()) {
+    collector->WaitUntilSweepingCompleted();
+  }
   VerifyPointers(heap_->old_pointer_space(),
                  &StoreBuffer::FindPointersToNewSpaceInRegion);
   VerifyPointers(heap_->map_space(),
@@ -603,17 +684,57 @@ void StoreBuffer::IteratePointersInStoreBuffer(
 }
 
 
+// Visits the slots in the slot sets.  Unlike the slots in the store buffer
+// they stay where they are, and only the slots that no longer point to new
+// space are removed.  Chunks whose slot set becomes empty go back to using
+// the store buffer alone.
+void StoreBuffer::IteratePointersInSlotSets(ObjectSlotCallback slot_callback) {
+  PointerChunkIterator it(heap_);
+  MemoryChunk* chunk;
+  while ((chunk = it.next()) != NULL) {
+    SlotSet* slot_set = chunk->slot_set();
+    if (slot_set == NULL) continue;
+    uint32_t* cells = slot_set->cells();
+    for (int i = 0; i < slot_set->CellsCount(); i++) {
+      uint32_t cell = cells[i];
+      while (cell != 0) {
+        int bit = CompilerIntrinsics::CountTrailingZeros(cell);
+        cell &= cell - 1;
+        Address slot_address = slot_set->SlotAt(i, bit);
+        Object** slot = reinterpret_cast<Object**>(slot_address);
+        Object* object = *slot;
+        if (heap_->InFromSpace(object)) {
+          slot_callback(reinterpret_cast<HeapObject**>(slot),
+                        reinterpret_cast<HeapObject*>(object));
+        }
+        if (!heap_->InNewSpace(*slot)) slot_set->Remove(slot_address);
+      }
+    }
+    if (slot_set->IsEmpty()) {
+      delete slot_set;
+      chunk->set_slot_set(NULL);
+    }
+  }
+}
+
+
 void StoreBuffer::IteratePointersToNewSpace(ObjectSlotCallback slot_callback) {
   // We do not sort or remove duplicated entries from the store buffer because
   // we expect that callback will rebuild the store buffer thus removing
   // all duplicates and pointers to old space.
   bool some_pages_to_scan = PrepareForIteration();
 
+  if (heap_->mark_compact_collector()->IsConcurrentSweepingInProgress()) {
+    EnsurePagesToIterateAreSwept();
+  }
+
   // TODO(gc): we want to skip slots on evacuation candidates
   // but we can't simply figure that out from slot address
   // because slot can belong to a large object.
   IteratePointersInStoreBuffer(slot_callback);
 
+  IteratePointersInSlotSets(slot_callback);
+
   // We are done scanning all the pointers that were in the store buffer, but
   // there may be some pages marked scan_on_scavenge that have pointers to new
   // space that are not in the store buffer.  We must scan them now.  As we
@@ -662,6 +783,29 @@ void StoreBuffer::IteratePointersToNewSpace(ObjectSlotCallback slot_callback) {
 }
 
 
+// The slots in the store buffer, in slot sets and on scan-on-scavenge pages
+// can lie in dead objects.  Updating them must not race with a sweeper thread
+// putting the dead object on a free list, so such pages are swept first.
+void StoreBuffer::EnsurePagesToIterateAreSwept() {
+  MarkCompactCollector* collector = heap_->mark_compact_collector();
+  MemoryChunk* previous_chunk = NULL;
+  for (Address* current = old_start_; current < old_top_; current++) {
+    Address addr = *current;
+    if (previous_chunk != NULL && previous_chunk->Contains(addr)) continue;
+    MemoryChunk* chunk = MemoryChunk::FromAnyPointerAddress(addr);
+    collector->SweepOrWaitUntilSwept(chunk);
+    previous_chunk = chunk;
+  }
+  PointerChunkIterator it(heap_);
+  MemoryChunk* chunk;
+  while ((chunk = it.next()) != NULL) {
+    if (chunk->scan_on_scavenge() || chunk->slot_set() != NULL) {
+      collector->SweepOrWaitUntilSwept(chunk);
+    }
+  }
+}
+
+
 void StoreBuffer::Compact() {
   Address* top = reinterpret_cast<Address*>(heap_->store_buffer_top());
 
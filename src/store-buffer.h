@@ -44,6 +44,46 @@ typedef void (*ObjectSlotCallback)(HeapObject** from, HeapObject* to);
 typedef void (StoreBuffer::*RegionCallback)(
     Address start, Address end, ObjectSlotCallback slot_callback);
 
+// The exact set of recorded slots of a memory chunk, with one bit for each
+// pointer-sized word of the chunk.  Chunks whose slots take up too much of
+// the store buffer move them into a slot set, so that a scavenge visits each
+// of their slots once no matter how often it was written to.
+class SlotSet : public Malloced {
+ public:
+  explicit SlotSet(MemoryChunk* chunk);
+  ~SlotSet();
+
+  // Returns false if the slot was in the set already.
+  inline bool Insert(Address slot);
+  inline void Remove(Address slot);
+  inline bool Contains(Address slot);
+
+  int Size() { return size_; }
+  bool IsEmpty() { return size_ == 0; }
+
+  uint32_t* cells() { return cells_; }
+  int CellsCount() { return cells_count_; }
+
+  Address SlotAt(int cell_index, int bit_index) {
+    int index = cell_index * kBitsPerCell + bit_index;
+    return base_ + (index << kPointerSizeLog2);
+  }
+
+ private:
+  static const int kBitsPerCell = 32;
+  static const int kBitsPerCellLog2 = 5;
+
+  inline int BitIndex(Address slot);
+
+  Address base_;
+  uint32_t* cells_;
+  int cells_count_;
+  int size_;
+
+  DISALLOW_COPY_AND_ASSIGN(SlotSet);
+};
+
+
 // Used to implement the write barrier by collecting addresses of pointers
 // between spaces.
 class StoreBuffer {
@@ -122,6 +162,10 @@ class StoreBuffer {
 
   void Filter(int flag);
 
+  // Moves the entries from start to the top of the old buffer, which must all
+  // be slots of chunk, into the slot set of chunk.
+  void MoveEntriesToSlotSet(MemoryChunk* chunk, Object*** start);
+
  private:
   Heap* heap_;
 
@@ -161,6 +205,9 @@ class StoreBuffer {
   void CheckForFullBuffer();
   void Uniq();
   void ExemptPopularPages(int prime_sample_step, int threshold);
+  // Moves the entries of chunks that have a slot set out of the old buffer.
+  void MoveEntriesToSlotSets();
+  void EnsurePagesToIterateAreSwept();
 
   void FindPointersToNewSpaceInRegion(Address start,
                                       Address end,
@@ -194,6 +241,7 @@ class StoreBuffer {
     ObjectSlotCallback slot_callback);
 
   void IteratePointersInStoreBuffer(ObjectSlotCallback slot_callback);
+  void IteratePointersInSlotSets(ObjectSlotCallback slot_callback);
 
 #ifdef DEBUG
   void VerifyPointers(PagedSpace* space, RegionCallback region_callback);
@@ -0,0 +1,95 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "v8.h"
+
+#include "mark-compact.h"
+#include "sweeper.h"
+
+namespace v8 {
+namespace internal {
+
+
+Sweeper::Sweeper(Heap* heap)
+    : heap_(heap),
+      collector_(heap_->mark_compact_collector()),
+      free_list_mutex_(OS::CreateMutex()),
+      free_list_old_data_space_(heap_->old_data_space()),
+      free_list_old_pointer_space_(heap_->old_pointer_space()),
+      private_free_list_old_data_space_(heap_->old_data_space()),
+      private_free_list_old_pointer_space_(heap_->old_pointer_space()) {
+}
+
+
+Sweeper::~Sweeper() {
+  delete free_list_mutex_;
+}
+
+
+void Sweeper::RunTask(int task_id) {
+  SweepSpace(heap_->old_data_space(),
+             &private_free_list_old_data_space_,
+             &free_list_old_data_space_);
+  SweepSpace(heap_->old_pointer_space(),
+             &private_free_list_old_pointer_space_,
+             &free_list_old_pointer_space_);
+  Barrier_AtomicIncrement(&collector_->running_sweeper_threads_, -1);
+}
+
+
+void Sweeper::SweepSpace(PagedSpace* space,
+                         FreeList* private_free_list,
+                         FreeList* free_list) {
+  PageIterator it(space);
+  while (it.has_next()) {
+    Page* p = it.next();
+    if (!p->TryParallelSweeping()) continue;
+    MarkCompactCollector::SweepConservativelyInParallel(
+        space, private_free_list, p);
+    {
+      ScopedLock lock(free_list_mutex_);
+      free_list->Concatenate(private_free_list);
+    }
+    // Only mark the page as swept once its memory can be stolen, so that
+    // the main thread never waits for a page whose memory it cannot get.
+    p->set_parallel_sweeping(MemoryChunk::SWEEPING_DONE);
+  }
+}
+
+
+intptr_t Sweeper::StealMemory(PagedSpace* space) {
+  ScopedLock lock(free_list_mutex_);
+  FreeList* free_list = space->identity() == OLD_POINTER_SPACE
+      ? &free_list_old_pointer_space_
+      : &free_list_old_data_space_;
+  ASSERT(space->identity() == OLD_POINTER_SPACE ||
+         space->identity() == OLD_DATA_SPACE);
+  return space->free_list()->Concatenate(free_list);
+}
+
+} }  // namespace v8::internal
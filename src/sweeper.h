@@ -0,0 +1,78 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef V8_SWEEPER_H_
+#define V8_SWEEPER_H_
+
+#include "gc-helper-thread.h"
+#include "platform.h"
+#include "spaces.h"
+
+namespace v8 {
+namespace internal {
+
+class Heap;
+class MarkCompactCollector;
+
+// The task of a sweeper thread, which sweeps the old pointer and data space
+// pages left by a mark-compact collection while the mutator runs.  Each
+// page is swept into a private free list, which is then moved to a free
+// list shared with the main thread.  The main thread steals the shared free
+// lists when it runs out of memory in a space and merges them when the
+// sweeping is done.
+class Sweeper : public GCHelperThread::Task {
+ public:
+  explicit Sweeper(Heap* heap);
+  ~Sweeper();
+
+  // Entry point of the sweeper thread.
+  virtual void RunTask(int task_id);
+
+  // Moves the memory freed so far in the given space to the space's free
+  // list.  Returns the number of bytes moved.  Called by the main thread.
+  intptr_t StealMemory(PagedSpace* space);
+
+ private:
+  void SweepSpace(PagedSpace* space,
+                  FreeList* private_free_list,
+                  FreeList* free_list);
+
+  Heap* heap_;
+  MarkCompactCollector* collector_;
+  Mutex* free_list_mutex_;
+  FreeList free_list_old_data_space_;
+  FreeList free_list_old_pointer_space_;
+  FreeList private_free_list_old_data_space_;
+  FreeList private_free_list_old_pointer_space_;
+
+  DISALLOW_COPY_AND_ASSIGN(Sweeper);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_SWEEPER_H_
@@ -45,6 +45,12 @@ Counters::Counters() {
     HISTOGRAM_PERCENTAGE_LIST(HP)
 #undef HP
 
+#define HM(name, caption) \
+    Histogram name = { #caption, 0, 10000, 50, NULL, false }; \
+    name##_ = name;
+    HISTOGRAM_MILLISECONDS_LIST(HM)
+#undef HM
+
 #define SC(name, caption) \
     StatsCounter name = { "c:" #caption, NULL, false };\
     name##_ = name;
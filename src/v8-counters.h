@@ -68,6 +68,19 @@ namespace internal {
      V8.MemoryExternalFragmentationLoSpace)
 
 
+// Histograms of durations in milliseconds.
+#define HISTOGRAM_MILLISECONDS_LIST(HM)                               \
+  /* Garbage collection pauses and their phases. */                   \
+  HM(gc_pause_scavenge, V8.GCPauseScavenge)                           \
+  HM(gc_pause_mark_compact, V8.GCPauseMarkCompact)                    \
+  HM(gc_phase_external, V8.GCPhaseExternal)                           \
+  HM(gc_phase_mark, V8.GCPhaseMark)                                   \
+  HM(gc_phase_sweep, V8.GCPhaseSweep)                                 \
+  HM(gc_phase_sweep_new_space, V8.GCPhaseSweepNewSpace)               \
+  HM(gc_phase_evacuate, V8.GCPhaseEvacuate)                           \
+  HM(gc_phase_update_pointers, V8.GCPhaseUpdatePointers)
+
+
 // WARNING: STATS_COUNTER_LIST_* is a very large macro that is causing MSVC
 // Intellisense to crash.  It was broken into two macros (each of length 40
 // lines) rather than one macro (of length about 80 lines) to work around
@@ -303,6 +316,11 @@ class Counters {
   HISTOGRAM_PERCENTAGE_LIST(HP)
 #undef HP
 
+#define HM(name, caption) \
+  Histogram* name() { return &name##_; }
+  HISTOGRAM_MILLISECONDS_LIST(HM)
+#undef HM
+
 #define SC(name, caption) \
   StatsCounter* name() { return &name##_; }
   STATS_COUNTER_LIST_1(SC)
@@ -338,6 +356,9 @@ class Counters {
 #define PERCENTAGE_ID(name, caption) k_##name,
     HISTOGRAM_PERCENTAGE_LIST(PERCENTAGE_ID)
 #undef PERCENTAGE_ID
+#define MILLISECONDS_ID(name, caption) k_##name,
+    HISTOGRAM_MILLISECONDS_LIST(MILLISECONDS_ID)
+#undef MILLISECONDS_ID
 #define COUNTER_ID(name, caption) k_##name,
     STATS_COUNTER_LIST_1(COUNTER_ID)
     STATS_COUNTER_LIST_2(COUNTER_ID)
@@ -374,6 +395,11 @@ class Counters {
   HISTOGRAM_PERCENTAGE_LIST(HP)
 #undef HP
 
+#define HM(name, caption) \
+  Histogram name##_;
+  HISTOGRAM_MILLISECONDS_LIST(HM)
+#undef HM
+
 #define SC(name, caption) \
   StatsCounter name##_;
   STATS_COUNTER_LIST_1(SC)
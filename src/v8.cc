@@ -194,6 +194,20 @@ bool V8::IdleNotification(int hint) {
 }
 
 
+bool V8::IdleNotificationDeadline(int idle_time_in_ms,
+                                  int* work_done,
+                                  double* time_needed_in_ms) {
+  if (!FLAG_use_idle_notification) {
+    *work_done = v8::IdleTaskReport::kNoWork;
+    *time_needed_in_ms = 0;
+    return true;
+  }
+  return HEAP->IdleNotificationDeadline(idle_time_in_ms,
+                                        work_done,
+                                        time_needed_in_ms);
+}
+
+
 void V8::AddCallCompletedCallback(CallCompletedCallback callback) {
   if (call_completed_callbacks_ == NULL) {  // Lazy init.
     call_completed_callbacks_ = new List<CallCompletedCallback>();
@@ -0,0 +1,259 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_WORK_STEALING_LIST_INL_H_
+#define V8_WORK_STEALING_LIST_INL_H_
+
+#include "work-stealing-list.h"
+
+namespace v8 {
+namespace internal {
+
+
+// A segment of a work list, a small stack of entries.
+template<typename Entry, int kSegmentCapacity>
+class WorkStealingList<Entry, kSegmentCapacity>::Segment : public Malloced {
+ public:
+  Segment() : length_(0), next_(NULL) { }
+
+  bool IsEmpty() { return length_ == 0; }
+  bool IsFull() { return length_ == kSegmentCapacity; }
+  int length() { return length_; }
+
+  Segment* next() { return next_; }
+  void set_next(Segment* next) { next_ = next; }
+
+  void Push(const Entry& entry) {
+    ASSERT(!IsFull());
+    entries_[length_++] = entry;
+  }
+
+  Entry Pop() {
+    ASSERT(!IsEmpty());
+    return entries_[--length_];
+  }
+
+  // Moves the older half of the entries to the empty segment |other|.
+  void SplitInto(Segment* other) {
+    ASSERT(other->IsEmpty());
+    int half = length_ / 2;
+    for (int i = 0; i < half; i++) {
+      other->Push(entries_[i]);
+    }
+    for (int i = half; i < length_; i++) {
+      entries_[i - half] = entries_[i];
+    }
+    length_ -= half;
+  }
+
+ private:
+  int length_;
+  Segment* next_;
+  Entry entries_[kSegmentCapacity];
+};
+
+
+template<typename Entry, int kSegmentCapacity>
+WorkStealingList<Entry, kSegmentCapacity>::WorkStealingList()
+    : number_of_tasks_(0),
+      active_tasks_(0),
+      published_segments_(0),
+      available_segments_(kMaxInt) {
+  for (int i = 0; i < kMaxTasks; i++) {
+    local_[i] = NULL;
+    shared_[i] = NULL;
+    shared_mutex_[i] = NULL;
+  }
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+WorkStealingList<Entry, kSegmentCapacity>::~WorkStealingList() {
+  TearDown();
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+void WorkStealingList<Entry, kSegmentCapacity>::SetUp(int number_of_tasks) {
+  ASSERT(number_of_tasks_ == 0);
+  ASSERT(number_of_tasks > 0 && number_of_tasks <= kMaxTasks);
+  number_of_tasks_ = number_of_tasks;
+  for (int i = 0; i < number_of_tasks; i++) {
+    local_[i] = new Segment();
+    shared_mutex_[i] = OS::CreateMutex();
+  }
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+void WorkStealingList<Entry, kSegmentCapacity>::TearDown() {
+  ASSERT(number_of_tasks_ == 0 || IsEmpty());
+  for (int i = 0; i < number_of_tasks_; i++) {
+    delete local_[i];
+    local_[i] = NULL;
+    delete shared_mutex_[i];
+    shared_mutex_[i] = NULL;
+  }
+  number_of_tasks_ = 0;
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+void WorkStealingList<Entry, kSegmentCapacity>::set_available_segments(
+    intptr_t segments) {
+  available_segments_ = segments;
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+void WorkStealingList<Entry, kSegmentCapacity>::StartPhase() {
+  active_tasks_ = number_of_tasks_;
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+bool WorkStealingList<Entry, kSegmentCapacity>::Push(int task_id,
+                                                     const Entry& entry) {
+  Segment* local = local_[task_id];
+  if (local->IsFull()) {
+    if (!AllocateSegment()) return false;
+    Publish(task_id, local);
+    local = local_[task_id] = new Segment();
+  }
+  local->Push(entry);
+  return true;
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+bool WorkStealingList<Entry, kSegmentCapacity>::Pop(int task_id,
+                                                    Entry* entry) {
+  Segment* local = local_[task_id];
+  if (local->IsEmpty()) {
+    Segment* segment = TakeSharedSegment(task_id);
+    if (segment == NULL) return false;
+    ReleaseSegment(local);
+    local = local_[task_id] = segment;
+  } else if (local->length() > 1 &&
+             shared_[task_id] == NULL &&
+             NoBarrier_Load(&active_tasks_) < number_of_tasks_ &&
+             AllocateSegment()) {
+    // Some tasks are idle, share half of the local work with them.
+    Segment* segment = new Segment();
+    local->SplitInto(segment);
+    Publish(task_id, segment);
+  }
+  *entry = local->Pop();
+  return true;
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+bool WorkStealingList<Entry, kSegmentCapacity>::Steal(int task_id) {
+  ASSERT(local_[task_id]->IsEmpty());
+  for (int i = 1; i < number_of_tasks_; i++) {
+    Segment* segment = TakeSharedSegment((task_id + i) % number_of_tasks_);
+    if (segment != NULL) {
+      ReleaseSegment(local_[task_id]);
+      local_[task_id] = segment;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+bool WorkStealingList<Entry, kSegmentCapacity>::WaitForWork() {
+  Barrier_AtomicIncrement(&active_tasks_, -1);
+  while (true) {
+    if (NoBarrier_Load(&published_segments_) > 0) {
+      Barrier_AtomicIncrement(&active_tasks_, 1);
+      return true;
+    }
+    // Only active tasks can publish new work.
+    if (Acquire_Load(&active_tasks_) == 0) return false;
+    Thread::YieldCPU();
+  }
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+bool WorkStealingList<Entry, kSegmentCapacity>::IsEmpty() {
+  for (int i = 0; i < number_of_tasks_; i++) {
+    if (!local_[i]->IsEmpty() || shared_[i] != NULL) return false;
+  }
+  ASSERT(published_segments_ == 0);
+  return true;
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+bool WorkStealingList<Entry, kSegmentCapacity>::AllocateSegment() {
+  if (Barrier_AtomicIncrement(&available_segments_, -1) >= 0) return true;
+  Barrier_AtomicIncrement(&available_segments_, 1);
+  return false;
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+void WorkStealingList<Entry, kSegmentCapacity>::ReleaseSegment(
+    Segment* segment) {
+  ASSERT(segment->IsEmpty());
+  delete segment;
+  Barrier_AtomicIncrement(&available_segments_, 1);
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+void WorkStealingList<Entry, kSegmentCapacity>::Publish(int task_id,
+                                                        Segment* segment) {
+  ScopedLock lock(shared_mutex_[task_id]);
+  segment->set_next(shared_[task_id]);
+  shared_[task_id] = segment;
+  Barrier_AtomicIncrement(&published_segments_, 1);
+}
+
+
+template<typename Entry, int kSegmentCapacity>
+typename WorkStealingList<Entry, kSegmentCapacity>::Segment*
+    WorkStealingList<Entry, kSegmentCapacity>::TakeSharedSegment(
+        int task_id) {
+  if (shared_[task_id] == NULL) return NULL;
+  ScopedLock lock(shared_mutex_[task_id]);
+  Segment* segment = shared_[task_id];
+  if (segment != NULL) {
+    shared_[task_id] = segment->next();
+    segment->set_next(NULL);
+    Barrier_AtomicIncrement(&published_segments_, -1);
+  }
+  return segment;
+}
+
+} }  // namespace v8::internal
+
+#endif  // V8_WORK_STEALING_LIST_INL_H_
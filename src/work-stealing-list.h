@@ -0,0 +1,113 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef V8_WORK_STEALING_LIST_H_
+#define V8_WORK_STEALING_LIST_H_
+
+#include "allocation.h"
+#include "atomicops.h"
+#include "platform.h"
+
+namespace v8 {
+namespace internal {
+
+
+// The work lists of a group of tasks that run in parallel and balance their
+// work by stealing from each other.
+//
+// Each task pushes and pops entries on a local segment that only it
+// accesses.  Full segments, and half of the local segment when other tasks
+// are idle, are published on a shared list of the task, from which idle
+// tasks steal whole segments.  The number of segments can be bounded; Push()
+// fails when the budget is used up.
+template<typename Entry, int kSegmentCapacity>
+class WorkStealingList {
+ public:
+  static const int kMaxTasks = 16;
+
+  inline WorkStealingList();
+  inline ~WorkStealingList();
+
+  // Creates the local and shared lists of |number_of_tasks| tasks.
+  inline void SetUp(int number_of_tasks);
+  inline void TearDown();
+
+  // Limits the number of segments that can be allocated in addition to the
+  // local segments of the tasks.  Unbounded by default.
+  inline void set_available_segments(intptr_t segments);
+
+  // Called before the tasks are started.  Marks all tasks active.
+  inline void StartPhase();
+
+  // Pushes an entry on the local segment of the task.  Returns false if
+  // the segment is full and the segment budget is used up.
+  inline bool Push(int task_id, const Entry& entry);
+
+  // Pops an entry from the local segment of the task, refilling it from
+  // the task's shared list.  Returns false if the task has no work left.
+  inline bool Pop(int task_id, Entry* entry);
+
+  // Moves a segment published by another task to the local segment of the
+  // task.  Returns false if there was nothing to steal.
+  inline bool Steal(int task_id);
+
+  // Called by a task that has run out of work.  Returns true when some task
+  // publishes new work, and false once all tasks have run out of work.
+  inline bool WaitForWork();
+
+  // Returns whether all lists are empty.  Only valid between phases.
+  inline bool IsEmpty();
+
+  int number_of_tasks() { return number_of_tasks_; }
+
+ private:
+  class Segment;
+
+  inline bool AllocateSegment();
+  inline void ReleaseSegment(Segment* segment);
+  inline void Publish(int task_id, Segment* segment);
+  inline Segment* TakeSharedSegment(int task_id);
+
+  int number_of_tasks_;
+  Segment* local_[kMaxTasks];
+  Segment* shared_[kMaxTasks];
+  Mutex* shared_mutex_[kMaxTasks];
+
+  // Number of tasks that have not run out of work and number of segments
+  // published by the tasks.
+  volatile AtomicWord active_tasks_;
+  volatile AtomicWord published_segments_;
+
+  // Number of segments the tasks may still allocate.
+  volatile AtomicWord available_segments_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingList);
+};
+
+} }  // namespace v8::internal
+
+#endif  // V8_WORK_STEALING_LIST_H_
@@ -189,9 +189,38 @@ static void Generate_JSConstructStubHelper(MacroAssembler* masm,
         __ bind(&allocate);
       }
 
+      // Objects are followed by an allocation memento if the constructor has
+      // an allocation site.  Constructors whose objects are pretenured
+      // allocate them in the runtime.  Only function literals that are not
+      // bound have the allocation site slot in their literals.
+      bool track_allocation_site =
+          !is_api_function && AllocationSite::CanTrack();
+      if (track_allocation_site) {
+        Label no_allocation_site;
+        __ Set(r8, 0);
+        __ movq(r9, FieldOperand(rdi, JSFunction::kSharedFunctionInfoOffset));
+        __ movl(r9, FieldOperand(r9, SharedFunctionInfo::kCompilerHintsOffset));
+        __ andl(r9, Immediate((1 << SharedFunctionInfo::kIsFunction) |
+                              (1 << SharedFunctionInfo::kBoundFunction)));
+        __ cmpl(r9, Immediate(1 << SharedFunctionInfo::kIsFunction));
+        __ j(not_equal, &no_allocation_site, Label::kNear);
+        __ movq(r9, FieldOperand(rdi, JSFunction::kLiteralsOffset));
+        __ movq(r9, FieldOperand(r9, FixedArray::OffsetOfElementAt(
+            JSFunction::kLiteralAllocationSiteIndex)));
+        __ CompareRoot(r9, Heap::kUndefinedValueRootIndex);
+        __ j(equal, &no_allocation_site, Label::kNear);
+        __ SmiCompare(
+            FieldOperand(r9, AllocationSite::kPretenureDecisionOffset),
+            Smi::FromInt(AllocationSite::kTenure));
+        __ j(equal, &rt_call);
+        __ Set(r8, AllocationMemento::kSize);
+        __ bind(&no_allocation_site);
+      }
+
       // Now allocate the JSObject on the heap.
       __ movzxbq(rdi, FieldOperand(rax, Map::kInstanceSizeOffset));
       __ shl(rdi, Immediate(kPointerSizeLog2));
+      if (track_allocation_site) __ addq(rdi, r8);
       // rdi: size of new object
       __ AllocateInNewSpace(rdi,
                             rbx,
@@ -199,6 +228,22 @@ static void Generate_JSConstructStubHelper(MacroAssembler* masm,
                             no_reg,
                             &rt_call,
                             NO_ALLOCATION_FLAGS);
+      if (track_allocation_site) {
+        // rdi: end of the object proper, where the memento goes.
+        // r8: size of the memento
+        // r9: allocation site
+        Label no_memento;
+        __ subq(rdi, r8);
+        __ testq(r8, r8);
+        __ j(zero, &no_memento, Label::kNear);
+        __ LoadRoot(rcx, Heap::kAllocationMementoMapRootIndex);
+        __ movq(Operand(rdi, HeapObject::kMapOffset), rcx);
+        __ movq(Operand(rdi, AllocationMemento::kAllocationSiteOffset), r9);
+        __ SmiAddConstant(
+            FieldOperand(r9, AllocationSite::kMementoCreateCountOffset),
+            Smi::FromInt(1));
+        __ bind(&no_memento);
+      }
       // Allocated the JSObject, now initialize the fields.
       // rax: initial map
       // rbx: JSObject (not HeapObject tagged - the actual address).
@@ -237,6 +282,10 @@ static void Generate_JSConstructStubHelper(MacroAssembler* masm,
       // rbx: JSObject
       // rdi: start of next object
       __ or_(rbx, Immediate(kHeapObjectTag));
+      if (track_allocation_site) {
+        // Step over the memento so that rdi is the allocation top again.
+        __ addq(rdi, r8);
+      }
 
       // Check if a non-empty properties array is needed.
       // Allocate and initialize a FixedArray if it is.
@@ -300,14 +300,46 @@ void FastNewBlockContextStub::Generate(MacroAssembler* masm) {
 }
 
 
+// Writes an allocation memento for the allocation site in rdi at the given
+// offset from the new object in rax and counts the allocation.
+static void GenerateAllocationMemento(MacroAssembler* masm, int offset) {
+  __ LoadRoot(rbx, Heap::kAllocationMementoMapRootIndex);
+  __ movq(FieldOperand(rax, offset), rbx);
+  __ movq(FieldOperand(rax, offset + AllocationMemento::kAllocationSiteOffset),
+          rdi);
+  __ SmiAddConstant(
+      FieldOperand(rdi, AllocationSite::kMementoCreateCountOffset),
+      Smi::FromInt(1));
+}
+
+
+// Loads the allocation site of the literal into rdi and bails out to the
+// runtime if it is missing or its objects are allocated in old space.
+static void GenerateLoadLiteralAllocationSite(MacroAssembler* masm,
+                                              int literals_stack_offset,
+                                              SmiIndex index,
+                                              Label* fail) {
+  __ movq(rdi, Operand(rsp, literals_stack_offset));
+  __ movq(rdi, FieldOperand(rdi, index.reg, index.scale,
+                            FixedArray::kHeaderSize + kPointerSize));
+  __ CompareRoot(rdi, Heap::kUndefinedValueRootIndex);
+  __ j(equal, fail);
+  __ SmiCompare(FieldOperand(rdi, AllocationSite::kPretenureDecisionOffset),
+                Smi::FromInt(AllocationSite::kTenure));
+  __ j(equal, fail);
+}
+
+
 static void GenerateFastCloneShallowArrayCommon(
     MacroAssembler* masm,
     int length,
     FastCloneShallowArrayStub::Mode mode,
+    bool track_allocation_site,
     Label* fail) {
   // Registers on entry:
   //
   // rcx: boilerplate literal array.
+  // rdi: allocation site, if track_allocation_site is set.
   ASSERT(mode != FastCloneShallowArrayStub::CLONE_ANY_ELEMENTS);
 
   // All sizes here are multiples of kPointerSize.
@@ -317,7 +349,9 @@ static void GenerateFastCloneShallowArrayCommon(
         ? FixedDoubleArray::SizeFor(length)
         : FixedArray::SizeFor(length);
   }
-  int size = JSArray::kSize + elements_size;
+  // The allocation memento, if any, directly follows the JS array.
+  int memento_size = track_allocation_site ? AllocationMemento::kSize : 0;
+  int size = JSArray::kSize + memento_size + elements_size;
 
   // Allocate both the JS array and the elements array in one big
   // allocation. This avoids multiple limit checks.
@@ -331,11 +365,15 @@ static void GenerateFastCloneShallowArrayCommon(
     }
   }
 
+  if (track_allocation_site) {
+    GenerateAllocationMemento(masm, JSArray::kSize);
+  }
+
   if (length > 0) {
     // Get hold of the elements array of the boilerplate and setup the
     // elements pointer in the resulting object.
     __ movq(rcx, FieldOperand(rcx, JSArray::kElementsOffset));
-    __ lea(rdx, Operand(rax, JSArray::kSize));
+    __ lea(rdx, Operand(rax, JSArray::kSize + memento_size));
     __ movq(FieldOperand(rax, JSArray::kElementsOffset), rdx);
 
     // Copy the elements array.
@@ -379,6 +417,12 @@ void FastCloneShallowArrayStub::Generate(MacroAssembler* masm) {
   Label slow_case;
   __ j(equal, &slow_case);
 
+  bool track_allocation_site = AllocationSite::CanTrack();
+  if (track_allocation_site) {
+    GenerateLoadLiteralAllocationSite(masm, 3 * kPointerSize, index,
+                                      &slow_case);
+  }
+
   FastCloneShallowArrayStub::Mode mode = mode_;
   // rcx is boilerplate object.
   Factory* factory = masm->isolate()->factory();
@@ -388,16 +432,16 @@ void FastCloneShallowArrayStub::Generate(MacroAssembler* masm) {
     __ Cmp(FieldOperand(rbx, HeapObject::kMapOffset),
            factory->fixed_cow_array_map());
     __ j(not_equal, &check_fast_elements);
-    GenerateFastCloneShallowArrayCommon(masm, 0,
-                                        COPY_ON_WRITE_ELEMENTS, &slow_case);
+    GenerateFastCloneShallowArrayCommon(masm, 0, COPY_ON_WRITE_ELEMENTS,
+                                        track_allocation_site, &slow_case);
     __ ret(3 * kPointerSize);
 
     __ bind(&check_fast_elements);
     __ Cmp(FieldOperand(rbx, HeapObject::kMapOffset),
            factory->fixed_array_map());
     __ j(not_equal, &double_elements);
-    GenerateFastCloneShallowArrayCommon(masm, length_,
-                                        CLONE_ELEMENTS, &slow_case);
+    GenerateFastCloneShallowArrayCommon(masm, length_, CLONE_ELEMENTS,
+                                        track_allocation_site, &slow_case);
     __ ret(3 * kPointerSize);
 
     __ bind(&double_elements);
@@ -427,7 +471,8 @@ void FastCloneShallowArrayStub::Generate(MacroAssembler* masm) {
     __ pop(rcx);
   }
 
-  GenerateFastCloneShallowArrayCommon(masm, length_, mode, &slow_case);
+  GenerateFastCloneShallowArrayCommon(masm, length_, mode,
+                                      track_allocation_site, &slow_case);
   __ ret(3 * kPointerSize);
 
   __ bind(&slow_case);
@@ -454,6 +499,12 @@ void FastCloneShallowObjectStub::Generate(MacroAssembler* masm) {
   __ CompareRoot(rcx, Heap::kUndefinedValueRootIndex);
   __ j(equal, &slow_case);
 
+  bool track_allocation_site = AllocationSite::CanTrack();
+  if (track_allocation_site) {
+    GenerateLoadLiteralAllocationSite(masm, 4 * kPointerSize, index,
+                                      &slow_case);
+  }
+
   // Check that the boilerplate contains only fast properties and we can
   // statically determine the instance size.
   int size = JSObject::kHeaderSize + length_ * kPointerSize;
@@ -462,13 +513,27 @@ void FastCloneShallowObjectStub::Generate(MacroAssembler* masm) {
   __ cmpq(rax, Immediate(size >> kPointerSizeLog2));
   __ j(not_equal, &slow_case);
 
+  // Copies of objects with double fields need boxes of their own.
+  if (JSObject::CanUseDoubleFields()) {
+    __ movq(rax, FieldOperand(rcx, HeapObject::kMapOffset));
+    __ SmiToInteger32(rax, FieldOperand(rax, Map::kBitField3Offset));
+    __ testl(rax, Immediate(Map::HasDoubleFields::kMask));
+    __ j(not_zero, &slow_case);
+  }
+
   // Allocate the JS object and copy header together with all in-object
-  // properties from the boilerplate.
-  __ AllocateInNewSpace(size, rax, rbx, rdx, &slow_case, TAG_OBJECT);
+  // properties from the boilerplate.  The allocation memento, if any,
+  // directly follows the object.
+  int memento_size = track_allocation_site ? AllocationMemento::kSize : 0;
+  __ AllocateInNewSpace(size + memento_size, rax, rbx, rdx, &slow_case,
+                        TAG_OBJECT);
   for (int i = 0; i < size; i += kPointerSize) {
     __ movq(rbx, FieldOperand(rcx, i));
     __ movq(FieldOperand(rax, i), rbx);
   }
+  if (track_allocation_site) {
+    GenerateAllocationMemento(masm, size);
+  }
 
   // Return and remove the on-stack parameters.
   __ ret(4 * kPointerSize);
@@ -6270,9 +6335,53 @@ void RecordWriteStub::CheckNeedsToInformIncrementalMarker(
     OnNoNeedToInformIncrementalMarker on_no_need,
     Mode mode) {
   Label on_black;
+  Label not_concurrent;
   Label need_incremental;
   Label need_incremental_pop_object;
 
+  __ LoadAddress(
+      regs_.scratch0(),
+      ExternalReference::concurrent_marking_active(masm->isolate()));
+  __ cmpq(Operand(regs_.scratch0(), 0), Immediate(0));
+  __ j(equal, &not_concurrent);
+
+  // The concurrent marker may be visiting the object right now, so its color
+  // does not tell whether the value will be found.  A value that is already
+  // grey or black needs nothing else.  The mark bits must not be changed
+  // here, so white values are left to the incremental marker.
+  __ movq(regs_.scratch0(), Operand(regs_.address(), 0));
+
+  if (mode == INCREMENTAL_COMPACTION) {
+    // Slots pointing to evacuation candidates are recorded by the runtime.
+    __ CheckPageFlag(regs_.scratch0(),  // Contains value.
+                     regs_.scratch1(),  // Scratch.
+                     MemoryChunk::kEvacuationCandidateMask,
+                     not_zero,
+                     &need_incremental);
+  }
+
+  // We need an extra register for this, so we push the object register
+  // temporarily.
+  __ push(regs_.object());
+  __ JumpIfWhite(regs_.scratch0(),  // The value.
+                 regs_.scratch1(),  // Scratch.
+                 regs_.object(),  // Scratch.
+                 &need_incremental_pop_object);
+  __ pop(regs_.object());
+
+  regs_.Restore(masm);
+  if (on_no_need == kUpdateRememberedSetOnNoNeedToInformIncrementalMarker) {
+    __ RememberedSetHelper(object_,
+                           address_,
+                           value_,
+                           save_fp_regs_mode_,
+                           MacroAssembler::kReturnAtEnd);
+  } else {
+    __ ret(0);
+  }
+
+  __ bind(&not_concurrent);
+
   // Let's look at the color of the object:  If it is not black we don't have
   // to inform the incremental marker.
   __ JumpIfBlack(regs_.object(),
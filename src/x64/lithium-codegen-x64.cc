@@ -364,7 +364,7 @@ void LCodeGen::WriteTranslation(LEnvironment* environment,
   if (environment == NULL) return;
 
   // The translation includes one command per value in the environment.
-  int translation_size = environment->values()->length();
+  int translation_size = environment->translation_size();
   // The output frame height does not include the parameters.
   int height = translation_size - environment->parameter_count();
 
@@ -408,11 +408,38 @@ void LCodeGen::WriteTranslation(LEnvironment* environment,
       }
     }
 
+    LCapturedObject* object =
+        value == NULL ? environment->CapturedObjectAt(i) : NULL;
+    if (object != NULL) {
+      AddCapturedObjectToTranslation(environment, translation, object);
+      continue;
+    }
+
     AddToTranslation(translation, value, environment->HasTaggedValueAt(i));
   }
 }
 
 
+void LCodeGen::AddCapturedObjectToTranslation(LEnvironment* environment,
+                                              Translation* translation,
+                                              LCapturedObject* object) {
+  // Objects in several slots or frames are described once.
+  if (translation->HasCapturedObject(object->capture_id())) {
+    translation->DuplicateObject(object->capture_id());
+    return;
+  }
+  translation->BeginCapturedObject(object->capture_id(),
+                                   DefineDeoptimizationLiteral(object->map()),
+                                   object->field_count());
+  for (int i = 0; i < object->field_count(); ++i) {
+    int index = object->first_field() + i;
+    AddToTranslation(translation,
+                     environment->values()->at(index),
+                     environment->HasTaggedValueAt(index));
+  }
+}
+
+
 void LCodeGen::AddToTranslation(Translation* translation,
                                 LOperand* op,
                                 bool is_tagged) {
@@ -2270,6 +2297,13 @@ void LCodeGen::DoStoreContextSlot(LStoreContextSlot* instr) {
 
 void LCodeGen::DoLoadNamedField(LLoadNamedField* instr) {
   Register object = ToRegister(instr->InputAt(0));
+  if (instr->hydrogen()->is_double_field()) {
+    XMMRegister result = ToDoubleRegister(instr->result());
+    __ movq(kScratchRegister,
+            FieldOperand(object, instr->hydrogen()->offset()));
+    __ movsd(result, FieldOperand(kScratchRegister, HeapNumber::kValueOffset));
+    return;
+  }
   Register result = ToRegister(instr->result());
   if (instr->hydrogen()->is_in_object()) {
     __ movq(result, FieldOperand(object, instr->hydrogen()->offset()));
@@ -3478,10 +3512,59 @@ void LCodeGen::DoCallRuntime(LCallRuntime* instr) {
 
 
 void LCodeGen::DoStoreNamedField(LStoreNamedField* instr) {
+  class DeferredAllocateBox: public LDeferredCode {
+   public:
+    DeferredAllocateBox(LCodeGen* codegen, LStoreNamedField* instr)
+        : LDeferredCode(codegen), instr_(instr) { }
+    virtual void Generate() { codegen()->DoDeferredAllocateBox(instr_); }
+    virtual LInstruction* instr() { return instr_; }
+   private:
+    LStoreNamedField* instr_;
+  };
+
   Register object = ToRegister(instr->object());
-  Register value = ToRegister(instr->value());
   int offset = instr->offset();
 
+  if (instr->hydrogen()->is_double_field()) {
+    // Overwrite the number in the field's box.  If the box has been handed
+    // out as a number, the field gets a new box instead.
+    ASSERT(instr->is_in_object() && instr->transition().is_null());
+    XMMRegister value = ToDoubleRegister(instr->value());
+    Register box = ToRegister(instr->TempAt(0));
+    Register temp = ToRegister(instr->TempAt(1));
+    Label new_box, done;
+    __ movq(box, FieldOperand(object, offset));
+    __ CompareRoot(FieldOperand(box, HeapObject::kMapOffset),
+                   Heap::kMutableHeapNumberMapRootIndex);
+    __ j(not_equal, &new_box, Label::kNear);
+    __ movsd(FieldOperand(box, HeapNumber::kValueOffset), value);
+    __ jmp(&done);
+
+    __ bind(&new_box);
+    DeferredAllocateBox* deferred = new(zone()) DeferredAllocateBox(this, instr);
+    if (FLAG_inline_new) {
+      __ AllocateHeapNumber(box, temp, deferred->entry());
+    } else {
+      __ jmp(deferred->entry());
+    }
+    __ bind(deferred->exit());
+    __ LoadRoot(kScratchRegister, Heap::kMutableHeapNumberMapRootIndex);
+    __ movq(FieldOperand(box, HeapObject::kMapOffset), kScratchRegister);
+    __ movsd(FieldOperand(box, HeapNumber::kValueOffset), value);
+    __ movq(FieldOperand(object, offset), box);
+    __ RecordWriteField(object,
+                        offset,
+                        box,
+                        temp,
+                        kSaveFPRegs,
+                        EMIT_REMEMBERED_SET,
+                        OMIT_SMI_CHECK);
+    __ bind(&done);
+    return;
+  }
+
+  Register value = ToRegister(instr->value());
+
   if (!instr->transition().is_null()) {
     if (!instr->hydrogen()->NeedsWriteBarrierForMap()) {
       __ Move(FieldOperand(object, HeapObject::kMapOffset),
@@ -3956,6 +4039,18 @@ void LCodeGen::DoDeferredNumberTagD(LNumberTagD* instr) {
 }
 
 
+void LCodeGen::DoDeferredAllocateBox(LStoreNamedField* instr) {
+  Register box = ToRegister(instr->TempAt(0));
+  {
+    PushSafepointRegistersScope scope(this);
+    CallRuntimeFromDeferred(Runtime::kAllocateHeapNumber, 0, instr);
+    // Ensure that value in rax survives popping registers.
+    __ movq(kScratchRegister, rax);
+  }
+  __ movq(box, kScratchRegister);
+}
+
+
 void LCodeGen::DoSmiTag(LSmiTag* instr) {
   ASSERT(instr->InputAt(0)->Equals(instr->result()));
   Register input = ToRegister(instr->InputAt(0));
@@ -4358,17 +4453,45 @@ void LCodeGen::DoAllocateObject(LAllocateObject* instr) {
          initial_map->unused_property_fields() -
          initial_map->inobject_properties() == 0);
 
+  // Deopt once the allocation site decides to pretenure the constructor's
+  // objects, so that the unoptimized code lets the runtime allocate them in
+  // old space.
+  Handle<AllocationSite> allocation_site =
+      instr->hydrogen()->allocation_site();
+  int memento_size = allocation_site.is_null() ? 0 : AllocationMemento::kSize;
+  if (!allocation_site.is_null()) {
+    __ LoadHeapObject(scratch, allocation_site);
+    __ SmiCompare(
+        FieldOperand(scratch, AllocationSite::kPretenureDecisionOffset),
+        Smi::FromInt(AllocationSite::kTenure));
+    DeoptimizeIf(equal, instr->environment());
+  }
+
   // Allocate memory for the object.  The initial map might change when
   // the constructor's prototype changes, but instance size and property
   // counts remain unchanged (if slack tracking finished).
   ASSERT(!constructor->shared()->IsInobjectSlackTrackingInProgress());
-  __ AllocateInNewSpace(instance_size,
+  __ AllocateInNewSpace(instance_size + memento_size,
                         result,
                         no_reg,
                         scratch,
                         deferred->entry(),
                         TAG_OBJECT);
 
+  // Objects allocated by the deferred code have no allocation memento.
+  if (!allocation_site.is_null()) {
+    __ LoadRoot(scratch, Heap::kAllocationMementoMapRootIndex);
+    __ movq(FieldOperand(result, instance_size), scratch);
+    __ LoadHeapObject(scratch, allocation_site);
+    __ movq(FieldOperand(result,
+                         instance_size +
+                             AllocationMemento::kAllocationSiteOffset),
+            scratch);
+    __ SmiAddConstant(
+        FieldOperand(scratch, AllocationSite::kMementoCreateCountOffset),
+        Smi::FromInt(1));
+  }
+
   __ bind(deferred->exit());
   if (FLAG_debug_code) {
     Label is_in_new_space;
@@ -4484,6 +4607,7 @@ void LCodeGen::DoArrayLiteral(LArrayLiteral* instr) {
 
 
 void LCodeGen::EmitDeepCopy(Handle<JSObject> object,
+                            Handle<AllocationSite> allocation_site,
                             Register result,
                             Register source,
                             int* offset) {
@@ -4496,12 +4620,14 @@ void LCodeGen::EmitDeepCopy(Handle<JSObject> object,
       elements->map() != isolate()->heap()->fixed_cow_array_map();
 
   // Increase the offset so that subsequent objects end up right after
-  // this object and its backing store.
+  // this object, its allocation memento and its backing store.
   int object_offset = *offset;
   int object_size = object->map()->instance_size();
-  int elements_offset = *offset + object_size;
+  int memento_offset = *offset + object_size;
+  int memento_size = allocation_site.is_null() ? 0 : AllocationMemento::kSize;
+  int elements_offset = memento_offset + memento_size;
   int elements_size = has_elements ? elements->Size() : 0;
-  *offset += object_size + elements_size;
+  *offset += object_size + memento_size + elements_size;
 
   // Copy object header.
   ASSERT(object->properties()->length() == 0);
@@ -4516,6 +4642,19 @@ void LCodeGen::EmitDeepCopy(Handle<JSObject> object,
     __ movq(FieldOperand(result, object_offset + i), rcx);
   }
 
+  if (!allocation_site.is_null()) {
+    __ LoadRoot(rcx, Heap::kAllocationMementoMapRootIndex);
+    __ movq(FieldOperand(result, memento_offset), rcx);
+    __ LoadHeapObject(rcx, allocation_site);
+    __ movq(FieldOperand(result,
+                         memento_offset +
+                             AllocationMemento::kAllocationSiteOffset),
+            rcx);
+    __ SmiAddConstant(
+        FieldOperand(rcx, AllocationSite::kMementoCreateCountOffset),
+        Smi::FromInt(1));
+  }
+
   // Copy in-object properties.
   for (int i = 0; i < inobject_properties; i++) {
     int total_offset = object_offset + object->GetInObjectPropertyOffset(i);
@@ -4525,7 +4664,8 @@ void LCodeGen::EmitDeepCopy(Handle<JSObject> object,
       __ lea(rcx, Operand(result, *offset));
       __ movq(FieldOperand(result, total_offset), rcx);
       __ LoadHeapObject(source, value_object);
-      EmitDeepCopy(value_object, result, source, offset);
+      EmitDeepCopy(value_object, Handle<AllocationSite>::null(),
+                   result, source, offset);
     } else if (value->IsHeapObject()) {
       __ LoadHeapObject(rcx, Handle<HeapObject>::cast(value));
       __ movq(FieldOperand(result, total_offset), rcx);
@@ -4565,7 +4705,8 @@ void LCodeGen::EmitDeepCopy(Handle<JSObject> object,
           __ lea(rcx, Operand(result, *offset));
           __ movq(FieldOperand(result, total_offset), rcx);
           __ LoadHeapObject(source, value_object);
-          EmitDeepCopy(value_object, result, source, offset);
+          EmitDeepCopy(value_object, Handle<AllocationSite>::null(),
+                   result, source, offset);
         } else if (value->IsHeapObject()) {
           __ LoadHeapObject(rcx, Handle<HeapObject>::cast(value));
           __ movq(FieldOperand(result, total_offset), rcx);
@@ -4602,6 +4743,16 @@ void LCodeGen::DoFastLiteral(LFastLiteral* instr) {
     DeoptimizeIf(not_equal, instr->environment());
   }
 
+  // Deopt once the allocation site decides to pretenure the literal, so
+  // that the unoptimized code lets the runtime allocate it in old space.
+  Handle<AllocationSite> allocation_site = instr->hydrogen()->allocation_site();
+  if (!allocation_site.is_null()) {
+    __ LoadHeapObject(rcx, allocation_site);
+    __ SmiCompare(FieldOperand(rcx, AllocationSite::kPretenureDecisionOffset),
+                  Smi::FromInt(AllocationSite::kTenure));
+    DeoptimizeIf(equal, instr->environment());
+  }
+
   // Allocate all objects that are part of the literal in one big
   // allocation. This avoids multiple limit checks.
   Label allocated, runtime_allocate;
@@ -4615,7 +4766,8 @@ void LCodeGen::DoFastLiteral(LFastLiteral* instr) {
   __ bind(&allocated);
   int offset = 0;
   __ LoadHeapObject(rbx, instr->hydrogen()->boilerplate());
-  EmitDeepCopy(instr->hydrogen()->boilerplate(), rax, rbx, &offset);
+  EmitDeepCopy(instr->hydrogen()->boilerplate(), allocation_site,
+               rax, rbx, &offset);
   ASSERT_EQ(size, offset);
 }
 
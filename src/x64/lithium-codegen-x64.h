@@ -98,6 +98,7 @@ class LCodeGen BASE_EMBEDDED {
 
   // Deferred code support.
   void DoDeferredNumberTagD(LNumberTagD* instr);
+  void DoDeferredAllocateBox(LStoreNamedField* instr);
   void DoDeferredTaggedToI(LTaggedToI* instr);
   void DoDeferredMathAbsTaggedHeapNumber(LUnaryMathOperation* instr);
   void DoDeferredStackCheck(LStackCheck* instr);
@@ -224,6 +225,9 @@ class LCodeGen BASE_EMBEDDED {
   void AddToTranslation(Translation* translation,
                         LOperand* op,
                         bool is_tagged);
+  void AddCapturedObjectToTranslation(LEnvironment* environment,
+                                      Translation* translation,
+                                      LCapturedObject* object);
   void PopulateDeoptimizationData(Handle<Code> code);
   int DefineDeoptimizationLiteral(Handle<Object> literal);
 
@@ -308,8 +312,10 @@ class LCodeGen BASE_EMBEDDED {
   void EmitPushTaggedOperand(LOperand* operand);
 
   // Emits optimized code to deep-copy the contents of statically known
-  // object graphs (e.g. object literal boilerplate).
+  // object graphs (e.g. object literal boilerplate).  If an allocation site
+  // is given, the copy of the object is followed by an allocation memento.
   void EmitDeepCopy(Handle<JSObject> object,
+                    Handle<AllocationSite> allocation_site,
                     Register result,
                     Register source,
                     int* offset);
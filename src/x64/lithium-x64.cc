@@ -802,6 +802,8 @@ void LChunkBuilder::DoBasicBlock(HBasicBlock* block, HBasicBlock* next_block) {
     HEnvironment* last_environment = pred->last_environment();
     for (int i = 0; i < block->phis()->length(); ++i) {
       HPhi* phi = block->phis()->at(i);
+      // The field phis of captured objects are not environment values.
+      if (!phi->HasMergedIndex()) continue;
       last_environment->SetValueAt(phi->merged_index(), phi);
     }
     for (int i = 0; i < block->deleted_phis()->length(); ++i) {
@@ -869,7 +871,7 @@ LEnvironment* LChunkBuilder::CreateEnvironment(
       ast_id,
       hydrogen_env->parameter_count(),
       argument_count_,
-      value_count,
+      value_count + hydrogen_env->CapturedFieldCount(),
       outer,
       zone());
   int argument_index = *argument_index_accumulator;
@@ -880,6 +882,12 @@ LEnvironment* LChunkBuilder::CreateEnvironment(
     LOperand* op = NULL;
     if (value->IsArgumentsObject()) {
       op = NULL;
+    } else if (value->IsCapturedObject()) {
+      HCapturedObject* object = HCapturedObject::cast(value);
+      result->AddCapturedObject(object->capture_id(),
+                                object->map(),
+                                object->OperandCount());
+      continue;
     } else if (value->IsPushArgument()) {
       op = new(zone()) LArgument(argument_index++);
     } else {
@@ -888,6 +896,20 @@ LEnvironment* LChunkBuilder::CreateEnvironment(
     result->AddValue(op, value->representation());
   }
 
+  // The fields of captured objects follow the values of the frame.
+  for (int i = 0; i < value_count; ++i) {
+    if (hydrogen_env->is_special_index(i)) continue;
+
+    HValue* value = hydrogen_env->values()->at(i);
+    if (!value->IsCapturedObject()) continue;
+    HCapturedObject* object = HCapturedObject::cast(value);
+    if (!result->BeginCapturedObjectFields(object->capture_id())) continue;
+    for (int j = 0; j < object->OperandCount(); ++j) {
+      HValue* field = object->OperandAt(j);
+      result->AddCapturedField(UseAny(field), field->representation());
+    }
+  }
+
   if (hydrogen_env->frame_type() == JS_FUNCTION) {
     *argument_index_accumulator = argument_index;
   }
@@ -1762,7 +1784,8 @@ LInstruction* LChunkBuilder::DoStoreContextSlot(HStoreContextSlot* instr) {
 
 
 LInstruction* LChunkBuilder::DoLoadNamedField(HLoadNamedField* instr) {
-  ASSERT(instr->representation().IsTagged());
+  ASSERT(instr->representation().IsTagged() ||
+         (instr->is_double_field() && instr->representation().IsDouble()));
   LOperand* obj = UseRegisterAtStart(instr->object());
   return DefineAsRegister(new(zone()) LLoadNamedField(obj));
 }
@@ -1989,6 +2012,15 @@ LInstruction* LChunkBuilder::DoTransitionElementsKind(
 
 
 LInstruction* LChunkBuilder::DoStoreNamedField(HStoreNamedField* instr) {
+  if (instr->is_double_field()) {
+    // The store gives the field a new box if the old one has been handed
+    // out, which may call into the runtime.
+    LOperand* obj = UseRegister(instr->object());
+    LOperand* val = UseRegister(instr->value());
+    return AssignPointerMap(new(zone()) LStoreNamedField(
+        obj, val, TempRegister(), TempRegister()));
+  }
+
   bool needs_write_barrier = instr->NeedsWriteBarrier();
   bool needs_write_barrier_for_map = !instr->transition().is_null() &&
       instr->NeedsWriteBarrierForMap();
@@ -2013,7 +2045,7 @@ LInstruction* LChunkBuilder::DoStoreNamedField(HStoreNamedField* instr) {
   LOperand* temp = (!instr->is_in_object() || needs_write_barrier ||
       needs_write_barrier_for_map) ? TempRegister() : NULL;
 
-  return new(zone()) LStoreNamedField(obj, val, temp);
+  return new(zone()) LStoreNamedField(obj, val, temp, NULL);
 }
 
 
@@ -2057,7 +2089,12 @@ LInstruction* LChunkBuilder::DoStringLength(HStringLength* instr) {
 
 LInstruction* LChunkBuilder::DoAllocateObject(HAllocateObject* instr) {
   LAllocateObject* result = new(zone()) LAllocateObject(TempRegister());
-  return AssignPointerMap(DefineAsRegister(result));
+  LInstruction* instr_result = AssignPointerMap(DefineAsRegister(result));
+  // Tracked allocations deoptimize when their site decides to pretenure.
+  if (!instr->allocation_site().is_null()) {
+    instr_result = AssignEnvironment(instr_result);
+  }
+  return instr_result;
 }
 
 
@@ -2200,6 +2237,12 @@ LInstruction* LChunkBuilder::DoSimulate(HSimulate* instr) {
 }
 
 
+LInstruction* LChunkBuilder::DoCapturedObject(HCapturedObject* instr) {
+  instr->ReplayEnvironment(current_block_->last_environment());
+  return NULL;
+}
+
+
 LInstruction* LChunkBuilder::DoStackCheck(HStackCheck* instr) {
   if (instr->is_function_entry()) {
     return MarkAsCall(new(zone()) LStackCheck, instr);
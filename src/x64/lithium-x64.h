@@ -1655,12 +1655,16 @@ class LSmiUntag: public LTemplateInstruction<1, 1, 0> {
 };
 
 
-class LStoreNamedField: public LTemplateInstruction<0, 2, 1> {
+class LStoreNamedField: public LTemplateInstruction<0, 2, 2> {
  public:
-  LStoreNamedField(LOperand* object, LOperand* value, LOperand* temp) {
+  LStoreNamedField(LOperand* object,
+                   LOperand* value,
+                   LOperand* temp,
+                   LOperand* temp2) {
     inputs_[0] = object;
     inputs_[1] = value;
     temps_[0] = temp;
+    temps_[1] = temp2;
   }
 
   DECLARE_CONCRETE_INSTRUCTION(StoreNamedField, "store-named-field")
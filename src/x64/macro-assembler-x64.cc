@@ -4300,6 +4300,22 @@ void MacroAssembler::JumpIfBlack(Register object,
 }
 
 
+void MacroAssembler::JumpIfWhite(Register object,
+                                 Register bitmap_scratch,
+                                 Register mask_scratch,
+                                 Label* on_white,
+                                 Label::Distance on_white_distance) {
+  ASSERT(!AreAliased(object, bitmap_scratch, mask_scratch, rcx));
+  GetMarkBits(object, bitmap_scratch, mask_scratch);
+
+  // Since both black and grey have a 1 in the first position and white does
+  // not have a 1 there we only need to check one bit.
+  ASSERT(strcmp(Marking::kWhiteBitPattern, "00") == 0);
+  testq(Operand(bitmap_scratch, MemoryChunk::kHeaderSize), mask_scratch);
+  j(zero, on_white, on_white_distance);
+}
+
+
 // Detect some, but not all, common pointer-free objects.  This is used by the
 // incremental write barrier which doesn't care about oddballs (they are always
 // marked black immediately so this code is not hit).
@@ -212,6 +212,15 @@ class MacroAssembler: public Assembler {
                         Label* not_data_object,
                         Label::Distance not_data_object_distance);
 
+  // Jumps to the label if the object is white.  Only reads the mark bits,
+  // so it can be used while the concurrent marker is running.  Also uses
+  // rcx!
+  void JumpIfWhite(Register object,
+                   Register bitmap_scratch,
+                   Register mask_scratch,
+                   Label* on_white,
+                   Label::Distance on_white_distance = Label::kFar);
+
   // Checks the color of an object.  If the object is already grey or black
   // then we just fall through, since it is already live.  If it is white and
   // we can determine that it doesn't need to be scanned, then we just mark it
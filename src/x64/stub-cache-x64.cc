@@ -787,6 +787,48 @@ void StubCompiler::GenerateStoreField(MacroAssembler* masm,
   // checks.
   ASSERT(object->IsJSGlobalProxy() || !object->IsAccessCheckNeeded());
 
+  bool is_double_field;
+  if (transition.is_null()) {
+    is_double_field = lookup.IsDoubleField();
+  } else {
+    DescriptorArray* descriptors = transition->instance_descriptors();
+    is_double_field =
+        descriptors->GetDetails(transition->LastAdded()).IsDoubleField();
+  }
+
+  if (is_double_field) {
+    // Unpack the number, and allocate a box if the field needs a new one,
+    // before the object is touched so that the stub can still miss.
+    Label heap_number, unpacked;
+    __ JumpIfNotSmi(rax, &heap_number);
+    __ SmiToInteger32(scratch1, rax);
+    __ cvtlsi2sd(xmm0, scratch1);
+    __ jmp(&unpacked);
+    __ bind(&heap_number);
+    __ CheckMap(rax, masm->isolate()->factory()->heap_number_map(),
+                miss_label, DONT_DO_SMI_CHECK);
+    __ movsd(xmm0, FieldOperand(rax, HeapNumber::kValueOffset));
+    __ bind(&unpacked);
+    if (transition.is_null()) {
+      // Overwrite the number in the box unless the box has been handed out.
+      // Double fields are always in-object.
+      Label new_box;
+      int offset = object->map()->instance_size() +
+          ((index - object->map()->inobject_properties()) * kPointerSize);
+      __ movq(scratch2, FieldOperand(receiver_reg, offset));
+      __ CompareRoot(FieldOperand(scratch2, HeapObject::kMapOffset),
+                     Heap::kMutableHeapNumberMapRootIndex);
+      __ j(not_equal, &new_box, Label::kNear);
+      __ movsd(FieldOperand(scratch2, HeapNumber::kValueOffset), xmm0);
+      __ ret(0);
+      __ bind(&new_box);
+    }
+    __ AllocateHeapNumber(scratch2, scratch1, miss_label);
+    __ LoadRoot(scratch1, Heap::kMutableHeapNumberMapRootIndex);
+    __ movq(FieldOperand(scratch2, HeapObject::kMapOffset), scratch1);
+    __ movsd(FieldOperand(scratch2, HeapNumber::kValueOffset), xmm0);
+  }
+
   // Perform map transition for the receiver if necessary.
   if (!transition.is_null() && (object->map()->unused_property_fields() == 0)) {
     // The properties must be extended before we can store the value.
@@ -825,7 +867,14 @@ void StubCompiler::GenerateStoreField(MacroAssembler* masm,
   // object and the number of in-object properties is not going to change.
   index -= object->map()->inobject_properties();
 
-  if (index < 0) {
+  if (is_double_field) {
+    // Store the new box of the double field.
+    ASSERT(index < 0);
+    int offset = object->map()->instance_size() + (index * kPointerSize);
+    __ movq(FieldOperand(receiver_reg, offset), scratch2);
+    __ RecordWriteField(
+        receiver_reg, offset, scratch2, scratch1, kDontSaveFPRegs);
+  } else if (index < 0) {
     // Set the property straight into the object.
     int offset = object->map()->instance_size() + (index * kPointerSize);
     __ movq(FieldOperand(receiver_reg, offset), rax);
@@ -1023,6 +1072,18 @@ void StubCompiler::GenerateLoadField(Handle<JSObject> object,
   Register reg = CheckPrototypes(
       object, receiver, holder, scratch1, scratch2, scratch3, name, miss);
 
+  LookupResult lookup(isolate());
+  holder->LocalLookupRealNamedProperty(*name, &lookup);
+  if (lookup.IsDoubleField()) {
+    // Hand out the box as an ordinary heap number, see
+    // JSObject::FastPropertyAt.
+    GenerateFastPropertyLoad(masm(), rax, reg, holder, index);
+    __ LoadRoot(kScratchRegister, Heap::kHeapNumberMapRootIndex);
+    __ movq(FieldOperand(rax, HeapObject::kMapOffset), kScratchRegister);
+    __ ret(0);
+    return;
+  }
+
   // Get the value from the properties.
   GenerateFastPropertyLoad(masm(), rax, reg, holder, index);
   __ ret(0);
@@ -1144,7 +1205,7 @@ void StubCompiler::GenerateLoadInterceptor(Handle<JSObject> object,
   bool compile_followup_inline = false;
   if (lookup->IsFound() && lookup->IsCacheable()) {
     if (lookup->IsField()) {
-      compile_followup_inline = true;
+      compile_followup_inline = !lookup->IsDoubleField();
     } else if (lookup->type() == CALLBACKS &&
                lookup->GetCallbackObject()->IsAccessorInfo()) {
       AccessorInfo* callback = AccessorInfo::cast(lookup->GetCallbackObject());
@@ -3160,22 +3221,55 @@ Handle<Code> ConstructStubCompiler::CompileConstructStub(
   __ Assert(not_equal, "Function constructed by construct stub.");
 #endif
 
+  // Objects are followed by an allocation memento if the constructor has
+  // an allocation site.  The stub is shared by all closures of the function,
+  // so the site is loaded from the literals of the constructor.  Until the
+  // site exists, and once it decides to pretenure, construction goes through
+  // the generic stub.
+  int memento_size = 0;
+  if (function->HasAllocationSiteLiteral()) {
+    memento_size = AllocationMemento::kSize;
+    __ movq(r9, FieldOperand(rdi, JSFunction::kLiteralsOffset));
+    __ movq(r9, FieldOperand(r9, FixedArray::OffsetOfElementAt(
+        JSFunction::kLiteralAllocationSiteIndex)));
+    __ cmpq(r9, r8);
+    __ j(equal, &generic_stub_call);
+    __ SmiCompare(FieldOperand(r9, AllocationSite::kPretenureDecisionOffset),
+                  Smi::FromInt(AllocationSite::kTenure));
+    __ j(equal, &generic_stub_call);
+  }
+
   // Now allocate the JSObject in new space.
   // rdi: constructor
   // rbx: initial map
   __ movzxbq(rcx, FieldOperand(rbx, Map::kInstanceSizeOffset));
   __ shl(rcx, Immediate(kPointerSizeLog2));
+  if (memento_size > 0) __ addq(rcx, Immediate(memento_size));
   __ AllocateInNewSpace(rcx, rdx, rcx, no_reg,
                         &generic_stub_call, NO_ALLOCATION_FLAGS);
 
   // Allocated the JSObject, now initialize the fields and add the heap tag.
   // rbx: initial map
+  // rcx: end of the allocation
   // rdx: JSObject (untagged)
   __ movq(Operand(rdx, JSObject::kMapOffset), rbx);
   __ Move(rbx, factory()->empty_fixed_array());
   __ movq(Operand(rdx, JSObject::kPropertiesOffset), rbx);
   __ movq(Operand(rdx, JSObject::kElementsOffset), rbx);
 
+  if (memento_size > 0) {
+    // The memento occupies the end of the allocation.
+    // r9: allocation site
+    __ LoadRoot(rbx, Heap::kAllocationMementoMapRootIndex);
+    __ movq(Operand(rcx, -memento_size + HeapObject::kMapOffset), rbx);
+    __ movq(Operand(rcx,
+                    -memento_size + AllocationMemento::kAllocationSiteOffset),
+            r9);
+    __ SmiAddConstant(
+        FieldOperand(r9, AllocationSite::kMementoCreateCountOffset),
+        Smi::FromInt(1));
+  }
+
   // rax: argc
   // rdx: JSObject (untagged)
   // Load the address of the first in-object property into r9.
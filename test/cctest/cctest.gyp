@@ -75,6 +75,7 @@
         'test-heap-profiler.cc',
         'test-list.cc',
         'test-liveedit.cc',
+        'test-load-elimination.cc',
         'test-lock.cc',
         'test-lockers.cc',
         'test-log.cc',
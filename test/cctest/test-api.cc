@@ -14197,6 +14197,47 @@ TEST(IdleNotificationWithLargeHint) {
 }
 
 
+// Test that idle notification with a deadline eventually collects garbage
+// and reports the collection.
+TEST(IdleNotificationDeadline) {
+  const intptr_t MB = 1024 * 1024;
+  const int kIdleTimeInMs = 900;
+  v8::HandleScope scope;
+  LocalContext env;
+  intptr_t initial_size = HEAP->SizeOfObjects();
+  CreateGarbageInOldSpace();
+  intptr_t size_with_garbage = HEAP->SizeOfObjects();
+  CHECK_GT(size_with_garbage, initial_size + MB);
+  bool finished = false;
+  int work_done = v8::IdleTaskReport::kNoWork;
+  for (int i = 0; i < 200 && !finished; i++) {
+    v8::IdleTaskReport report;
+    finished = v8::V8::IdleNotificationDeadline(kIdleTimeInMs, &report);
+    CHECK_GE(report.time_used_in_ms(), 0);
+    work_done |= report.work_done();
+  }
+  intptr_t final_size = HEAP->SizeOfObjects();
+  CHECK(finished);
+  CHECK_LT(final_size, initial_size + 1);
+  CHECK_NE(0, work_done &
+              (v8::IdleTaskReport::kFinalizeIncrementalMarking |
+               v8::IdleTaskReport::kFullGarbageCollection));
+}
+
+
+// Test that idle notification without idle time does not collect garbage.
+TEST(IdleNotificationZeroDeadline) {
+  v8::HandleScope scope;
+  LocalContext env;
+  CreateGarbageInOldSpace();
+  int ms_count = HEAP->ms_count();
+  v8::IdleTaskReport report;
+  v8::V8::IdleNotificationDeadline(0, &report);
+  CHECK_EQ(v8::IdleTaskReport::kNoWork, report.work_done());
+  CHECK_EQ(ms_count, HEAP->ms_count());
+}
+
+
 TEST(Regress2107) {
   const intptr_t MB = 1024 * 1024;
   const int kShortIdlePauseInMs = 100;
@@ -14894,6 +14935,50 @@ TEST(GCCallbacks) {
 }
 
 
+static int gc_timing_call_count = 0;
+static v8::GCTimingRecord last_gc_timing_record;
+
+static void GCTimingCallback(const v8::GCTimingRecord* record) {
+  ++gc_timing_call_count;
+  last_gc_timing_record = *record;
+}
+
+
+TEST(GCTimingCallback) {
+  const size_t MB = 1024 * 1024;
+  v8::HandleScope scope;
+  LocalContext context;
+
+  v8::V8::AddGCTimingCallback(GCTimingCallback);
+  CreateGarbageInOldSpace();
+  HEAP->CollectAllGarbage(i::Heap::kNoGCFlags, "timing test");
+  CHECK_EQ(1, gc_timing_call_count);
+  v8::GCTimingRecord* record = &last_gc_timing_record;
+  CHECK_EQ(v8::kGCTypeMarkSweepCompact, record->type());
+  CHECK_EQ(0, strcmp("timing test", record->reason()));
+  CHECK_GE(record->pause_in_ms(),
+           record->phase_time_in_ms(v8::GCTimingRecord::kMark));
+  CHECK_GT(record->freed_bytes(), MB);
+  CHECK(record->size_before() - record->size_after() ==
+        record->freed_bytes());
+  CHECK_LT(record->survival_rate(), 100);
+
+  CompileRun("var a = []; for (var i = 0; i < 1000; i++) a.push({});");
+  HEAP->CollectGarbage(i::NEW_SPACE, "timing test");
+  CHECK_EQ(2, gc_timing_call_count);
+  if (record->type() == v8::kGCTypeScavenge) {
+    // Not when --stress-compaction turns the scavenge into a mark-compact.
+    CHECK_GT(record->survival_rate(), 0);
+    CHECK_LE(record->survival_rate(), 100);
+    CHECK_EQ(0.0, record->phase_time_in_ms(v8::GCTimingRecord::kMark));
+  }
+
+  v8::V8::RemoveGCTimingCallback(GCTimingCallback);
+  HEAP->CollectAllGarbage(i::Heap::kNoGCFlags);
+  CHECK_EQ(2, gc_timing_call_count);
+}
+
+
 THREADED_TEST(AddToJSFunctionResultCache) {
   i::FLAG_allow_natives_syntax = true;
   v8::HandleScope scope;
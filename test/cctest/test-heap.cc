@@ -983,6 +983,46 @@ TEST(TestCodeFlushing) {
 }
 
 
+TEST(MemoryPressureNotification) {
+  // If we do not flush code this test is invalid.
+  if (!FLAG_flush_code) return;
+  InitializeVM();
+  v8::HandleScope scope;
+  const char* source = "function bar() {"
+                       "  var x = 42;"
+                       "  var y = 42;"
+                       "  var z = x + y;"
+                       "};"
+                       "bar()";
+  Handle<String> bar_name = FACTORY->LookupAsciiSymbol("bar");
+  { v8::HandleScope scope;
+    CompileRun(source);
+  }
+  Object* func_value = Isolate::Current()->context()->global()->
+      GetProperty(*bar_name)->ToObjectChecked();
+  CHECK(func_value->IsJSFunction());
+  Handle<JSFunction> function(JSFunction::cast(func_value));
+  CHECK(function->shared()->is_compiled());
+
+  // Moderate pressure leaves recently used code alone but releases the
+  // pages freed by the collection.
+  { v8::HandleScope scope;
+    AlwaysAllocateScope always_allocate;
+    for (int i = 0; i < 2000; i++) FACTORY->NewFixedArray(1000, TENURED);
+  }
+  size_t released =
+      v8::V8::MemoryPressureNotification(v8::kMemoryPressureModerate);
+  CHECK_GT(released, 0);
+  CHECK(function->shared()->is_compiled());
+
+  // Critical pressure flushes the code without waiting for it to age.
+  v8::V8::MemoryPressureNotification(v8::kMemoryPressureCritical);
+  CHECK(!function->shared()->is_compiled() || function->IsOptimized());
+  CompileRun("bar()");
+  CHECK(function->shared()->is_compiled());
+}
+
+
 // Count the number of global contexts in the weak list of global contexts.
 int CountGlobalContexts() {
   int count = 0;
@@ -1199,6 +1239,10 @@ TEST(TestSizeOfObjects) {
   HEAP->CollectAllGarbage(Heap::kNoGCFlags);
   HEAP->CollectAllGarbage(Heap::kNoGCFlags);
   HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  MarkCompactCollector* collector = HEAP->mark_compact_collector();
+  if (collector->IsConcurrentSweepingInProgress()) {
+    collector->WaitUntilSweepingCompleted();
+  }
   CHECK(HEAP->old_pointer_space()->IsSweepingComplete());
   int initial_size = static_cast<int>(HEAP->SizeOfObjects());
 
@@ -1349,6 +1393,78 @@ TEST(CollectingAllAvailableGarbageShrinksNewSpace) {
 }
 
 
+TEST(NewSpaceGrowsWithThroughputAndShrinksWhenIdle) {
+  InitializeVM();
+
+  if (HEAP->ReservedSemiSpaceSize() == HEAP->InitialSemiSpaceSize()) {
+    // We can't test new space growing and shrinking if the reserved size is
+    // the same as the minimum (initial) size.
+    return;
+  }
+
+  // Any allocation rate fills new space faster than this.
+  v8::ResourceConstraints constraints;
+  constraints.set_young_space_growth_survival_rate(100);
+  constraints.set_target_scavenge_interval_ms(1000000);
+  CHECK(v8::SetResourceConstraints(&constraints));
+
+  NewSpace* new_space = HEAP->new_space();
+  intptr_t initial_capacity = new_space->Capacity();
+  for (int i = 0; i < 4; i++) {
+    { v8::HandleScope scope;
+      for (int j = 0; j < 100; j++) FACTORY->NewFixedArray(100);
+    }
+    HEAP->CollectGarbage(NEW_SPACE);
+  }
+  CHECK_GT(new_space->Capacity(), initial_capacity);
+
+  bool shrunk = false;
+  for (int i = 0; i < 200 && !shrunk; i++) {
+    v8::IdleTaskReport report;
+    v8::V8::IdleNotificationDeadline(1000, &report);
+    shrunk = (report.work_done() & v8::IdleTaskReport::kShrinkNewSpace) != 0;
+  }
+  CHECK(shrunk);
+  CHECK_EQ(initial_capacity, new_space->Capacity());
+
+  HEAP->ConfigureNewSpaceSizing(Heap::kDefaultNewSpaceGrowthSurvivalRate,
+                                Heap::kDefaultTargetScavengeIntervalMs);
+}
+
+
+TEST(OldGenerationGrowsWithTargetGCOverhead) {
+  InitializeVM();
+
+  // Measure the old generation allocation rate across a few mark-compacts.
+  for (int i = 0; i < 4; i++) {
+    { v8::HandleScope scope;
+      for (int j = 0; j < 100; j++) FACTORY->NewFixedArray(1000, TENURED);
+    }
+    OS::Sleep(1);
+    HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  }
+
+  intptr_t old_gen_size = HEAP->PromotedSpaceSizeOfObjects();
+  intptr_t halfway_to_the_max =
+      (old_gen_size + HEAP->MaxOldGenerationSize()) / 2;
+
+  v8::ResourceConstraints constraints;
+  constraints.set_target_gc_overhead_percent(1);
+  CHECK(v8::SetResourceConstraints(&constraints));
+  intptr_t low_overhead_limit = HEAP->OldGenAllocationLimit(old_gen_size);
+
+  constraints.set_target_gc_overhead_percent(50);
+  CHECK(v8::SetResourceConstraints(&constraints));
+  intptr_t high_overhead_limit = HEAP->OldGenAllocationLimit(old_gen_size);
+
+  // Spending less time in GC requires a larger heap, up to the maximum.
+  CHECK_GE(low_overhead_limit, high_overhead_limit);
+  CHECK_LE(low_overhead_limit, halfway_to_the_max);
+
+  HEAP->ConfigureOldGenerationGrowing(Heap::kDefaultTargetGCOverhead);
+}
+
+
 static int NumberOfGlobalObjects() {
   int count = 0;
   HeapIterator iterator;
@@ -1718,7 +1834,7 @@ TEST(ResetSharedFunctionInfoCountersDuringMarkSweep) {
 TEST(OptimizedAllocationAlwaysInNewSpace) {
   i::FLAG_allow_natives_syntax = true;
   InitializeVM();
-  if (!i::V8::UseCrankshaft() || i::FLAG_always_opt) return;
+  if (!i::V8::UseCrankshaft()) return;
   v8::HandleScope scope;
 
   FillUpNewSpace(HEAP->new_space());
@@ -1966,3 +2082,680 @@ TEST(Regress2237) {
   HEAP->CollectAllGarbage(Heap::kNoGCFlags);
   CHECK(SlicedString::cast(*slice)->parent()->IsSeqAsciiString());
 }
+
+
+TEST(ParallelScavenge) {
+  i::FLAG_parallel_scavenge = true;
+  i::FLAG_scavenger_threads = 3;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  // An old-space array referencing new-space objects exercises the store
+  // buffer; the linked list and the strings exercise copying and promotion.
+  Handle<FixedArray> old_array = FACTORY->NewFixedArray(1000, TENURED);
+  for (int i = 0; i < old_array->length(); i++) {
+    Handle<FixedArray> inner = FACTORY->NewFixedArray(4);
+    inner->set(0, Smi::FromInt(i));
+    inner->set(1, *FACTORY->NewNumber(i + 0.5));
+    old_array->set(i, *inner);
+  }
+  CompileRun(
+      "var list = null;"
+      "for (var i = 0; i < 20000; i++) {"
+      "  list = { value: i, name: 'n' + i, next: list };"
+      "}");
+
+  for (int i = 0; i < 4; i++) {
+    HEAP->CollectGarbage(NEW_SPACE);
+  }
+
+  for (int i = 0; i < old_array->length(); i++) {
+    FixedArray* inner = FixedArray::cast(old_array->get(i));
+    CHECK_EQ(Smi::FromInt(i), inner->get(0));
+    CHECK_EQ(i + 0.5, HeapNumber::cast(inner->get(1))->value());
+  }
+  v8::Handle<v8::Value> result = CompileRun(
+      "var sum = 0, count = 0;"
+      "for (var node = list; node != null; node = node.next) {"
+      "  if (node.name != 'n' + node.value) throw 'corrupted';"
+      "  sum += node.value; count++;"
+      "}"
+      "count == 20000 && sum == 20000 * 19999 / 2;");
+  CHECK(result->BooleanValue());
+}
+
+
+TEST(ParallelMarking) {
+  i::FLAG_parallel_marking = true;
+  i::FLAG_marker_threads = 3;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  // The linked list, the arrays and the strings are visited by the marking
+  // tasks; the functions and their maps are deferred to the main thread.
+  CompileRun(
+      "var list = null;"
+      "for (var i = 0; i < 20000; i++) {"
+      "  list = { value: i, name: 'n' + i, next: list,"
+      "           f: function() { return i; }, a: [i, i + 0.5] };"
+      "}"
+      "var garbage = [];"
+      "for (var i = 0; i < 20000; i++) garbage.push({ value: i });");
+  v8::Handle<v8::String> check_source = v8::String::New(
+      "var sum = 0, count = 0;"
+      "for (var node = list; node != null; node = node.next) {"
+      "  if (node.name != 'n' + node.value) throw 'corrupted';"
+      "  if (node.a[1] != node.value + 0.5) throw 'corrupted';"
+      "  sum += node.value; count++;"
+      "}"
+      "count == 20000 && sum == 20000 * 19999 / 2;");
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK(v8::Script::Compile(check_source)->Run()->BooleanValue());
+
+  // Dropped objects are not marked.
+  intptr_t size_with_garbage = HEAP->SizeOfObjects();
+  CompileRun("garbage = null;");
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK_LT(HEAP->SizeOfObjects(), size_with_garbage);
+
+  // Overflowing the work lists of the tasks leaves grey objects in the heap.
+  i::FLAG_force_marking_deque_overflows = true;
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  i::FLAG_force_marking_deque_overflows = false;
+  CHECK(v8::Script::Compile(check_source)->Run()->BooleanValue());
+}
+
+
+TEST(ParallelEvacuation) {
+  i::FLAG_parallel_evacuation = true;
+  i::FLAG_evacuator_threads = 3;
+  i::FLAG_always_compact = true;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  // Only every other array and string survives, so that after the first
+  // collection every page of the old spaces is fragmented.  The surviving
+  // arrays point to new space, to old data space and to each other.
+  const int kLength = 2000;
+  Handle<FixedArray> survivors = FACTORY->NewFixedArray(kLength, TENURED);
+  for (int i = 0; i < 2 * kLength; i++) {
+    Handle<FixedArray> array = FACTORY->NewFixedArray(32, TENURED);
+    array->set(0, Smi::FromInt(i));
+    Handle<String> string = FACTORY->NewStringFromAscii(
+        CStrVector("a sequential string in old data space"), TENURED);
+    array->set(1, *string);
+    if (i % 2 == 0) {
+      if (i > 0) array->set(3, survivors->get(i / 2 - 1));
+      survivors->set(i / 2, *array);
+    }
+  }
+  CompileRun(
+      "var list = null;"
+      "for (var i = 0; i < 5000; i++) {"
+      "  list = { value: i, next: list, f: function() { return i; } };"
+      "}");
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  for (int i = 0; i < kLength; i++) {
+    FixedArray::cast(survivors->get(i))->set(2, *FACTORY->NewFixedArray(4));
+  }
+
+  // The second collection evacuates the fragmented pages.
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+
+  for (int i = 0; i < kLength; i++) {
+    FixedArray* array = FixedArray::cast(survivors->get(i));
+    CHECK_EQ(2 * i, Smi::cast(array->get(0))->value());
+    CHECK(String::cast(array->get(1))->IsEqualTo(
+        CStrVector("a sequential string in old data space")));
+    CHECK_EQ(4, FixedArray::cast(array->get(2))->length());
+    if (i > 0) CHECK_EQ(survivors->get(i - 1), array->get(3));
+  }
+  v8::Handle<v8::String> check_source = v8::String::New(
+      "var sum = 0;"
+      "for (var node = list; node != null; node = node.next) {"
+      "  sum += node.value + node.f() - 5000;"
+      "}"
+      "sum == 5000 * 4999 / 2;");
+  CHECK(v8::Script::Compile(check_source)->Run()->BooleanValue());
+}
+
+
+TEST(ConcurrentSweeping) {
+  i::FLAG_concurrent_sweeping = true;
+  i::FLAG_sweeper_threads = 2;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  // Fill the old spaces with arrays and strings of which only every other
+  // one survives, so that the sweeper threads find free memory on every page.
+  const int kLength = 4000;
+  Handle<FixedArray> survivors = FACTORY->NewFixedArray(kLength, TENURED);
+  for (int i = 0; i < 2 * kLength; i++) {
+    Handle<FixedArray> array = FACTORY->NewFixedArray(32, TENURED);
+    array->set(0, Smi::FromInt(i));
+    Handle<String> string = FACTORY->NewStringFromAscii(
+        CStrVector("a sequential string in old data space"), TENURED);
+    array->set(1, *string);
+    if (i % 2 == 0) survivors->set(i / 2, *array);
+  }
+
+  MarkCompactCollector* collector = HEAP->mark_compact_collector();
+  HEAP->CollectGarbage(OLD_POINTER_SPACE);
+  // Heap verification after the collection waits for the sweeper threads.
+  if (!i::FLAG_verify_heap) {
+    CHECK(collector->IsConcurrentSweepingInProgress());
+    CHECK(!HEAP->IsSweepingComplete());
+  }
+
+  // Allocating in the old spaces takes memory from the sweeper threads or
+  // sweeps pages on the main thread, and scavenges sweep the pages they
+  // visit first.
+  for (int i = 0; i < kLength; i++) {
+    Handle<FixedArray> array = FACTORY->NewFixedArray(32, TENURED);
+    array->set(0, *FACTORY->NewFixedArray(4));
+  }
+  HEAP->CollectGarbage(NEW_SPACE);
+
+  if (collector->IsConcurrentSweepingInProgress()) {
+    collector->WaitUntilSweepingCompleted();
+  }
+  CHECK(HEAP->IsSweepingComplete());
+  CHECK(!collector->IsConcurrentSweepingInProgress());
+
+  for (int i = 0; i < kLength; i++) {
+    FixedArray* array = FixedArray::cast(survivors->get(i));
+    CHECK_EQ(Smi::FromInt(2 * i), array->get(0));
+    CHECK(array->get(1)->IsString());
+  }
+#ifdef DEBUG
+  HEAP->Verify();
+#endif
+}
+
+
+TEST(ConcurrentMarking) {
+  i::FLAG_concurrent_marking = true;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  if (!ConcurrentMarker::CanMarkConcurrently()) return;
+  v8::HandleScope scope;
+
+  CompileRun(
+      "var list = null;"
+      "for (var i = 0; i < 20000; i++) {"
+      "  list = { value: i, name: 'n' + i, next: list,"
+      "           f: function() { return i; }, a: [i, i + 0.5] };"
+      "}");
+
+  // Building the list may have started incremental marking already.
+  HEAP->CollectAllGarbage(Heap::kAbortIncrementalMarkingMask);
+  IncrementalMarking* marking = HEAP->incremental_marking();
+  if (marking->IsStopped()) marking->Start();
+  while (!marking->IsMarking()) {
+    marking->Step(MB, IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+  }
+  // The first marking step starts the helper thread.
+  marking->Step(MB, IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+  CHECK(marking->concurrent_marker()->IsRunning());
+
+  // Rewire the heap while the helper thread is marking it.  New strings and
+  // arrays are stored into objects that may already be black, and arrays
+  // grow and shrink in place.
+  CompileRun(
+      "for (var round = 0; round < 4; round++) {"
+      "  var reversed = null;"
+      "  for (var node = list; node != null; ) {"
+      "    var next = node.next;"
+      "    node.name = 'm' + node.value;"
+      "    node.a.push(node.value + 0.25, { value: node.value });"
+      "    node.a.shift();"
+      "    node.a.shift();"
+      "    node.next = reversed;"
+      "    reversed = node;"
+      "    node = next;"
+      "  }"
+      "  list = reversed;"
+      "}");
+
+  marking->set_should_hurry(true);
+  HEAP->CollectGarbage(OLD_POINTER_SPACE);
+  CHECK(!marking->concurrent_marker()->IsRunning());
+
+  // Allocate some garbage so that memory of objects the marker might have
+  // missed is reused before the list is checked.
+  CompileRun(
+      "var garbage = [];"
+      "for (var i = 0; i < 20000; i++) garbage.push({ value: 'g' + i });"
+      "garbage = null;");
+  v8::Handle<v8::String> check_source = v8::String::New(
+      "var sum = 0, count = 0;"
+      "for (var node = list; node != null; node = node.next) {"
+      "  if (node.name != 'm' + node.value) throw 'corrupted';"
+      "  if (node.a.length != 2) throw 'corrupted';"
+      "  if (node.a[0] != node.value + 0.25) throw 'corrupted';"
+      "  if (node.a[1].value != node.value) throw 'corrupted';"
+      "  if (node.f() != 20000) throw 'corrupted';"
+      "  sum += node.value; count++;"
+      "}"
+      "count == 20000 && sum == 20000 * 19999 / 2;");
+  CHECK(v8::Script::Compile(check_source)->Run()->BooleanValue());
+}
+
+
+TEST(ConcurrentMarkingPublishedAllocation) {
+  i::FLAG_concurrent_marking = true;
+  i::FLAG_allow_natives_syntax = true;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  if (!ConcurrentMarker::CanMarkConcurrently()) return;
+  if (!i::V8::UseCrankshaft()) return;
+  v8::HandleScope scope;
+
+  // The inlined constructor publishes the fresh object before it stores the
+  // other fields, so the helper thread may visit it in between.
+  CompileRun(
+      "function Node(list, v) {"
+      "  list.head = this;"
+      "  this.data = { value: v };"
+      "  this.name = 'n' + v;"
+      "}"
+      "function make(list, v) { return new Node(list, v); }"
+      "var lists = [];"
+      "for (var i = 0; i < 100; i++) lists.push({ head: null });"
+      "make({ head: null }, 0);"
+      "make({ head: null }, 0);"
+      "%OptimizeFunctionOnNextCall(make);"
+      "make({ head: null }, 0);");
+
+  HEAP->CollectAllGarbage(Heap::kAbortIncrementalMarkingMask);
+  IncrementalMarking* marking = HEAP->incremental_marking();
+  if (marking->IsStopped()) marking->Start();
+  while (!marking->IsMarking()) {
+    marking->Step(MB, IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+  }
+  marking->Step(MB, IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+  CHECK(marking->concurrent_marker()->IsRunning());
+
+  CompileRun(
+      "for (var round = 0; round < 200; round++) {"
+      "  for (var i = 0; i < lists.length; i++) make(lists[i], round);"
+      "}");
+
+  marking->set_should_hurry(true);
+  HEAP->CollectGarbage(OLD_POINTER_SPACE);
+  CHECK(!marking->concurrent_marker()->IsRunning());
+
+  CompileRun(
+      "var garbage = [];"
+      "for (var i = 0; i < 20000; i++) garbage.push({ value: 'g' + i });"
+      "garbage = null;");
+  v8::Handle<v8::String> check_source = v8::String::New(
+      "var ok = true;"
+      "for (var i = 0; i < lists.length; i++) {"
+      "  var node = lists[i].head;"
+      "  if (node.data.value != 199 || node.name != 'n199') ok = false;"
+      "}"
+      "ok;");
+  CHECK(v8::Script::Compile(check_source)->Run()->BooleanValue());
+}
+
+
+TEST(AllocationSitePretenuring) {
+  i::FLAG_allocation_site_pretenuring = true;
+  InitializeVM();
+  if (!AllocationSite::CanTrack()) return;
+  v8::HandleScope scope;
+
+  // Objects from all three sites are kept alive, so they survive the
+  // scavenges and the sites switch to old space allocation.
+  CompileRun(
+      "function Point(x) { this.x = x; }"
+      "function makeObject(i) { return { value: i }; }"
+      "function makeArray(i) { return [i, i + 1]; }"
+      "var kept = [];"
+      "for (var i = 0; i < 1000; i++) {"
+      "  kept.push(makeObject(i), makeArray(i), new Point(i));"
+      "}");
+  HEAP->CollectGarbage(NEW_SPACE);
+  HEAP->CollectGarbage(NEW_SPACE);
+
+  const char* sources[] = { "makeObject(0)", "makeArray(0)", "new Point(0)" };
+  for (size_t i = 0; i < ARRAY_SIZE(sources); i++) {
+    v8::Handle<v8::Object> result =
+        v8::Handle<v8::Object>::Cast(CompileRun(sources[i]));
+    Handle<JSObject> object = v8::Utils::OpenHandle(*result);
+    CHECK(HEAP->old_pointer_space()->Contains(*object));
+  }
+}
+
+
+TEST(StringDeduplication) {
+  i::FLAG_string_deduplication = true;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  // Strings referenced from handles are left alone, so the strings are only
+  // referenced from the heap.
+  const char* kContents = "a string that is long enough to be merged";
+  Handle<FixedArray> holder = FACTORY->NewFixedArray(5, TENURED);
+  {
+    v8::HandleScope inner_scope;
+    holder->set(0, *FACTORY->NewStringFromAscii(CStrVector(kContents),
+                                                TENURED));
+    holder->set(1, *FACTORY->NewStringFromAscii(CStrVector(kContents),
+                                                TENURED));
+    holder->set(2, *FACTORY->NewStringFromAscii(
+        CStrVector("another string that is long enough"), TENURED));
+    holder->set(3, *FACTORY->NewStringFromAscii(CStrVector("short"),
+                                                TENURED));
+    holder->set(4, *FACTORY->NewStringFromAscii(CStrVector("short"),
+                                                TENURED));
+  }
+  CHECK(holder->get(0) != holder->get(1));
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+
+  CHECK_EQ(holder->get(0), holder->get(1));
+  CHECK(String::cast(holder->get(0))->IsEqualTo(CStrVector(kContents)));
+  CHECK(holder->get(2) != holder->get(0));
+  CHECK(holder->get(3) != holder->get(4));
+  i::FLAG_string_deduplication = false;
+}
+
+
+TEST(StringDeduplicationTruncate) {
+  i::FLAG_string_deduplication = true;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  const char* kContents = "a string that is long enough to be merged";
+  int length = StrLength(kContents);
+  Handle<FixedArray> holder = FACTORY->NewFixedArray(1, TENURED);
+  {
+    v8::HandleScope inner_scope;
+    holder->set(0, *FACTORY->NewStringFromAscii(CStrVector(kContents),
+                                                TENURED));
+  }
+  // A string that is still being built, like the pretenured strings of
+  // SlowScanJsonString: it is truncated once all characters are written.
+  Handle<SeqAsciiString> building =
+      FACTORY->NewRawAsciiString(length, TENURED);
+  memcpy(building->GetChars(), kContents, length);
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+
+  CHECK(*building != holder->get(0));
+  HEAP->RightTrimObject(*building, 8);
+  building->SeqAsciiStringSet(0, 'A');
+  CHECK(building->IsEqualTo(CStrVector("A string")));
+  CHECK_EQ(length, String::cast(holder->get(0))->length());
+  CHECK(String::cast(holder->get(0))->IsEqualTo(CStrVector(kContents)));
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK(String::cast(holder->get(0))->IsEqualTo(CStrVector(kContents)));
+  i::FLAG_string_deduplication = false;
+}
+
+
+TEST(DoubleFieldsUpdateInPlace) {
+  i::FLAG_unbox_double_fields = true;
+  i::FLAG_allow_natives_syntax = true;
+  InitializeVM();
+  if (!JSObject::CanUseDoubleFields()) {
+    i::FLAG_unbox_double_fields = false;
+    return;
+  }
+  v8::HandleScope scope;
+
+  v8::Local<v8::Value> res = CompileRun(
+      "function P(x) { this.x = x; }"
+      "function move(p, dx) { p.x = p.x + dx; return p.x; }"
+      "var p = new P(1.5);"
+      "var old_x = p.x;"
+      "move(p, 0.25); move(p, 0.25);"
+      "%OptimizeFunctionOnNextCall(move);"
+      "move(p, 0.5);"
+      "p");
+  Handle<JSObject> p =
+      v8::Utils::OpenHandle(*v8::Handle<v8::Object>::Cast(res));
+  Handle<String> x = FACTORY->LookupAsciiSymbol("x");
+  CHECK(p->map()->has_double_fields());
+
+  LookupResult lookup(ISOLATE);
+  p->LocalLookup(*x, &lookup);
+  CHECK(lookup.IsDoubleField());
+  int index = lookup.GetFieldIndex();
+  Object* box = p->RawFastPropertyAt(index);
+  CHECK_EQ(2.5, HeapNumber::cast(box)->value());
+  CHECK_EQ(HEAP->mutable_heap_number_map(), HeapObject::cast(box)->map());
+
+  // A load hands out the box itself as an ordinary heap number, after which
+  // stores give the field a new box, so earlier values do not change.
+  CHECK_EQ(1.5, CompileRun("old_x")->NumberValue());
+  Handle<Object> loaded = v8::Utils::OpenHandle(*CompileRun("p.x"));
+  CHECK_EQ(box, *loaded);
+  CHECK_EQ(HEAP->heap_number_map(), HeapObject::cast(box)->map());
+  CompileRun("p.x = 7.5;");
+  CHECK_EQ(2.5, loaded->Number());
+  Object* new_box = p->RawFastPropertyAt(index);
+  CHECK(new_box != box);
+  CHECK_EQ(HEAP->mutable_heap_number_map(), HeapObject::cast(new_box)->map());
+  CompileRun("p.x = 8.5;");
+  CHECK_EQ(new_box, p->RawFastPropertyAt(index));
+  CHECK_EQ(8.5, HeapNumber::cast(new_box)->value());
+  CHECK_EQ(2.5, CompileRun("new P(2.5).x")->NumberValue());
+
+  // Optimized stores do not change numbers handed out before either.
+  CompileRun(
+      "function store(p, v) { p.x = v; }"
+      "store(p, 0.5); store(p, 0.5);"
+      "%OptimizeFunctionOnNextCall(store);"
+      "var seen = [];"
+      "for (var i = 0; i < 10; i++) { store(p, i + 0.5); seen.push(p.x); }");
+  CHECK(CompileRun("seen[0] == 0.5 && seen[9] == 9.5")->BooleanValue());
+
+  // Storing something other than a number makes the field tagged again.
+  CompileRun("p.x = 'left';");
+  LookupResult generalized(ISOLATE);
+  p->LocalLookup(*x, &generalized);
+  CHECK(generalized.IsField());
+  CHECK(!generalized.IsDoubleField());
+  CHECK(CompileRun("p.x")->IsString());
+  i::FLAG_unbox_double_fields = false;
+}
+
+
+TEST(StoreBufferOverflowUsesSlotSets) {
+  i::FLAG_remembered_set_bitmaps = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  // Fill an old space array with more pointers to new space than the store
+  // buffer can hold.
+  int length = StoreBuffer::kOldStoreBufferLength;
+  Handle<FixedArray> array = FACTORY->NewFixedArray(length, TENURED);
+  Handle<Object> number = FACTORY->NewNumber(0.5);
+  CHECK(HEAP->InNewSpace(*number));
+  CHECK(!HEAP->InNewSpace(*array));
+  for (int i = 0; i < length; i++) array->set(i, *number);
+  HEAP->store_buffer()->Compact();
+
+  MemoryChunk* chunk = MemoryChunk::FromAddress(array->address());
+  CHECK(!chunk->scan_on_scavenge());
+  SlotSet* slot_set = chunk->slot_set();
+  CHECK(slot_set != NULL);
+  CHECK(slot_set->Contains(reinterpret_cast<Address>(array->data_start())));
+
+  // Scavenges update the slots and drop them once they point to old space.
+  HEAP->CollectGarbage(NEW_SPACE);
+  HEAP->CollectGarbage(NEW_SPACE);
+  CHECK(!HEAP->InNewSpace(*number));
+  for (int i = 0; i < length; i += 1024) CHECK(array->get(i) == *number);
+  CHECK(chunk->slot_set() == NULL);
+}
+
+
+// Stores short slices of a fresh large string into |holder|, which then
+// holds the only references to the string.
+static void AllocateSlicesOfLargeString(Handle<FixedArray> holder) {
+  v8::HandleScope scope;
+  int length = Page::kMaxNonCodeHeapObjectSize;
+  Handle<SeqAsciiString> parent = FACTORY->NewRawAsciiString(length, TENURED);
+  for (int i = 0; i < length; i++) {
+    parent->SeqAsciiStringSet(i, 'a' + i % 26);
+  }
+  CHECK(HEAP->lo_space()->Contains(*parent));
+  for (int i = 0; i < holder->length(); i++) {
+    Handle<String> slice = FACTORY->NewSubString(parent, 26 * i, 26 * i + 26);
+    CHECK(slice->IsSlicedString());
+    holder->set(i, *slice);
+  }
+}
+
+
+static void CheckSlicesWereRescued(Handle<FixedArray> holder,
+                                   intptr_t lo_size_before) {
+  CHECK_EQ(lo_size_before, HEAP->lo_space()->Size());
+  for (int i = 0; i < holder->length(); i++) {
+    String* slice = String::cast(holder->get(i));
+    CHECK(slice->IsConsString());
+    CHECK(ConsString::cast(slice)->first()->IsSeqAsciiString());
+    CHECK_EQ("abcdefghijklmnopqrstuvwxyz", *slice->ToCString());
+  }
+}
+
+
+TEST(RescueStringSlices) {
+  i::FLAG_string_slices = true;
+  i::FLAG_rescue_string_slices = true;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  intptr_t lo_size_before = HEAP->lo_space()->Size();
+  Handle<FixedArray> holder = FACTORY->NewFixedArray(4);
+  AllocateSlicesOfLargeString(holder);
+
+  // The slices alone do not keep their large parent alive.
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CheckSlicesWereRescued(holder, lo_size_before);
+
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CheckSlicesWereRescued(holder, lo_size_before);
+}
+
+
+TEST(RescueStringSlicesParallelMarking) {
+  i::FLAG_string_slices = true;
+  i::FLAG_rescue_string_slices = true;
+  i::FLAG_parallel_marking = true;
+  i::FLAG_marker_threads = 3;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  // The marking tasks leave the slices to the main thread.
+  intptr_t lo_size_before = HEAP->lo_space()->Size();
+  Handle<FixedArray> holder = FACTORY->NewFixedArray(4);
+  AllocateSlicesOfLargeString(holder);
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CheckSlicesWereRescued(holder, lo_size_before);
+
+  // Overflows make the collector visit some objects again.
+  AllocateSlicesOfLargeString(holder);
+  i::FLAG_force_marking_deque_overflows = true;
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  i::FLAG_force_marking_deque_overflows = false;
+  CheckSlicesWereRescued(holder, lo_size_before);
+}
+
+
+TEST(RescueStringSlicesIncrementalMarking) {
+  i::FLAG_string_slices = true;
+  i::FLAG_rescue_string_slices = true;
+  i::FLAG_incremental_marking = true;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  intptr_t lo_size_before = HEAP->lo_space()->Size();
+  Handle<FixedArray> holder = FACTORY->NewFixedArray(4, TENURED);
+  HEAP->CollectAllGarbage(Heap::kAbortIncrementalMarkingMask);
+  AllocateSlicesOfLargeString(holder);
+
+  // The slices are recorded by incremental marking while they are still in
+  // new space and moved by a scavenge before the collection frees the
+  // parent.
+  IncrementalMarking* marking = HEAP->incremental_marking();
+  if (marking->IsStopped()) marking->Start();
+  while (!marking->IsComplete()) {
+    marking->Step(MB, IncrementalMarking::NO_GC_VIA_STACK_GUARD);
+  }
+  CHECK(HEAP->InNewSpace(holder->get(0)));
+  HEAP->CollectGarbage(NEW_SPACE);
+  CHECK(marking->IsComplete());
+  HEAP->CollectAllGarbage(Heap::kNoGCFlags);
+  CHECK(marking->IsStopped());
+  CheckSlicesWereRescued(holder, lo_size_before);
+}
+
+
+TEST(MapSpaceCompaction) {
+  i::FLAG_compact_map_space = true;
+  i::FLAG_verify_heap = true;
+  InitializeVM();
+  v8::HandleScope scope;
+
+  // Every object gets a map of its own; only a few of them stay alive.
+  CompileRun(
+      "var kept = [];"
+      "for (var i = 0; i < 60000; i++) {"
+      "  var o = { a: i };"
+      "  o.__proto__ = { b: i };"
+      "  if (i % 100 == 0) kept.push(o);"
+      "}");
+  HEAP->CollectAllGarbage(Heap::kAbortIncrementalMarkingMask);
+  int pages_before = HEAP->map_space()->CountTotalPages();
+  CHECK_LT(2, pages_before);
+
+  Handle<JSArray> kept = v8::Utils::OpenHandle(*v8::Handle<v8::Array>::Cast(
+      v8::Context::GetCurrent()->Global()->Get(v8_str("kept"))));
+  Handle<FixedArray> elements(FixedArray::cast(kept->elements()));
+  const int kKept = 600;
+  Address* map_addresses = NewArray<Address>(kKept);
+  for (int i = 0; i < kKept; i++) {
+    map_addresses[i] = JSObject::cast(elements->get(i))->map()->address();
+  }
+
+  HEAP->CollectAllGarbage(Heap::kAbortIncrementalMarkingMask |
+                          Heap::kForceCompactionMask);
+  CHECK_LT(HEAP->map_space()->CountTotalPages(), pages_before);
+
+  // Live maps on the sparse pages were moved rather than the pages being
+  // evicted from the evacuation candidates.
+  int moved_maps = 0;
+  for (int i = 0; i < kKept; i++) {
+    Map* map = JSObject::cast(elements->get(i))->map();
+    CHECK(HEAP->map_space()->Contains(map));
+    if (map->address() != map_addresses[i]) moved_maps++;
+  }
+  DeleteArray(map_addresses);
+  CHECK_LT(0, moved_maps);
+
+  v8::Local<v8::Value> result = CompileRun(
+      "var ok = kept.length == 600;"
+      "for (var i = 0; i < kept.length; i++) {"
+      "  ok = ok && kept[i].a == i * 100 && kept[i].b == i * 100;"
+      "  ok = ok && Object.getPrototypeOf(kept[i]).b == i * 100;"
+      "}"
+      "ok;");
+  CHECK(result->BooleanValue());
+  i::FLAG_compact_map_space = false;
+}
@@ -0,0 +1,182 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "v8.h"
+
+#include "api.h"
+#include "cctest.h"
+
+using ::v8::internal::Handle;
+using ::v8::internal::JSFunction;
+
+// Tests for the Hydrogen load elimination, which forwards stored and loaded
+// values of fields and fast elements to later loads of the same location.
+
+
+static Handle<JSFunction> GetJSFunction(v8::Handle<v8::Object> obj,
+                                        const char* property_name) {
+  v8::Local<v8::Function> fun =
+      v8::Local<v8::Function>::Cast(obj->Get(v8_str(property_name)));
+  return v8::Utils::OpenHandle(*fun);
+}
+
+
+// Runs the source, which defines f, optimizes f and returns the value of
+// calling f with the given arguments.
+static int32_t RunOptimized(LocalContext* env,
+                            const char* source,
+                            const char* warm_up,
+                            const char* call) {
+  i::FLAG_allow_natives_syntax = true;
+  CompileRun(source);
+  CompileRun(warm_up);
+  CompileRun(warm_up);
+  CompileRun("%OptimizeFunctionOnNextCall(f)");
+  int32_t result = CompileRun(call)->Int32Value();
+  Handle<JSFunction> f = GetJSFunction((*env)->Global(), "f");
+  CHECK(f->IsOptimized() || !f->IsOptimizable());
+  return result;
+}
+
+
+TEST(LoadEliminationForwardsStoredValue) {
+  v8::HandleScope scope;
+  LocalContext env;
+  const char* source =
+      "function f(o, v) {"
+      "  o.a = v;"
+      "  o.b = 1;"
+      "  return o.a + o.b;"
+      "}";
+  CHECK_EQ(43, RunOptimized(&env, source,
+                            "f({a: 0, b: 0}, 2)",
+                            "f({a: 0, b: 0}, 42)"));
+}
+
+
+TEST(LoadEliminationAcrossStoreToOtherField) {
+  v8::HandleScope scope;
+  LocalContext env;
+  const char* source =
+      "function f(o) {"
+      "  var x = o.a.b;"
+      "  o.c = 10;"
+      "  return x + o.a.b;"
+      "}";
+  CHECK_EQ(4, RunOptimized(&env, source,
+                           "f({a: {b: 1}, c: 0})",
+                           "f({a: {b: 2}, c: 0})"));
+}
+
+
+TEST(LoadEliminationAliasedObjects) {
+  v8::HandleScope scope;
+  LocalContext env;
+  const char* source =
+      "function f(o, p) {"
+      "  var x = o.a;"
+      "  p.a = 2;"
+      "  return x * 10 + o.a;"
+      "}";
+  CHECK_EQ(12, RunOptimized(&env, source,
+                            "f({a: 1}, {a: 1})",
+                            "var q = {a: 1}; f(q, q)"));
+  CHECK_EQ(11, CompileRun("f({a: 1}, {a: 1})")->Int32Value());
+}
+
+
+TEST(LoadEliminationCallKillsFields) {
+  v8::HandleScope scope;
+  LocalContext env;
+  const char* source =
+      "function g(o) { o.a = 5; }"
+      "function f(o) {"
+      "  var x = o.a;"
+      "  g(o);"
+      "  return x * 10 + o.a;"
+      "}";
+  CHECK_EQ(15, RunOptimized(&env, source,
+                            "f({a: 1})",
+                            "f({a: 1})"));
+}
+
+
+TEST(LoadEliminationAcrossBranches) {
+  v8::HandleScope scope;
+  LocalContext env;
+  const char* source =
+      "function f(o, c) {"
+      "  o.a = 5;"
+      "  if (c) {"
+      "    o.b = 1;"
+      "  } else {"
+      "    o.a = 7;"
+      "  }"
+      "  return o.a;"
+      "}";
+  CHECK_EQ(5, RunOptimized(&env, source,
+                           "f({a: 0, b: 0}, true); f({a: 0, b: 0}, false)",
+                           "f({a: 0, b: 0}, true)"));
+  CHECK_EQ(7, CompileRun("f({a: 0, b: 0}, false)")->Int32Value());
+}
+
+
+TEST(LoadEliminationInLoop) {
+  v8::HandleScope scope;
+  LocalContext env;
+  const char* source =
+      "function f(o, n) {"
+      "  var s = 0;"
+      "  o.a = 1;"
+      "  for (var i = 0; i < n; i++) {"
+      "    s += o.a;"
+      "    o.a = o.a + 1;"
+      "  }"
+      "  return s + o.a;"
+      "}";
+  CHECK_EQ(15, RunOptimized(&env, source,
+                            "f({a: 0}, 4)",
+                            "f({a: 0}, 4)"));
+}
+
+
+TEST(LoadEliminationElements) {
+  v8::HandleScope scope;
+  LocalContext env;
+  const char* source =
+      "function f(a, i, j) {"
+      "  a[i] = 1;"
+      "  a[j] = 2;"
+      "  return a[i] * 10 + a[1];"
+      "}";
+  CHECK_EQ(22, RunOptimized(&env, source,
+                            "f([0, 0, 0], 0, 1)",
+                            "f([0, 0, 0], 1, 1)"));
+  CHECK_EQ(12, CompileRun("f([0, 0, 0], 0, 1)")->Int32Value());
+  CHECK_EQ(13, CompileRun("f([0, 3, 0], 0, 2)")->Int32Value());
+}
@@ -174,6 +174,138 @@ TEST(MemoryAllocator) {
 }
 
 
+TEST(MemoryAllocatorPool) {
+  OS::SetUp();
+  Isolate* isolate = Isolate::Current();
+  isolate->InitializeLoggingAndCounters();
+  Heap* heap = isolate->heap();
+  CHECK(isolate->heap()->ConfigureHeapDefault());
+  // Huge pages put additional pages into the pool.
+  FLAG_transparent_huge_pages = false;
+
+  MemoryAllocator* memory_allocator = new MemoryAllocator(isolate);
+  CHECK(memory_allocator->SetUp(heap->MaxReserved(),
+                                heap->MaxExecutableSize()));
+
+  OldSpace faked_space(heap,
+                       heap->MaxReserved(),
+                       OLD_POINTER_SPACE,
+                       NOT_EXECUTABLE);
+  Page* page = memory_allocator->AllocatePage(
+      faked_space.AreaSize(), &faked_space, NOT_EXECUTABLE);
+  Address address = page->address();
+  int size = static_cast<int>(memory_allocator->Size());
+
+  // A freed page is kept in the pool.
+  memory_allocator->Free(page);
+  CHECK_EQ(0, static_cast<int>(memory_allocator->Size()));
+  CHECK_EQ(size, static_cast<int>(memory_allocator->PooledSize()));
+  CHECK_EQ(1, memory_allocator->PooledChunks());
+
+  // The next page reuses its memory.
+  page = memory_allocator->AllocatePage(
+      faked_space.AreaSize(), &faked_space, NOT_EXECUTABLE);
+  CHECK_EQ(address, page->address());
+  CHECK(page->owner() == &faked_space);
+  CHECK_EQ(size, static_cast<int>(memory_allocator->Size()));
+  CHECK_EQ(0, static_cast<int>(memory_allocator->PooledSize()));
+  CHECK_EQ(0, memory_allocator->PooledChunks());
+  CHECK_EQ(1, memory_allocator->PoolHits());
+
+  memory_allocator->Free(page);
+  memory_allocator->ReleasePooledChunks();
+  CHECK_EQ(0, static_cast<int>(memory_allocator->PooledSize()));
+  CHECK_EQ(0, memory_allocator->PooledChunks());
+  memory_allocator->TearDown();
+  delete memory_allocator;
+}
+
+
+TEST(MemoryAllocatorHugePages) {
+  if (!VirtualMemory::HasHugePages()) return;
+  OS::SetUp();
+  Isolate* isolate = Isolate::Current();
+  isolate->InitializeLoggingAndCounters();
+  Heap* heap = isolate->heap();
+  CHECK(isolate->heap()->ConfigureHeapDefault());
+  FLAG_transparent_huge_pages = true;
+
+  MemoryAllocator* memory_allocator = new MemoryAllocator(isolate);
+  CHECK(memory_allocator->SetUp(heap->MaxReserved(),
+                                heap->MaxExecutableSize()));
+
+  OldSpace faked_space(heap,
+                       heap->MaxReserved(),
+                       OLD_POINTER_SPACE,
+                       NOT_EXECUTABLE);
+  // Pages are mapped a huge page at a time.
+  Page* first_page = memory_allocator->AllocatePage(
+      faked_space.AreaSize(), &faked_space, NOT_EXECUTABLE);
+  CHECK(IsAligned(reinterpret_cast<intptr_t>(first_page->address()),
+                  VirtualMemory::kHugePageSize));
+  CHECK_EQ(static_cast<int>(VirtualMemory::kHugePageSize / Page::kPageSize),
+           memory_allocator->PooledChunks() + 1);
+  Page* second_page = memory_allocator->AllocatePage(
+      faked_space.AreaSize(), &faked_space, NOT_EXECUTABLE);
+  CHECK_EQ(first_page->address() + Page::kPageSize, second_page->address());
+  // Code pages keep their guard pages and non-executable header.
+  CHECK_EQ(static_cast<int>(OS::CommitPageSize()),
+           MemoryAllocator::CodePageGuardSize());
+
+  memory_allocator->Free(first_page);
+  memory_allocator->Free(second_page);
+  memory_allocator->TearDown();
+  delete memory_allocator;
+  FLAG_transparent_huge_pages = false;
+}
+
+
+// Reports how much of the body of a large code chunk in the code range the
+// OS backs with huge pages.
+TEST(CodeRangeHugePages) {
+  if (!VirtualMemory::HasHugePages()) return;
+  OS::SetUp();
+  Isolate::Current()->InitializeLoggingAndCounters();
+  FLAG_transparent_huge_pages = true;
+  CodeRange* code_range = new CodeRange(Isolate::Current());
+  CHECK(code_range->SetUp(32 * MB));
+
+  size_t requested = 8 * MB;
+  size_t allocated = 0;
+  Address base = code_range->AllocateRawMemory(requested, &allocated);
+  CHECK(base != NULL);
+  Address huge_start;
+  Address huge_end;
+  MemoryAllocator::CodePageHugePageArea(base, allocated,
+                                        &huge_start, &huge_end);
+  // The guard pages stay outside of the huge pages.
+  CHECK(huge_start >= base + MemoryAllocator::CodePageAreaStartOffset());
+  CHECK(huge_end <= base + allocated - MemoryAllocator::CodePageGuardSize());
+  CHECK(huge_end - huge_start >=
+        static_cast<intptr_t>(requested - 2 * VirtualMemory::kHugePageSize));
+
+  // Touch the body so that the OS backs it with memory.
+  Address area_start = base + MemoryAllocator::CodePageAreaStartOffset();
+  Address area_end = base + allocated - MemoryAllocator::CodePageGuardSize();
+  memset(area_start, 0xcc, area_end - area_start);
+  intptr_t huge_bytes =
+      VirtualMemory::HugePageBytes(area_start, area_end - area_start);
+  CHECK(huge_bytes <= huge_end - huge_start);
+  if (huge_bytes >= 0) {
+    CHECK_EQ(0, static_cast<int>(VirtualMemory::HugePageBytes(
+        base, MemoryAllocator::CodePageAreaStartOffset())));
+    PrintF("Huge pages back %d of %d KB of the code chunk body.\n",
+           static_cast<int>(huge_bytes / KB),
+           static_cast<int>((area_end - area_start) / KB));
+  }
+
+  code_range->FreeRawMemory(base, allocated);
+  code_range->TearDown();
+  delete code_range;
+  FLAG_transparent_huge_pages = false;
+}
+
+
 TEST(NewSpace) {
   OS::SetUp();
   Isolate* isolate = Isolate::Current();
@@ -234,6 +366,53 @@ TEST(OldSpace) {
 }
 
 
+TEST(FreeListSizeClasses) {
+  // Free list nodes need the heap's filler maps, so use a fully set up heap
+  // and a private space on top of its memory allocator.
+  v8::V8::Initialize();
+  Heap* heap = Isolate::Current()->heap();
+
+  OldSpace* s = new OldSpace(heap,
+                             heap->MaxOldGenerationSize(),
+                             OLD_DATA_SPACE,
+                             NOT_EXECUTABLE);
+  CHECK(s->SetUp());
+
+  // Carve a small and a medium block out of the linear allocation area,
+  // separated by live objects, and put everything else on the free list.
+  Address small_block = HeapObject::cast(
+      s->AllocateRaw(64 * kPointerSize)->ToObjectUnchecked())->address();
+  s->AllocateRaw(kPointerSize)->ToObjectUnchecked();
+  Address medium_block = HeapObject::cast(
+      s->AllocateRaw(600 * kPointerSize)->ToObjectUnchecked())->address();
+  s->AllocateRaw(kPointerSize)->ToObjectUnchecked();
+  s->Free(s->top(), static_cast<int>(s->limit() - s->top()));
+  s->SetTop(NULL, NULL);
+  s->Free(small_block, 64 * kPointerSize);
+  s->Free(medium_block, 600 * kPointerSize);
+
+  Page* page = Page::FromAddress(small_block);
+  FreeList::SizeStats sizes;
+  s->CountFreeListItems(page, &sizes);
+  CHECK_EQ(64 * kPointerSize, static_cast<int>(sizes.small_size_));
+  CHECK_EQ(600 * kPointerSize, static_cast<int>(sizes.medium_size_));
+  CHECK(sizes.huge_size_ > 0);
+
+  // Allocations are served from the smallest block that fits.
+  HeapObject* object =
+      HeapObject::cast(s->AllocateRaw(40 * kPointerSize)->ToObjectUnchecked());
+  CHECK_EQ(small_block, object->address());
+  object =
+      HeapObject::cast(s->AllocateRaw(500 * kPointerSize)->ToObjectUnchecked());
+  CHECK_EQ(medium_block, object->address());
+  s->CountFreeListItems(page, &sizes);
+  CHECK_EQ(0, static_cast<int>(sizes.small_size_ + sizes.medium_size_));
+
+  s->TearDown();
+  delete s;
+}
+
+
 TEST(LargeObjectSpace) {
   v8::V8::Initialize();
 
@@ -0,0 +1,159 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Flags: --allow-natives-syntax --use-escape-analysis --inline-construct
+
+// Test that allocations replaced by their fields are rematerialized with
+// the right field values when the optimized code deoptimizes.
+
+var deopt = false;
+
+function MaybeDeopt(f) {
+  // Functions containing try-catch are never inlined.
+  try {
+    if (deopt) %DeoptimizeFunction(f);
+  } catch (e) { }
+}
+
+function Literal(a, b) {
+  var p = { x: 0, y: 0 };
+  p.x = a;
+  p.y = b;
+  MaybeDeopt(Literal);
+  p.x += 1;
+  return p.x + p.y;
+}
+
+assertEquals(4, Literal(1, 2));
+assertEquals(4, Literal(1, 2));
+%OptimizeFunctionOnNextCall(Literal);
+assertEquals(6, Literal(2, 3));
+deopt = true;
+assertEquals(8, Literal(3, 4));
+deopt = false;
+
+// Eager deoptimization when the field values change their type.
+function Sum(a, b) {
+  var p = { x: a, y: b };
+  return p.x + p.y;
+}
+
+assertEquals(3, Sum(1, 2));
+assertEquals(3, Sum(1, 2));
+%OptimizeFunctionOnNextCall(Sum);
+assertEquals(7, Sum(3, 4));
+assertEquals("ab", Sum("a", "b"));
+
+// Objects of inlined constructors.
+function Point(x, y) {
+  this.x = x;
+  this.y = y;
+}
+
+function Distance(a, b) {
+  var p = new Point(a, b);
+  MaybeDeopt(Distance);
+  return p.x * p.x + p.y * p.y;
+}
+
+assertEquals(25, Distance(3, 4));
+assertEquals(25, Distance(3, 4));
+%OptimizeFunctionOnNextCall(Distance);
+assertEquals(169, Distance(5, 12));
+deopt = true;
+assertEquals(100, Distance(6, 8));
+deopt = false;
+
+// Fields updated in a loop.
+function Accumulate(n) {
+  var acc = { sum: 0, count: 0 };
+  for (var i = 0; i < n; i++) {
+    acc.sum += i;
+    acc.count++;
+    if (i == 5) MaybeDeopt(Accumulate);
+  }
+  return acc.sum * 100 + acc.count;
+}
+
+assertEquals(1010, Accumulate(5));
+assertEquals(1010, Accumulate(5));
+%OptimizeFunctionOnNextCall(Accumulate);
+assertEquals(4510, Accumulate(10));
+deopt = true;
+assertEquals(4510, Accumulate(10));
+deopt = false;
+
+// Fields merged from both branches of a conditional.
+function Choose(c, a, b) {
+  var p = { v: 0 };
+  if (c) {
+    p.v = a;
+  } else {
+    p.v = b;
+  }
+  MaybeDeopt(Choose);
+  return p.v;
+}
+
+assertEquals(1, Choose(true, 1, 2));
+assertEquals(2, Choose(false, 1, 2));
+%OptimizeFunctionOnNextCall(Choose);
+assertEquals(3, Choose(true, 3, 4));
+deopt = true;
+assertEquals(6, Choose(false, 5, 6));
+deopt = false;
+
+// Several variables refer to the same object after deoptimization.
+function Alias(a) {
+  var p = { x: a };
+  var q = p;
+  MaybeDeopt(Alias);
+  q.x = 5;
+  return p.x;
+}
+
+assertEquals(5, Alias(1));
+assertEquals(5, Alias(1));
+%OptimizeFunctionOnNextCall(Alias);
+assertEquals(5, Alias(2));
+deopt = true;
+assertEquals(5, Alias(3));
+deopt = false;
+
+// Objects that escape are still allocated.
+var escaped;
+function Escape(a) {
+  var p = { x: a };
+  escaped = p;
+  return p.x;
+}
+
+assertEquals(1, Escape(1));
+assertEquals(1, Escape(1));
+%OptimizeFunctionOnNextCall(Escape);
+assertEquals(2, Escape(2));
+assertEquals(2, escaped.x);
@@ -0,0 +1,104 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Flags: --allow-natives-syntax --array-bounds-checks-hoisting
+
+// Test that bounds checks of loop induction variables, which are removed or
+// hoisted out of the loop, still catch out of bounds accesses.
+
+function Sum(a, n) {
+  var s = 0;
+  for (var i = 0; i < n; i++) s += a[i];
+  return s;
+}
+
+function SumAll(a) {
+  var s = 0;
+  for (var i = 0; i < a.length; i++) s += a[i];
+  return s;
+}
+
+function SumBackwards(a) {
+  var s = 0;
+  for (var i = a.length - 1; i >= 0; i--) s += a[i];
+  return s;
+}
+
+function SumPairs(a) {
+  var s = 0;
+  for (var i = 0; i < a.length - 1; i++) s += a[i] * a[i + 1];
+  return s;
+}
+
+function SumRows(a, width, height) {
+  var s = 0;
+  for (var y = 0; y < height; y++) {
+    for (var x = 0; x < width; x++) s += a[y * width + x];
+  }
+  return s;
+}
+
+var array = [1, 2, 3, 4, 5];
+var typed = new Int32Array(5);
+for (var i = 0; i < typed.length; i++) typed[i] = i + 1;
+
+function Test(a) {
+  for (var i = 0; i < 3; i++) {
+    assertEquals(15, Sum(a, 5));
+    assertEquals(6, Sum(a, 3));
+    assertEquals(0, Sum(a, 0));
+    assertEquals(0, Sum(a, -1));
+    assertEquals(15, SumAll(a));
+    assertEquals(15, SumBackwards(a));
+    assertEquals(40, SumPairs(a));
+    assertEquals(10, SumRows(a, 2, 2));
+    assertEquals(0, SumRows(a, 0, 2));
+  }
+}
+
+function Optimize() {
+  %OptimizeFunctionOnNextCall(Sum);
+  %OptimizeFunctionOnNextCall(SumAll);
+  %OptimizeFunctionOnNextCall(SumBackwards);
+  %OptimizeFunctionOnNextCall(SumPairs);
+  %OptimizeFunctionOnNextCall(SumRows);
+}
+
+Test(array);
+Optimize();
+Test(array);
+Test(typed);
+Optimize();
+Test(typed);
+
+// Out of bounds accesses deoptimize and read undefined, which turns the
+// sums into NaN.
+Optimize();
+assertTrue(isNaN(Sum(array, 6)));
+assertTrue(isNaN(SumRows(array, 3, 2)));
+assertEquals(15, Sum(array, 5));
+assertTrue(isNaN(Sum([1, 2, 3], 4)));
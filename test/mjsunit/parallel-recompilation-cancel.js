@@ -0,0 +1,65 @@
+// Copyright 2012 the V8 project authors. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Google Inc. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Flags: --allow-natives-syntax --parallel-recompilation
+// Flags: --parallel-recompilation-threads=2
+// Flags: --parallel-recompilation-queue-length=2
+
+// Functions queued for parallel recompilation keep computing the right
+// result when their compilation is cancelled or dropped from a full queue.
+
+function make(k) {
+  return function(x) {
+    var sum = 0;
+    for (var i = 0; i < x; i++) sum += i * k;
+    return sum;
+  };
+}
+
+var functions = [];
+for (var i = 0; i < 8; i++) {
+  var f = make(i);
+  f(10);
+  f(10);
+  %OptimizeFunctionOnNextCall(f, "parallel");
+  // Queues the function, or drops it when the queue is full.
+  assertEquals(45 * i, f(10));
+  functions.push(f);
+}
+
+// Cancel every other compilation.  Cancelled functions keep running
+// unoptimized code.
+for (var i = 0; i < functions.length; i += 2) {
+  %DeoptimizeFunction(functions[i]);
+}
+
+for (var round = 0; round < 100; round++) {
+  for (var i = 0; i < functions.length; i++) {
+    assertEquals(45 * i, functions[i](10));
+  }
+}
@@ -261,6 +261,8 @@
             '../../src/compilation-cache.h',
             '../../src/compiler.cc',
             '../../src/compiler.h',
+            '../../src/concurrent-marker.cc',
+            '../../src/concurrent-marker.h',
             '../../src/contexts.cc',
             '../../src/contexts.h',
             '../../src/conversions-inl.h',
@@ -321,6 +323,8 @@
             '../../src/full-codegen.h',
             '../../src/func-name-inferrer.cc',
             '../../src/func-name-inferrer.h',
+            '../../src/gc-helper-thread.cc',
+            '../../src/gc-helper-thread.h',
             '../../src/global-handles.cc',
             '../../src/global-handles.h',
             '../../src/globals.h',
@@ -388,6 +392,12 @@
             '../../src/once.h',
             '../../src/optimizing-compiler-thread.h',
             '../../src/optimizing-compiler-thread.cc',
+            '../../src/parallel-evacuator.cc',
+            '../../src/parallel-evacuator.h',
+            '../../src/parallel-marker.cc',
+            '../../src/parallel-marker.h',
+            '../../src/parallel-scavenger.cc',
+            '../../src/parallel-scavenger.h',
             '../../src/parser.cc',
             '../../src/parser.h',
             '../../src/platform-posix.h',
@@ -453,6 +463,8 @@
             '../../src/strtod.h',
             '../../src/stub-cache.cc',
             '../../src/stub-cache.h',
+            '../../src/sweeper.cc',
+            '../../src/sweeper.h',
             '../../src/token.cc',
             '../../src/token.h',
             '../../src/transitions-inl.h',
@@ -487,6 +499,8 @@
             '../../src/version.h',
             '../../src/vm-state-inl.h',
             '../../src/vm-state.h',
+            '../../src/work-stealing-list-inl.h',
+            '../../src/work-stealing-list.h',
             '../../src/zone-inl.h',
             '../../src/zone.cc',
             '../../src/zone.h',